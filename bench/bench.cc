@@ -0,0 +1,49 @@
+
+#include "bench.h"
+
+namespace sdk {
+
+namespace bench {
+
+static constexpr uint32_t MAX_SAMPLES = 31;
+
+static void sort(uint64_t *values, uint32_t count)
+{
+    for (uint32_t i = 1; i < count; i++) {
+        uint64_t v = values[i];
+        uint32_t j = i;
+        for (; j > 0 && values[j - 1] > v; j--)
+            values[j] = values[j - 1];
+        values[j] = v;
+    }
+}
+
+result run(const benchmark &b, uint32_t samples)
+{
+    if (samples > MAX_SAMPLES)
+        samples = MAX_SAMPLES;
+    if (samples == 0)
+        samples = 1;
+
+    // one untimed batch to warm caches and lazy initialization
+    b.body(b.ctx, b.iterations);
+
+    uint64_t per_iteration[MAX_SAMPLES];
+    uint64_t ps_per_tick = 1000000 / ticks_per_us();
+    for (uint32_t i = 0; i < samples; i++) {
+        uint64_t start = now_ticks();
+        b.body(b.ctx, b.iterations);
+        uint64_t ticks = now_ticks() - start;
+        per_iteration[i] = ticks * ps_per_tick / b.iterations;
+    }
+    sort(per_iteration, samples);
+
+    return {
+        b.name, b.iterations, samples, per_iteration[0],
+        per_iteration[samples / 2], per_iteration[samples - 1],
+    };
+}
+
+} // namespace bench
+
+} // namespace sdk
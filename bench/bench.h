@@ -0,0 +1,102 @@
+
+#ifndef AIRBRAKES_SDK_BENCH_H_
+#define AIRBRAKES_SDK_BENCH_H_
+
+#include <stm32f4xx_hal.h>
+
+#include <stdint.h>
+
+namespace sdk {
+
+namespace bench {
+
+/** Receives the report text, in pieces */
+using write_fn = void (*)(const char *text, void *ctx);
+
+/** Runs the measured operation `iterations` times */
+using body_fn = void (*)(void *ctx, uint32_t iterations);
+
+struct benchmark {
+    const char *name;
+    uint32_t iterations; /* per sample */
+    body_fn body;
+    void *ctx;
+};
+
+/** Per-iteration times, in picoseconds so integers keep sub-ns precision */
+struct result {
+    const char *name;
+    uint32_t iterations;
+    uint32_t samples;
+    uint64_t min_ps;
+    uint64_t median_ps;
+    uint64_t max_ps;
+};
+
+/** Peripherals the driver benchmarks may drive. Nothing may be attached. */
+struct board {
+    TIM_HandleTypeDef *htim; /* PWM, channels 1 and 2 */
+    GPIO_TypeDef *motor_port; /* sh1, sh2 and nsleep */
+    uint16_t sh1_pin;
+    uint16_t sh2_pin;
+    uint16_t nsleep_pin;
+    GPIO_TypeDef *encoder_port;
+    uint16_t encoder_a_pin;
+    uint16_t encoder_b_pin;
+};
+
+static constexpr uint32_t DEFAULT_SAMPLES = 15;
+
+/*
+ * Timer, one per platform (timer_stm.cc: DWT cycle counter, timer_host.cc:
+ * steady clock in ns).
+ */
+uint64_t now_ticks();
+uint32_t ticks_per_us();
+const char *platform_name();
+
+/** Times `samples` batches of `b.iterations` runs of `b.body`. */
+result run(const benchmark &b, uint32_t samples);
+
+/** Fast-math kernels against libm, see fast_math_benchmarks.cc */
+extern const benchmark FAST_MATH_BENCHMARKS[];
+extern const int FAST_MATH_BENCHMARK_COUNT;
+
+/** SDK models and estimators, see model_benchmarks.cc */
+extern const benchmark MODEL_BENCHMARKS[];
+extern const int MODEL_BENCHMARK_COUNT;
+
+/**
+ * Checks the SDK's models and estimators against slow references (apogee
+ * prediction against fine-step RK4, ...), writing objects of the same form
+ * as `write_accuracy` with the error relative to the checked quantity. Each
+ * is followed by a comma, `write_accuracy` goes last. Returns false if any
+ * bound is exceeded.
+ */
+bool write_model_accuracy(write_fn write, void *ctx);
+
+/**
+ * Sweeps every sdk::fast_math kernel against double-precision libm and
+ * writes one JSON object per kernel with the worst error and its documented
+ * bound. Returns false if any bound is exceeded.
+ */
+bool write_accuracy(write_fn write, void *ctx);
+
+/**
+ * Runs every SDK benchmark and writes one JSON report through `write`.
+ * Must be called from a task, with the scheduler running.
+ */
+void run_sdk(const board &b, write_fn write, void *ctx);
+
+/** Keeps the compiler from optimizing away a computed value */
+template<typename T>
+inline void keep(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+} // namespace bench
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_BENCH_H_
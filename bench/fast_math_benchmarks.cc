@@ -0,0 +1,255 @@
+
+#include "bench.h"
+
+#include <sdk/fast_math.h>
+
+#include <math.h>
+#include <stdio.h>
+
+namespace sdk {
+
+namespace bench {
+
+/*
+ * Timing: each kernel against the single-precision libm function it replaces,
+ * over a spread of inputs so table lookups and branches see realistic data.
+ */
+
+template<float (*F)(float)>
+static void bench_unary(void *ctx, uint32_t iterations)
+{
+    const float *range = (const float *) ctx;
+    float x = range[0];
+    float step = (range[1] - range[0]) / (float) iterations;
+    for (uint32_t i = 0; i < iterations; i++) {
+        float y = F(x);
+        keep(y);
+        x += step;
+    }
+}
+
+template<float (*F)(float, float)>
+static void bench_binary(void *ctx, uint32_t iterations)
+{
+    (void) ctx;
+    float a = 0.5f;
+    float b = -2.0f;
+    for (uint32_t i = 0; i < iterations; i++) {
+        float y = F(a, b);
+        keep(y);
+        a += 0.003f;
+        b += 0.004f;
+    }
+}
+
+static float libm_sinf(float x) { return sinf(x); }
+static float libm_atan2f(float y, float x) { return atan2f(y, x); }
+static float libm_expf(float x) { return expf(x); }
+static float libm_logf(float x) { return logf(x); }
+static float libm_powf(float b, float e) { return powf(b, e); }
+static float libm_inv_sqrtf(float x) { return 1.0f / sqrtf(x); }
+
+static float fast_inv_sqrt(float x) { return 1.0f / fast_math::sqrt(x); }
+
+static float ANGLE_RANGE[2] = { -10.0f, 10.0f };
+static float EXP_RANGE[2] = { -10.0f, 10.0f };
+static float POSITIVE_RANGE[2] = { 0.01f, 1000.0f };
+
+extern const benchmark FAST_MATH_BENCHMARKS[] = {
+    { "libm.sinf", 1000, bench_unary<libm_sinf>, ANGLE_RANGE },
+    { "fast_math.sin", 1000, bench_unary<fast_math::sin>, ANGLE_RANGE },
+    { "fast_math.sin_lut", 1000, bench_unary<fast_math::sin_lut>,
+        ANGLE_RANGE },
+    { "libm.atan2f", 1000, bench_binary<libm_atan2f>, nullptr },
+    { "fast_math.atan2", 1000, bench_binary<fast_math::atan2>, nullptr },
+    { "fast_math.atan2_lut", 1000, bench_binary<fast_math::atan2_lut>,
+        nullptr },
+    { "libm.expf", 1000, bench_unary<libm_expf>, EXP_RANGE },
+    { "fast_math.exp", 1000, bench_unary<fast_math::exp>, EXP_RANGE },
+    { "fast_math.exp_lut", 1000, bench_unary<fast_math::exp_lut>,
+        EXP_RANGE },
+    { "libm.logf", 1000, bench_unary<libm_logf>, POSITIVE_RANGE },
+    { "fast_math.log", 1000, bench_unary<fast_math::log>, POSITIVE_RANGE },
+    { "fast_math.log_lut", 1000, bench_unary<fast_math::log_lut>,
+        POSITIVE_RANGE },
+    { "libm.powf", 1000, bench_binary<libm_powf>, nullptr },
+    { "fast_math.pow", 1000, bench_binary<fast_math::pow>, nullptr },
+    { "fast_math.pow_lut", 1000, bench_binary<fast_math::pow_lut>,
+        nullptr },
+    { "libm.inv_sqrtf", 1000, bench_unary<libm_inv_sqrtf>,
+        POSITIVE_RANGE },
+    { "fast_math.sqrt_div", 1000, bench_unary<fast_inv_sqrt>,
+        POSITIVE_RANGE },
+    { "fast_math.inv_sqrt", 1000, bench_unary<fast_math::inv_sqrt>,
+        POSITIVE_RANGE },
+};
+extern const int FAST_MATH_BENCHMARK_COUNT =
+    sizeof(FAST_MATH_BENCHMARKS) / sizeof(FAST_MATH_BENCHMARKS[0]);
+
+/*
+ * Accuracy: a sweep of each kernel against double-precision libm, checked
+ * against the documented bound.
+ */
+
+static constexpr int ACCURACY_POINTS = 20001;
+
+enum class error_kind {
+    /* |error| / max(1, |f(x)|), the form of the *_MAX_ERROR bounds */
+    ABSOLUTE,
+    RELATIVE,
+};
+
+struct accuracy_check {
+    const char *name;
+    float (*approx)(float);
+    double (*exact)(double);
+    double lo, hi;
+    bool log_spaced; /* sweep exp(u) for u in [lo, hi] */
+    error_kind kind;
+    float bound;
+};
+
+/* atan2 and acos are swept over an angle, around the unit circle */
+static float fast_atan2_at(float t)
+{
+    return fast_math::atan2((float) ::sin(t), (float) ::cos(t));
+}
+
+static float fast_atan2_lut_at(float t)
+{
+    return fast_math::atan2_lut((float) ::sin(t), (float) ::cos(t));
+}
+
+static double exact_atan2_at(double t)
+{
+    float t_in = (float) t;
+    return ::atan2((double) (float) ::sin(t_in), (double) (float) ::cos(t_in));
+}
+
+/* and along the diagonals, where |y| == |x| is the end of the octant */
+static float fast_atan2_diagonal(float t)
+{
+    return fast_math::atan2(t, t);
+}
+
+static float fast_atan2_antidiagonal(float t)
+{
+    return fast_math::atan2(t, -t);
+}
+
+static float fast_atan2_lut_diagonal(float t)
+{
+    return fast_math::atan2_lut(t, t);
+}
+
+static float fast_atan2_lut_antidiagonal(float t)
+{
+    return fast_math::atan2_lut(t, -t);
+}
+
+static double exact_atan2_diagonal(double t) { return ::atan2(t, t); }
+
+static double exact_atan2_antidiagonal(double t)
+{
+    // the kernels give 0 at the origin, whatever the signs of the zeros
+    return t == 0 ? 0 : ::atan2(t, -t);
+}
+
+static double exact_sin(double x) { return ::sin(x); }
+static double exact_cos(double x) { return ::cos(x); }
+static double exact_atan(double x) { return ::atan(x); }
+static double exact_acos(double x) { return ::acos(x); }
+static double exact_exp(double x) { return ::exp(x); }
+static double exact_log(double x) { return ::log(x); }
+static double exact_inv_sqrt(double x) { return 1.0 / ::sqrt(x); }
+
+static const accuracy_check ACCURACY_CHECKS[] = {
+    { "fast_math.sin", fast_math::sin, exact_sin, -1e4, 1e4, false,
+        error_kind::ABSOLUTE, fast_math::SIN_MAX_ERROR },
+    { "fast_math.cos", fast_math::cos, exact_cos, -1e4, 1e4, false,
+        error_kind::ABSOLUTE, fast_math::SIN_MAX_ERROR },
+    { "fast_math.atan", fast_math::atan, exact_atan, -100, 100, false,
+        error_kind::ABSOLUTE, fast_math::ATAN_MAX_ERROR },
+    { "fast_math.atan2", fast_atan2_at, exact_atan2_at, -3.14, 3.14, false,
+        error_kind::ABSOLUTE, fast_math::ATAN_MAX_ERROR },
+    { "fast_math.atan2_diagonal", fast_atan2_diagonal, exact_atan2_diagonal,
+        -100, 100, false, error_kind::ABSOLUTE, fast_math::ATAN_MAX_ERROR },
+    { "fast_math.atan2_antidiagonal", fast_atan2_antidiagonal,
+        exact_atan2_antidiagonal, -100, 100, false, error_kind::ABSOLUTE,
+        fast_math::ATAN_MAX_ERROR },
+    { "fast_math.acos", fast_math::acos, exact_acos, -1, 1, false,
+        error_kind::ABSOLUTE, fast_math::ACOS_MAX_ERROR },
+    { "fast_math.exp", fast_math::exp, exact_exp, -87, 88, false,
+        error_kind::RELATIVE, fast_math::EXP_MAX_REL_ERROR },
+    { "fast_math.log", fast_math::log, exact_log, -87, 88, true,
+        error_kind::ABSOLUTE, fast_math::LOG_MAX_ERROR },
+    { "fast_math.inv_sqrt", fast_math::inv_sqrt, exact_inv_sqrt, -87, 88,
+        true, error_kind::RELATIVE, fast_math::INV_SQRT_MAX_REL_ERROR },
+    { "fast_math.sin_lut", fast_math::sin_lut, exact_sin, -100, 100, false,
+        error_kind::ABSOLUTE, fast_math::SIN_LUT_MAX_ERROR },
+    { "fast_math.cos_lut", fast_math::cos_lut, exact_cos, -100, 100, false,
+        error_kind::ABSOLUTE, fast_math::SIN_LUT_MAX_ERROR },
+    { "fast_math.atan2_lut", fast_atan2_lut_at, exact_atan2_at, -3.14, 3.14,
+        false, error_kind::ABSOLUTE, fast_math::ATAN_LUT_MAX_ERROR },
+    { "fast_math.atan2_lut_diagonal", fast_atan2_lut_diagonal,
+        exact_atan2_diagonal, -100, 100, false, error_kind::ABSOLUTE,
+        fast_math::ATAN_LUT_MAX_ERROR },
+    { "fast_math.atan2_lut_antidiagonal", fast_atan2_lut_antidiagonal,
+        exact_atan2_antidiagonal, -100, 100, false, error_kind::ABSOLUTE,
+        fast_math::ATAN_LUT_MAX_ERROR },
+    { "fast_math.exp_lut", fast_math::exp_lut, exact_exp, -87, 88, false,
+        error_kind::RELATIVE, fast_math::EXP_LUT_MAX_REL_ERROR },
+    { "fast_math.log_lut", fast_math::log_lut, exact_log, -87, 88, true,
+        error_kind::ABSOLUTE, fast_math::LOG_LUT_MAX_ERROR },
+};
+
+static double max_error(const accuracy_check &c)
+{
+    double worst = 0;
+    for (int i = 0; i < ACCURACY_POINTS; i++) {
+        double u = c.lo + (c.hi - c.lo) * i / (ACCURACY_POINTS - 1);
+        // the kernel sees a float, so compare at exactly that float
+        float x = (float) (c.log_spaced ? ::exp(u) : u);
+        double exact = c.exact(x);
+        double error = fabs((double) c.approx(x) - exact);
+        double scale = fabs(exact);
+        if (c.kind == error_kind::ABSOLUTE && scale < 1.0)
+            scale = 1.0;
+        if (scale > 0)
+            error /= scale;
+        if (!(error <= worst)) // keeps NaN
+            worst = error;
+    }
+    return worst;
+}
+
+bool write_accuracy(write_fn write, void *ctx)
+{
+    const int count = sizeof(ACCURACY_CHECKS) / sizeof(ACCURACY_CHECKS[0]);
+    bool all_ok = true;
+    for (int i = 0; i < count; i++) {
+        const accuracy_check &c = ACCURACY_CHECKS[i];
+        double error = max_error(c);
+        bool ok = error <= c.bound;
+        all_ok = all_ok && ok;
+
+        // in parts per billion, integers since printf may lack floats
+        double ppb = error * 1e9;
+        unsigned long error_ppb = ppb < 4e9 ? (unsigned long) ppb :
+            4000000000ul;
+
+        char line[192];
+        snprintf(line, sizeof(line),
+            "    {\"name\": \"%s\", \"points\": %d, \"max_error_ppb\": %lu, "
+            "\"bound_ppb\": %lu, \"ok\": %s}%s\n",
+            c.name, ACCURACY_POINTS, error_ppb,
+            (unsigned long) (c.bound * 1e9f + 0.5f), ok ? "true" : "false",
+            i == count - 1 ? "" : ",");
+        write(line, ctx);
+    }
+    return all_ok;
+}
+
+} // namespace bench
+
+} // namespace sdk
@@ -0,0 +1,57 @@
+
+/*
+ * Host runner for the SDK microbenchmarks, see bench.h. Writes the JSON
+ * report to stdout (or the file given as the only argument); compare it with
+ * a baseline using tools/bench_compare.py.
+ */
+
+#include "bench.h"
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <stdio.h>
+
+static TIM_HandleTypeDef htim2;
+static FILE *out;
+
+static void write_out(const char *text, void *ctx)
+{
+    (void) ctx;
+    fputs(text, out);
+}
+
+static void bench_task(void *params)
+{
+    (void) params;
+    const sdk::bench::board b = {
+        &htim2, GPIOB, GPIO_PIN_1, GPIO_PIN_2, GPIO_PIN_0,
+        GPIOB, GPIO_PIN_6, GPIO_PIN_7,
+    };
+    sdk::bench::run_sdk(b, write_out, nullptr);
+    vTaskEndScheduler();
+}
+
+int main(int argc, char **argv)
+{
+    out = stdout;
+    if (argc > 1) {
+        out = fopen(argv[1], "w");
+        if (out == nullptr) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    HAL_Init();
+    htim2.Instance = TIM2;
+    htim2.Init.Period = 999;
+    htim2.Instance->ARR = 999;
+
+    xTaskCreate(bench_task, "bench", 2048, nullptr, 1, nullptr);
+    vTaskStartScheduler();
+
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
@@ -0,0 +1,720 @@
+
+#include "bench.h"
+
+#include <sdk/altitude.h>
+#include <sdk/apogee.h>
+#include <sdk/attitude.h>
+#include <sdk/clock.h>
+#include <sdk/imu_calibration.h>
+#include <sdk/vertical_kalman.h>
+
+#include <math.h>
+#include <stdio.h>
+
+namespace sdk {
+
+namespace bench {
+
+/*
+ * Timing and accuracy of the SDK's models and estimators. Accuracy checks
+ * sweep a model against a slow reference and report the worst error relative
+ * to the quantity checked, or in SI units where the SDK documents an absolute
+ * bound, in the same form as the fast-math sweeps.
+ */
+
+/* pressures of a flight from a high launch site, in Pa */
+static float PRESSURE_RANGE[2] = { 80000.0f, 101000.0f };
+
+template<float (*F)(float)>
+static void bench_altitude(void *ctx, uint32_t iterations)
+{
+    const float *range = (const float *) ctx;
+    float p = range[0];
+    float step = (range[1] - range[0]) / (float) iterations;
+    for (uint32_t i = 0; i < iterations; i++) {
+        float h = F(p);
+        keep(h);
+        p += step;
+    }
+}
+
+/* the flight computer's tuning */
+static constexpr vertical_kalman::config KALMAN_CONFIG = {
+    vertical_kalman::axis::POS_Z, 0.05f, 0.01f, 0.5f,
+};
+
+static constexpr float IMU_DT = 0.0025f; /* 400 Hz */
+
+static void bench_kalman_predict(void *ctx, uint32_t iterations)
+{
+    vertical_kalman *k = (vertical_kalman *) ctx;
+    for (uint32_t i = 0; i < iterations; i++)
+        k->predict(9.9f + 0.001f * (float) (i & 63), IMU_DT);
+    keep(*k);
+}
+
+static void bench_kalman_update(void *ctx, uint32_t iterations)
+{
+    vertical_kalman *k = (vertical_kalman *) ctx;
+    for (uint32_t i = 0; i < iterations; i++)
+        k->update(0.01f * (float) (i & 63));
+    keep(*k);
+}
+
+static vertical_kalman kalman(KALMAN_CONFIG);
+
+static void bench_attitude_update(void *ctx, uint32_t iterations)
+{
+    attitude_estimator *e = (attitude_estimator *) ctx;
+    for (uint32_t i = 0; i < iterations; i++) {
+        float wobble = 0.01f * (float) (i & 63);
+        e->update({ 0.1f, -0.2f + wobble, 2.0f },
+            { 0.3f + wobble, -0.2f, 9.8f }, IMU_DT);
+    }
+    keep(*e);
+}
+
+static attitude_estimator attitude;
+
+static void bench_running_stats(void *ctx, uint32_t iterations)
+{
+    running_stats *s = (running_stats *) ctx;
+    s->reset();
+    for (uint32_t i = 0; i < iterations; i++) {
+        float wobble = 0.001f * (float) (i & 63);
+        s->add({ 0.1f + wobble, -0.2f, 9.8f - wobble });
+    }
+    keep(*s);
+}
+
+/* 2 s at 400 Hz, thresholds well above the BMI088's noise */
+static constexpr imu_calibration::config CALIBRATION_CONFIG = {
+    800, 5.0f, 0.5f, 0.2f,
+};
+
+static void bench_calibration(void *ctx, uint32_t iterations)
+{
+    imu_calibration *c = (imu_calibration *) ctx;
+    bmi088::state sample = {};
+    c->reset();
+    for (uint32_t i = 0; i < iterations; i++) {
+        float wobble = 0.001f * (float) (i & 63);
+        sample.acceleration_ms2 = { 0.1f + wobble, -0.2f, 9.8f - wobble };
+        sample.angular_velocity_ds = { 0.3f, -0.2f + wobble, 0.1f };
+        imu_calibration::status s = c->add_sample(sample);
+        keep(s);
+    }
+}
+
+static running_stats stats;
+static imu_calibration calibration(CALIBRATION_CONFIG);
+
+static void bench_extend(void *ctx, uint32_t iterations)
+{
+    counter_extender *e = (counter_extender *) ctx;
+    uint32_t raw = 0xfffff000u;
+    for (uint32_t i = 0; i < iterations; i++) {
+        uint64_t wide = e->extend(raw);
+        keep(wide);
+        raw += 16;
+    }
+}
+
+/* a BMI088 read every 2.5 ms, its sensortime against the local clock */
+static void bench_timebase_sync(void *ctx, uint32_t iterations)
+{
+    timebase_sync *s = (timebase_sync *) ctx;
+    s->reset();
+    uint64_t local_us = 1000000;
+    uint32_t ticks = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        s->observe(ticks, local_us + (i & 7));
+        uint64_t mapped = s->to_local_us(ticks);
+        keep(mapped);
+        local_us += 2500;
+        ticks += 64;
+    }
+}
+
+static counter_extender extender;
+static timebase_sync sensortime_sync(bmi088::SENSORTIME_SYNC_CONFIG);
+
+/* the host simulation's ~700 m airframe */
+static apogee_predictor::config sport_airframe()
+{
+    apogee_predictor::config conf = {};
+    conf.coast_mass_kg = 3.5f;
+    conf.ground_altitude_asl_m = 200.0f;
+    conf.max_deployment_deg = 60.0f;
+    for (int i = 0; i < apogee_predictor::DRAG_TABLE_SIZE; i++) {
+        conf.drag_area_m2[i] = 0.0045f + 0.012f * (float) i /
+            (float) (apogee_predictor::DRAG_TABLE_SIZE - 1);
+    }
+    return conf;
+}
+
+/* the same shape at 40 kg, whose climbs reach the long-climb path */
+static apogee_predictor::config heavy_airframe()
+{
+    apogee_predictor::config conf = sport_airframe();
+    conf.coast_mass_kg = 40.0f;
+    return conf;
+}
+
+struct solve_ctx {
+    apogee_predictor *predictor;
+    float altitude_m;
+    float velocity_ms;
+    float target_apogee_m;
+};
+
+/*
+ * one control tick's search; every input of a batch takes the same path, so
+ * the long-climb case times the worst case of `solve_deployment`
+ */
+static void bench_solve_deployment(void *ctx, uint32_t iterations)
+{
+    solve_ctx *c = (solve_ctx *) ctx;
+    for (uint32_t i = 0; i < iterations; i++) {
+        float deg = c->predictor->solve_deployment(c->altitude_m +
+            (float) (i & 15), c->velocity_ms, c->target_apogee_m);
+        keep(deg);
+    }
+}
+
+static apogee_predictor sport_predictor(sport_airframe());
+static apogee_predictor heavy_predictor(heavy_airframe());
+
+/* in reach of partial deployment, so the bisection runs in full */
+static solve_ctx SPORT_SOLVE = { &sport_predictor, 150.0f, 200.0f, 700.0f };
+static solve_ctx HEAVY_SOLVE = { &heavy_predictor, 500.0f, 450.0f, 5000.0f };
+
+extern const benchmark MODEL_BENCHMARKS[] = {
+    { "counter_extender.extend", 1000, bench_extend, &extender },
+    { "timebase_sync.observe_and_map", 1000, bench_timebase_sync,
+        &sensortime_sync },
+    { "running_stats.add", 1000, bench_running_stats, &stats },
+    { "imu_calibration.add_sample", 800, bench_calibration, &calibration },
+    { "attitude.update", 1000, bench_attitude_update, &attitude },
+    { "vertical_kalman.predict", 1000, bench_kalman_predict, &kalman },
+    { "vertical_kalman.update", 1000, bench_kalman_update, &kalman },
+    { "altitude.pressure_to_altitude", 1000,
+        bench_altitude<altitude_estimator::pressure_to_altitude>,
+        PRESSURE_RANGE },
+    { "altitude.pressure_to_altitude_powf", 1000,
+        bench_altitude<altitude_estimator::pressure_to_altitude_exact>,
+        PRESSURE_RANGE },
+    { "apogee.solve_deployment", 100, bench_solve_deployment, &SPORT_SOLVE },
+    { "apogee.solve_long_climb", 10, bench_solve_deployment, &HEAVY_SOLVE },
+};
+extern const int MODEL_BENCHMARK_COUNT =
+    sizeof(MODEL_BENCHMARKS) / sizeof(MODEL_BENCHMARKS[0]);
+
+/* the table against the ISA barometric formula in double, in m */
+static double altitude_table_error(int &points)
+{
+    constexpr double BARO_SCALE = 44330.77;
+    constexpr double BARO_EXPONENT = 0.190263;
+    constexpr int POINTS = 20001;
+
+    double worst = 0;
+    for (int i = 0; i < POINTS; i++) {
+        float p = altitude_estimator::TABLE_MIN_PRESSURE +
+            (altitude_estimator::TABLE_MAX_PRESSURE -
+             altitude_estimator::TABLE_MIN_PRESSURE) * (float) i /
+            (float) POINTS;
+        double exact = BARO_SCALE * (1.0 - pow((double) p /
+            altitude_estimator::SEA_LEVEL_PRESSURE, BARO_EXPONENT));
+        double error = fabs(altitude_estimator::pressure_to_altitude(p) -
+            exact);
+        if (!(error <= worst))
+            worst = error;
+    }
+    points = POINTS;
+    return worst;
+}
+
+/* deterministic noise, roughly gaussian with unit variance */
+static float noise(uint32_t &seed)
+{
+    float sum = 0;
+    for (int i = 0; i < 4; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        sum += (float) (seed >> 8) * (1.0f / 16777216.0f);
+    }
+    // four uniforms have variance 1/3, mean 2
+    return (sum - 2.0f) * 1.7320508f;
+}
+
+/*
+ * a 20 s replay: 2.5 s of boost at 6 g, then a coast with quadratic drag,
+ * as a 400 Hz IMU with a 0.3 m/s^2 bias and a 50 Hz barometer see it. the
+ * error is the worst of the estimate against the true track once the bias
+ * has settled, after the first 5 s on the pad
+ */
+static constexpr float REPLAY_PAD_S = 5.0f;
+static constexpr float REPLAY_BOOST_S = 2.5f;
+static constexpr float REPLAY_END_S = 25.0f;
+
+static double kalman_replay_error(int &points, bool velocity)
+{
+    constexpr float g = vertical_kalman::GRAVITY_EARTH;
+    constexpr float DRAG = 0.0012f; /* 1/m */
+    vertical_kalman k(KALMAN_CONFIG);
+    uint32_t seed = 12345;
+
+    float h = 0;
+    float v = 0;
+    double worst = 0;
+    points = 0;
+    int steps = (int) (REPLAY_END_S / IMU_DT);
+    for (int i = 0; i < steps; i++) {
+        float t = (float) i * IMU_DT;
+        float a = 0;
+        if (t >= REPLAY_PAD_S && t < REPLAY_PAD_S + REPLAY_BOOST_S)
+            a = 6.0f * g;
+        else if (t >= REPLAY_PAD_S)
+            a = -g - DRAG * v * (v > 0 ? v : -v);
+
+        k.predict(a + g + 0.3f + KALMAN_CONFIG.accel_noise * noise(seed),
+            IMU_DT);
+        h += v * IMU_DT + 0.5f * a * IMU_DT * IMU_DT;
+        v += a * IMU_DT;
+        if (i % 8 == 7)
+            k.update(h + KALMAN_CONFIG.baro_noise * noise(seed));
+
+        if (t < REPLAY_PAD_S)
+            continue;
+        vertical_kalman::state est = k.get_state();
+        double error = velocity ? fabs(est.vertical_velocity_ms - v) :
+            fabs(est.altitude_m - h);
+        if (!(error <= worst))
+            worst = error;
+        points++;
+    }
+    return worst;
+}
+
+/* in m */
+static double kalman_altitude_error(int &points)
+{
+    return kalman_replay_error(points, false);
+}
+
+/* in m/s */
+static double kalman_velocity_error(int &points)
+{
+    return kalman_replay_error(points, true);
+}
+
+/*
+ * a 60 s replay of a constant rotation, 2 rad/s of roll with slower pitch and
+ * yaw rates, from a 10 deg tilt, as a 400 Hz IMU with a gyro bias sees it.
+ * yaw is unobservable, so the tilt error is the angle between the true and
+ * estimated gravity directions in the body frame. the bias integrator has a
+ * ~20 s time constant at the default gains, so its error counts over the
+ * last 10 s
+ */
+static constexpr float ROTATION_SETTLE_S = 5.0f;
+static constexpr float ROTATION_BIAS_SETTLE_S = 50.0f;
+static constexpr float ROTATION_END_S = 60.0f;
+
+static double attitude_rotation_error(int &points, bool bias_error)
+{
+    using dvec3 = basic_vec3<double>;
+    using dquat = basic_quat<double>;
+
+    const dvec3 rate = { 0.3, -0.2, 2.0 }; /* in rad/s, body frame */
+    const vec3 bias = { 0.02f, -0.015f, 0.01f };
+    const dvec3 up = { 0, 0, 1 };
+    double speed = sqrt(dot(rate, rate));
+    dquat step = axis_angle(rate * (1.0 / speed), speed * IMU_DT);
+    dquat truth = axis_angle(dvec3{ 1, 0, 0 }, 10.0 * M_PI / 180.0);
+
+    attitude_estimator e;
+    uint32_t seed = 54321;
+    double worst = 0;
+    points = 0;
+    int steps = (int) (ROTATION_END_S / IMU_DT);
+    for (int i = 0; i < steps; i++) {
+        truth = normalized(truth * step);
+        dvec3 g_body = rotate(conjugate(truth), up) *
+            (double) attitude_estimator::GRAVITY_EARTH;
+        vec3 gyro = {
+            (float) rate.x + bias.x + 0.005f * noise(seed),
+            (float) rate.y + bias.y + 0.005f * noise(seed),
+            (float) rate.z + bias.z + 0.005f * noise(seed),
+        };
+        vec3 accel = {
+            (float) g_body.x + 0.05f * noise(seed),
+            (float) g_body.y + 0.05f * noise(seed),
+            (float) g_body.z + 0.05f * noise(seed),
+        };
+        e.update(gyro, accel, IMU_DT);
+
+        float t = (float) i * IMU_DT;
+        if (t < (bias_error ? ROTATION_BIAS_SETTLE_S : ROTATION_SETTLE_S))
+            continue;
+        double error;
+        if (bias_error) {
+            // about the spin axis only its mean shows, so x and y
+            vec3 b = e.get_gyro_bias();
+            error = fmax(fabs(b.x - bias.x), fabs(b.y - bias.y));
+        } else {
+            quat q = e.get_orientation();
+            dquat estimate = { q.w, q.x, q.y, q.z };
+            dvec3 a = rotate(conjugate(truth), up);
+            dvec3 b = rotate(conjugate(normalized(estimate)), up);
+            double c = dot(a, b);
+            error = acos(c < 1.0 ? c : 1.0) * 180.0 / M_PI;
+        }
+        if (!(error <= worst))
+            worst = error;
+        points++;
+    }
+    return worst;
+}
+
+/* in deg */
+static double attitude_tilt_error(int &points)
+{
+    return attitude_rotation_error(points, false);
+}
+
+/* in rad/s */
+static double attitude_bias_error(int &points)
+{
+    return attitude_rotation_error(points, true);
+}
+
+/*
+ * Welford in single precision against a two-pass mean and variance in double,
+ * over a long window of a signal far from zero (gravity, plus noise): the
+ * worst relative error of the per-axis variance. the second pass replays the
+ * same noise rather than storing the samples
+ */
+static constexpr int WELFORD_SAMPLES = 100000;
+
+static vec3 welford_sample(uint32_t &seed)
+{
+    return {
+        0.3f + 0.2f * noise(seed),
+        -bmi088::GRAVITY_EARTH + 0.02f * noise(seed),
+        150.0f + 0.05f * noise(seed),
+    };
+}
+
+static double welford_variance_error(int &points)
+{
+    running_stats s;
+    double sum[3] = {};
+    uint32_t seed = 777;
+    for (int i = 0; i < WELFORD_SAMPLES; i++) {
+        vec3 x = welford_sample(seed);
+        s.add(x);
+        sum[0] += x.x;
+        sum[1] += x.y;
+        sum[2] += x.z;
+    }
+
+    double m2[3] = {};
+    seed = 777;
+    for (int i = 0; i < WELFORD_SAMPLES; i++) {
+        vec3 x = welford_sample(seed);
+        double d[3] = { x.x - sum[0] / WELFORD_SAMPLES,
+            x.y - sum[1] / WELFORD_SAMPLES, x.z - sum[2] / WELFORD_SAMPLES };
+        for (int k = 0; k < 3; k++)
+            m2[k] += d[k] * d[k];
+    }
+
+    vec3 variance = s.variance();
+    float got[3] = { variance.x, variance.y, variance.z };
+    double worst = 0;
+    for (int k = 0; k < 3; k++) {
+        double exact = m2[k] / (WELFORD_SAMPLES - 1);
+        double error = fabs(got[k] - exact) / exact;
+        if (!(error <= worst))
+            worst = error;
+    }
+    points = WELFORD_SAMPLES;
+    return worst;
+}
+
+/* one calibration window, as the pad sees it */
+enum class pad_motion {
+    STILL,
+    BUMP, /* one knock on the rail */
+    SWAY, /* slow rocking, under the per-sample rate limit */
+    VIBRATION, /* e.g. a generator nearby */
+};
+
+static constexpr vec3 GYRO_ZERO_RATE_DS = { 0.3f, -0.2f, 0.15f };
+
+/*
+ * runs a window through `imu_calibration`; true if it was accepted, with
+ * `gyro_error` the worst axis error of the zero-rate offset (in deg/s)
+ */
+static bool calibrate_window(pad_motion motion, uint32_t &seed,
+        double &gyro_error)
+{
+    imu_calibration cal(CALIBRATION_CONFIG);
+    bmi088::state sample = {};
+    for (uint32_t i = 0; i < CALIBRATION_CONFIG.window_samples; i++) {
+        float t = (float) i * IMU_DT;
+        vec3 gyro = GYRO_ZERO_RATE_DS;
+        vec3 acc = { 0.05f, -0.1f, bmi088::GRAVITY_EARTH };
+        if (motion == pad_motion::BUMP && i == 300)
+            gyro.y += 20.0f;
+        if (motion == pad_motion::SWAY)
+            gyro.x += 3.0f * sinf(2.0f * (float) M_PI * 0.5f * t);
+        if (motion == pad_motion::VIBRATION)
+            acc.z += 0.8f * sinf(2.0f * (float) M_PI * 25.0f * t);
+
+        sample.angular_velocity_ds = {
+            gyro.x + 0.1f * noise(seed),
+            gyro.y + 0.1f * noise(seed),
+            gyro.z + 0.1f * noise(seed),
+        };
+        sample.acceleration_ms2 = {
+            acc.x + 0.02f * noise(seed),
+            acc.y + 0.02f * noise(seed),
+            acc.z + 0.02f * noise(seed),
+        };
+        imu_calibration::status s = cal.add_sample(sample);
+        if (s == imu_calibration::status::MOTION_DETECTED)
+            return false;
+        if (s == imu_calibration::status::DONE) {
+            vec3 d = cal.get_offsets().gyro_ds - GYRO_ZERO_RATE_DS;
+            gyro_error = fmax(fabs(d.x), fmax(fabs(d.y), fabs(d.z)));
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * windows accepted or rejected wrongly, out of a set of pad scenarios; a
+ * count, so any is a failure
+ */
+static double calibration_misclassified(int &points)
+{
+    static const pad_motion SCENARIOS[] = {
+        pad_motion::STILL, pad_motion::BUMP, pad_motion::SWAY,
+        pad_motion::VIBRATION, pad_motion::STILL,
+    };
+    uint32_t seed = 4242;
+    double wrong = 0;
+    points = 0;
+    for (pad_motion motion : SCENARIOS) {
+        double gyro_error = 0;
+        bool accepted = calibrate_window(motion, seed, gyro_error);
+        if (accepted != (motion == pad_motion::STILL))
+            wrong++;
+        points++;
+    }
+    return wrong;
+}
+
+/* the zero-rate offset from still windows, in deg/s */
+static double calibration_gyro_error(int &points)
+{
+    uint32_t seed = 99;
+    double worst = 0;
+    points = 0;
+    for (int i = 0; i < 10; i++) {
+        double error = 1e9;
+        calibrate_window(pad_motion::STILL, seed, error);
+        if (!(error <= worst))
+            worst = error;
+        points++;
+    }
+    return worst;
+}
+
+/*
+ * a 32-bit cycle counter at 84 MHz read at irregular intervals, up to just
+ * under its 51 s wrap period, for 200 wraps; a count of wrong extensions
+ */
+static double extender_wrap_errors(int &points)
+{
+    constexpr uint64_t MAX_GAP = 84000000ull * 51;
+
+    counter_extender e;
+    uint64_t cycles = 0;
+    uint32_t seed = 2024;
+    double wrong = 0;
+    points = 0;
+    while (cycles < 200ull << 32) {
+        seed = seed * 1664525u + 1013904223u;
+        // mostly short gaps, with the longest allowed one now and then
+        uint64_t gap = (seed >> 28) == 0 ? MAX_GAP :
+            (uint64_t) (seed >> 4) % (MAX_GAP / 16);
+        cycles += gap;
+        if (e.extend((uint32_t) cycles) != cycles)
+            wrong++;
+        points++;
+    }
+    return wrong;
+}
+
+/*
+ * the BMI088 sensortime mapping on a sensor clock 300 ppm slow, read every
+ * 2.5 ms with up to 40 us of read latency, across a wrap of the 24-bit
+ * counter. the error is the worst of the mapped time of each sample against
+ * when it really was taken, once the loop has settled after 30 s; it keeps
+ * the 20 us mean read latency, which the loop cannot see
+ */
+static constexpr float SYNC_DRIFT = 300e-6f;
+static constexpr float SYNC_SETTLE_S = 30.0f;
+static constexpr float SYNC_END_S = 120.0f;
+
+static double sync_error(int &points, bool drift)
+{
+    const timebase_sync::config &conf = bmi088::SENSORTIME_SYNC_CONFIG;
+    const double tick_us = conf.tick_us * (1.0 + SYNC_DRIFT);
+    // starts 60 s before the counter wraps
+    const uint32_t start_ticks = (uint32_t) (conf.modulus -
+        (uint64_t) (60e6 / tick_us));
+
+    timebase_sync sync(conf);
+    uint32_t seed = 31337;
+    double worst = 0;
+    points = 0;
+    int reads = (int) (SYNC_END_S / IMU_DT);
+    for (int i = 0; i < reads; i++) {
+        // the sample is taken on a sensor tick, the read lands a bit later
+        double taken_us = 1e6 + (double) i * IMU_DT * 1e6;
+        uint64_t elapsed = (uint64_t) ((taken_us - 1e6) / tick_us);
+        uint32_t ticks = (uint32_t) ((start_ticks + elapsed) % conf.modulus);
+        double tick_at_us = 1e6 + (double) elapsed * tick_us;
+        seed = seed * 1664525u + 1013904223u;
+        double read_us = tick_at_us + 40.0 * (double) (seed >> 8) /
+            16777216.0;
+
+        sync.observe(ticks, (uint64_t) read_us);
+        if ((double) i * IMU_DT < SYNC_SETTLE_S)
+            continue;
+        // in s and as a fraction, to keep the report's integers in range
+        double error = drift ?
+            fabs((double) sync.drift_ppm() * 1e-6 - SYNC_DRIFT) :
+            fabs((double) sync.to_local_us(ticks) - tick_at_us) * 1e-6;
+        if (!(error <= worst))
+            worst = error;
+        points++;
+    }
+    return worst;
+}
+
+/* in s */
+static double sync_time_error(int &points)
+{
+    return sync_error(points, false);
+}
+
+/* of the rate */
+static double sync_drift_error(int &points)
+{
+    return sync_error(points, true);
+}
+
+/* the reference integration step, RK4 at 5 ms agrees with 0.5 ms to 1e-6 */
+static constexpr float APOGEE_REFERENCE_STEP = 0.005f;
+
+/*
+ * `predict` against RK4 over a grid of altitudes, speeds and deployments,
+ * keeping the points whose reference climb is in [min_climb, max_climb]
+ */
+static double apogee_error(apogee_predictor &p, float max_speed,
+        float min_climb, float max_climb, int &points)
+{
+    double worst = 0;
+    points = 0;
+    for (int a = 0; a <= 8; a++) {
+        for (int s = 0; s <= 40; s++) {
+            for (int d = 0; d <= 6; d++) {
+                float h = 250.0f * (float) a;
+                float v = 10.0f + (max_speed - 10.0f) * (float) s / 40.0f;
+                float deg = 10.0f * (float) d;
+                float exact = p.predict_integrated(h, v, deg,
+                    APOGEE_REFERENCE_STEP, 1000000);
+                float climb = exact - h;
+                if (climb < min_climb || climb > max_climb)
+                    continue;
+                double error = fabs((double) p.predict(h, v, deg) - exact) /
+                    climb;
+                if (!(error <= worst))
+                    worst = error;
+                points++;
+            }
+        }
+    }
+    return worst;
+}
+
+/* the fast path, subsonic as the drag model assumes */
+static double apogee_fast_path_error(int &points)
+{
+    return apogee_error(sport_predictor, 330.0f, 0.0f,
+        apogee_predictor::FAST_PATH_MAX_CLIMB, points);
+}
+
+/* clear of the switch-over, so every point takes the layers */
+static double apogee_long_climb_error(int &points)
+{
+    return apogee_error(heavy_predictor, 330.0f,
+        apogee_predictor::FAST_PATH_MAX_CLIMB * 1.05f, 1e9f, points);
+}
+
+struct model_check {
+    const char *name;
+    double (*max_error)(int &points); /* worst error, as `bound` */
+    double bound; /* under 4, the report's ppb are 32-bit */
+};
+
+static const model_check MODEL_CHECKS[] = {
+    { "altitude.pressure_to_altitude", altitude_table_error,
+        altitude_estimator::TABLE_MAX_ERROR },
+    { "vertical_kalman.replay_altitude", kalman_altitude_error, 0.5 },
+    { "vertical_kalman.replay_velocity", kalman_velocity_error, 0.5 },
+    { "attitude.rotation_tilt_deg", attitude_tilt_error, 1.0 },
+    { "attitude.rotation_gyro_bias", attitude_bias_error, 0.01 },
+    { "running_stats.welford_variance", welford_variance_error, 1e-4 },
+    { "imu_calibration.misclassified_windows", calibration_misclassified,
+        0 },
+    { "imu_calibration.gyro_offset_ds", calibration_gyro_error, 0.02 },
+    { "counter_extender.wrap_errors", extender_wrap_errors, 0 },
+    { "timebase_sync.mapped_time_s", sync_time_error, 30e-6 },
+    { "timebase_sync.rate", sync_drift_error, 5e-6 },
+    { "apogee.predict", apogee_fast_path_error, 0.002 },
+    { "apogee.predict_long_climb", apogee_long_climb_error, 0.0005 },
+};
+
+bool write_model_accuracy(write_fn write, void *ctx)
+{
+    const int count = sizeof(MODEL_CHECKS) / sizeof(MODEL_CHECKS[0]);
+    bool all_ok = true;
+    for (int i = 0; i < count; i++) {
+        const model_check &c = MODEL_CHECKS[i];
+        int points = 0;
+        double error = c.max_error(points);
+        bool ok = points > 0 && error <= c.bound;
+        all_ok = all_ok && ok;
+
+        double ppb = error * 1e9;
+        unsigned long error_ppb = ppb < 4e9 ? (unsigned long) ppb :
+            4000000000ul;
+
+        char line[192];
+        snprintf(line, sizeof(line),
+            "    {\"name\": \"%s\", \"points\": %d, \"max_error_ppb\": %lu, "
+            "\"bound_ppb\": %lu, \"ok\": %s},\n",
+            c.name, points, error_ppb, (unsigned long) (c.bound * 1e9 + 0.5),
+            ok ? "true" : "false");
+        write(line, ctx);
+    }
+    return all_ok;
+}
+
+} // namespace bench
+
+} // namespace sdk
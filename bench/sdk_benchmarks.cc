@@ -0,0 +1,582 @@
+
+#include "bench.h"
+
+#include <sdk/baro_filter.h>
+#include <sdk/imu_filter.h>
+#include <sdk/mutex.h>
+#include <sdk/packet.h>
+#include <sdk/pwm.h>
+#include <sdk/queue.h>
+#include <sdk/topic.h>
+#include <sdk/vecmath.h>
+#include <sdk/drivers/bmi088.h>
+#include <sdk/drivers/bmp390.h>
+#include <sdk/drivers/motor_controller.h>
+
+#include <stdio.h>
+
+namespace sdk {
+
+namespace bench {
+
+/* a plausible NVM calibration block, see bmp390::set_calibration_data */
+static const uint8_t BMP390_NVM[21] = {
+    0x78, 0x69, 0x38, 0x4a, 0xf9, 0x70, 0x17, 0x80, 0x3e, 0x05, 0x00, 0x20,
+    0x4e, 0xc0, 0x5d, 0x03, 0xfc, 0xe8, 0x03, 0x02, 0x0a,
+};
+
+/* a mid-scale pressure and temperature conversion */
+static const uint8_t BMP390_FRAME[8] = {
+    0x00, 0x40, 0x6b, 0x00, 0x80, 0x82, 0x00, 0x00,
+};
+
+static const uint8_t BMI088_ACC_FRAME[bmi088::ACC_FRAME_SIZE] = {
+    0x10, 0x00, 0xe0, 0xff, 0x00, 0x08, 0x34, 0x12, 0x00,
+};
+
+static const uint8_t BMI088_GYRO_FRAME[bmi088::GYRO_FRAME_SIZE] = {
+    0x05, 0x00, 0xfb, 0xff, 0x02, 0x00,
+};
+
+static void bench_compensate_pressure(void *ctx, uint32_t iterations)
+{
+    bmp390 &baro = *(bmp390 *) ctx;
+    bmp390::data_frame frame;
+    for (int i = 0; i < 8; i++)
+        frame[i] = BMP390_FRAME[i];
+    for (uint32_t i = 0; i < iterations; i++) {
+        frame[0] = (uint8_t) i;
+        bmp390::real p = baro.compensate_pressure(25.0f, frame);
+        keep(p);
+    }
+}
+
+static void bench_parse_frames(void *ctx, uint32_t iterations)
+{
+    (void) ctx;
+    uint8_t acc_frame[bmi088::ACC_FRAME_SIZE];
+    for (int i = 0; i < bmi088::ACC_FRAME_SIZE; i++)
+        acc_frame[i] = BMI088_ACC_FRAME[i];
+    bmi088::state out;
+    for (uint32_t i = 0; i < iterations; i++) {
+        acc_frame[0] = (uint8_t) i;
+        bmi088::parse_frames(acc_frame, BMI088_GYRO_FRAME, out);
+        keep(out);
+    }
+}
+
+/* a FIFO-sized burst of raw accelerometer samples */
+static constexpr uint32_t BURST = 256;
+
+static bmi088::raw_vec3 *raw_burst()
+{
+    static bmi088::raw_vec3 raw[BURST];
+    for (uint32_t i = 0; i < BURST; i++)
+        raw[i] = { (int16_t) (i * 7), (int16_t) -(i * 5), 2048 };
+    return raw;
+}
+
+static const vec3 ACC_OFFSET = { 0.01f, -0.02f, 0.03f };
+
+static void bench_convert(void *ctx, uint32_t iterations)
+{
+    const bmi088::raw_vec3 *raw = (const bmi088::raw_vec3 *) ctx;
+    for (uint32_t i = 0; i < iterations; i++) {
+        vec3 v = bmi088::convert(raw[i % BURST], 0.0018f, ACC_OFFSET);
+        keep(v);
+    }
+}
+
+/* per sample, comparable to bench_convert */
+static void bench_scale_offset(void *ctx, uint32_t iterations)
+{
+    const bmi088::raw_vec3 *raw = (const bmi088::raw_vec3 *) ctx;
+    static vec3 out[BURST];
+    for (uint32_t i = 0; i < iterations; i += BURST) {
+        scale_offset(raw, BURST, 0.0018f, ACC_OFFSET, out);
+        keep(out);
+    }
+}
+
+static void bench_quat_rotate(void *ctx, uint32_t iterations)
+{
+    (void) ctx;
+    quat q = normalized(quat { 0.9f, 0.1f, -0.3f, 0.2f });
+    vec3 v = { 0.0f, 0.0f, 1.0f };
+    for (uint32_t i = 0; i < iterations; i++) {
+        v = rotate(q, v);
+        keep(v);
+    }
+}
+
+static void bench_quat_multiply(void *ctx, uint32_t iterations)
+{
+    (void) ctx;
+    quat step = normalized(quat { 1.0f, 0.001f, -0.002f, 0.0005f });
+    quat q = identity_quat<float>();
+    for (uint32_t i = 0; i < iterations; i++) {
+        q = q * step;
+        keep(q);
+    }
+}
+
+struct encoder_ctx {
+    motor_controller *motors;
+    GPIO_TypeDef *port;
+    uint16_t pin_a;
+    uint16_t pin_b;
+};
+
+static void bench_encoder(void *ctx, uint32_t iterations)
+{
+    encoder_ctx &e = *(encoder_ctx *) ctx;
+    quad_encoder &encoder = e.motors->get_encoder();
+    for (uint32_t i = 0; i < iterations; i++) {
+        // one quadrature edge per call where inputs are writable (the host
+        // HAL); on hardware the pins hold still and the no-edge path is timed
+        uint16_t pin = (i & 1) ? e.pin_b : e.pin_a;
+        e.port->IDR ^= pin;
+        encoder.read_and_update(pin);
+    }
+}
+
+static void bench_update_motor(void *ctx, uint32_t iterations)
+{
+    motor_controller &motors = *(motor_controller *) ctx;
+    for (uint32_t i = 0; i < iterations; i++) {
+        motors.set_target_degrees((i & 1) ? 90.0f : -90.0f);
+        motors.update_motor(0.001f);
+    }
+}
+
+static void bench_pwm_set(void *ctx, uint32_t iterations)
+{
+    pwm &out = *(pwm *) ctx;
+    for (uint32_t i = 0; i < iterations; i++)
+        out.set((pwm::real) (i & 0xff) / 255.0f);
+}
+
+static void bench_queue(void *ctx, uint32_t iterations)
+{
+    queue<uint32_t> &q = *(queue<uint32_t> *) ctx;
+    for (uint32_t i = 0; i < iterations; i++) {
+        q.push_back(i);
+        uint32_t out = q.pop();
+        keep(out);
+    }
+}
+
+/*
+ * draining vs popping one at a time, per item: every batch is pushed and then
+ * popped. Both cost a kernel receive per item, so they should match.
+ */
+static constexpr uint32_t QUEUE_BATCH = 32;
+
+static void bench_queue_pop_each(void *ctx, uint32_t iterations)
+{
+    queue<uint32_t, QUEUE_BATCH> &q = *(queue<uint32_t, QUEUE_BATCH> *) ctx;
+    for (uint32_t i = 0; i < iterations; i += QUEUE_BATCH) {
+        for (uint32_t j = 0; j < QUEUE_BATCH; j++)
+            q.push_back(j);
+        for (uint32_t j = 0; j < QUEUE_BATCH; j++) {
+            uint32_t out = q.pop();
+            keep(out);
+        }
+    }
+}
+
+static void bench_queue_drain(void *ctx, uint32_t iterations)
+{
+    queue<uint32_t, QUEUE_BATCH> &q = *(queue<uint32_t, QUEUE_BATCH> *) ctx;
+    uint32_t out[QUEUE_BATCH];
+    for (uint32_t i = 0; i < iterations; i += QUEUE_BATCH) {
+        for (uint32_t j = 0; j < QUEUE_BATCH; j++)
+            q.push_back(j);
+        uint32_t count = q.drain(out, QUEUE_BATCH);
+        keep(count);
+        keep(out);
+    }
+}
+
+static void bench_mutex(void *ctx, uint32_t iterations)
+{
+    mutex &m = *(mutex *) ctx;
+    for (uint32_t i = 0; i < iterations; i++) {
+        m.lock();
+        m.unlock();
+    }
+}
+
+/* an estimator-sized sample, as the flight computer publishes */
+struct topic_sample {
+    uint32_t seq;
+    float values[5];
+};
+
+static constexpr int TOPIC_SUBSCRIBERS = 4;
+using sample_topic = topic<topic_sample, 8, TOPIC_SUBSCRIBERS>;
+
+/* throughput: every sample is published and then read by each subscriber */
+struct topic_readers {
+    sample_topic samples;
+    sample_topic::subscriber subs[TOPIC_SUBSCRIBERS];
+};
+
+static void bench_topic_read(void *ctx, uint32_t iterations)
+{
+    topic_readers &t = *(topic_readers *) ctx;
+    topic_sample in = { 0, { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f } };
+    for (uint32_t i = 0; i < iterations; i++) {
+        in.seq = i;
+        t.samples.publish(in);
+        for (int j = 0; j < TOPIC_SUBSCRIBERS; j++) {
+            topic_sample out;
+            bool fresh = t.samples.read(t.subs[j], out);
+            keep(fresh);
+            keep(out);
+        }
+    }
+}
+
+/*
+ * Latency: subscriber tasks above the benchmark's priority wait on the topic
+ * and acknowledge every sample they read, so an iteration is one publish, the
+ * wakeup and read in each subscriber and the acknowledgements back.
+ */
+struct topic_fanout {
+    sample_topic samples;
+    TaskHandle_t publisher;
+};
+
+static void topic_subscriber_task(void *params)
+{
+    topic_fanout &t = *(topic_fanout *) params;
+    sample_topic::subscriber sub = t.samples.subscribe(true);
+    for (;;) {
+        t.samples.wait(1000);
+        topic_sample out;
+        while (t.samples.read(sub, out))
+            xTaskNotifyGive(t.publisher);
+    }
+}
+
+static void bench_topic_fanout(void *ctx, uint32_t iterations)
+{
+    topic_fanout &t = *(topic_fanout *) ctx;
+    topic_sample in = { 0, { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f } };
+    for (uint32_t i = 0; i < iterations; i++) {
+        in.seq = i;
+        t.samples.publish(in);
+        for (uint32_t acks = 0; acks < TOPIC_SUBSCRIBERS;)
+            acks += ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+/* a telemetry-sized payload, with the zeros COBS has to take out */
+static constexpr uint16_t PACKET_PAYLOAD = 64;
+
+static const uint8_t *packet_payload()
+{
+    static uint8_t payload[PACKET_PAYLOAD];
+    for (uint16_t i = 0; i < PACKET_PAYLOAD; i++)
+        payload[i] = (i % 5 == 0) ? 0 : (uint8_t) (i * 37);
+    return payload;
+}
+
+static void bench_packet_crc16(void *ctx, uint32_t iterations)
+{
+    const uint8_t *payload = (const uint8_t *) ctx;
+    for (uint32_t i = 0; i < iterations; i++) {
+        uint16_t crc = packet::crc16(payload, PACKET_PAYLOAD);
+        keep(crc);
+    }
+}
+
+static void bench_packet_encode(void *ctx, uint32_t iterations)
+{
+    const uint8_t *payload = (const uint8_t *) ctx;
+    uint8_t frame[packet::frame_size(PACKET_PAYLOAD)];
+    for (uint32_t i = 0; i < iterations; i++) {
+        uint16_t size = packet::encode(payload, PACKET_PAYLOAD, frame);
+        keep(size);
+        keep(frame);
+    }
+}
+
+static void count_packet(const uint8_t *payload, uint16_t size, void *ctx)
+{
+    (void) payload;
+    *(uint32_t *) ctx += size;
+}
+
+static void bench_packet_decode(void *ctx, uint32_t iterations)
+{
+    const uint8_t *payload = (const uint8_t *) ctx;
+    uint8_t frame[packet::frame_size(PACKET_PAYLOAD)];
+    uint16_t size = packet::encode(payload, PACKET_PAYLOAD, frame);
+    uint32_t received = 0;
+    packet::decoder decoder(count_packet, &received);
+    for (uint32_t i = 0; i < iterations; i++)
+        decoder.feed(frame, size);
+    keep(received);
+}
+
+/* decimating the accelerometer FIFO, per input sample */
+static constexpr int FILTER_TAPS = 32;
+static constexpr int FILTER_FACTOR = 4;
+static constexpr fir_coefficients<FILTER_TAPS> FILTER_LOWPASS =
+    fir_lowpass<FILTER_TAPS>(0.4 / FILTER_FACTOR);
+
+static void bench_fir_decimate(void *ctx, uint32_t iterations)
+{
+    const raw_vec3 *raw = (const raw_vec3 *) ctx;
+    static fir_decimator<FILTER_TAPS, FILTER_FACTOR> fir(FILTER_LOWPASS);
+    raw_vec3 out[BURST / FILTER_FACTOR + 1];
+    for (uint32_t i = 0; i < iterations; i += BURST) {
+        uint32_t count = fir.process(raw, BURST, out);
+        keep(count);
+        keep(out);
+    }
+}
+
+/* the same filter the obvious way: every output, one multiply at a time */
+static void bench_fir_naive(void *ctx, uint32_t iterations)
+{
+    const raw_vec3 *raw = (const raw_vec3 *) ctx;
+    static raw_vec3 history[FILTER_TAPS];
+    raw_vec3 out[BURST / FILTER_FACTOR + 1];
+    for (uint32_t i = 0; i < iterations; i += BURST) {
+        uint32_t count = 0;
+        for (uint32_t j = 0; j < BURST; j++) {
+            for (int k = FILTER_TAPS - 1; k > 0; k--)
+                history[k] = history[k - 1];
+            history[0] = raw[j];
+            int32_t x = 0, y = 0, z = 0;
+            for (int k = 0; k < FILTER_TAPS; k++) {
+                x += history[k].x * FILTER_LOWPASS.h[k];
+                y += history[k].y * FILTER_LOWPASS.h[k];
+                z += history[k].z * FILTER_LOWPASS.h[k];
+            }
+            raw_vec3 filtered = { (int16_t) (x >> 15), (int16_t) (y >> 15),
+                (int16_t) (z >> 15) };
+            if (j % FILTER_FACTOR == FILTER_FACTOR - 1)
+                out[count++] = filtered;
+        }
+        keep(count);
+        keep(out);
+    }
+}
+
+static void bench_cic_decimate(void *ctx, uint32_t iterations)
+{
+    const raw_vec3 *raw = (const raw_vec3 *) ctx;
+    static cic_decimator<3, FILTER_FACTOR> cic;
+    raw_vec3 out[BURST / FILTER_FACTOR + 1];
+    for (uint32_t i = 0; i < iterations; i += BURST) {
+        uint32_t count = cic.process(raw, BURST, out);
+        keep(count);
+        keep(out);
+    }
+}
+
+/* converted to floats first, as the raw samples would be */
+static void bench_biquad(void *ctx, uint32_t iterations)
+{
+    const raw_vec3 *raw = (const raw_vec3 *) ctx;
+    static const biquad_coefficients sections[2] = {
+        biquad_lowpass(1600.0f, 100.0f),
+        biquad_notch(1600.0f, 250.0f, 5.0f),
+    };
+    static biquad_cascade<2> filter(sections);
+    static vec3 samples[BURST];
+    for (uint32_t i = 0; i < iterations; i += BURST) {
+        scale_offset(raw, BURST, 0.0018f, ACC_OFFSET, samples);
+        filter.process(samples, BURST, samples);
+        keep(samples);
+    }
+}
+
+/* a noisy climb through the window, with an outlier every so often */
+static bmp390::real baro_sample(uint32_t i)
+{
+    bmp390::real noise = (bmp390::real) ((i * 2654435761u) >> 28) - 8.0f;
+    bmp390::real spike = (i % 37 == 0) ? 900.0f : 0.0f;
+    return 95000.0f - 12.0f * (bmp390::real) (i & 0xff) + noise + spike;
+}
+
+static void bench_baro_filter(void *ctx, uint32_t iterations)
+{
+    baro_filter &filter = *(baro_filter *) ctx;
+    bmp390::state sample = {};
+    for (uint32_t i = 0; i < iterations; i++) {
+        sample.pressure_pascals = baro_sample(i);
+        filter.process(sample);
+        keep(sample);
+    }
+}
+
+static void sort_window(bmp390::real *values, int count)
+{
+    for (int i = 1; i < count; i++) {
+        bmp390::real v = values[i];
+        int j = i;
+        for (; j > 0 && values[j - 1] > v; j--)
+            values[j] = values[j - 1];
+        values[j] = v;
+    }
+}
+
+/* the same decisions, sorting a copy of the window and the deviations */
+static void bench_baro_naive(void *ctx, uint32_t iterations)
+{
+    (void) ctx;
+    constexpr int W = baro_filter::WINDOW;
+    static bmp390::real window[W];
+    static uint32_t head;
+    for (uint32_t i = 0; i < iterations; i++) {
+        bmp390::real p = baro_sample(i);
+        window[head++ % W] = p;
+        bmp390::real sorted[W];
+        for (int k = 0; k < W; k++)
+            sorted[k] = window[k];
+        sort_window(sorted, W);
+        bmp390::real median = sorted[W / 2];
+        for (int k = 0; k < W; k++) {
+            bmp390::real d = sorted[k] - median;
+            sorted[k] = d < 0 ? -d : d;
+        }
+        sort_window(sorted, W);
+        bmp390::real limit = 3.0f * 1.4826f * sorted[W / 2];
+        if (limit < 25.0f)
+            limit = 25.0f;
+        bmp390::real d = p - median;
+        if (d > limit || d < -limit)
+            p = median;
+        keep(p);
+    }
+}
+
+static void write_result(const result &r, bool last, write_fn write,
+        void *ctx)
+{
+    char line[192];
+    snprintf(line, sizeof(line),
+        "    {\"name\": \"%s\", \"iterations\": %lu, \"samples\": %lu, "
+        "\"min_ns\": %lu.%03lu, \"median_ns\": %lu.%03lu, "
+        "\"max_ns\": %lu.%03lu}%s\n",
+        r.name, (unsigned long) r.iterations, (unsigned long) r.samples,
+        (unsigned long) (r.min_ps / 1000), (unsigned long) (r.min_ps % 1000),
+        (unsigned long) (r.median_ps / 1000),
+        (unsigned long) (r.median_ps % 1000),
+        (unsigned long) (r.max_ps / 1000), (unsigned long) (r.max_ps % 1000),
+        last ? "" : ",");
+    write(line, ctx);
+}
+
+void run_sdk(const board &b, write_fn write, void *ctx)
+{
+    // i2c_master needs a handle to tag, even though nothing goes on the bus
+    static I2C_HandleTypeDef unused_i2c;
+    static i2c_master i2c(&unused_i2c);
+
+    static bmp390 baro(i2c);
+    baro.set_calibration_data(BMP390_NVM);
+
+    static pwm pwm_out(b.htim, pwm::tim_channel::CHANNEL_1);
+    static motor_controller motors(0.01f, 0.001f, 0.0001f,
+        drv8701(
+            pwm(b.htim, pwm::tim_channel::CHANNEL_1),
+            pwm(b.htim, pwm::tim_channel::CHANNEL_2),
+            unique_pin(b.motor_port, b.sh1_pin),
+            unique_pin(b.motor_port, b.sh2_pin),
+            unique_pin(b.motor_port, b.nsleep_pin)),
+        quad_encoder(48.0f,
+            unique_pin(b.encoder_port, b.encoder_a_pin),
+            unique_pin(b.encoder_port, b.encoder_b_pin)));
+    static encoder_ctx encoder = {
+        &motors, b.encoder_port, b.encoder_a_pin, b.encoder_b_pin,
+    };
+    static bmi088::raw_vec3 *raw = raw_burst();
+    static queue<uint32_t> q(1);
+    static queue<uint32_t, QUEUE_BATCH> batch_q;
+    static mutex m("bench");
+    static const uint8_t *payload = packet_payload();
+    static baro_filter baro_outliers({ 3.0f, 25.0f, 0, 0 });
+
+    static topic_readers readers;
+    for (int i = 0; i < TOPIC_SUBSCRIBERS; i++)
+        readers.subs[i] = readers.samples.subscribe(false);
+    static topic_fanout fanout;
+    fanout.publisher = xTaskGetCurrentTaskHandle();
+    UBaseType_t priority = uxTaskPriorityGet(fanout.publisher) + 1;
+    for (int i = 0; i < TOPIC_SUBSCRIBERS; i++)
+        xTaskCreate(topic_subscriber_task, "topic_sub", 256, &fanout,
+            priority, nullptr);
+
+    const benchmark benchmarks[] = {
+        { "bmp390.compensate_pressure", 1000, bench_compensate_pressure,
+            &baro },
+        { "bmi088.parse_frames", 1000, bench_parse_frames, nullptr },
+        { "bmi088.convert", 1024, bench_convert, raw },
+        { "vecmath.scale_offset", 1024, bench_scale_offset, raw },
+        { "vecmath.quat_rotate", 1000, bench_quat_rotate, nullptr },
+        { "vecmath.quat_multiply", 1000, bench_quat_multiply, nullptr },
+        { "quad_encoder.read_and_update", 1000, bench_encoder, &encoder },
+        { "motor_controller.update_motor", 1000, bench_update_motor,
+            &motors },
+        { "pwm.set", 1000, bench_pwm_set, &pwm_out },
+        { "queue.round_trip", 1000, bench_queue, &q },
+        { "queue.batch_pop_each", 1024, bench_queue_pop_each, &batch_q },
+        { "queue.batch_drain", 1024, bench_queue_drain, &batch_q },
+        { "mutex.round_trip", 1000, bench_mutex, &m },
+        { "topic.publish_read_4", 1000, bench_topic_read, &readers },
+        { "topic.fanout_4_round_trip", 200, bench_topic_fanout, &fanout },
+        { "packet.crc16_64", 1000, bench_packet_crc16, (void *) payload },
+        { "packet.encode_64", 1000, bench_packet_encode, (void *) payload },
+        { "packet.decode_64", 1000, bench_packet_decode, (void *) payload },
+        { "imu_filter.fir32_decimate4", 1024, bench_fir_decimate, raw },
+        { "imu_filter.fir32_naive", 1024, bench_fir_naive, raw },
+        { "imu_filter.cic3_decimate4", 1024, bench_cic_decimate, raw },
+        { "imu_filter.biquad2", 1024, bench_biquad, raw },
+        { "baro_filter.process", 1000, bench_baro_filter, &baro_outliers },
+        { "baro_filter.naive_sort", 1000, bench_baro_naive, nullptr },
+    };
+    const int count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+#ifdef SDK_MUTEX_STATS
+    const char *mutex_stats = "true";
+#else
+    const char *mutex_stats = "false";
+#endif
+#ifdef SDK_TRACE
+    const char *trace = "true";
+#else
+    const char *trace = "false";
+#endif
+
+    char line[192];
+    snprintf(line, sizeof(line),
+        "{\n  \"platform\": \"%s\",\n  \"ticks_per_us\": %lu,\n"
+        "  \"config\": {\"mutex_stats\": %s, \"trace\": %s},\n"
+        "  \"results\": [\n", platform_name(),
+        (unsigned long) ticks_per_us(), mutex_stats, trace);
+    write(line, ctx);
+
+    for (int i = 0; i < count; i++)
+        write_result(run(benchmarks[i], DEFAULT_SAMPLES), false, write, ctx);
+    for (int i = 0; i < MODEL_BENCHMARK_COUNT; i++)
+        write_result(run(MODEL_BENCHMARKS[i], DEFAULT_SAMPLES), false, write,
+            ctx);
+    for (int i = 0; i < FAST_MATH_BENCHMARK_COUNT; i++)
+        write_result(run(FAST_MATH_BENCHMARKS[i], DEFAULT_SAMPLES),
+            i == FAST_MATH_BENCHMARK_COUNT - 1, write, ctx);
+
+    write("  ],\n  \"accuracy\": [\n", ctx);
+    write_model_accuracy(write, ctx);
+    write_accuracy(write, ctx);
+    write("  ]\n}\n", ctx);
+}
+
+} // namespace bench
+
+} // namespace sdk
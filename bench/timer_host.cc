@@ -0,0 +1,30 @@
+
+#include "bench.h"
+
+#include <chrono>
+
+namespace sdk {
+
+namespace bench {
+
+// sdk::clock follows simulated time on the host, which stands still while
+// code runs, so benchmarks use the wall clock
+uint64_t now_ticks()
+{
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t ticks_per_us()
+{
+    return 1000;
+}
+
+const char *platform_name()
+{
+    return "host";
+}
+
+} // namespace bench
+
+} // namespace sdk
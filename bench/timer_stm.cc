@@ -0,0 +1,27 @@
+
+#include "bench.h"
+
+#include <sdk/clock.h>
+
+namespace sdk {
+
+namespace bench {
+
+uint64_t now_ticks()
+{
+    return clock::now_cycles();
+}
+
+uint32_t ticks_per_us()
+{
+    return clock::cycles_per_us();
+}
+
+const char *platform_name()
+{
+    return "stm32";
+}
+
+} // namespace bench
+
+} // namespace sdk
@@ -0,0 +1,96 @@
+
+#ifndef AIRBRAKES_SDK_ALTITUDE_H_
+#define AIRBRAKES_SDK_ALTITUDE_H_
+
+#include <sdk/drivers/bmp390.h>
+
+#include <stdint.h>
+
+namespace sdk {
+
+/**
+ * Barometric altitude estimator. Converts BMP390 pressure readings into
+ * altitude above a captured ground reference, and tracks altitude and vertical
+ * velocity with an alpha-beta filter.
+ *
+ * Not thread-safe; meant to be owned by a single control task.
+ */
+class altitude_estimator {
+public:
+
+    using real = float;
+
+    /** ISA sea-level pressure (in Pa) */
+    static constexpr real SEA_LEVEL_PRESSURE = 101325.0f;
+
+    /*
+     * pressure range covered by the lookup table (in Pa). roughly -700 m to
+     * 9100 m above sea level; outside of this range the conversion falls back
+     * to powf.
+     */
+    static constexpr real TABLE_MIN_PRESSURE = 30000.0f;
+    static constexpr real TABLE_MAX_PRESSURE = 110000.0f;
+    static constexpr int TABLE_SIZE = 257;
+
+    /**
+     * Maximum interpolation error of `pressure_to_altitude` (in m) inside the
+     * table range, against the exact barometric formula.
+     */
+    static constexpr real TABLE_MAX_ERROR = 0.08f;
+
+    struct state {
+        real altitude_m; /* above ground reference, in m */
+        real vertical_velocity_ms; /* in m/s, positive up */
+
+        real ground_altitude_m; /* above sea level, in m */
+        uint32_t ground_samples;
+    };
+
+public:
+
+    /**
+     * Creates a new estimator with the given alpha-beta filter gains. `alpha`
+     * weighs the altitude correction, `beta` the velocity correction, and
+     * both should be in (0,1].
+     */
+    altitude_estimator(real alpha, real beta);
+
+    /**
+     * Converts a pressure (in Pa) to an altitude above sea level (in m) using
+     * the ISA barometric formula. Uses a linearly interpolated lookup table
+     * with error bounded by `TABLE_MAX_ERROR`.
+     */
+    static real pressure_to_altitude(real pressure_pascals);
+
+    /** Exact (powf-based) conversion, for reference. */
+    static real pressure_to_altitude_exact(real pressure_pascals);
+
+    /**
+     * Accumulates one barometer sample into the ground reference. Call this
+     * repeatedly while sitting on the pad; the reference is the mean of all
+     * samples captured since the last `reset_ground`. Locked-out samples
+     * (see baro_filter) are skipped.
+     */
+    void capture_ground(const bmp390::state &baro);
+
+    /** Discards the ground reference and resets the filter. */
+    void reset_ground();
+
+    /**
+     * Runs one filter step with a new barometer sample, taken `dt` seconds
+     * after the previous one. A locked-out sample only predicts.
+     */
+    void update(const bmp390::state &baro, real dt);
+
+    state get_state() const { return current_state; }
+
+private:
+    real alpha, beta;
+
+    bool initialized;
+    state current_state;
+};
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_ALTITUDE_H_
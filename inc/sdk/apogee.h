@@ -0,0 +1,101 @@
+
+#ifndef AIRBRAKES_SDK_APOGEE_H_
+#define AIRBRAKES_SDK_APOGEE_H_
+
+#include <stdint.h>
+
+namespace sdk {
+
+/**
+ * Predicts coast-phase apogee for vertical flight with quadratic drag, and
+ * searches for the airbrake deployment angle that hits a target apogee.
+ *
+ * The fast path uses the closed-form ballistic solution with air density
+ * taken from a compile-time ISA table at an effective point of the remaining
+ * climb. Long climbs instead step through a fixed number of constant-density
+ * layers, each solved in closed form, so every prediction takes bounded time.
+ * A fixed-step RK4 integrator is kept as the reference.
+ *
+ * Not thread-safe; meant to be owned by a single control task.
+ */
+class apogee_predictor {
+public:
+
+    using real = float;
+
+    static constexpr real GRAVITY_EARTH = 9.80665f; /* m/s^2 */
+
+    /** number of points in the drag-area-versus-deployment table */
+    static constexpr int DRAG_TABLE_SIZE = 8;
+
+    /*
+     * remaining climb (in m) above which `predict` goes layer by layer, since
+     * a single effective density is no longer representative
+     */
+    static constexpr real FAST_PATH_MAX_CLIMB = 3000.0f;
+
+    struct config {
+        real coast_mass_kg;
+        real ground_altitude_asl_m; /* launch site altitude above sea level */
+
+        /*
+         * drag area (Cd * reference area, in m^2) at evenly spaced airbrake
+         * deployments from 0 to `max_deployment_deg`, inclusive. must be
+         * non-decreasing.
+         */
+        real drag_area_m2[DRAG_TABLE_SIZE];
+        real max_deployment_deg;
+    };
+
+public:
+
+    explicit apogee_predictor(const config &conf) : conf(conf)
+    {
+    }
+
+    /**
+     * Predicts apogee (in m above ground) from the current altitude (in m above
+     * ground), vertical velocity (in m/s) and airbrake deployment (in deg).
+     * Runs in bounded time; a remaining climb over `FAST_PATH_MAX_CLIMB`
+     * costs about eight times the fast path.
+     */
+    real predict(real altitude_m, real velocity_ms, real deployment_deg);
+
+    /**
+     * Predicts apogee by integrating the equations of motion with RK4 steps of
+     * `step_s` seconds, up to `max_steps` steps. Worst-case time is bounded by
+     * `max_steps`; with a small step, the reference for `predict`.
+     */
+    real predict_integrated(real altitude_m, real velocity_ms,
+            real deployment_deg, real step_s, int max_steps);
+
+    /**
+     * Searches for the deployment angle (in deg) whose predicted apogee is
+     * closest to `target_apogee_m`, suitable for
+     * `motor_controller::set_target_degrees`. Uses a fixed number of bisection
+     * iterations so the cost per control tick is constant.
+     */
+    real solve_deployment(real altitude_m, real velocity_ms,
+            real target_apogee_m);
+
+    /** Drag area (in m^2) at a deployment angle, interpolated from the table */
+    real drag_area(real deployment_deg);
+
+    /** ISA air density (in kg/m^3) at an altitude above ground (in m) */
+    real air_density(real altitude_m);
+
+private:
+
+    /*
+     * the long-climb path: closed-form steps through a fixed number of
+     * constant-density layers, where c is drag area / 2m
+     */
+    real predict_layered(real altitude_m, real v2, real c,
+            real climb_estimate);
+
+    config conf;
+};
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_APOGEE_H_
@@ -0,0 +1,89 @@
+
+#ifndef AIRBRAKES_SDK_ATTITUDE_H_
+#define AIRBRAKES_SDK_ATTITUDE_H_
+
+#include <sdk/vecmath.h>
+
+namespace sdk {
+
+/**
+ * Mahony-style complementary attitude estimator. Integrates body rates into a
+ * quaternion, corrects roll/pitch drift against the measured gravity vector
+ * and estimates the gyro bias with the integral term.
+ *
+ * Single precision, no trig in `update`; only square roots for normalisation.
+ * Yaw is unobservable without a magnetometer and only follows the gyro.
+ */
+class attitude_estimator {
+public:
+
+    using real = float;
+
+    static constexpr real GRAVITY_EARTH = 9.80665f; /* m/s^2 */
+
+    using vec3 = sdk::vec3;
+
+    /** unit quaternion rotating body-frame vectors into the world frame */
+    using quat = sdk::quat;
+
+    struct config {
+        real kp; /* proportional gain on the gravity error, in 1/s */
+        real ki; /* integral (bias) gain on the gravity error, in 1/s^2 */
+
+        /*
+         * accelerometer correction is only applied while |a| is within
+         * `accel_gate` * g of 1 g, so thrust and drag don't tilt the estimate
+         */
+        real accel_gate;
+    };
+
+    static constexpr config DEFAULT_CONFIG = { 2.0f, 0.1f, 0.1f };
+
+public:
+
+    explicit attitude_estimator(const config &conf = DEFAULT_CONFIG)
+        : conf(conf)
+    {
+        reset();
+    }
+
+    /** Resets to the identity orientation and zero bias. */
+    void reset();
+
+    /**
+     * Runs one update with body rates `gyro_rads` (in rad/s) and specific force
+     * `accel_ms2` (in m/s^2), `dt` seconds after the previous update. The first
+     * update after a reset aligns the orientation with gravity.
+     */
+    void update(const vec3 &gyro_rads, const vec3 &accel_ms2, real dt);
+
+    void set_config(const config &new_conf) { conf = new_conf; }
+
+    quat get_orientation() const { return q; }
+
+    /** Estimated gyro bias (in rad/s), already removed from the body rates */
+    vec3 get_gyro_bias() const { return -bias; }
+
+    /**
+     * Cosine of the angle between the body axis `body_up` (unit vector) and
+     * world vertical. Cheap; prefer it in control logic over `tilt_deg`.
+     */
+    static real tilt_cos(const quat &q, const vec3 &body_up);
+
+    /** Angle (in deg) between the body axis `body_up` and world vertical. */
+    static real tilt_deg(const quat &q, const vec3 &body_up);
+
+private:
+    /* aligns the orientation so that `accel_ms2` points up */
+    void align(const vec3 &accel_ms2);
+
+    config conf;
+
+    bool aligned;
+    quat q;
+    vec3 bias; /* integral term, the negated gyro bias */
+};
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_ATTITUDE_H_
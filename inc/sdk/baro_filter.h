@@ -0,0 +1,121 @@
+
+#ifndef AIRBRAKES_SDK_BARO_FILTER_H_
+#define AIRBRAKES_SDK_BARO_FILTER_H_
+
+#include <sdk/drivers/bmi088.h>
+#include <sdk/drivers/bmp390.h>
+
+#include <stdint.h>
+
+namespace sdk {
+
+/**
+ * Outlier rejection for barometer samples, between the BMP390 read and its
+ * state publication (see `bmp390::set_filter`).
+ *
+ * A Hampel filter: each pressure is compared with the median of the last
+ * `WINDOW` samples, and one more than `threshold` robust standard deviations
+ * (1.4826 median absolute deviations) away is replaced by that median. Good
+ * samples pass through unchanged and without delay; on a steady climb the
+ * deviation grows with the rate, so the climb itself is never rejected. A real
+ * step in pressure is taken once it fills half the window.
+ *
+ * Around transonic flight and ejection charges the pressure is wrong for far
+ * longer than that, so the filter can also lock the barometer out entirely:
+ * while the IMU reads more than `lockout_accel_ms2` of specific force (and
+ * for `lockout_hold_us` after), or while `set_lockout` holds it. Locked-out
+ * samples carry the last good pressure, and the window starts over when the
+ * lockout ends.
+ *
+ * The window is kept sorted, so a sample costs one insertion and one removal
+ * of at most `WINDOW` moves and half a window to find the deviation; the
+ * work is the same for every sample and nothing is allocated.
+ *
+ * Not thread-safe; meant to be fed by the task that reads the sensors.
+ */
+class baro_filter {
+public:
+
+    using real = bmp390::real;
+
+    /** samples in the median window, odd */
+    static constexpr int WINDOW = 9;
+    static_assert(WINDOW % 2 == 1, "the median must be a sample");
+
+    struct config {
+        real threshold; /* in robust standard deviations, 3 is usual */
+        real min_deviation_pa; /* never rejects closer to the median */
+        /* specific force magnitude that locks out, in m/s^2, 0 for never */
+        real lockout_accel_ms2;
+        uint32_t lockout_hold_us;
+    };
+
+    struct stats {
+        uint32_t samples;
+        uint32_t replaced; /* outliers replaced by the median */
+        uint32_t locked_out;
+        uint32_t lockouts; /* times a lockout started */
+    };
+
+public:
+
+    explicit baro_filter(const config &conf);
+
+    /** Forgets the window and any lockout. */
+    void reset();
+
+    /** Filters a sample in place, setting its `sample_quality`. */
+    void process(bmp390::state &sample);
+
+    /**
+     * Feeds an IMU sample, locking the barometer out while its acceleration
+     * is over `lockout_accel_ms2`.
+     */
+    void update_acceleration(const bmi088::state &imu);
+
+    /** As above, from a specific force magnitude (in m/s^2) */
+    void update_acceleration(real specific_force_ms2, uint64_t timestamp_us);
+
+    /**
+     * Locks the barometer out until cleared, e.g. from just before an
+     * ejection charge fires until its pressure pulse has passed.
+     */
+    void set_lockout(bool locked) { manual_lockout = locked; }
+
+    /** Gets if a sample taken at `timestamp_us` would be locked out */
+    bool is_locked_out(uint64_t timestamp_us) const
+    {
+        return manual_lockout || timestamp_us < lockout_until_us;
+    }
+
+    /** Median of the window (in Pa), 0 before the first sample */
+    real get_median() const;
+
+    stats get_stats() const { return counts; }
+
+private:
+
+    /* inserts into the sorted window, dropping the oldest when it is full */
+    void insert(real pressure);
+
+    /* the median absolute deviation, from the sorted window */
+    real median_deviation(real median) const;
+
+    config conf;
+
+    real window[WINDOW]; /* in arrival order, a ring */
+    real sorted[WINDOW];
+    int head; /* the oldest sample once the window is full */
+    int count;
+
+    real last_good_pa;
+    uint64_t lockout_until_us;
+    bool manual_lockout;
+    bool was_locked_out;
+
+    stats counts;
+};
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_BARO_FILTER_H_
@@ -0,0 +1,127 @@
+
+#ifndef AIRBRAKES_SDK_BOOT_SEQUENCER_H_
+#define AIRBRAKES_SDK_BOOT_SEQUENCER_H_
+
+#include <sdk/clock.h>
+
+#include <stdint.h>
+
+namespace sdk {
+
+/**
+ * Brings devices up from a single task as a graph of steps instead of a fixed
+ * sequence. Each step declares the steps it depends on and how long its own
+ * dependents must wait after it (a datasheet power-up or reset delay). While
+ * one device waits out such a delay, steps of other devices run on the bus.
+ *
+ * Among the steps that can run, the one heading the longest chain of delays
+ * goes first, then the one added first; the order only depends on the graph
+ * and on how long the steps take. A failed step skips everything depending
+ * on it. Every step is timed for the boot report.
+ *
+ * Everything is sized at compile time; nothing is allocated.
+ */
+class boot_sequencer {
+public:
+
+    static constexpr int MAX_STEPS = 16;
+
+    /** runs one step, returns false if it failed */
+    using step_fn = bool (*)(void *ctx);
+    /** time source, in us */
+    using now_fn = uint64_t (*)();
+
+    enum class step_status {
+        PENDING,
+        DONE,
+        FAILED,
+        SKIPPED, /* a step it depends on failed */
+    };
+
+    struct step_stats {
+        const char *name;
+        step_status status;
+        uint32_t settle_us;
+
+        uint64_t ready_us; /* when its dependencies had settled */
+        uint64_t start_us;
+        uint64_t end_us;
+    };
+
+public:
+
+    explicit boot_sequencer(now_fn now = clock::now_us) : now(now), count(0),
+            started(false), start_us(0)
+    {
+    }
+
+    /** Dependency mask bit of a step id; -1 (a failed `add`) poisons it. */
+    static constexpr uint32_t after(int step_id)
+    {
+        return step_id < 0 ? UINT32_MAX : 1ul << step_id;
+    }
+
+    /**
+     * Adds a step, run once every step in `depends` (`after` bits, or'ed) is
+     * done and settled. Steps depending on this one wait `settle_us` after it
+     * ends. `fn` may be nullptr for a pure delay, e.g. a power-on time counted
+     * from the first `step`. Returns the step id, or -1 if the sequencer is
+     * full or a dependency does not exist. Must be called before `run`/`step`.
+     */
+    int add(const char *name, step_fn fn, void *ctx, uint32_t depends = 0,
+            uint32_t settle_us = 0);
+
+    /**
+     * Runs every step that can run at `now_us`, and any that become runnable
+     * meanwhile. Returns when the next step can run, or UINT64_MAX once all
+     * are finished. Meant to be driven by `run`, or directly with simulated
+     * time.
+     */
+    uint64_t step(uint64_t now_us);
+
+    /**
+     * Steps until all steps are finished, sleeping through delays. Returns
+     * true if every step succeeded.
+     */
+    bool run();
+
+    /** Gets if every step has run and succeeded */
+    bool succeeded() const;
+
+    /** Stats for one step */
+    const step_stats &get_stats(int step_id) const
+    {
+        return steps[step_id].stats;
+    }
+
+    /** Time from the first `step` to the end of the last step, in us */
+    uint64_t get_boot_us() const;
+
+    int get_count() const { return count; }
+
+private:
+
+    struct entry {
+        step_fn fn;
+        void *ctx;
+        uint32_t depends;
+        uint64_t chain_us; /* settle times along the longest path from here */
+
+        step_stats stats;
+    };
+
+    /* when `e` can run, or UINT64_MAX if it is waiting on unfinished steps */
+    uint64_t ready_at(entry &e);
+
+    now_fn now;
+
+    entry steps[MAX_STEPS]; /* indexed by step id */
+    int count;
+
+    bool started;
+    uint64_t start_us;
+};
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_BOOT_SEQUENCER_H_
@@ -0,0 +1,149 @@
+
+#ifndef AIRBRAKES_SDK_CLOCK_H_
+#define AIRBRAKES_SDK_CLOCK_H_
+
+#include <stdint.h>
+
+namespace sdk {
+
+/**
+ * Extends a free-running 32-bit counter to 64 bits. `extend` must be called at
+ * least once per wrap period of the counter. Not thread-safe by itself; see
+ * `clock` for the ISR-safe wrapper.
+ */
+class counter_extender {
+public:
+
+    counter_extender() : last(0), high(0)
+    {
+    }
+
+    uint64_t extend(uint32_t raw)
+    {
+        if (raw < last)
+            high++;
+        last = raw;
+        return ((uint64_t) high << 32) | raw;
+    }
+
+private:
+    uint32_t last;
+    uint32_t high;
+};
+
+/**
+ * SDK-wide monotonic clock, backed by the DWT cycle counter extended to 64
+ * bits. All sample timestamps in the SDK (`timestamp_us` fields) come from
+ * here.
+ *
+ * At 84 MHz the raw counter wraps every ~51 s, so something must read the
+ * clock at least that often; any running sensor loop does.
+ */
+class clock {
+public:
+
+    /** Enables the cycle counter. Call once at boot, before the scheduler. */
+    static void start();
+
+    /** Cycles since `start`. ISR-safe. */
+    static uint64_t now_cycles();
+
+    /**
+     * Raw 32-bit cycle counter, wrapping. No locking, for hot paths (tracing)
+     * that can unwrap it themselves.
+     */
+    static uint32_t now_cycles32();
+
+    /** Microseconds since `start`. ISR-safe. */
+    static uint64_t now_us();
+
+    /** Core clock cycles per microsecond */
+    static uint32_t cycles_per_us();
+
+    /**
+     * Arms a one-shot hardware timer to call `wake_from_isr` after `delay_us`,
+     * replacing any armed before.
+     */
+    using wake_timer_fn = void (*)(uint32_t delay_us, void *ctx);
+
+    /**
+     * Gives `sleep_until_us` a wake timer, for waits finer than the kernel
+     * tick. `arm` is called from task context.
+     */
+    static void set_wake_timer(wake_timer_fn arm, void *ctx);
+
+    /** Wakes the task sleeping on the wake timer. Call from its ISR. */
+    static void wake_from_isr();
+
+    /**
+     * Blocks the calling task until `now_us` reaches `deadline_us`.
+     *
+     * Whole ticks are slept with `vTaskDelay`, and with a wake timer set the
+     * last one or two ticks are slept on the timer, so the task wakes within
+     * the timer's resolution. Without one, the wait is rounded to ticks: it
+     * wakes up to a tick late, and nothing can run at more than
+     * configTICK_RATE_HZ. One task at a time can use the wake timer; others
+     * meanwhile get the tick rounding.
+     */
+    static void sleep_until_us(uint64_t deadline_us);
+};
+
+/**
+ * Maps a sensor's own free-running time base (e.g. BMI088 sensortime) onto
+ * `clock` microseconds, with a phase-locked loop correcting offset and rate
+ * drift from pairs of simultaneous readings. Pure logic, testable on the host.
+ */
+class timebase_sync {
+public:
+
+    using real = float;
+
+    struct config {
+        real tick_us; /* nominal sensor tick period, in us */
+        uint64_t modulus; /* sensor counter wraps at this value */
+
+        real phase_gain; /* fraction of the phase error corrected per step */
+        real rate_gain; /* fraction of the rate error corrected per step */
+    };
+
+public:
+
+    explicit timebase_sync(const config &conf) : conf(conf)
+    {
+        reset();
+    }
+
+    void reset();
+
+    /**
+     * Feeds one pair of readings taken at (nearly) the same instant. Jitter in
+     * `local_us` is averaged out by the loop gains.
+     */
+    void observe(uint32_t sensor_ticks, uint64_t local_us);
+
+    /** Converts a sensor time to `clock` microseconds. */
+    uint64_t to_local_us(uint32_t sensor_ticks) const;
+
+    /** Converts `clock` microseconds to a sensor time. */
+    uint32_t to_sensor_ticks(uint64_t local_us) const;
+
+    /** Estimated sensor clock rate error, in ppm (positive = sensor slow) */
+    real drift_ppm() const { return rate * 1e6f; }
+
+    bool is_locked() const { return initialized; }
+
+private:
+    /* signed sensor ticks from the anchor, modulo the sensor counter */
+    int64_t ticks_since_anchor(uint32_t sensor_ticks) const;
+
+    config conf;
+
+    bool initialized;
+    uint32_t anchor_sensor;
+    uint64_t anchor_local_ns; /* ns keeps sub-us phase corrections */
+    real rate; /* fractional rate correction */
+};
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_CLOCK_H_
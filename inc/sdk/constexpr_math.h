@@ -0,0 +1,126 @@
+
+#ifndef AIRBRAKES_SDK_CONSTEXPR_MATH_H_
+#define AIRBRAKES_SDK_CONSTEXPR_MATH_H_
+
+namespace sdk {
+
+/**
+ * Double-precision math usable in constant expressions, for generating lookup
+ * tables at compile time so they end up in flash. Much too slow to be called
+ * at runtime.
+ */
+namespace constexpr_math {
+
+constexpr double LN_2 = 0.69314718055994530942;
+
+/** natural log, x > 0 */
+constexpr double log(double x)
+{
+    // reduce to [0.5, 1] so the series converges quickly
+    int exponent = 0;
+    while (x > 1.0) {
+        x *= 0.5;
+        exponent++;
+    }
+    while (x < 0.5) {
+        x *= 2.0;
+        exponent--;
+    }
+
+    // ln(x) = 2 * atanh((x - 1) / (x + 1))
+    double y = (x - 1.0) / (x + 1.0);
+    double y2 = y * y;
+    double term = y;
+    double sum = 0.0;
+    for (int n = 1; n < 64; n += 2) {
+        sum += term / n;
+        term *= y2;
+    }
+    return 2.0 * sum + exponent * LN_2;
+}
+
+/** e^x */
+constexpr double exp(double x)
+{
+    // x = n * ln(2) + r, with |r| <= ln(2) / 2
+    int n = (int) (x / LN_2 + (x < 0 ? -0.5 : 0.5));
+    double r = x - n * LN_2;
+
+    double term = 1.0;
+    double sum = 1.0;
+    for (int i = 1; i < 32; i++) {
+        term *= r / i;
+        sum += term;
+    }
+
+    for (; n > 0; n--)
+        sum *= 2.0;
+    for (; n < 0; n++)
+        sum *= 0.5;
+    return sum;
+}
+
+/** base^exponent, base > 0 */
+constexpr double pow(double base, double exponent)
+{
+    return exp(exponent * log(base));
+}
+
+constexpr double PI = 3.14159265358979323846;
+
+/** sine, for |x| up to a few turns */
+constexpr double sin(double x)
+{
+    // reduce to [-pi, pi]
+    while (x > PI)
+        x -= 2.0 * PI;
+    while (x < -PI)
+        x += 2.0 * PI;
+
+    double term = x;
+    double sum = x;
+    for (int i = 1; i < 24; i++) {
+        term *= -x * x / ((2 * i) * (2 * i + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double cos(double x)
+{
+    return sin(x + PI / 2);
+}
+
+/** arctangent, in (-pi/2, pi/2) */
+constexpr double atan(double x)
+{
+    if (x < 0)
+        return -atan(-x);
+    if (x > 1.0)
+        return PI / 2 - atan(1.0 / x);
+
+    // halve the argument twice so the series converges quickly:
+    // atan(x) = 2 * atan(x / (1 + sqrt(1 + x^2)))
+    for (int i = 0; i < 2; i++) {
+        double s = 1.0 + x * x;
+        double r = s; // Newton's method for sqrt(s), s in [1, 2]
+        for (int j = 0; j < 8; j++)
+            r = 0.5 * (r + s / r);
+        x = x / (1.0 + r);
+    }
+
+    double x2 = x * x;
+    double term = x;
+    double sum = 0.0;
+    for (int n = 1; n < 40; n += 2) {
+        sum += term / n;
+        term *= -x2;
+    }
+    return 4.0 * sum;
+}
+
+} // namespace constexpr_math
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_CONSTEXPR_MATH_H_
@@ -2,8 +2,12 @@
 #ifndef AIRBRAKES_SDK_BMI088_H_
 #define AIRBRAKES_SDK_BMI088_H_
 
+#include <sdk/attitude.h>
+#include <sdk/clock.h>
 #include <sdk/i2c.h>
 #include <sdk/mutex.h>
+#include <sdk/register_map.h>
+#include <sdk/vecmath.h>
 
 namespace sdk {
 
@@ -23,9 +27,36 @@ public:
     static constexpr int ACC_CONF_ADDR = 0x40;
     static constexpr int ACC_RANGE_ADDR = 0x41;
 
+    static constexpr int ACC_INTERNAL_STAT_ADDR = 0x2a;
+    static constexpr int ACC_INT1_IO_CONF_ADDR = 0x53;
+    static constexpr int ACC_INT2_IO_CONF_ADDR = 0x54;
+    static constexpr int ACC_INT2_MAP_ADDR = 0x57;
+    static constexpr int ACC_INIT_CTRL_ADDR = 0x59;
+    static constexpr int ACC_FEATURE_ADDR_LSB_ADDR = 0x5b;
+    static constexpr int ACC_FEATURE_ADDR_MSB_ADDR = 0x5c;
+    static constexpr int ACC_FEATURE_CFG_ADDR = 0x5e;
+    static constexpr int ACC_PWR_CONF_ADDR = 0x7c;
+    static constexpr int ACC_PWR_CTRL_ADDR = 0x7d;
+
     static constexpr int RATE_X_LSB_ADDR = 0x02;
     static constexpr int GYRO_RANGE_ADDR = 0x0f;
     static constexpr int GYRO_BANDWIDTH_ADDR = 0x10;
+    static constexpr int GYRO_LPM1_ADDR = 0x11;
+    static constexpr int GYRO_INT_CTRL_ADDR = 0x15;
+    static constexpr int GYRO_INT3_INT4_IO_CONF_ADDR = 0x16;
+    static constexpr int GYRO_INT3_INT4_IO_MAP_ADDR = 0x18;
+
+    /* accel x/y/z + sensortime, gyro x/y/z */
+    static constexpr int ACC_FRAME_SIZE = 9;
+    static constexpr int GYRO_FRAME_SIZE = 6;
+
+    /* byte offset of the data sync word in the feature config */
+    static constexpr int FEATURE_DATA_SYNC_OFFSET = 4;
+    /* bytes per feature config burst write */
+    static constexpr int FEATURE_CONFIG_CHUNK = 32;
+
+    /* settling after `start`, the gyro start-up time t_su in the datasheet */
+    static constexpr uint32_t START_DELAY_US = 30000;
 
     /** Accelerometer low-pass filter bandwidth. see 4.4.1 and 5.3.8 */
     enum class acc_bwp : uint8_t {
@@ -75,56 +106,225 @@ public:
         BW_32HZ = 0x07, /* BW: 32Hz, ODR: 100Hz */
     };
 
+    /**
+     * Data synchronization mode. The gyro data-ready interrupt (INT3) must be
+     * wired to accel INT1; the synchronized data-ready is output on accel INT2.
+     * Requires the Bosch feature config, see `load_feature_config`.
+     */
+    enum class sync_mode : uint8_t {
+        OFF = 0x00,
+        SYNC_400HZ = 0x01, /* gyro ODR 400 Hz, BW 47 Hz */
+        SYNC_1000HZ = 0x02, /* gyro ODR 1000 Hz, BW 116 Hz */
+        SYNC_2000HZ = 0x03, /* gyro ODR 2000 Hz, BW 230 Hz */
+    };
+
     using real = float;
 
-    /* seconds per sensortime lsb */
-    static constexpr real SENSORTIME_RESOLUTION = 1.0f / 256000.0f;
+    /* seconds per sensortime lsb (39.0625 us), see 5.3.6 */
+    static constexpr real SENSORTIME_RESOLUTION = 1.0f / 25600.0f;
+    /* sensortime is a 24-bit counter, see 5.3.6 */
+    static constexpr uint32_t SENSORTIME_MODULUS = 1ul << 24;
+    static constexpr real DEG_TO_RAD = 0.0174532925f;
+
+    /* sensortime to sdk::clock mapping, see timebase_sync */
+    static constexpr timebase_sync::config SENSORTIME_SYNC_CONFIG = {
+        SENSORTIME_RESOLUTION * 1e6f, SENSORTIME_MODULUS, 0.01f, 2.5e-5f
+    };
     static constexpr real GRAVITY_EARTH = 9.80665f; /* m/s^2 */
 
-    struct vec3 {
-        real x, y, z;
+    using vec3 = sdk::vec3;
+
+    /** Raw sample as read from the data registers */
+    using raw_vec3 = basic_vec3<int16_t>;
+
+    /** Zero offsets subtracted from converted samples, see imu_calibration */
+    struct offsets {
+        vec3 acc_ms2; /* in m/s^2 */
+        vec3 gyro_ds; /* in deg/s */
     };
     
     struct state {
         vec3 acceleration_ms2; /* in m/s^2 */
-        vec3 orientation_deg; /* in deg */
         vec3 angular_velocity_ds; /* in deg/s */
 
+        raw_vec3 acc_raw;
+        raw_vec3 gyro_raw;
+
+        /* body-to-world orientation, see attitude_estimator */
+        quat orientation;
+        vec3 gyro_bias_rads; /* in rad/s */
+
         uint32_t last_sensortime;
         uint32_t sensortime;
         bool uninitialized_sensortime = true;
 
-        acc_range acc_range = acc_range::RANGE_6G;
-        acc_bwp acc_bwp = acc_bwp::NORMAL;
-        acc_odr acc_odr = acc_odr::ODR_100HZ;
+        /* sensortime mapped onto sdk::clock, in us */
+        uint64_t timestamp_us;
+
+        bmi088::acc_range acc_range = bmi088::acc_range::RANGE_6G;
+        bmi088::acc_bwp acc_bwp = bmi088::acc_bwp::NORMAL;
+        bmi088::acc_odr acc_odr = bmi088::acc_odr::ODR_100HZ;
+
+        bmi088::gyro_range gyro_range = bmi088::gyro_range::RANGE_2000DPS;
+        bmi088::gyro_bw gyro_bw = bmi088::gyro_bw::BW_532HZ;
+
+        bmi088::sync_mode sync_mode = bmi088::sync_mode::OFF;
+
+        /* raw-to-SI scales, only recomputed when the range changes */
+        real acc_scale = GRAVITY_EARTH * 6.0f / 32768.0f; /* RANGE_6G */
+        real gyro_scale = 2000.0f / 32768.0f; /* RANGE_2000DPS */
 
-        gyro_range gyro_range = gyro_range::RANGE_2000DPS;
-        gyro_bw gyro_bw = gyro_bw::BW_532HZ;
+        attitude_estimator::config attitude_config =
+            attitude_estimator::DEFAULT_CONFIG;
+
+        bmi088::offsets offsets = {};
     };
 
 public:
 
-    bmi088(sdk::i2c_master &i2c) : i2c(i2c)
+    /** Accelerometer raw-to-m/s^2 scale for a range. See 5.3.4 */
+    static constexpr real get_acc_scale(acc_range range)
     {
+        switch (range) {
+        case acc_range::RANGE_3G:
+            return GRAVITY_EARTH * 3.0f / 32768.0f;
+        case acc_range::RANGE_6G:
+            return GRAVITY_EARTH * 6.0f / 32768.0f;
+        case acc_range::RANGE_12G:
+            return GRAVITY_EARTH * 12.0f / 32768.0f;
+        case acc_range::RANGE_24G:
+        default:
+            return GRAVITY_EARTH * 24.0f / 32768.0f;
+        }
     }
 
-    /** Start the accelerometer and gyroscope. Thread-safe blocking. */
-    void start();
-    /** Stop the accelerometer and gyroscope. Thread-safe blocking. */
-    void stop();
+    /** Gyroscope raw-to-deg/s scale for a range. See 5.5.4 */
+    static constexpr real get_gyro_scale(gyro_range range)
+    {
+        switch (range) {
+        case gyro_range::RANGE_2000DPS:
+            return 2000.0f / 32768.0f;
+        case gyro_range::RANGE_1000DPS:
+            return 1000.0f / 32768.0f;
+        case gyro_range::RANGE_500DPS:
+            return 500.0f / 32768.0f;
+        case gyro_range::RANGE_250DPS:
+            return 250.0f / 32768.0f;
+        case gyro_range::RANGE_125DPS:
+        default:
+            return 125.0f / 32768.0f;
+        }
+    }
 
-    /** Sets the configuration of the accelerometer. Thread-safe blocking. */
-    void set_acc_config(acc_range range, acc_bwp bwp, acc_odr odr);
-    /** Sets the configuration of the gyroscope. Thread-safe blocking. */
-    void set_gyro_config(gyro_range range, gyro_bw bw);
+    /** Accelerometer output data rate in Hz. See 5.3.8 */
+    static constexpr real get_acc_odr_hz(acc_odr odr)
+    {
+        // 1600 Hz / 2^(0x0c - odr)
+        return 1600.0f / (real) (1 << (0x0c - (uint8_t) odr));
+    }
+
+    /** Gyroscope output data rate in Hz. See 5.5.5 */
+    static constexpr real get_gyro_odr_hz(gyro_bw bw)
+    {
+        switch (bw) {
+        case gyro_bw::BW_532HZ:
+        case gyro_bw::BW_230HZ:
+            return 2000.0f;
+        case gyro_bw::BW_116HZ:
+            return 1000.0f;
+        case gyro_bw::BW_47HZ:
+            return 400.0f;
+        case gyro_bw::BW_23HZ:
+        case gyro_bw::BW_64HZ:
+            return 200.0f;
+        case gyro_bw::BW_12HZ:
+        case gyro_bw::BW_32HZ:
+        default:
+            return 100.0f;
+        }
+    }
+
+    /**
+     * Converts a raw sample with a scale and offset, for consumers working
+     * from `state::acc_raw`/`state::gyro_raw`. One multiply-subtract per axis;
+     * see `scale_offset` for whole buffers.
+     */
+    static vec3 convert(const raw_vec3 &raw, real scale, const vec3 &offset)
+    {
+        return vec_cast<real>(raw) * scale - offset;
+    }
+
+public:
+
+    bmi088(sdk::i2c_master &i2c) : i2c(i2c),
+            acc_regs(i2c, SLAVE_ADDRESS_ACC << 1),
+            gyro_regs(i2c, SLAVE_ADDRESS_GYRO << 1),
+            sensortime_sync(SENSORTIME_SYNC_CONFIG)
+    {
+    }
+
+    /**
+     * Starts the accelerometer and gyroscope, which then need
+     * `START_DELAY_US`. Returns false if a write failed. Thread-safe blocking.
+     */
+    bool start();
+    /**
+     * Suspends the accelerometer and gyroscope. Returns false if a write
+     * failed. Thread-safe blocking.
+     */
+    bool stop();
+
+    /**
+     * Sets the configuration of the accelerometer. Returns false if the write
+     * failed. Thread-safe blocking.
+     */
+    bool set_acc_config(acc_range range, acc_bwp bwp, acc_odr odr);
+    /**
+     * Sets the configuration of the gyroscope. Returns false if the write
+     * failed. Thread-safe blocking.
+     */
+    bool set_gyro_config(gyro_range range, gyro_bw bw);
 
     /** Gets if this chip is connected. Thread-safe blocking. */
     bool is_connected();
 
     /**
-     * Updates internal driver state. Thread-safe blocking.
+     * Uploads the accelerometer feature config (the `bmi08x_config_file` blob
+     * from Bosch's BMI08x SensorAPI, not redistributed here), which is needed
+     * for data synchronization. Takes ~150 ms. Returns true if the chip
+     * reports successful initialization. Thread-safe blocking.
+     */
+    bool load_feature_config(const uint8_t *config, uint16_t size);
+
+    /**
+     * Enables or disables data synchronization. While enabled, the gyro
+     * triggers accelerometer sampling at the gyro ODR, and `update` should be
+     * called on each accel INT2 edge to get one time-aligned 6-DoF sample.
+     * Overrides the gyro bandwidth and accelerometer ODR. Returns false if a
+     * transfer failed. Thread-safe blocking.
+     */
+    bool set_sync_mode(sync_mode mode);
+
+    /**
+     * Sets the zero offsets subtracted from every sample, e.g. from
+     * `imu_calibration`. Thread-safe blocking.
      */
-    void update();
+    void set_offsets(const offsets &new_offsets);
+
+    /** Sets the attitude estimator gains. Thread-safe blocking. */
+    void set_attitude_config(const attitude_estimator::config &conf);
+
+    /**
+     * Gets the rate (in Hz) at which `update` yields new samples: the gyro ODR
+     * in sync mode, else the faster of the two sensors. Thread-safe blocking.
+     */
+    real get_odr_hz();
+
+    /**
+     * Updates internal driver state. Returns false if the read failed, in
+     * which case the state is left untouched. Thread-safe blocking.
+     */
+    bool update();
 
     /**
      * Copies the internal driver state for use in a control loop. May thread-safe
@@ -132,20 +332,53 @@ public:
      */
     state copy_state();
 
+    /**
+     * Decodes an accel frame (`ACC_FRAME_SIZE` bytes from ACC_X_LSB) and a gyro
+     * frame (`GYRO_FRAME_SIZE` bytes from RATE_X_LSB) into one sample of `out`.
+     * Both share the accel sensortime; the previous sensortime is kept for
+     * `last_sensortime`. Does not touch the attitude estimate.
+     */
+    static void parse_frames(const uint8_t *acc_frame,
+            const uint8_t *gyro_frame, state &out);
+
 private:
+    i2c_master::status write_reg(int slave_address, uint8_t reg,
+            uint8_t value);
+
+    /* stage into acc_regs/gyro_regs, see `flush_config` */
+    void stage_acc_config(acc_range range, acc_bwp bwp, acc_odr odr);
+    void stage_gyro_config(gyro_range range, gyro_bw bw);
+
+    /**
+     * Writes the staged configuration and publishes it to the driver state.
+     * Called with config_mutex held.
+     */
+    bool flush_config();
+
     real sensortime_to_s(uint32_t sensortime);
 
     /** Gets the difference (in s) between two sensortimes. */
     real get_delta_t(uint32_t last_sensortime, uint32_t sensortime);
 
-    bool fetch_acc_data(state &out);
-    bool fetch_gyro_data(state &out);
     bool fetch_data(state &out);
+    void update_attitude(state &out);
 
     sdk::i2c_master &i2c;
 
+    /*
+     * configuration registers, ACC_CONF to ACC_INT2_MAP and GYRO_RANGE to
+     * GYRO_INT3_INT4_IO_MAP, guarded by config_mutex
+     */
+    register_map<ACC_CONF_ADDR, ACC_INT2_MAP_ADDR - ACC_CONF_ADDR + 1>
+        acc_regs;
+    register_map<GYRO_RANGE_ADDR,
+        GYRO_INT3_INT4_IO_MAP_ADDR - GYRO_RANGE_ADDR + 1> gyro_regs;
+    mutex config_mutex { "bmi088_cfg" };
+
     state internal_state;
-    mutex state_mutex;   
+    attitude_estimator attitude;
+    timebase_sync sensortime_sync;
+    mutex state_mutex { "bmi088" };
 };
 
 } // namespace sdk
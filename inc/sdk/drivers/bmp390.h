@@ -4,9 +4,12 @@
 
 #include <sdk/i2c.h>
 #include <sdk/mutex.h>
+#include <sdk/register_map.h>
 
 namespace sdk {
 
+class baro_filter;
+
 /**
  * Class representing the driver for the BMP390 barometric altimeter.
  */
@@ -17,22 +20,46 @@ public:
 
     static constexpr int CHIP_ID_ADDR = 0x00;
     static constexpr int DATA_0_ADDR = 0x04;
+    static constexpr int PWR_CTRL_ADDR = 0x1B;
+    static constexpr int ODR_ADDR = 0x1D;
     static constexpr int CONFIG_ADDR = 0x1F;
     static constexpr int NVM_PAR_T1_ADDR = 0x31;
 
+    /* power-on to the first bus access, t_startup in the datasheet */
+    static constexpr uint32_t STARTUP_US = 2000;
+
+    /** Output data rate, see 4.3.20 */
+    enum class odr : uint8_t {
+        ODR_200HZ = 0x00,
+        ODR_100HZ = 0x01,
+        ODR_50HZ = 0x02,
+        ODR_25HZ = 0x03,
+        ODR_12_5HZ = 0x04,
+    };
+
     /* this might be too low precision */
     using real = float;
     using data_frame = uint8_t[8];
 
+    /** What the filter, if any, made of a sample, see baro_filter */
+    enum class quality : uint8_t {
+        MEASURED, /* as read */
+        REPLACED, /* an outlier, the pressure is the recent median */
+        LOCKED_OUT, /* not a measurement, the pressure is the last good one */
+    };
+
     /** Driver state */
     struct state {
         real temperature_celsius;
         real pressure_pascals;
+
+        uint64_t timestamp_us; /* sdk::clock time of the read */
+        quality sample_quality = quality::MEASURED;
     };
     
 public:
 
-    bmp390(i2c_master &i2c) : i2c(i2c)
+    bmp390(i2c_master &i2c) : i2c(i2c), regs(i2c, SLAVE_ADDRESS << 1)
     {
     }
 
@@ -40,21 +67,50 @@ public:
     bool is_connected();
 
     /**
-     * Reads the calibration data from the chip. Thread-safe blocking.
+     * Reads the calibration data from the chip. Returns false if the read
+     * failed. Thread-safe blocking.
      */
-    void read_calibration_data();
+    bool read_calibration_data();
+
+    /**
+     * Decodes the 21-byte NVM calibration block (read from NVM_PAR_T1), as
+     * `read_calibration_data` does after the bus read.
+     */
+    void set_calibration_data(const uint8_t *reg_data);
+
+    /* gets the temperature from a data frame (in degrees celsius) */
+    real compensate_temperature(data_frame frame);
+    /* gets the pressure from a data frame (in pascals) */
+    real compensate_pressure(real temperature_celsius, data_frame frame);
 
     /**
      * Updates internal driver state with new data received from the chip.
-     * Thread-safe blocking.
+     * Returns false if the read failed. Thread-safe blocking.
      */
-    void update();
+    bool update();
+
+    /**
+     * Runs every sample `update` reads through `filter` before it is
+     * published, or none if null. The filter is used from the task calling
+     * `update`.
+     */
+    void set_filter(baro_filter *filter) { this->filter = filter; }
 
     /**
      * Sets the CONFIG register with the given filter coefficient value (see
-     * 4.3.21). Thread-safe blocking.
+     * 4.3.21). Skips the write if the chip already has it. Returns false if
+     * the write failed. Thread-safe blocking.
+     */
+    bool set_config(uint8_t filter_coefficient);
+
+    /**
+     * Sets the output data rate and enables pressure and temperature in normal
+     * mode. Returns false if a write failed. Thread-safe blocking.
      */
-    void set_config(uint8_t filter_coefficient);
+    bool set_odr(odr rate);
+
+    /** Gets the configured output data rate in Hz. Thread-safe blocking. */
+    real get_odr_hz();
 
     state copy_state(); /* may thread-safe block */
 
@@ -83,16 +139,19 @@ private:
     calibration calib_data;
 
 private:
-    /* gets the temperature from a data frame (in degrees celsius) */
-    real compensate_temperature(data_frame frame);
-    /* gets the pressure from a data frame (in pascals) */
-    real compensate_pressure(real temperature_celsius, data_frame frame);
-    
     bool fetch_data(state &out);
 
     i2c_master &i2c;
-    mutex state_mutex;
+
+    /* PWR_CTRL to CONFIG, guarded by config_mutex */
+    register_map<PWR_CTRL_ADDR, CONFIG_ADDR - PWR_CTRL_ADDR + 1> regs;
+    mutex config_mutex { "bmp390_cfg" };
+
+    baro_filter *filter = nullptr;
+
+    mutex state_mutex { "bmp390" };
     state current_state;
+    odr current_odr = odr::ODR_200HZ;
 
 };
 
@@ -5,6 +5,7 @@
 #include <sdk/drivers/drv8701.h>
 #include <sdk/drivers/quad_encoder.h>
 
+#include <stdint.h>
 #include <utility>
 
 namespace sdk {
@@ -19,7 +20,8 @@ public:
         float p, float i, float d,
         drv8701 &&motor,
         quad_encoder &&encoder
-    ) : p(p), i(i), d(d), target_motor(std::move(motor)),
+    ) : target_degrees(0), p(p), i(i), d(d), integral_error(0),
+            last_error(0), target_motor(std::move(motor)),
             encoder(std::move(encoder))
     {
     }
@@ -33,6 +35,15 @@ public:
     /** Recalculates motor power. Thread-safe blocking. */
     void update_motor(float dt);
 
+    /**
+     * Recalculates motor power, taking dt from sdk::clock. The first call only
+     * records the time. Thread-safe blocking.
+     */
+    void update_motor();
+
+    /** The encoder, for forwarding its pin interrupts (see read_and_update) */
+    quad_encoder &get_encoder() { return encoder; }
+
 private:
     float target_degrees;
     float p, i, d;
@@ -40,6 +51,8 @@ private:
     float integral_error;
     float last_error;
 
+    uint64_t last_update_us = 0;
+
     drv8701 target_motor;
     quad_encoder encoder;
     
@@ -18,8 +18,8 @@ public:
         float counts_per_rev, // encoder counts per revolution of motor shaft
         unique_pin &&pin_a,
         unique_pin &&pin_b
-    ) : counts_per_rev(counts_per_rev), pin_a(std::move(pin_a)),
-            pin_b(std::move(pin_b))
+    ) : count(0), counts_per_rev(counts_per_rev), pin_a(std::move(pin_a)),
+            pin_b(std::move(pin_b)), pin_a_value(false), pin_b_value(false)
     {
     }
 
@@ -30,10 +30,20 @@ public:
     float get_revolutions();
     float get_degrees();
 
+    /**
+     * sdk::clock time (in us) of the last counted edge, 0 before the first.
+     * The edge is stamped with the raw cycle counter and unwrapped here, so
+     * an edge more than one counter wrap old (see `clock`) reads a wrap late.
+     */
+    uint64_t get_last_edge_us();
+
 private:
 
     int count;
     float counts_per_rev;
+    /* raw clock::now_cycles32 of the last counted edge, from the ISR */
+    uint32_t last_edge_cycles = 0;
+    bool edge_seen = false;
 
     unique_pin pin_a, pin_b;
     bool pin_a_value, pin_b_value;
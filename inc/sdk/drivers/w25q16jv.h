@@ -27,7 +27,7 @@ public:
      * Constructs a new `w25q16jv` class using the provided SPI interface.
      */
     explicit w25q16jv(spi &interface, unique_pin pin) : interface(interface),
-            pin(std::move(pin)), write_queue(8)
+            pin(std::move(pin))
     {
     }
 
@@ -73,8 +73,8 @@ private:
 private:
     spi &interface;
     unique_pin pin;
-    mutex state_mutex;
-    queue<write_command> write_queue;
+    mutex state_mutex { "w25q16jv" };
+    queue<write_command, 8> write_queue;
 
 };
 
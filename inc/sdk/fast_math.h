@@ -0,0 +1,299 @@
+
+#ifndef AIRBRAKES_SDK_FAST_MATH_H_
+#define AIRBRAKES_SDK_FAST_MATH_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace sdk {
+
+/**
+ * Single-precision approximations of the libm functions used in the control
+ * loop. newlib's versions are double precision and set errno, which makes
+ * them slow on a single-precision FPU.
+ *
+ * Two variants of most kernels: polynomial ones (inline, the more accurate)
+ * and table ones (`*_lut`, linear interpolation in constexpr tables kept in
+ * flash, see src/fast_math.cc). The `*_MAX_ERROR` bounds are measured against
+ * double-precision libm over each function's documented domain; the
+ * airbrakes_sdk_bench accuracy report checks them. Absolute errors turn
+ * relative where |f(x)| > 1, since no float can do better there.
+ *
+ * No errno, no exceptions. Out-of-domain inputs give the results documented
+ * per function, not necessarily what libm would return.
+ */
+namespace fast_math {
+
+constexpr float PI = 3.14159265358979f;
+constexpr float HALF_PI = 1.57079632679490f;
+
+/** absolute error of `sin`/`cos`, for |x| <= 1e4 */
+constexpr float SIN_MAX_ERROR = 2e-7f;
+/** absolute error (in rad) of `atan`/`atan2` */
+constexpr float ATAN_MAX_ERROR = 2.5e-7f;
+/** absolute error (in rad) of `acos`, x in [-1, 1] */
+constexpr float ACOS_MAX_ERROR = 5e-7f;
+/** relative error of `exp`, x in [-87, 88] */
+constexpr float EXP_MAX_REL_ERROR = 2e-7f;
+/** absolute error of `log`, normal x > 0 */
+constexpr float LOG_MAX_ERROR = 2e-7f;
+/** relative error of `inv_sqrt`, normal x > 0 */
+constexpr float INV_SQRT_MAX_REL_ERROR = 5e-6f;
+
+/** absolute error of `sin_lut`/`cos_lut`, for |x| <= 100 */
+constexpr float SIN_LUT_MAX_ERROR = 8e-5f;
+/** absolute error (in rad) of `atan2_lut` */
+constexpr float ATAN_LUT_MAX_ERROR = 2e-6f;
+/** relative error of `exp_lut`, x in [-87, 88] */
+constexpr float EXP_LUT_MAX_REL_ERROR = 2e-6f;
+/** absolute error of `log_lut`, normal x > 0 */
+constexpr float LOG_LUT_MAX_ERROR = 3e-6f;
+
+namespace detail {
+
+inline uint32_t to_bits(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+inline float from_bits(uint32_t bits)
+{
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+/* nearest integer, for range reduction; |x| < 2^31 */
+inline int32_t round_to_int(float x)
+{
+    return (int32_t) (x + (x < 0 ? -0.5f : 0.5f));
+}
+
+/* 2^n for n in [-126, 127] */
+inline float exp2_int(int32_t n)
+{
+    return from_bits((uint32_t) (n + 127) << 23);
+}
+
+/* sin and cos of r in [-pi/4, pi/4], cephes minimax coefficients */
+inline float sin_poly(float r)
+{
+    float z = r * r;
+    return ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z -
+        1.6666654611e-1f) * z * r + r;
+}
+
+inline float cos_poly(float r)
+{
+    float z = r * r;
+    return ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z +
+        4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+}
+
+/* r in [-pi/4, pi/4] and the quadrant of x; Cody-Waite reduction */
+inline float reduce_quadrant(float x, int32_t &quadrant)
+{
+    quadrant = round_to_int(x * 0.636619772f);
+    float k = (float) quadrant;
+    // pi/2 split so that k times the first two parts is exact for |k| < 2^13
+    return ((x - k * 1.5703125f) - k * 4.837512969970703125e-4f) -
+        k * 7.549789948768648e-8f;
+}
+
+/* atan of a in [0, 1] */
+inline float atan01(float a)
+{
+    // atan(a) = pi/4 + atan((a - 1) / (a + 1)) above tan(pi/8)
+    float offset = 0;
+    if (a > 0.414213562f) {
+        a = (a - 1.0f) / (a + 1.0f);
+        offset = 0.785398163f;
+    }
+    float z = a * a;
+    return offset + ((((8.05374449538e-2f * z - 1.38776856032e-1f) * z +
+        1.99777106478e-1f) * z - 3.33329491539e-1f) * z * a + a);
+}
+
+} // namespace detail
+
+/**
+ * Square root. Compiles to the FPU's square root instruction (14 cycles on
+ * the Cortex-M4F) without libm's errno handling. Negative x gives NaN.
+ */
+inline float sqrt(float x)
+{
+#if defined(__ARM_FP) && (__ARM_FP & 4)
+    float r;
+    asm("vsqrt.f32 %0, %1" : "=t"(r) : "t"(x));
+    return r;
+#elif defined(__SSE__)
+    return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(x)));
+#else
+    return __builtin_sqrtf(x);
+#endif
+}
+
+/**
+ * 1 / sqrt(x) for normal x > 0, from the exponent bit trick and two Newton
+ * steps. Multiplies only, avoiding the square root and the division.
+ */
+inline float inv_sqrt(float x)
+{
+    float y = detail::from_bits(0x5f375a86 - (detail::to_bits(x) >> 1));
+    float half_x = 0.5f * x;
+    y = y * (1.5f - half_x * y * y);
+    y = y * (1.5f - half_x * y * y);
+    return y;
+}
+
+/** sine of x (in rad), |x| <= 1e4 */
+inline float sin(float x)
+{
+    int32_t quadrant;
+    float r = detail::reduce_quadrant(x, quadrant);
+    float s = (quadrant & 1) ? detail::cos_poly(r) : detail::sin_poly(r);
+    return (quadrant & 2) ? -s : s;
+}
+
+/** cosine of x (in rad), |x| <= 1e4 */
+inline float cos(float x)
+{
+    int32_t quadrant;
+    float r = detail::reduce_quadrant(x, quadrant);
+    float c = (quadrant & 1) ? detail::sin_poly(r) : detail::cos_poly(r);
+    return ((quadrant + 1) & 2) ? -c : c;
+}
+
+/** arctangent, in [-pi/2, pi/2] */
+inline float atan(float x)
+{
+    float a = x < 0 ? -x : x;
+    float r = a > 1.0f ? HALF_PI - detail::atan01(1.0f / a) :
+        detail::atan01(a);
+    return x < 0 ? -r : r;
+}
+
+/** Angle of (x, y), in [-pi, pi]. atan2(0, 0) is 0. */
+inline float atan2(float y, float x)
+{
+    float ax = x < 0 ? -x : x;
+    float ay = y < 0 ? -y : y;
+    float hi = ax > ay ? ax : ay;
+    if (hi == 0)
+        return 0;
+    float lo = ax > ay ? ay : ax;
+
+    // angle in the first octant, then unfolded
+    float r = detail::atan01(lo / hi);
+    if (ay > ax)
+        r = HALF_PI - r;
+    if (x < 0)
+        r = PI - r;
+    return y < 0 ? -r : r;
+}
+
+/** arccosine, in [0, pi]; x is clamped to [-1, 1] */
+inline float acos(float x)
+{
+    if (x > 1.0f)
+        x = 1.0f;
+    else if (x < -1.0f)
+        x = -1.0f;
+    return atan2(sqrt((1.0f - x) * (1.0f + x)), x);
+}
+
+/** e^x for x in [-87, 88]; saturates to 0 and infinity outside */
+inline float exp(float x)
+{
+    if (x > 88.7f)
+        return detail::from_bits(0x7f800000);
+    if (x < -87.3f)
+        return 0;
+
+    // x = n ln(2) + r, |r| <= ln(2) / 2, ln(2) split for an exact n ln(2)
+    int32_t n = detail::round_to_int(x * 1.44269504f);
+    float r = x - (float) n * 0.693359375f + (float) n * 2.12194440e-4f;
+
+    float p = (((((1.9875691500e-4f * r + 1.3981999507e-3f) * r +
+        8.3334519073e-3f) * r + 4.1665795894e-2f) * r +
+        1.6666665459e-1f) * r + 5.0000001201e-1f) * r * r + r + 1.0f;
+    // 2^128 is not a float, but the result can still be
+    if (n > 127)
+        return p * 2.0f * detail::exp2_int(n - 1);
+    return p * detail::exp2_int(n);
+}
+
+/**
+ * Natural log for normal x > 0. Zero and denormals give -infinity, negative
+ * x gives NaN.
+ */
+inline float log(float x)
+{
+    uint32_t bits = detail::to_bits(x);
+    if ((bits & 0x7fffffff) < 0x00800000) // zero or denormal
+        return detail::from_bits(0xff800000);
+    if (bits >= 0x7f800000) // negative, infinity or NaN
+        return (int32_t) bits < 0 ? detail::from_bits(0x7fc00000) : x;
+
+    // x = m 2^e with m in [sqrt(2)/2, sqrt(2))
+    int32_t e = (int32_t) (bits >> 23) - 127;
+    float m = detail::from_bits((bits & 0x007fffff) | 0x3f800000);
+    if (m > 1.41421356f) {
+        m *= 0.5f;
+        e++;
+    }
+    m -= 1.0f;
+
+    float z = m * m;
+    float y = ((((((((7.0376836292e-2f * m - 1.1514610310e-1f) * m +
+        1.1676998740e-1f) * m - 1.2420140846e-1f) * m +
+        1.4249322787e-1f) * m - 1.6668057665e-1f) * m +
+        2.0000714765e-1f) * m - 2.4999993993e-1f) * m +
+        3.3333331174e-1f) * m * z;
+    float k = (float) e;
+    y -= 2.12194440e-4f * k;
+    y -= 0.5f * z;
+    return m + y + 0.693359375f * k;
+}
+
+/**
+ * base^exponent for base > 0, as exp(exponent * log(base)). The relative
+ * error grows with |exponent * log(base)|, by about 6e-8 per unit.
+ */
+inline float pow(float base, float exponent)
+{
+    return exp(exponent * log(base));
+}
+
+/** sine of x (in rad) by table, |x| <= 100 */
+float sin_lut(float x);
+
+/** cosine of x (in rad) by table, |x| <= 100 */
+float cos_lut(float x);
+
+/** Angle of (x, y) by table, in [-pi, pi]. atan2_lut(0, 0) is 0. */
+float atan2_lut(float y, float x);
+
+/** e^x by table, same domain and saturation as `exp` */
+float exp_lut(float x);
+
+/** Natural log by table, same domain and special cases as `log` */
+float log_lut(float x);
+
+/** base^exponent by table, as exp_lut(exponent * log_lut(base)) */
+inline float pow_lut(float base, float exponent)
+{
+    return exp_lut(exponent * log_lut(base));
+}
+
+} // namespace fast_math
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_FAST_MATH_H_
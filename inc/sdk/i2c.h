@@ -23,9 +23,26 @@ public:
      */
     enum class status {
         OK,
-        ERROR,
+        ERROR, /* not started or aborted, or the peripheral failed to reset */
+        NACK, /* the device did not acknowledge */
+        TIMEOUT, /* no completion within the timeout, the bus was recovered */
+        ARBITRATION_LOST, /* another master won the bus, it was recovered */
+        BUS_ERROR, /* misplaced start or stop, the bus was recovered */
     };
 
+    /** Transfer timeout when none is given, far above any register access */
+    static constexpr uint32_t DEFAULT_TIMEOUT_MS = 5;
+
+    /**
+     * Observes every completed transfer, e.g. to record a log for replay (see
+     * sdk/i2c_log.h). `issued_us` is the sdk::clock time the transfer was
+     * started. Called from the transferring task with the bus locked, so it
+     * must be quick.
+     */
+    using tap_fn = void (*)(void *ctx, uint64_t issued_us,
+            uint16_t device_address, uint16_t reg_address,
+            const uint8_t *data, uint16_t data_size, bool write);
+
 public:
 
     /** get a sdk::i2c_master object associated with a handle */
@@ -51,9 +68,13 @@ public:
      *
      * Importantly, the `device_address` is the address shifted by one bit left,
      * not the 7-bit or 10-bit address that datasheets usually list.
+     *
+     * Blocks for at most `timeout_ms` (plus a bus recovery, see
+     * `set_recovery_pins`), so a stuck device cannot stall the caller.
      */
     status read(uint16_t device_address, uint16_t reg_address, uint8_t *data,
-            uint16_t data_size, bool mem_16bit);
+            uint16_t data_size, bool mem_16bit,
+            uint32_t timeout_ms = DEFAULT_TIMEOUT_MS);
 
     /**
      * Initiates a write to a `reg_address` using the `device_address` given.
@@ -62,17 +83,78 @@ public:
      *
      * Importantly, the `device_address` is the full address, not the 7-bit
      * address that datasheets usually list.
+     *
+     * Blocks for at most `timeout_ms`, as `read`.
      */
     status write(uint16_t device_address, uint16_t reg_address, uint8_t *data,
-            uint16_t data_size, bool mem_16bit);
+            uint16_t data_size, bool mem_16bit,
+            uint32_t timeout_ms = DEFAULT_TIMEOUT_MS);
 
+    /** Completes the transfer, from HAL_I2C_Mem{Rx,Tx}CpltCallback */
     void unblock_from_isr();
 
+    /**
+     * Fails the transfer with the HAL's error code, from HAL_I2C_ErrorCallback
+     * and HAL_I2C_AbortCpltCallback.
+     */
+    void error_from_isr();
+
+    /**
+     * Sets the pins behind the peripheral's SCL and SDA. A bus recovery then
+     * also clocks SCL by hand to free a device holding SDA low, before it
+     * resets the peripheral. Without them only the peripheral is reset.
+     */
+    void set_recovery_pins(GPIO_TypeDef *scl_port, uint16_t scl_pin,
+            GPIO_TypeDef *sda_port, uint16_t sda_pin)
+    {
+        scoped_lock lock(interface_mutex);
+        this->scl_port = scl_port;
+        this->scl_pin = scl_pin;
+        this->sda_port = sda_port;
+        this->sda_pin = sda_pin;
+    }
+
+    /** Number of bus recoveries so far */
+    uint32_t get_recovery_count() const { return recovery_count; }
+
+    /** Installs a transfer tap, or removes it with nullptr. */
+    void set_tap(tap_fn fn, void *ctx)
+    {
+        scoped_lock lock(interface_mutex);
+        tap = fn;
+        tap_ctx = ctx;
+    }
+
 private:
 
+    status transfer(uint16_t device_address, uint16_t reg_address,
+            uint8_t *data, uint16_t data_size, bool mem_16bit,
+            uint32_t timeout_ms, bool read);
+
+    /* starts a transfer, recovering a bus the peripheral finds busy */
+    HAL_StatusTypeDef start(uint16_t device_address, uint16_t reg_address,
+            uint8_t *data, uint16_t data_size, bool mem_16bit, bool read);
+
+    /*
+     * frees the bus (SCL clocking and a STOP, if the pins are known) and
+     * resets the peripheral, with interface_mutex held; ERROR if the
+     * peripheral failed to initialize again, else OK
+     */
+    status recover(status cause);
+
     TaskHandle_t blocked_task;
+    volatile uint32_t transfer_error = HAL_I2C_ERROR_NONE;
+    uint32_t recovery_count = 0;
+
+    GPIO_TypeDef *scl_port = nullptr;
+    uint16_t scl_pin = 0;
+    GPIO_TypeDef *sda_port = nullptr;
+    uint16_t sda_pin = 0;
+
+    tap_fn tap = nullptr;
+    void *tap_ctx = nullptr;
     I2C_HandleTypeDef *handle;
-    mutex interface_mutex;
+    mutex interface_mutex { "i2c" };
 };
 
 } // namespace sdk
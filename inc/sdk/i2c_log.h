@@ -0,0 +1,74 @@
+
+#ifndef AIRBRAKES_SDK_I2C_LOG_H_
+#define AIRBRAKES_SDK_I2C_LOG_H_
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Raw I2C transfer log: what the drivers read from (and wrote to) the bus, with
+ * timestamps. Recorded through an `i2c_master` tap and fed back through the
+ * unchanged drivers on the host by `sim::i2c_replay`.
+ *
+ * A log is a `header` followed by fixed-size `record`s in time order, in
+ * little-endian byte order (both platforms' native order).
+ */
+
+namespace sdk {
+
+namespace i2c_log {
+
+static constexpr uint32_t MAGIC = 0x4c4b4453; /* "SDKL" */
+static constexpr uint16_t VERSION = 1;
+
+/** longest transfer kept whole; longer ones are cut and flagged */
+static constexpr int MAX_DATA = 24;
+
+static constexpr uint8_t FLAG_WRITE = 0x01;
+static constexpr uint8_t FLAG_TRUNCATED = 0x02;
+
+struct header {
+    uint32_t magic; /* MAGIC */
+    uint16_t version;
+    uint16_t record_size;
+};
+
+struct record { // 40 bytes
+    uint64_t timestamp_us; /* sdk::clock time the transfer was started */
+    uint16_t reg;
+    uint8_t address; /* 7-bit */
+    uint8_t flags;
+    uint8_t size; /* valid bytes in data */
+    uint8_t reserved[3];
+    uint8_t data[MAX_DATA];
+};
+
+inline header make_header()
+{
+    return { MAGIC, VERSION, (uint16_t) sizeof(record) };
+}
+
+/** Builds a record from the arguments of an `i2c_master::tap_fn` */
+inline record make_record(uint64_t issued_us, uint16_t device_address,
+        uint16_t reg_address, const uint8_t *data, uint16_t data_size,
+        bool write)
+{
+    record out = {};
+    out.timestamp_us = issued_us;
+    out.reg = reg_address;
+    out.address = (uint8_t) (device_address >> 1);
+    out.flags = write ? FLAG_WRITE : 0;
+    if (data_size > MAX_DATA) {
+        data_size = MAX_DATA;
+        out.flags |= FLAG_TRUNCATED;
+    }
+    out.size = (uint8_t) data_size;
+    memcpy(out.data, data, data_size);
+    return out;
+}
+
+} // namespace i2c_log
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_I2C_LOG_H_
@@ -0,0 +1,112 @@
+
+#ifndef AIRBRAKES_SDK_IMU_CALIBRATION_H_
+#define AIRBRAKES_SDK_IMU_CALIBRATION_H_
+
+#include <sdk/drivers/bmi088.h>
+
+#include <stdint.h>
+
+namespace sdk {
+
+/**
+ * Streaming mean and variance of a 3-axis signal (Welford's algorithm), stable
+ * in single precision over long windows.
+ */
+class running_stats {
+public:
+
+    using real = bmi088::real;
+    using vec3 = bmi088::vec3;
+
+public:
+
+    running_stats()
+    {
+        reset();
+    }
+
+    void reset();
+    void add(const vec3 &sample);
+
+    uint32_t count() const { return n; }
+    vec3 mean() const { return m; }
+    /** sample variance per axis, zero until two samples were added */
+    vec3 variance() const;
+
+private:
+    uint32_t n;
+    vec3 m;
+    vec3 m2; /* sum of squared deviations from the mean */
+};
+
+/**
+ * Startup zero-offset calibration for the BMI088. Collects a window of samples
+ * while the rocket sits still on the pad and derives the gyro zero-rate offset
+ * and the accelerometer offset relative to 1 g. Windows with motion are
+ * rejected and collection starts over.
+ *
+ * Offsets are applied with `bmi088::set_offsets` and can be persisted with
+ * `serialize` so later boots skip calibration.
+ */
+class imu_calibration {
+public:
+
+    using real = bmi088::real;
+
+    enum class status {
+        IN_PROGRESS,
+        DONE,
+        MOTION_DETECTED, /* window was discarded, collection restarted */
+    };
+
+    struct config {
+        uint32_t window_samples;
+        real max_gyro_rate_ds; /* per-sample motion threshold, in deg/s */
+        real max_gyro_stddev_ds; /* per-axis window threshold, in deg/s */
+        real max_acc_stddev_ms2; /* per-axis window threshold, in m/s^2 */
+    };
+
+    /** size of a serialized offsets blob, in bytes */
+    static constexpr uint32_t BLOB_SIZE = 32;
+    static constexpr uint32_t BLOB_MAGIC = 0x43554d49; /* "IMUC" */
+
+public:
+
+    explicit imu_calibration(const config &conf) : conf(conf), done(false)
+    {
+    }
+
+    /** Discards all collected samples. */
+    void reset();
+
+    /**
+     * Adds one driver sample to the window. Offsets already applied by the
+     * driver are added back, so calibration can run on a driver that has
+     * stale offsets.
+     */
+    status add_sample(const bmi088::state &sample);
+
+    /** Resulting offsets, valid once `add_sample` returned `status::DONE` */
+    bmi088::offsets get_offsets() const { return result; }
+
+    /** Writes `BLOB_SIZE` bytes into `out`: magic, offsets and a CRC-32. */
+    static void serialize(const bmi088::offsets &offsets, uint8_t *out);
+
+    /**
+     * Reads a blob written by `serialize`. Returns false if the magic or CRC do
+     * not match, e.g. for erased flash.
+     */
+    static bool deserialize(const uint8_t *in, bmi088::offsets &out);
+
+private:
+    config conf;
+
+    bool done;
+    running_stats acc_stats;
+    running_stats gyro_stats;
+    bmi088::offsets result;
+};
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_IMU_CALIBRATION_H_
@@ -0,0 +1,394 @@
+
+#ifndef AIRBRAKES_SDK_IMU_FILTER_H_
+#define AIRBRAKES_SDK_IMU_FILTER_H_
+
+#include <sdk/constexpr_math.h>
+#include <sdk/fast_math.h>
+#include <sdk/vecmath.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * Streaming anti-alias filters and decimators for IMU sample streams, to take
+ * the BMI088's 1.6-2 kHz down to what the control loop and logger run at
+ * without folding motor and airframe vibration into the band they use.
+ *
+ * - `fir_decimator`: linear-phase FIR lowpass over raw int16 samples, only
+ *   evaluated for the samples it keeps (the polyphase form of a decimator).
+ *   Q15 taps, designed at compile time by `fir_lowpass`.
+ * - `cic_decimator`: multiplier-free cascaded integrator-comb, cheap and
+ *   steep for large factors, with a sinc^N passband droop to clean up after.
+ * - `biquad_cascade`: float IIR sections (lowpass, notch) on converted
+ *   samples, e.g. after decimation or against a known motor line.
+ *
+ * All state is fixed size and inside the objects; nothing is allocated.
+ * Batches are raw `basic_vec3<int16_t>` samples as the FIFO or
+ * `state::acc_raw` hold them, one filter per sensor.
+ */
+
+namespace sdk {
+
+using raw_vec3 = basic_vec3<int16_t>;
+
+namespace detail {
+
+/*
+ * sum of x[i] * h[i] for i < n. Uses the Cortex-M4 SMLAD (two 16-bit
+ * multiply-accumulates per instruction) or SSE2 pmaddwd (eight) on the host;
+ * the results are identical everywhere.
+ */
+inline int32_t dot_q15(const int16_t *x, const int16_t *h, int n)
+{
+    int32_t acc = 0;
+    int i = 0;
+#if defined(__ARM_FEATURE_DSP)
+    for (; i + 2 <= n; i += 2) {
+        // plain word loads may be unaligned on the M4
+        uint32_t xx, hh;
+        memcpy(&xx, x + i, sizeof(xx));
+        memcpy(&hh, h + i, sizeof(hh));
+        asm("smlad %0, %1, %2, %0" : "+r"(acc) : "r"(xx), "r"(hh));
+    }
+#elif defined(__SSE2__)
+    __m128i sum = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8) {
+        __m128i xx = _mm_loadu_si128((const __m128i *) (x + i));
+        __m128i hh = _mm_loadu_si128((const __m128i *) (h + i));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(xx, hh));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+    acc = _mm_cvtsi128_si32(sum);
+#endif
+    for (; i < n; i++)
+        acc += (int32_t) x[i] * h[i];
+    return acc;
+}
+
+/* Q15 accumulator back to a sample, rounded and saturated */
+inline int16_t from_q15(int32_t acc)
+{
+    int32_t y = (acc + (1 << 14)) >> 15;
+    if (y > INT16_MAX)
+        return INT16_MAX;
+    if (y < INT16_MIN)
+        return INT16_MIN;
+    return (int16_t) y;
+}
+
+} // namespace detail
+
+/** Q15 FIR taps, h[0] applied to the newest sample */
+template<int TAPS>
+struct fir_coefficients {
+    int16_t h[TAPS];
+};
+
+/**
+ * Blackman-windowed sinc lowpass, -6 dB at `cutoff` times the input rate, in
+ * (0, 0.5); for a decimator by M, about 0.4 / M. The taps sum to
+ * exactly 1.0 (32768), so DC passes unchanged. For constant expressions only
+ * (see constexpr_math), so that the taps end up in flash.
+ */
+template<int TAPS>
+constexpr fir_coefficients<TAPS> fir_lowpass(double cutoff)
+{
+    double ideal[TAPS] = {};
+    double sum = 0;
+    for (int i = 0; i < TAPS; i++) {
+        double t = i - (TAPS - 1) / 2.0;
+        double sinc = t == 0 ? 2.0 * cutoff :
+            constexpr_math::sin(2.0 * constexpr_math::PI * cutoff * t) /
+            (constexpr_math::PI * t);
+        double phase = 2.0 * constexpr_math::PI * i / (TAPS - 1);
+        double window = 0.42 - 0.5 * constexpr_math::cos(phase) +
+            0.08 * constexpr_math::cos(2.0 * phase);
+        ideal[i] = sinc * window;
+        sum += ideal[i];
+    }
+
+    fir_coefficients<TAPS> out = {};
+    int32_t total = 0;
+    for (int i = 0; i < TAPS; i++) {
+        double q = ideal[i] / sum * 32768.0;
+        out.h[i] = (int16_t) (q < 0 ? q - 0.5 : q + 0.5);
+        total += out.h[i];
+    }
+    // rounding leftovers go to the middle tap, the largest
+    out.h[TAPS / 2] = (int16_t) (out.h[TAPS / 2] + 32768 - total);
+    return out;
+}
+
+/**
+ * Lowpass-filters and decimates a stream of raw 3-axis samples by `FACTOR`
+ * with a `TAPS`-tap FIR. Outputs are only computed for the samples kept, so
+ * the cost is TAPS multiply-accumulates per axis per output. Delay is
+ * (TAPS - 1) / 2 input samples.
+ *
+ * The absolute taps must sum to less than 2.0 (65536) so the 32-bit
+ * accumulators cannot overflow.
+ */
+template<int TAPS, int FACTOR>
+class fir_decimator {
+public:
+    static_assert(TAPS > 0 && FACTOR > 0, "bad filter size");
+
+public:
+
+    explicit fir_decimator(const fir_coefficients<TAPS> &coefficients)
+    {
+        // stored oldest-first, the order the history is in
+        for (int i = 0; i < TAPS; i++)
+            taps[i] = coefficients.h[TAPS - 1 - i];
+        reset();
+    }
+
+    /** Fills the history with `steady`, e.g. the first sample or 1 g. */
+    void reset(const raw_vec3 &steady = {})
+    {
+        for (int i = 0; i < 2 * TAPS; i++) {
+            history[0][i] = steady.x;
+            history[1][i] = steady.y;
+            history[2][i] = steady.z;
+        }
+        head = 0;
+        phase = 0;
+    }
+
+    /**
+     * Filters `count` samples, writing every `FACTOR`th output to `out`,
+     * which needs room for `count / FACTOR + 1`. Returns the number written.
+     */
+    uint32_t process(const raw_vec3 *in, uint32_t count, raw_vec3 *out)
+    {
+        uint32_t written = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            push(in[i]);
+            if (++phase < FACTOR)
+                continue;
+            phase = 0;
+            // the window, oldest first, starts where the next sample goes
+            out[written++] = {
+                detail::from_q15(detail::dot_q15(history[0] + head, taps,
+                    TAPS)),
+                detail::from_q15(detail::dot_q15(history[1] + head, taps,
+                    TAPS)),
+                detail::from_q15(detail::dot_q15(history[2] + head, taps,
+                    TAPS)),
+            };
+        }
+        return written;
+    }
+
+private:
+
+    void push(const raw_vec3 &sample)
+    {
+        // every sample is kept twice, so the window is always contiguous
+        history[0][head] = history[0][head + TAPS] = sample.x;
+        history[1][head] = history[1][head + TAPS] = sample.y;
+        history[2][head] = history[2][head + TAPS] = sample.z;
+        if (++head == TAPS)
+            head = 0;
+    }
+
+    int16_t taps[TAPS];
+    int16_t history[3][2 * TAPS];
+    int head; /* oldest sample, and where the next one goes */
+    int phase; /* samples since the last output */
+};
+
+/**
+ * Decimates a stream of raw 3-axis samples by `FACTOR` through an
+ * `ORDER`-stage cascaded integrator-comb filter: no multiplies, and a null at
+ * every multiple of the output rate, which is where aliases would land. The
+ * passband droops like sinc^ORDER, so follow with a short FIR or biquad if
+ * that matters. DC gain is normalized to 1.
+ */
+template<int ORDER, int FACTOR>
+class cic_decimator {
+public:
+    static_assert(ORDER > 0 && FACTOR > 1, "bad filter size");
+
+    static constexpr int64_t gain()
+    {
+        int64_t g = 1;
+        for (int i = 0; i < ORDER; i++)
+            g *= FACTOR;
+        return g;
+    }
+
+    static_assert(gain() <= (1 << 15),
+        "int16 samples times the gain must fit the 32-bit registers");
+
+public:
+
+    cic_decimator()
+    {
+        reset();
+    }
+
+    /** Settles the filter on `steady`, so it outputs `steady` right away. */
+    void reset(const raw_vec3 &steady = {})
+    {
+        memset(integrators, 0, sizeof(integrators));
+        memset(combs, 0, sizeof(combs));
+        phase = 0;
+        // the impulse response is shorter than ORDER * FACTOR samples
+        raw_vec3 discard[ORDER + 1];
+        for (int i = 0; i < ORDER * FACTOR; i++)
+            process(&steady, 1, discard);
+        phase = 0;
+    }
+
+    /** As `fir_decimator::process` */
+    uint32_t process(const raw_vec3 *in, uint32_t count, raw_vec3 *out)
+    {
+        uint32_t written = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            // wrapping arithmetic: the combs undo any integrator overflow
+            integrate(integrators[0], in[i].x);
+            integrate(integrators[1], in[i].y);
+            integrate(integrators[2], in[i].z);
+            if (++phase < FACTOR)
+                continue;
+            phase = 0;
+            out[written++] = {
+                comb(combs[0], integrators[0][ORDER - 1]),
+                comb(combs[1], integrators[1][ORDER - 1]),
+                comb(combs[2], integrators[2][ORDER - 1]),
+            };
+        }
+        return written;
+    }
+
+private:
+
+    static void integrate(uint32_t (&stage)[ORDER], int16_t sample)
+    {
+        uint32_t value = (uint32_t) (int32_t) sample;
+        for (int s = 0; s < ORDER; s++) {
+            stage[s] += value;
+            value = stage[s];
+        }
+    }
+
+    static int16_t comb(uint32_t (&delay)[ORDER], uint32_t value)
+    {
+        for (int s = 0; s < ORDER; s++) {
+            uint32_t previous = delay[s];
+            delay[s] = value;
+            value -= previous;
+        }
+        return (int16_t) ((int32_t) value / (int32_t) gain());
+    }
+
+    uint32_t integrators[3][ORDER];
+    uint32_t combs[3][ORDER]; /* the previous input of each comb */
+    int phase;
+};
+
+/** Normalized biquad, a0 = 1 */
+struct biquad_coefficients {
+    float b0, b1, b2;
+    float a1, a2;
+};
+
+/** Second-order lowpass (RBJ cookbook), Butterworth at the default `q` */
+inline biquad_coefficients biquad_lowpass(float sample_hz, float cutoff_hz,
+        float q = 0.70710678f)
+{
+    float w = 2.0f * fast_math::PI * cutoff_hz / sample_hz;
+    float alpha = fast_math::sin(w) / (2.0f * q);
+    float cos_w = fast_math::cos(w);
+    float a0 = 1.0f + alpha;
+    float b = (1.0f - cos_w) / (2.0f * a0);
+    return { b, 2.0f * b, b, -2.0f * cos_w / a0, (1.0f - alpha) / a0 };
+}
+
+/**
+ * Notch at `center_hz` (RBJ cookbook); the -3 dB width is about
+ * center_hz / q.
+ */
+inline biquad_coefficients biquad_notch(float sample_hz, float center_hz,
+        float q)
+{
+    float w = 2.0f * fast_math::PI * center_hz / sample_hz;
+    float alpha = fast_math::sin(w) / (2.0f * q);
+    float cos_w = fast_math::cos(w);
+    float a0 = 1.0f + alpha;
+    return {
+        1.0f / a0, -2.0f * cos_w / a0, 1.0f / a0,
+        -2.0f * cos_w / a0, (1.0f - alpha) / a0,
+    };
+}
+
+/**
+ * `SECTIONS` biquads in series over 3-axis float samples, transposed direct
+ * form II. Float, since the Cortex-M4 FPU is single precision and its SIMD
+ * is integer only.
+ */
+template<int SECTIONS>
+class biquad_cascade {
+public:
+    static_assert(SECTIONS > 0, "bad filter size");
+
+public:
+
+    explicit biquad_cascade(const biquad_coefficients (&sections)[SECTIONS])
+    {
+        for (int s = 0; s < SECTIONS; s++)
+            coefficients[s] = sections[s];
+        reset();
+    }
+
+    /** Settles every section on a constant input `steady`. */
+    void reset(const vec3 &steady = {})
+    {
+        vec3 x = steady;
+        for (int s = 0; s < SECTIONS; s++) {
+            const biquad_coefficients &c = coefficients[s];
+            // y = x * dc gain; z1 = y - b0 x, z2 = b2 x - a2 y
+            float dc = (c.b0 + c.b1 + c.b2) / (1.0f + c.a1 + c.a2);
+            vec3 y = x * dc;
+            z1[s] = y - x * c.b0;
+            z2[s] = x * c.b2 - y * c.a2;
+            x = y;
+        }
+    }
+
+    /** Filters one sample. */
+    vec3 update(const vec3 &sample)
+    {
+        vec3 x = sample;
+        for (int s = 0; s < SECTIONS; s++) {
+            const biquad_coefficients &c = coefficients[s];
+            vec3 y = x * c.b0 + z1[s];
+            z1[s] = x * c.b1 - y * c.a1 + z2[s];
+            z2[s] = x * c.b2 - y * c.a2;
+            x = y;
+        }
+        return x;
+    }
+
+    /** Filters `count` samples; `in` and `out` may be the same. */
+    void process(const vec3 *in, uint32_t count, vec3 *out)
+    {
+        for (uint32_t i = 0; i < count; i++)
+            out[i] = update(in[i]);
+    }
+
+private:
+    biquad_coefficients coefficients[SECTIONS];
+    vec3 z1[SECTIONS];
+    vec3 z2[SECTIONS];
+};
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_IMU_FILTER_H_
@@ -4,6 +4,21 @@
 
 #include <stdint.h>
 
+/*
+ * Defining SDK_MUTEX_STATS (the AIRBRAKES_SDK_MUTEX_STATS CMake option) makes
+ * every mutex record contention statistics and join a global registry that
+ * can be enumerated with `mutex::for_each`. Without it, mutexes are plain
+ * FreeRTOS mutexes and names are discarded.
+ *
+ * Defining SDK_STATIC_ALLOCATION (the AIRBRAKES_SDK_STATIC_ALLOCATION CMake
+ * option) embeds the kernel object in the mutex instead of allocating it from
+ * the FreeRTOS heap, which needs configSUPPORT_STATIC_ALLOCATION. Mutexes can
+ * then be constructed as globals with no heap at all.
+ */
+#ifdef SDK_STATIC_ALLOCATION
+#include <FreeRTOS.h>
+#endif
+
 namespace sdk {
 
 /**
@@ -18,15 +33,37 @@ public:
         ERROR,
     };
 
+    /** Contention statistics, in core clock cycles */
+    struct stats {
+        uint32_t acquisitions;
+        uint32_t contended; /* acquisitions that had to wait */
+        uint32_t timeouts; /* try_lock calls that gave up */
+        uint64_t total_wait_cycles;
+        uint32_t max_wait_cycles;
+        uint32_t max_hold_cycles;
+    };
+
 public:
 
-    mutex();
+    mutex() : mutex(nullptr)
+    {
+    }
+
+    /** `name` identifies the mutex in stats dumps; must outlive it. */
+    explicit mutex(const char *name);
+
+    ~mutex();
 
-    // Move-only semantics.
+    /*
+     * Move-only semantics. The moved-from mutex is left without a kernel
+     * object and must not be used again. With static allocation the kernel
+     * object cannot move, so a fresh one is created in place; either way
+     * neither mutex may be locked or waited on during the move.
+     */
     mutex(const mutex &) = delete;
-    mutex(mutex &&) = default;
+    mutex(mutex &&other);
     mutex &operator=(const mutex &) = delete;
-    mutex &operator=(mutex &&) = default;
+    mutex &operator=(mutex &&other);
 
     /**
      * If this mutex is unlocked, attempts to lock this mutex. Else, instead
@@ -41,7 +78,8 @@ public:
      * lock on the mutex is relieved.
      *
      * Returns status::OK if successfully locked, status::IN_USE if the mutex is
-     * unavailable.
+     * unavailable, status::ERROR if it has no kernel object (its creation
+     * failed, or it was moved from).
      */
      status try_lock(uint32_t timeout_ms);
 
@@ -59,10 +97,58 @@ public:
      */
     void *unwrap();
 
+#ifdef SDK_MUTEX_STATS
+    const char *get_name() const { return name; }
+
+    /**
+     * Returns the statistics so far. Not synchronized with the owner, so a
+     * concurrent lock may leave the copy slightly inconsistent.
+     */
+    stats get_stats() const { return counters; }
+
+    void reset_stats();
+
+    /**
+     * Calls `fn` on every live mutex, in creation order. A moved-to mutex
+     * takes the place of the one it was moved from.
+     */
+    static void for_each(void (*fn)(mutex &m, void *ctx), void *ctx);
+
+    /**
+     * Formats the stats of every mutex as a text table (times in us) into
+     * `out`, always null-terminated. Returns the length written.
+     */
+    static uint32_t format_stats(char *out, uint32_t size);
+#endif
+
 private:
 
+    /* creates the kernel object, into `storage` if statically allocated */
+    void create();
+    void destroy();
+
     void *handle;
 
+#ifdef SDK_STATIC_ALLOCATION
+    StaticSemaphore_t storage;
+#endif
+
+#ifdef SDK_MUTEX_STATS
+    /* acquisition bookkeeping, called with the mutex held */
+    void record_lock(uint32_t wait_cycles, bool contended);
+
+    void register_self();
+    void unregister_self();
+    /* puts this mutex in place of `other`, which leaves the registry */
+    void take_registry_entry(mutex &other);
+
+    const char *name;
+    stats counters;
+    uint32_t locked_at; /* cycle count when the current owner took it */
+
+    mutex *next; /* registry link */
+#endif
+
 };
 
 } // namespace sdk;
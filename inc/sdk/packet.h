@@ -0,0 +1,112 @@
+
+#ifndef AIRBRAKES_SDK_PACKET_H_
+#define AIRBRAKES_SDK_PACKET_H_
+
+#include <stdint.h>
+
+/*
+ * Packet framing for byte streams such as a telemetry downlink (see
+ * sdk/uart.h). A frame is the payload followed by its CRC-16/CCITT-FALSE
+ * (big-endian, so the CRC over the whole frame is zero), COBS-encoded so it
+ * holds no zero byte, then a single zero delimiter. A receiver that joins
+ * mid-stream or loses bytes resynchronizes at the next delimiter, and the
+ * CRC rejects frames damaged in between.
+ *
+ * The payload layout is up to the application; a leading type byte keeps
+ * room for more than one kind of packet.
+ */
+
+namespace sdk {
+
+namespace packet {
+
+static constexpr uint16_t CRC_SIZE = 2;
+
+/** largest payload a `decoder` accepts */
+static constexpr uint16_t MAX_PAYLOAD = 250;
+
+/** COBS-encoded size of `size` bytes: one code byte per 254 data bytes */
+constexpr uint16_t cobs_size(uint16_t size)
+{
+    return (uint16_t) (size + size / 254 + 1);
+}
+
+/** Size of the frame of a `payload_size` payload, delimiter included */
+constexpr uint16_t frame_size(uint16_t payload_size)
+{
+    return (uint16_t) (cobs_size(payload_size + CRC_SIZE) + 1);
+}
+
+/** CRC-16/CCITT-FALSE (poly 0x1021, init 0xffff), by table */
+uint16_t crc16(const uint8_t *data, uint32_t size, uint16_t crc = 0xffff);
+
+/**
+ * COBS-encodes `size` bytes into `out` (`cobs_size(size)` bytes, must not
+ * overlap `data`). No delimiter is appended. Returns the encoded size.
+ */
+uint16_t cobs_encode(const uint8_t *data, uint16_t size, uint8_t *out);
+
+/**
+ * Decodes `size` COBS bytes (without delimiter) into `out`, which may be
+ * `data` itself. Returns the decoded size, or -1 if the input is not valid
+ * COBS.
+ */
+int32_t cobs_decode(const uint8_t *data, uint16_t size, uint8_t *out);
+
+/**
+ * Builds the frame of a payload into `out` (`frame_size(size)` bytes, must
+ * not overlap `payload`). Returns the frame size.
+ */
+uint16_t encode(const void *payload, uint16_t size, uint8_t *out);
+
+/**
+ * Reassembles frames from a received byte stream, fed in chunks of any size,
+ * and hands each intact payload to a callback. Frames that are too long,
+ * malformed or fail the CRC are counted and dropped.
+ */
+class decoder {
+public:
+
+    /** Called with each payload, from `feed` */
+    using packet_fn = void (*)(const uint8_t *payload, uint16_t size,
+        void *ctx);
+
+    struct stats {
+        uint32_t packets;
+        uint32_t crc_errors;
+        uint32_t framing_errors; /* bad COBS, or frames too short or long */
+    };
+
+public:
+
+    decoder(packet_fn fn, void *ctx) : fn(fn), ctx(ctx)
+    {
+    }
+
+    /** Decodes `size` more bytes of the stream. */
+    void feed(const uint8_t *data, uint32_t size);
+
+    const stats &get_stats() const { return counts; }
+
+private:
+
+    void end_frame();
+
+    packet_fn fn;
+    void *ctx;
+
+    uint8_t buffer[MAX_PAYLOAD + CRC_SIZE];
+    uint16_t length = 0;
+    uint8_t block_left = 0; /* data bytes until the next code byte */
+    bool zero_pending = false; /* the last block implies a zero */
+    bool in_frame = false;
+    bool overflow = false; /* dropping until the delimiter */
+
+    stats counts = {};
+};
+
+} // namespace packet
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_PACKET_H_
@@ -5,12 +5,44 @@
 #include <FreeRTOS.h>
 #include <queue.h>
 
+#include <sdk/trace.h>
+
 namespace sdk {
 
+namespace detail {
+
+/* kernel object and item storage embedded in a statically allocated queue */
+template<typename T, UBaseType_t N>
+struct queue_storage {
+    static constexpr bool IS_STATIC = true;
+
+    StaticQueue_t control;
+    uint8_t items[N * sizeof(T)];
+
+    QueueHandle_t create()
+    {
+        return xQueueCreateStatic(N, sizeof(T), items, &control);
+    }
+};
+
+template<typename T>
+struct queue_storage<T, 0> {
+    static constexpr bool IS_STATIC = false;
+
+    QueueHandle_t create() { return nullptr; }
+};
+
+} // namespace detail
+
 /**
  * A class representing a thread-safe queue object.
+ *
+ * With `N` = 0 the length is given at construction and the queue is allocated
+ * from the FreeRTOS heap. With `N` > 0 the kernel object and space for `N`
+ * items are embedded in the queue itself: nothing is allocated, and the queue
+ * can be constructed as a global. That needs configSUPPORT_STATIC_ALLOCATION.
  */
-template<typename T>
+template<typename T, UBaseType_t N = 0>
 class queue {
 public:
 
@@ -20,91 +52,283 @@ public:
 
         // failure conditions
         FULL = 1,
-        EMPTY = 1
+        EMPTY = 2,
+        ERROR = 3, /* the queue is not valid, see `is_valid` */
     };
 public:
 
+    /** Instantiates a statically allocated queue with space for `N` items. */
+    queue()
+    {
+        static_assert(N > 0, "heap-allocated queues need a length");
+        handle = storage.create();
+    }
+
     /**
      * Instantiates a `queue` object with space for `length` objects of
-     * `sizeof(T)`.
+     * `sizeof(T)`, allocated from the FreeRTOS heap. If the heap is exhausted
+     * the queue is not valid (see `is_valid`) and every operation fails.
      */
     explicit queue(UBaseType_t length)
     {
+        static_assert(N == 0, "statically allocated queues have length N");
         handle = xQueueCreate(length, sizeof(T));
     }
 
+    ~queue()
+    {
+        destroy();
+    }
+
+    /*
+     * Move-only semantics. The moved-from queue is left invalid. A statically
+     * allocated kernel object cannot move, so a fresh one is created in place
+     * and the queued items are copied over; either way no task may be
+     * blocked on either queue during the move.
+     */
+    queue(const queue &) = delete;
+    queue &operator=(const queue &) = delete;
+
+    queue(queue &&other)
+    {
+        take(other);
+    }
+
+    queue &operator=(queue &&other)
+    {
+        if (this != &other) {
+            destroy();
+            take(other);
+        }
+        return *this;
+    }
+
+    /** Returns false if the queue has no kernel object. */
+    bool is_valid() const
+    {
+        return handle != nullptr;
+    }
+
     /**
      * Attempts to push the given value to the back of the queue, or blocks the
      * thread up to `timeout_ms` if the queue is full. Returns `status::OK` if
-     * the value was sent, else `status::FULL`.
+     * the value was sent, else `status::FULL` (or `status::ERROR`).
      */
-    status try_push_back(T &val, uint32_t timeout_ms)
+    status try_push_back(const T &val, uint32_t timeout_ms)
     {
-        return xQueueSendToBack(handle, &val, pdMS_TO_TICKS(timeout_ms)) ==
-            pdPASS ? status::OK : status::FULL;
+        if (handle == nullptr)
+            return status::ERROR;
+        SDK_TRACE_BEGIN(QUEUE_PUSH, (uintptr_t) handle);
+        BaseType_t sent = xQueueSendToBack(handle, &val,
+            pdMS_TO_TICKS(timeout_ms));
+        SDK_TRACE_END(QUEUE_PUSH, sent);
+        return sent == pdPASS ? status::OK : status::FULL;
     }
 
     /**
      * Attempts to push the given value to the front of the queue, or blocks the
      * thread up to `timeout_ms` if the queue is full. Returns `status::OK` if
-     * the value was sent, else `status::FULL`.
+     * the value was sent, else `status::FULL` (or `status::ERROR`).
      */
-    status try_push_front(T &val, uint32_t timeout_ms)
+    status try_push_front(const T &val, uint32_t timeout_ms)
     {
-        return xQueueSendToFront(handle, &val, pdMS_TO_TICKS(timeout_ms)) ==
-            pdPASS ? status::OK : status::FULL;
+        if (handle == nullptr)
+            return status::ERROR;
+        SDK_TRACE_BEGIN(QUEUE_PUSH, (uintptr_t) handle);
+        BaseType_t sent = xQueueSendToFront(handle, &val,
+            pdMS_TO_TICKS(timeout_ms));
+        SDK_TRACE_END(QUEUE_PUSH, sent);
+        return sent == pdPASS ? status::OK : status::FULL;
     }
 
     /**
      * Pushes the given value to the back of the queue, or blocks the current
-     * thread indefinitely until space is available.
+     * thread indefinitely until space is available. Does nothing if the queue
+     * is not valid.
      */
-    void push_back(T &val)
+    void push_back(const T &val)
     {
+        if (handle == nullptr)
+            return;
+        SDK_TRACE_BEGIN(QUEUE_PUSH, (uintptr_t) handle);
         xQueueSendToBack(handle, &val, portMAX_DELAY);
+        SDK_TRACE_END(QUEUE_PUSH, pdPASS);
     }
 
     /**
      * Pushes the given value to the front of the queue, or blocks the current
-     * thread indefinitely until space is available.
+     * thread indefinitely until space is available. Does nothing if the queue
+     * is not valid.
      */
-    void push_front(T &val)
+    void push_front(const T &val)
     {
+        if (handle == nullptr)
+            return;
+        SDK_TRACE_BEGIN(QUEUE_PUSH, (uintptr_t) handle);
         xQueueSendToFront(handle, &val, portMAX_DELAY);
+        SDK_TRACE_END(QUEUE_PUSH, pdPASS);
     }
 
     /**
      * Attempts to pop (receive) the value at the front of the queue, or blocks
      * the current thread up to `timeout_ms` if the queue is empty. Returns
-     * `status::OK` if a value was received, else returns `status::EMPTY`.
+     * `status::OK` if a value was received, else returns `status::EMPTY` (or
+     * `status::ERROR`).
      */
     status try_pop(T *val, uint32_t timeout_ms)
     {
-        return xQueueReceive(handle, (void *) val, pdMS_TO_TICKS(timeout_ms));
+        if (handle == nullptr)
+            return status::ERROR;
+        SDK_TRACE_BEGIN(QUEUE_POP, (uintptr_t) handle);
+        BaseType_t received = xQueueReceive(handle, (void *) val,
+            pdMS_TO_TICKS(timeout_ms));
+        SDK_TRACE_END(QUEUE_POP, received);
+        return received == pdPASS ? status::OK : status::EMPTY;
     }
 
     /**
      * Pops (receives) the value at the front of the queue, or blocks
-     * indefinitely until there is a value to pop.
+     * indefinitely until there is a value to pop. Returns a value-initialized
+     * `T` at once if the queue is not valid.
      */
     T pop()
     {
+        if (handle == nullptr)
+            return T();
         T out;
+        SDK_TRACE_BEGIN(QUEUE_POP, (uintptr_t) handle);
         xQueueReceive(handle, (void *) &out, portMAX_DELAY);
+        SDK_TRACE_END(QUEUE_POP, pdPASS);
         return out;
     }
 
+    /**
+     * Pushes the given value to the back of the queue from an ISR, never
+     * blocking. Sets `*woken` to pdTRUE if a higher-priority task was
+     * unblocked, and leaves it alone otherwise, so one flag can collect
+     * several pushes; the ISR should end with `portYIELD_FROM_ISR(*woken)`.
+     * Returns `status::OK` or `status::FULL` (or `status::ERROR`).
+     */
+    status push_back_from_isr(const T &val, BaseType_t *woken)
+    {
+        if (handle == nullptr)
+            return status::ERROR;
+        BaseType_t task_woken = pdFALSE;
+        BaseType_t sent = xQueueSendToBackFromISR(handle, &val, &task_woken);
+        if (task_woken == pdTRUE)
+            *woken = pdTRUE;
+        SDK_TRACE_INSTANT(QUEUE_PUSH, (uintptr_t) handle);
+        return sent == pdPASS ? status::OK : status::FULL;
+    }
+
+    /**
+     * Pops up to `max` values into `out`, waiting up to `timeout_ms` for the
+     * first one and taking the rest only if already queued. Returns the number
+     * of values popped. A convenience, not a fast path: each value costs a
+     * kernel receive, as with `try_pop`.
+     */
+    uint32_t pop_n(T *out, uint32_t max, uint32_t timeout_ms)
+    {
+        if (handle == nullptr || max == 0)
+            return 0;
+        SDK_TRACE_BEGIN(QUEUE_POP, (uintptr_t) handle);
+        uint32_t count = 0;
+        if (xQueueReceive(handle, (void *) out, pdMS_TO_TICKS(timeout_ms)) ==
+                pdPASS) {
+            count = 1 + receive_queued(out + 1, max - 1);
+        }
+        SDK_TRACE_END(QUEUE_POP, count);
+        return count;
+    }
+
+    /**
+     * Pops every queued value, up to `max`, into `out` without blocking.
+     * Returns the number of values popped. Costs one kernel receive per value,
+     * like `pop_n`.
+     */
+    uint32_t drain(T *out, uint32_t max)
+    {
+        if (handle == nullptr)
+            return 0;
+        SDK_TRACE_BEGIN(QUEUE_POP, (uintptr_t) handle);
+        uint32_t count = receive_queued(out, max);
+        SDK_TRACE_END(QUEUE_POP, count);
+        return count;
+    }
+
+    /**
+     * Copies the value at the front of the queue without removing it, waiting
+     * up to `timeout_ms` for one. Returns `status::OK` if a value was copied,
+     * else `status::EMPTY` (or `status::ERROR`).
+     */
+    status try_peek(T *val, uint32_t timeout_ms)
+    {
+        if (handle == nullptr)
+            return status::ERROR;
+        return xQueuePeek(handle, (void *) val, pdMS_TO_TICKS(timeout_ms)) ==
+            pdPASS ? status::OK : status::EMPTY;
+    }
+
+    /** Number of queued values. Never blocks; not callable from ISRs. */
+    uint32_t size()
+    {
+        return handle != nullptr ? uxQueueMessagesWaiting(handle) : 0;
+    }
+
+    /** Number of queued values, from an ISR. */
+    uint32_t size_from_isr()
+    {
+        return handle != nullptr ? uxQueueMessagesWaitingFromISR(handle) : 0;
+    }
+
     /**
      * Returns true if the queue is empty, else returns false.
      */
     bool is_empty()
     {
-        return uxQueueMessagesWaiting(handle) == 0;
+        return size() == 0;
     }
     
 private:
-    QueueHandle_t handle;
 
+    void destroy()
+    {
+        if (handle != nullptr)
+            vQueueDelete(handle);
+        handle = nullptr;
+    }
+
+    /*
+     * FreeRTOS has no multi-item receive, and its API may not be called inside
+     * a critical section, so this is one zero-timeout receive per item
+     */
+    uint32_t receive_queued(T *out, uint32_t max)
+    {
+        uint32_t count = 0;
+        while (count < max && xQueueReceive(handle, (void *) &out[count], 0) ==
+                pdPASS)
+            count++;
+        return count;
+    }
+
+    void take(queue &other)
+    {
+        if (!storage.IS_STATIC) {
+            handle = other.handle;
+            other.handle = nullptr;
+            return;
+        }
+
+        handle = storage.create();
+        T item;
+        while (other.handle != nullptr &&
+                xQueueReceive(other.handle, &item, 0) == pdPASS)
+            xQueueSendToBack(handle, &item, 0);
+        other.destroy();
+    }
+
+    QueueHandle_t handle;
+    detail::queue_storage<T, N> storage;
 };
 
 } // namespace sdk
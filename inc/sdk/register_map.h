@@ -0,0 +1,179 @@
+
+#ifndef AIRBRAKES_SDK_REGISTER_MAP_H_
+#define AIRBRAKES_SDK_REGISTER_MAP_H_
+
+#include <stdint.h>
+
+#include <sdk/i2c.h>
+
+namespace sdk {
+
+/**
+ * A shadow copy of the `COUNT` 8-bit registers of an I2C device starting at
+ * `FIRST`, for configuration registers that the device does not change by
+ * itself.
+ *
+ * Writes are staged in the shadow and only marked dirty when they differ from
+ * what the device is known to hold, so redundant writes cost nothing and
+ * read-modify-writes need no bus read. `flush` then writes each run of
+ * contiguous dirty registers in one burst, in ascending address order; flush
+ * in between if the device needs a particular order.
+ *
+ * Registers start unknown: the first `set` always writes, unless the value
+ * was `load`ed or `assume`d. Not thread-safe, the owning driver serializes
+ * access.
+ */
+template<uint8_t FIRST, uint8_t COUNT>
+class register_map {
+public:
+    static_assert(COUNT > 0 && FIRST + COUNT <= 0x100,
+        "registers must be in [0, 0xff]");
+
+public:
+
+    /** `device_address` is as passed to `i2c_master::write` */
+    register_map(i2c_master &i2c, uint16_t device_address) : i2c(i2c),
+            device_address(device_address)
+    {
+    }
+
+    /** Gets the staged (or else last known) value of `reg`. */
+    uint8_t get(uint8_t reg) const
+    {
+        return shadow[reg - FIRST];
+    }
+
+    /** Gets if the device is known to hold `get(reg)`. */
+    bool is_known(uint8_t reg) const
+    {
+        int i = reg - FIRST;
+        return test(known, i) && !test(pending, i);
+    }
+
+    /** Stages `value` for `reg`. No bus access. */
+    void set(uint8_t reg, uint8_t value)
+    {
+        int i = reg - FIRST;
+        shadow[i] = value;
+        assign(pending, i, !test(known, i) || device[i] != value);
+    }
+
+    /**
+     * Stages the bits of `value` selected by `mask`, keeping the others from
+     * the shadow. No bus access.
+     */
+    void update_bits(uint8_t reg, uint8_t mask, uint8_t value)
+    {
+        set(reg, (uint8_t) ((get(reg) & ~mask) | (value & mask)));
+    }
+
+    /**
+     * Records that the device holds `value` in `reg`, e.g. its reset value
+     * after a soft reset, discarding a staged write. No bus access.
+     */
+    void assume(uint8_t reg, uint8_t value)
+    {
+        int i = reg - FIRST;
+        shadow[i] = device[i] = value;
+        assign(known, i, true);
+        assign(pending, i, false);
+    }
+
+    /**
+     * Reads `count` registers from `reg` into the shadow in one transfer,
+     * discarding staged writes to them.
+     */
+    i2c_master::status load(uint8_t reg, uint8_t count)
+    {
+        int first = reg - FIRST;
+        auto status = i2c.read(device_address, reg, device + first, count,
+            false);
+        for (int i = first; i < first + count; i++) {
+            assign(known, i, status == i2c_master::status::OK);
+            assign(pending, i, false);
+            shadow[i] = device[i];
+        }
+        return status;
+    }
+
+    /**
+     * Forgets what the device holds, e.g. after a reset or a bus error. Staged
+     * writes are kept and the next `set` of each register writes it.
+     */
+    void invalidate()
+    {
+        for (int w = 0; w < WORDS; w++)
+            known[w] = 0;
+    }
+
+    /** Gets if there are staged writes for `flush`. */
+    bool is_dirty() const
+    {
+        for (int w = 0; w < WORDS; w++) {
+            if (pending[w])
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * Writes the staged registers, one burst per contiguous run. Stops at the
+     * first failed burst: its registers turn unknown and, like the ones after
+     * it, stay staged for the next `flush`.
+     */
+    i2c_master::status flush()
+    {
+        int i = 0;
+        while (i < COUNT) {
+            if (!test(pending, i)) {
+                i++;
+                continue;
+            }
+            int end = i + 1;
+            while (end < COUNT && test(pending, end))
+                end++;
+
+            auto status = i2c.write(device_address, FIRST + i, shadow + i,
+                end - i, false);
+            for (int r = i; r < end; r++) {
+                bool ok = status == i2c_master::status::OK;
+                if (ok)
+                    device[r] = shadow[r];
+                assign(known, r, ok);
+                assign(pending, r, !ok);
+            }
+            if (status != i2c_master::status::OK)
+                return status;
+            i = end;
+        }
+        return i2c_master::status::OK;
+    }
+
+private:
+    static constexpr int WORDS = (COUNT + 31) / 32;
+
+    static bool test(const uint32_t *bits, int i)
+    {
+        return bits[i / 32] & (1u << (i % 32));
+    }
+
+    static void assign(uint32_t *bits, int i, bool value)
+    {
+        if (value)
+            bits[i / 32] |= 1u << (i % 32);
+        else
+            bits[i / 32] &= ~(1u << (i % 32));
+    }
+
+    i2c_master &i2c;
+    uint16_t device_address;
+
+    uint8_t shadow[COUNT] = {}; /* staged values */
+    uint8_t device[COUNT] = {}; /* what the device holds, where known */
+    uint32_t known[WORDS] = {};
+    uint32_t pending[WORDS] = {};
+};
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_REGISTER_MAP_H_
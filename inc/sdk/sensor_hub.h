@@ -0,0 +1,149 @@
+
+#ifndef AIRBRAKES_SDK_SENSOR_HUB_H_
+#define AIRBRAKES_SDK_SENSOR_HUB_H_
+
+#include <sdk/clock.h>
+#include <sdk/drivers/bmi088.h>
+#include <sdk/drivers/bmp390.h>
+
+#include <stdint.h>
+
+namespace sdk {
+
+/**
+ * Polls each registered sensor at its configured output data rate from a
+ * single bus-owning task, using a static rate-monotonic schedule: sensors with
+ * shorter periods always run first within a step. All reads that are due are
+ * issued back to back, then fanned out to subscribers.
+ *
+ * Everything is sized at compile time; nothing is allocated.
+ */
+class sensor_hub {
+public:
+
+    static constexpr int MAX_SENSORS = 4;
+    static constexpr int MAX_SUBSCRIBERS = 4; /* per sensor */
+
+    /** reads one sample into the driver, returns false on a bus error */
+    using read_fn = bool (*)(void *ctx);
+    /** the sensor's current period in us, e.g. from its configured ODR */
+    using period_fn = uint32_t (*)(void *ctx);
+    /** called after every successful read of a sensor */
+    using notify_fn = void (*)(void *ctx);
+    /** time source, in us */
+    using now_fn = uint64_t (*)();
+
+    struct sensor_stats {
+        const char *name;
+        uint32_t period_us;
+
+        uint32_t reads;
+        uint32_t failures;
+        uint32_t overruns; /* releases skipped because the hub fell behind */
+
+        uint64_t last_read_us; /* time of the last successful read */
+        uint32_t max_read_us; /* longest read, in us */
+        uint64_t busy_us; /* total time spent reading */
+    };
+
+public:
+
+    explicit sensor_hub(now_fn now = clock::now_us) : now(now), count(0),
+            started(false), start_us(0), busy_us(0)
+    {
+    }
+
+    /**
+     * Registers a sensor read at `period_us`. Returns the sensor id, or -1 if
+     * the hub is full. Must be called before `run`/`step`.
+     */
+    int add(const char *name, uint32_t period_us, read_fn read, void *ctx);
+
+    /**
+     * Registers a sensor whose period `period(ctx)` gives. It is asked again
+     * after every read, so a change of the sensor's rate takes effect from
+     * its next release; a period of 0 keeps the previous one.
+     */
+    int add(const char *name, period_fn period, read_fn read, void *ctx);
+
+    /**
+     * Registers a BMI088 at the rate from `bmi088::get_odr_hz`, following
+     * later ODR and sync mode changes
+     */
+    int add(bmi088 &imu);
+
+    /** Registers a BMP390 at the rate from `bmp390::get_odr_hz`, as above */
+    int add(bmp390 &baro);
+
+    /**
+     * Changes a sensor's period, from its next release on. Not for sensors
+     * registered with a `period_fn`, which overrides it.
+     */
+    void set_period(int sensor_id, uint32_t period_us);
+
+    /** Adds a subscriber to a sensor. Returns false if it is full. */
+    bool subscribe(int sensor_id, notify_fn notify, void *ctx);
+
+    /**
+     * Runs every read that is due at `now_us`, in rate-monotonic order.
+     * Returns the time of the next release. Meant to be driven by `run`, or
+     * directly with simulated time.
+     */
+    uint64_t step(uint64_t now_us);
+
+    /**
+     * Steps forever, sleeping until the next release; see
+     * `clock::sleep_until_us` for how close to it. Never returns.
+     */
+    void run();
+
+    /** Stats for one sensor */
+    const sensor_stats &get_stats(int sensor_id) const
+    {
+        return entries[sensor_id].stats;
+    }
+
+    /** Age (in us) of the newest sample of a sensor at `now_us` */
+    uint64_t get_age_us(int sensor_id, uint64_t now_us) const;
+
+    /** Fraction of time spent in reads since the first step, [0,1] */
+    float get_bus_load(uint64_t now_us) const;
+
+    int get_count() const { return count; }
+
+private:
+
+    struct subscriber {
+        notify_fn notify;
+        void *ctx;
+    };
+
+    struct entry {
+        read_fn read;
+        period_fn period; /* null for a fixed period */
+        void *ctx;
+        uint64_t next_release_us;
+
+        subscriber subscribers[MAX_SUBSCRIBERS];
+        int subscriber_count;
+
+        sensor_stats stats;
+    };
+
+    /* rebuilds `order` after a period changed */
+    void sort_order();
+
+    now_fn now;
+
+    entry entries[MAX_SENSORS]; /* indexed by sensor id */
+    int order[MAX_SENSORS]; /* sensor ids by period, shortest first */
+    int count;
+
+    bool started;
+    uint64_t start_us;
+    uint64_t busy_us;
+};
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_SENSOR_HUB_H_
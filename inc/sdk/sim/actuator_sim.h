@@ -0,0 +1,92 @@
+
+#ifndef AIRBRAKES_SDK_SIM_ACTUATOR_SIM_H_
+#define AIRBRAKES_SDK_SIM_ACTUATOR_SIM_H_
+
+#include <sdk/sim/flight.h>
+#include <sdk/sim/hal.h>
+
+#include <stdint.h>
+
+namespace sdk {
+
+namespace sim {
+
+/**
+ * The airbrake actuator as the SDK sees it: a DRV8701 H-bridge read from its
+ * two PWM inputs and nSLEEP, a brushed motor with a first-order speed
+ * response, a gearbox onto the brakes with hard stops at both ends, and a
+ * quadrature encoder on the motor shaft driving two input pins.
+ *
+ * Pushes the brake deployment into a `flight` as it moves. Steps itself on
+ * the sim kernel once `start`ed, until the flight lands.
+ */
+class actuator_sim {
+public:
+
+    using real = double;
+
+    struct config {
+        real counts_per_rev; /* encoder counts per motor revolution */
+        real max_speed_rps; /* motor no-load speed at full power */
+        real time_constant_s; /* motor speed response */
+        real gear_ratio; /* motor revolutions per brake revolution */
+        real step_s;
+    };
+
+    struct wiring {
+        TIM_HandleTypeDef *in1_tim;
+        uint32_t in1_channel;
+        TIM_HandleTypeDef *in2_tim;
+        uint32_t in2_channel;
+        GPIO_TypeDef *nsleep_port;
+        uint16_t nsleep_pin;
+
+        GPIO_TypeDef *enc_a_port;
+        uint16_t enc_a_pin;
+        GPIO_TypeDef *enc_b_port;
+        uint16_t enc_b_pin;
+    };
+
+    static constexpr config DEFAULT_CONFIG = { 48.0, 100.0, 0.02, 50.0, 50e-6 };
+
+public:
+
+    actuator_sim(flight &target, const config &conf, const wiring &pins);
+
+    /** Starts stepping on the sim kernel every `step_s`. */
+    void start();
+
+    /** Advances the motor by `dt` seconds, emitting encoder edges. */
+    void step(real dt);
+
+    /** Motor shaft angle, in degrees from fully retracted */
+    real get_shaft_deg() const { return shaft_deg; }
+    real get_speed_rps() const { return speed_rps; }
+
+    /** Signed encoder count, as a perfect quad_encoder would read it */
+    int32_t get_count() const { return count; }
+
+private:
+    static void on_step(void *ctx);
+
+    /* bridge output [-1,1] from the driver inputs */
+    real bridge_power() const;
+
+    /* moves the encoder one count in `direction`, driving the pins */
+    void emit_edge(int direction);
+
+    flight &target;
+    config conf;
+    wiring pins;
+
+    real shaft_deg;
+    real max_shaft_deg;
+    real speed_rps;
+    int32_t count;
+};
+
+} // namespace sim
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_SIM_ACTUATOR_SIM_H_
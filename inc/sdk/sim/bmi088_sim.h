@@ -0,0 +1,103 @@
+
+#ifndef AIRBRAKES_SDK_SIM_BMI088_SIM_H_
+#define AIRBRAKES_SDK_SIM_BMI088_SIM_H_
+
+#include <sdk/sim/flight.h>
+#include <sdk/sim/hal.h>
+#include <sdk/sim/rng.h>
+
+#include <stdint.h>
+
+namespace sdk {
+
+namespace sim {
+
+/**
+ * Register-level BMI088 (accel at 0x18, gyro at 0x68) reading the specific
+ * force of a `flight` along one body axis, plus white noise and a constant
+ * gyro bias. Models chip ids, range and ODR registers, the 24-bit sensortime
+ * and the feature config window used by data sync. The accel starts out
+ * suspended and the data registers of either sensor do not update until it
+ * has been started and its start-up time has passed.
+ *
+ * Without data sync, each sensor samples when its data LSB is read. With
+ * data sync on (a non-zero sync word in a loaded feature config), both
+ * sample together once per gyro ODR period, so every read within a period
+ * returns the same pair. Sensortime is the free-running counter either way.
+ */
+class bmi088_sim {
+public:
+
+    struct config {
+        int vertical_axis; /* body axis along the flight, 0..2 = x..z */
+        double acc_noise_ms2; /* 1-sigma */
+        double gyro_noise_ds; /* 1-sigma */
+        double gyro_bias_ds; /* on every axis */
+        uint64_t seed;
+    };
+
+    static constexpr config DEFAULT_CONFIG = { 2, 0.05, 0.1, 0.3, 1 };
+
+public:
+
+    bmi088_sim(const flight &source, const config &conf);
+
+    /** Attaches both halves to a bus at their default addresses. */
+    void attach(I2C_HandleTypeDef *bus);
+
+private:
+
+    class acc_port : public i2c_device {
+    public:
+        explicit acc_port(bmi088_sim &owner) : owner(owner) {}
+        bool read(uint16_t reg, uint8_t *data, uint16_t size) override;
+        bool write(uint16_t reg, const uint8_t *data, uint16_t size) override;
+    private:
+        bmi088_sim &owner;
+    };
+
+    class gyro_port : public i2c_device {
+    public:
+        explicit gyro_port(bmi088_sim &owner) : owner(owner) {}
+        bool read(uint16_t reg, uint8_t *data, uint16_t size) override;
+        bool write(uint16_t reg, const uint8_t *data, uint16_t size) override;
+    private:
+        bmi088_sim &owner;
+    };
+
+    /* latches a new data sample into the data registers */
+    void sample_acc();
+    void sample_gyro();
+    /* in data sync, latches both once per gyro period; false if not synced */
+    bool sample_synced();
+    /* copies the running sensortime counter into its registers */
+    void latch_sensortime();
+
+    const flight &source;
+    config conf;
+    rng noise;
+
+    acc_port acc;
+    gyro_port gyro;
+
+    uint8_t acc_regs[128];
+    uint8_t gyro_regs[64];
+
+    /* kernel time from which samples update, UINT64_MAX while suspended */
+    uint64_t acc_ready_ns;
+    uint64_t gyro_ready_ns;
+    /* gyro period last latched in data sync, UINT64_MAX if none */
+    uint64_t sync_period_index;
+
+    uint8_t feature_config[8192];
+    uint16_t feature_address; /* in bytes */
+    uint32_t feature_size;
+    /* behind the feature window once the config has initialized */
+    uint8_t features[16];
+};
+
+} // namespace sim
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_SIM_BMI088_SIM_H_
@@ -0,0 +1,68 @@
+
+#ifndef AIRBRAKES_SDK_SIM_BMP390_SIM_H_
+#define AIRBRAKES_SDK_SIM_BMP390_SIM_H_
+
+#include <sdk/sim/flight.h>
+#include <sdk/sim/hal.h>
+#include <sdk/sim/rng.h>
+
+#include <stdint.h>
+
+namespace sdk {
+
+namespace sim {
+
+/**
+ * Register-level BMP390 at 0x76 reporting the ISA pressure and temperature at
+ * the altitude of a `flight`. Raw ADC values are found by inverting the
+ * datasheet compensation for a fixed set of calibration coefficients, so the
+ * driver's own compensation is exercised end to end. NACKs everything until
+ * its start-up time after power-on (simulated time 0) has passed.
+ */
+class bmp390_sim : public i2c_device {
+public:
+
+    struct config {
+        double pressure_noise_pa; /* 1-sigma */
+        double temperature_offset_c; /* electronics bay above ambient */
+        uint64_t seed;
+    };
+
+    static constexpr config DEFAULT_CONFIG = { 2.0, 5.0, 2 };
+
+public:
+
+    bmp390_sim(const flight &source, const config &conf);
+
+    void attach(I2C_HandleTypeDef *bus);
+
+    bool read(uint16_t reg, uint8_t *data, uint16_t size) override;
+    bool write(uint16_t reg, const uint8_t *data, uint16_t size) override;
+
+    /* datasheet compensation in double, for a raw reading */
+    double compensate_temperature(uint32_t raw) const;
+    double compensate_pressure(double temperature_c, uint32_t raw) const;
+
+private:
+
+    struct calibration {
+        double t1, t2, t3;
+        double p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11;
+    };
+
+    /* latches a new conversion into the data registers */
+    void sample();
+
+    const flight &source;
+    config conf;
+    rng noise;
+
+    calibration calib;
+    uint8_t regs[128];
+};
+
+} // namespace sim
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_SIM_BMP390_SIM_H_
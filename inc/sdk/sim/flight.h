@@ -0,0 +1,116 @@
+
+#ifndef AIRBRAKES_SDK_SIM_FLIGHT_H_
+#define AIRBRAKES_SDK_SIM_FLIGHT_H_
+
+#include <stdint.h>
+
+namespace sdk {
+
+namespace sim {
+
+/**
+ * Vertical-only rocket flight used as ground truth by the simulated devices:
+ * thrust with a linear propellant burn, gravity, and drag from the body plus
+ * the airbrakes at their current deployment. Descent under a parachute is a
+ * constant sink rate.
+ *
+ * Steps itself on the sim kernel once `start`ed. Host only, so it runs in
+ * double precision.
+ */
+class flight {
+public:
+
+    using real = double;
+
+    static constexpr real GRAVITY_EARTH = 9.80665; /* m/s^2 */
+
+    struct config {
+        real dry_mass_kg; /* mass after burnout */
+        real propellant_mass_kg;
+        real thrust_n; /* average motor thrust */
+        real burn_time_s;
+        real launch_time_s; /* time on the pad before ignition */
+
+        real body_drag_area_m2; /* Cd * area of the body */
+        real brake_drag_area_m2; /* added Cd * area at full deployment */
+        real max_deployment_deg;
+
+        real ground_altitude_asl_m;
+        real descent_rate_ms; /* under parachute */
+        real step_s; /* integration step */
+    };
+
+    enum class phase {
+        PAD,
+        BOOST,
+        COAST,
+        DESCENT,
+        LANDED,
+    };
+
+    struct state {
+        enum phase phase;
+        real time_s;
+
+        real altitude_m; /* above ground */
+        real velocity_ms; /* positive up */
+        real acceleration_ms2; /* kinematic, positive up */
+        real specific_force_ms2; /* what an axial accelerometer reads */
+
+        real deployment_deg;
+        real apogee_m; /* highest altitude so far */
+    };
+
+    /** A ~700 m flight on an I-class motor */
+    static constexpr config DEFAULT_CONFIG = {
+        3.5, 0.6, 300.0, 2.0, 1.0,
+        0.0045, 0.012, 60.0,
+        200.0, 6.0, 0.001,
+    };
+
+public:
+
+    explicit flight(const config &conf) : conf(conf)
+    {
+        reset();
+    }
+
+    void reset();
+
+    /** Starts stepping on the sim kernel every `step_s`. */
+    void start();
+
+    /** Advances the flight by `dt` seconds. */
+    void step(real dt);
+
+    const state &get_state() const { return current; }
+    const config &get_config() const { return conf; }
+
+    /** Sets the airbrake deployment, clamped to [0, max]. */
+    void set_deployment_deg(real deployment_deg);
+
+    /** Drag area (Cd * area, in m^2) at a deployment */
+    real drag_area(real deployment_deg) const;
+
+    /** ISA air density (kg/m^3) and pressure (Pa) at an altitude above ground */
+    real air_density(real altitude_m) const;
+    real air_pressure(real altitude_m) const;
+    /** ISA temperature (deg C) at an altitude above ground */
+    real air_temperature(real altitude_m) const;
+
+private:
+    static void on_step(void *ctx);
+
+    /* net acceleration (positive up) at a velocity and altitude */
+    real acceleration(real altitude_m, real velocity_ms, real mass_kg,
+            real thrust_n) const;
+
+    config conf;
+    state current;
+};
+
+} // namespace sim
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_SIM_FLIGHT_H_
@@ -0,0 +1,122 @@
+
+#ifndef AIRBRAKES_SDK_SIM_HAL_H_
+#define AIRBRAKES_SDK_SIM_HAL_H_
+
+#include <stm32f4xx_hal.h>
+
+#include <stdint.h>
+
+namespace sdk {
+
+namespace sim {
+
+/**
+ * A simulated I2C target. Register reads and writes auto-increment from
+ * `reg`, like the sensors the SDK drives.
+ */
+class i2c_device {
+public:
+    virtual ~i2c_device() = default;
+
+    /** Reads `size` bytes starting at `reg`. Returning false NACKs. */
+    virtual bool read(uint16_t reg, uint8_t *data, uint16_t size) = 0;
+
+    /** Writes `size` bytes starting at `reg`. Returning false NACKs. */
+    virtual bool write(uint16_t reg, const uint8_t *data, uint16_t size) = 0;
+};
+
+/** A simulated SPI target behind a chip select line */
+class spi_device {
+public:
+    virtual ~spi_device() = default;
+
+    /** Chip select went low */
+    virtual void select() = 0;
+    /** Chip select went high */
+    virtual void deselect() = 0;
+
+    /** Full-duplex transfer while selected; `tx` or `rx` may be null. */
+    virtual void transfer(const uint8_t *tx, uint8_t *rx, uint16_t size) = 0;
+};
+
+/** Bus faults for `hal::inject_i2c_fault` */
+enum class i2c_fault {
+    NACK, /* nobody acknowledges the address */
+    ARBITRATION_LOST, /* another master took the bus */
+    BUS_ERROR, /* a misplaced START or STOP */
+    HANG, /* the transfer never ends, e.g. a clock stretched forever */
+    SDA_STUCK, /* a device holds SDA low until clocked out */
+    INIT_FAILS, /* HAL_I2C_Init fails, leaving the peripheral busy */
+};
+
+/**
+ * Wiring between the host HAL (src/sim/hal.cc) and simulated devices. The
+ * HAL itself behaves like the target's: interrupt-mode I2C transfers take bus
+ * time and complete through the usual HAL callbacks, which the application
+ * must forward to the SDK as it does on the target.
+ */
+class hal {
+public:
+
+    /** Puts `device` at 7-bit `address` on an I2C bus. */
+    static void attach(I2C_HandleTypeDef *bus, uint16_t address,
+            i2c_device &device);
+
+    /**
+     * Names the GPIOs behind an I2C bus's SCL and SDA, which idle high from
+     * the pull-ups. Only needed to watch a bus recovery clock them.
+     */
+    static void attach_i2c_pins(I2C_HandleTypeDef *bus, GPIO_TypeDef
+            *scl_port, uint16_t scl_pin, GPIO_TypeDef *sda_port,
+            uint16_t sda_pin);
+
+    /**
+     * Makes the next `count` interrupt-mode transfers on `bus` fail with
+     * `fault`. SDA_STUCK instead takes effect at once, ignoring `count`:
+     * transfers cannot start (HAL_BUSY) until SCL is clocked by hand through
+     * the pins of `attach_i2c_pins`. INIT_FAILS applies to the next `count`
+     * calls of HAL_I2C_Init rather than to transfers, and adds to a transfer
+     * fault already injected.
+     */
+    static void inject_i2c_fault(I2C_HandleTypeDef *bus, i2c_fault fault,
+            int count = 1);
+
+    /**
+     * Wires the TX line of `from` to the RX line of `to`, which may be the
+     * same UART for a loopback. A DMA transmission takes 10 bit times per
+     * byte at `from`'s baud rate; its bytes arrive when it completes, ending
+     * with an idle-line event.
+     */
+    static void connect(UART_HandleTypeDef *from, UART_HandleTypeDef *to);
+
+    /**
+     * Reports a line error (HAL_UART_ERROR_*) on a UART, ending its DMA
+     * reception as the HAL does. Event (interrupt) context only.
+     */
+    static void inject_uart_error(UART_HandleTypeDef *uart, uint32_t error);
+
+    /** Puts `device` on an SPI bus, selected while `cs_pin` is low. */
+    static void attach(SPI_HandleTypeDef *bus, GPIO_TypeDef *cs_port,
+            uint16_t cs_pin, spi_device &device);
+
+    /**
+     * Drives an input pin from a device, calling HAL_GPIO_EXTI_Callback if
+     * it changed. Event (interrupt) context only.
+     */
+    static void drive_pin(GPIO_TypeDef *port, uint16_t pin, bool value);
+
+    /** Current level of a pin, as driven by either side */
+    static bool read_pin(GPIO_TypeDef *port, uint16_t pin);
+
+    /** Duty cycle [0,1] of a PWM channel, 0 while it is stopped */
+    static float get_pwm_duty(TIM_HandleTypeDef *htim, uint32_t channel);
+
+    /** Detaches every device and clears all peripheral state. */
+    static void reset();
+};
+
+} // namespace sim
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_SIM_HAL_H_
@@ -0,0 +1,77 @@
+
+#ifndef AIRBRAKES_SDK_SIM_I2C_REPLAY_H_
+#define AIRBRAKES_SDK_SIM_I2C_REPLAY_H_
+
+#include <sdk/i2c_log.h>
+#include <sdk/sim/hal.h>
+
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+namespace sdk {
+
+namespace sim {
+
+/**
+ * Plays an I2C log (see sdk/i2c_log.h) back to the drivers. Every address in
+ * the log becomes a device whose registers hold whatever was last read from
+ * them at the current simulated time, so chip ids, calibration and data
+ * frames come back exactly as recorded while the driver code runs unchanged.
+ *
+ * Log time is aligned to simulated time at the first access. Writes are
+ * acknowledged and ignored, as are written records in the log.
+ */
+class i2c_replay {
+public:
+
+    /** Reads a log file. Returns false if it is missing or malformed. */
+    bool load(const char *path);
+
+    /** Attaches a device for every address in the log to `bus`. */
+    void attach(I2C_HandleTypeDef *bus);
+
+    /** True once the simulated time is past the last record */
+    bool is_finished() const;
+
+    uint32_t get_record_count() const { return (uint32_t) records.size(); }
+
+    /** Time from the first to the last record, in us */
+    uint64_t get_duration_us() const;
+
+private:
+
+    class device : public i2c_device {
+    public:
+        device(i2c_replay &owner, uint8_t address);
+
+        bool read(uint16_t reg, uint8_t *data, uint16_t size) override;
+        bool write(uint16_t reg, const uint8_t *data, uint16_t size) override;
+
+        uint8_t get_address() const { return address; }
+        void apply(const i2c_log::record &r);
+
+    private:
+        i2c_replay &owner;
+        uint8_t address;
+        uint8_t regs[256];
+    };
+
+    /* applies every record up to the current simulated time */
+    void advance();
+
+    device *find(uint8_t address);
+
+    std::vector<i2c_log::record> records;
+    std::vector<std::unique_ptr<device>> devices;
+    size_t cursor = 0;
+
+    bool aligned = false;
+    int64_t offset_us = 0; /* log time minus simulated time */
+};
+
+} // namespace sim
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_SIM_I2C_REPLAY_H_
@@ -0,0 +1,58 @@
+
+#ifndef AIRBRAKES_SDK_SIM_KERNEL_H_
+#define AIRBRAKES_SDK_SIM_KERNEL_H_
+
+#include <stdint.h>
+
+namespace sdk {
+
+namespace sim {
+
+/**
+ * Simulated time base behind the host FreeRTOS port (host builds only).
+ *
+ * Tasks are std::threads, but exactly one task or event runs at a time and
+ * code takes no simulated time: the clock only moves when every task is
+ * blocked, jumping straight to the next timeout or scheduled event. A flight
+ * therefore runs as fast as the host can execute the SDK, and the same inputs
+ * always produce the same schedule.
+ *
+ * Events stand in for interrupts: they run outside any task, may only use
+ * FromISR kernel calls, and run before any task at the same instant.
+ */
+class kernel {
+public:
+
+    using event_fn = void (*)(void *ctx);
+
+    /** Simulated nanoseconds since the last `reset` */
+    static uint64_t now_ns();
+
+    /** Schedules `fn(ctx)` at `at_ns` (or now, if that has passed). */
+    static void schedule(uint64_t at_ns, event_fn fn, void *ctx);
+
+    /** Makes the running scheduler return. Callable from tasks and events. */
+    static void stop();
+
+    /**
+     * Rewinds time to zero and drops pending events. Only between scheduler
+     * runs, with every task deleted.
+     */
+    static void reset();
+
+    /** Number of task switches so far, a rough cost measure */
+    static uint64_t get_switch_count();
+
+    /**
+     * Number of allocations the target port would take from the FreeRTOS
+     * heap so far: pvPortMalloc and heap-allocated queues and semaphores
+     * (task stacks are not counted). Statically allocated objects add none.
+     */
+    static uint64_t get_heap_allocations();
+};
+
+} // namespace sim
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_SIM_KERNEL_H_
@@ -0,0 +1,56 @@
+
+#ifndef AIRBRAKES_SDK_SIM_RNG_H_
+#define AIRBRAKES_SDK_SIM_RNG_H_
+
+#include <math.h>
+#include <stdint.h>
+
+namespace sdk {
+
+namespace sim {
+
+/**
+ * Small deterministic PRNG (xorshift64*) for sensor noise, so a seeded
+ * simulated flight is reproducible on every host.
+ */
+class rng {
+public:
+
+    explicit rng(uint64_t seed) : s(seed != 0 ? seed : 0x9e3779b97f4a7c15ull)
+    {
+    }
+
+    uint64_t next()
+    {
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return s * 0x2545f4914f6cdd1dull;
+    }
+
+    /** Uniform in [0,1) */
+    double uniform()
+    {
+        return (double) (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    /** Normally distributed with the given standard deviation */
+    double gaussian(double stddev)
+    {
+        // Box-Muller, one of the pair is thrown away
+        double u1 = uniform();
+        double u2 = uniform();
+        if (u1 < 1e-300)
+            u1 = 1e-300;
+        return stddev * sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+    }
+
+private:
+    uint64_t s;
+};
+
+} // namespace sim
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_SIM_RNG_H_
@@ -0,0 +1,70 @@
+
+#ifndef AIRBRAKES_SDK_SIM_W25Q16JV_SIM_H_
+#define AIRBRAKES_SDK_SIM_W25Q16JV_SIM_H_
+
+#include <sdk/sim/hal.h>
+
+#include <stdint.h>
+#include <vector>
+
+namespace sdk {
+
+namespace sim {
+
+/**
+ * Command-level W25Q16JV: 2 MiB of NOR flash with the write enable latch,
+ * page program (which can only clear bits and wraps within a page), sector,
+ * block and chip erase, and a BUSY bit held for the typical datasheet times.
+ */
+class w25q16jv_sim : public spi_device {
+public:
+
+    static constexpr uint32_t SIZE = 2 * 1024 * 1024;
+    static constexpr uint32_t PAGE_SIZE = 256;
+
+public:
+
+    w25q16jv_sim();
+
+    void attach(SPI_HandleTypeDef *bus, GPIO_TypeDef *cs_port,
+            uint16_t cs_pin);
+
+    void select() override;
+    void deselect() override;
+    void transfer(const uint8_t *tx, uint8_t *rx, uint16_t size) override;
+
+    /** Array contents, for checking what the driver wrote */
+    const uint8_t *get_data() const { return memory.data(); }
+
+    uint32_t get_program_count() const { return program_count; }
+    uint32_t get_erase_count() const { return erase_count; }
+
+private:
+
+    /* one byte clocked in while selected, returns the byte clocked out */
+    uint8_t exchange(uint8_t in);
+
+    /* runs a command with everything it needs on deselect */
+    void finish_command();
+
+    bool is_busy() const;
+
+    std::vector<uint8_t> memory;
+
+    bool selected;
+    uint32_t position; /* bytes clocked since select */
+    uint8_t command;
+    uint32_t address;
+
+    bool write_enabled;
+    uint64_t busy_until_ns;
+
+    uint32_t program_count;
+    uint32_t erase_count;
+};
+
+} // namespace sim
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_SIM_W25Q16JV_SIM_H_
@@ -0,0 +1,251 @@
+
+#ifndef AIRBRAKES_SDK_TOPIC_H_
+#define AIRBRAKES_SDK_TOPIC_H_
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <atomic>
+#include <stdint.h>
+
+/*
+ * Task notification index used for topic wakeups. sdk::i2c_master blocks on
+ * index 0, so topics use index 1 when the kernel has notification arrays
+ * (configTASK_NOTIFICATION_ARRAY_ENTRIES >= 2). Without them, a task must not
+ * wait on a topic and use the I2C bus at the same time.
+ */
+#ifndef SDK_TOPIC_NOTIFY_INDEX
+#if defined(configTASK_NOTIFICATION_ARRAY_ENTRIES) && \
+        configTASK_NOTIFICATION_ARRAY_ENTRIES >= 2
+#define SDK_TOPIC_NOTIFY_INDEX 1
+#endif
+#endif
+
+namespace sdk {
+
+/**
+ * A single-publisher, multi-subscriber topic: a fixed ring of `N` samples with
+ * a read cursor per subscriber. Publishing never blocks and never waits on
+ * subscribers; a subscriber that falls more than `N` samples behind skips
+ * ahead and has the gap counted in `subscriber::dropped`.
+ *
+ * Samples are written in place and read either by copy (`read`) or in place
+ * (`acquire`/`release`). Each slot carries a sequence number and a ready
+ * flag, so readers detect a slot being overwritten under them without any
+ * lock. The flag is kept apart from the sequence number, which uses all 32
+ * bits and so stays unambiguous across wraps.
+ */
+template<typename T, uint32_t N, int MAX_SUBSCRIBERS = 4>
+class topic {
+    static_assert((N & (N - 1)) == 0, "topic length must be a power of two");
+
+public:
+
+    /** Per-subscriber read state. Owned by the subscribing task. */
+    struct subscriber {
+        uint32_t cursor; /* sequence number of the next sample to read */
+        uint32_t dropped; /* samples overwritten before they were read */
+    };
+
+public:
+
+    topic() : head(0), task_count(0)
+    {
+        for (uint32_t i = 0; i < N; i++) {
+            slots[i].seq.store(0, std::memory_order_relaxed);
+            slots[i].ready.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // not copyable or movable, subscribers point into it
+    topic(const topic &) = delete;
+    topic &operator=(const topic &) = delete;
+
+    /**
+     * Subscribes from the current task, starting at the next published
+     * sample. If `notify` is true, the task is woken on every publish (see
+     * `wait`). Call before the publisher starts.
+     */
+    subscriber subscribe(bool notify)
+    {
+        if (notify && task_count < MAX_SUBSCRIBERS)
+            tasks[task_count++] = xTaskGetCurrentTaskHandle();
+        return { head.load(std::memory_order_acquire), 0 };
+    }
+
+    /**
+     * Returns the slot to write the next sample into. Must be followed by
+     * `commit`. Publisher only.
+     */
+    T &begin_publish()
+    {
+        uint32_t seq = head.load(std::memory_order_relaxed);
+        slot &s = slots[seq & (N - 1)];
+        s.ready.store(false, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return s.value;
+    }
+
+    /** Publishes the sample written since `begin_publish`. */
+    void commit()
+    {
+        uint32_t seq = head.load(std::memory_order_relaxed);
+        slot &s = slots[seq & (N - 1)];
+        s.seq.store(seq, std::memory_order_relaxed);
+        s.ready.store(true, std::memory_order_release);
+        head.store(seq + 1, std::memory_order_release);
+        for (int i = 0; i < task_count; i++)
+            notify_give(tasks[i]);
+    }
+
+    /** Publishes from an ISR; yields if a subscriber was woken. */
+    void commit_from_isr()
+    {
+        uint32_t seq = head.load(std::memory_order_relaxed);
+        slot &s = slots[seq & (N - 1)];
+        s.seq.store(seq, std::memory_order_relaxed);
+        s.ready.store(true, std::memory_order_release);
+        head.store(seq + 1, std::memory_order_release);
+
+        BaseType_t woken = pdFALSE;
+        for (int i = 0; i < task_count; i++)
+            notify_give_from_isr(tasks[i], &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+
+    /** Copies and publishes `value`. */
+    void publish(const T &value)
+    {
+        begin_publish() = value;
+        commit();
+    }
+
+    /**
+     * Copies the oldest unread sample into `out`. Returns false if there is
+     * nothing new.
+     */
+    bool read(subscriber &sub, T &out)
+    {
+        for (;;) {
+            const slot *s = next_slot(sub);
+            if (s == nullptr)
+                return false;
+            out = s->value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s->holds(sub.cursor, std::memory_order_relaxed)) {
+                sub.cursor++;
+                return true;
+            }
+            // overwritten while copying, skip ahead and try again
+        }
+    }
+
+    /**
+     * Returns the oldest unread sample in place, or nullptr if there is
+     * nothing new. The pointer is valid until `release`, which reports whether
+     * the publisher overwrote the sample in the meantime (the caller should
+     * then discard whatever it derived from it).
+     */
+    const T *acquire(subscriber &sub)
+    {
+        const slot *s = next_slot(sub);
+        return s == nullptr ? nullptr : &s->value;
+    }
+
+    /** Finishes an `acquire`. Returns false if the sample was torn. */
+    bool release(subscriber &sub)
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        bool intact = slots[sub.cursor & (N - 1)].holds(sub.cursor,
+            std::memory_order_relaxed);
+        if (intact)
+            sub.cursor++;
+        return intact;
+    }
+
+    /** Number of unread samples, including ones that will be dropped */
+    uint32_t pending(const subscriber &sub) const
+    {
+        return head.load(std::memory_order_acquire) - sub.cursor;
+    }
+
+    /**
+     * Blocks the subscribing task until something is published or
+     * `timeout_ms` passes. Returns true if woken by a publish. The task must
+     * have subscribed with `notify`.
+     */
+    bool wait(uint32_t timeout_ms)
+    {
+#ifdef SDK_TOPIC_NOTIFY_INDEX
+        return ulTaskNotifyTakeIndexed(SDK_TOPIC_NOTIFY_INDEX, pdTRUE,
+            pdMS_TO_TICKS(timeout_ms)) != 0;
+#else
+        return ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms)) != 0;
+#endif
+    }
+
+    /** Total samples published so far (wraps at 2^32) */
+    uint32_t published() const { return head.load(std::memory_order_relaxed); }
+
+private:
+
+    struct slot {
+        std::atomic<uint32_t> seq; /* sequence number of the last commit */
+        std::atomic<bool> ready; /* false while empty or being written */
+        T value;
+
+        /* whether the slot holds the committed sample `expected` */
+        bool holds(uint32_t expected, std::memory_order order) const
+        {
+            return ready.load(order) &&
+                seq.load(std::memory_order_relaxed) == expected;
+        }
+    };
+
+    /* catches the cursor up if it was lapped, then finds its slot */
+    const slot *next_slot(subscriber &sub)
+    {
+        uint32_t h = head.load(std::memory_order_acquire);
+        if (h - sub.cursor > N) {
+            sub.dropped += h - sub.cursor - N;
+            sub.cursor = h - N;
+        }
+        while (sub.cursor != h) {
+            const slot *s = &slots[sub.cursor & (N - 1)];
+            if (s->holds(sub.cursor, std::memory_order_acquire))
+                return s;
+            // being rewritten right now, that sample is gone
+            sub.cursor++;
+            sub.dropped++;
+        }
+        return nullptr;
+    }
+
+    static void notify_give(TaskHandle_t task)
+    {
+#ifdef SDK_TOPIC_NOTIFY_INDEX
+        xTaskNotifyGiveIndexed(task, SDK_TOPIC_NOTIFY_INDEX);
+#else
+        xTaskNotifyGive(task);
+#endif
+    }
+
+    static void notify_give_from_isr(TaskHandle_t task, BaseType_t *woken)
+    {
+#ifdef SDK_TOPIC_NOTIFY_INDEX
+        vTaskNotifyGiveIndexedFromISR(task, SDK_TOPIC_NOTIFY_INDEX, woken);
+#else
+        vTaskNotifyGiveFromISR(task, woken);
+#endif
+    }
+
+    slot slots[N];
+    std::atomic<uint32_t> head;
+
+    TaskHandle_t tasks[MAX_SUBSCRIBERS];
+    int task_count;
+};
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_TOPIC_H_
@@ -0,0 +1,107 @@
+
+#ifndef AIRBRAKES_SDK_TRACE_H_
+#define AIRBRAKES_SDK_TRACE_H_
+
+#include <stdint.h>
+
+/*
+ * Event tracing for driver hot paths. Enabled by defining SDK_TRACE (the
+ * AIRBRAKES_SDK_TRACE CMake option); otherwise every SDK_TRACE_* macro expands
+ * to nothing. SDK_TRACE_BUFFER_SIZE sets the ring size in events (power of
+ * two, 16 bytes each in RAM, 12 in dumps).
+ *
+ * Dumps are decoded into Chrome trace / Perfetto JSON by
+ * tools/trace_to_json.py, which must be kept in sync with `trace::event`.
+ */
+#ifndef SDK_TRACE_BUFFER_SIZE
+#define SDK_TRACE_BUFFER_SIZE 1024
+#endif
+
+namespace sdk {
+
+namespace trace {
+
+/** Event ids. Append only, the decoder relies on the values. */
+enum class event : uint16_t {
+    I2C_READ = 0, /* arg: device address << 16 | register */
+    I2C_WRITE = 1, /* arg: device address << 16 | register */
+    I2C_WAIT = 2, /* waiting for the transfer-complete notification */
+    SPI_TRANSMIT = 3, /* arg: size */
+    SPI_RECEIVE = 4, /* arg: size */
+    MUTEX_LOCK = 5, /* waiting to take a mutex, arg: handle */
+    QUEUE_PUSH = 6, /* arg: handle */
+    QUEUE_POP = 7, /* arg: handle */
+    ENCODER_EDGE = 8, /* arg: count */
+    MOTOR_UPDATE = 9, /* arg: output power * 1000, signed */
+    I2C_RECOVER = 10, /* arg: the status that triggered it */
+    UART_TX_DMA = 11, /* a transmit DMA transfer started, arg: size */
+    UART_DROP = 12, /* a send did not fit, arg: size */
+    USER = 0x100, /* first id free for application events */
+};
+
+enum class phase : uint16_t {
+    INSTANT = 0,
+    BEGIN = 1,
+    END = 2,
+};
+
+/** One trace event, as stored in dumps */
+struct record {
+    /*
+     * raw cycle counter, wraps. Claiming a slot and reading the counter are
+     * not atomic, so an event that preempted another may come after it with
+     * an earlier time.
+     */
+    uint32_t cycles;
+    uint16_t id;
+    uint16_t phase;
+    uint32_t arg;
+};
+
+/** Dump header, followed by `count` records, oldest first */
+struct dump_header {
+    uint32_t magic; /* DUMP_MAGIC */
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t cycles_per_us;
+    uint32_t count;
+};
+
+static constexpr uint32_t DUMP_MAGIC = 0x544b4453; /* "SDKT" */
+static constexpr uint16_t DUMP_VERSION = 1;
+
+#ifdef SDK_TRACE
+
+/** Appends an event. Lock-free, callable from tasks and ISRs. */
+void emit(event id, phase ph, uint32_t arg);
+
+/**
+ * Writes a dump (header + records, oldest first) into `out`. Returns the
+ * number of bytes written, at most `size`. Events being written or
+ * overwritten while dumping are left out, never torn.
+ */
+uint32_t dump(uint8_t *out, uint32_t size);
+
+/** Discards all recorded events. */
+void clear();
+
+#endif // SDK_TRACE
+
+} // namespace trace
+
+} // namespace sdk
+
+#ifdef SDK_TRACE
+#define SDK_TRACE_INSTANT(id, arg) ::sdk::trace::emit( \
+    ::sdk::trace::event::id, ::sdk::trace::phase::INSTANT, (uint32_t) (arg))
+#define SDK_TRACE_BEGIN(id, arg) ::sdk::trace::emit( \
+    ::sdk::trace::event::id, ::sdk::trace::phase::BEGIN, (uint32_t) (arg))
+#define SDK_TRACE_END(id, arg) ::sdk::trace::emit( \
+    ::sdk::trace::event::id, ::sdk::trace::phase::END, (uint32_t) (arg))
+#else
+#define SDK_TRACE_INSTANT(id, arg) do { } while (0)
+#define SDK_TRACE_BEGIN(id, arg) do { } while (0)
+#define SDK_TRACE_END(id, arg) do { } while (0)
+#endif
+
+#endif // AIRBRAKES_SDK_TRACE_H_
@@ -0,0 +1,134 @@
+
+#ifndef AIRBRAKES_SDK_UART_H_
+#define AIRBRAKES_SDK_UART_H_
+
+#include <stm32f4xx_hal.h>
+
+#include <stdint.h>
+
+namespace sdk {
+
+/**
+ * A non-blocking UART for streaming, e.g. a telemetry downlink, over the
+ * HAL's DMA calls.
+ *
+ * Transmit is double buffered: `send` appends to one buffer while DMA
+ * drains the other, and the buffers swap when a DMA transfer completes.
+ * Producers never wait; what does not fit is dropped whole and counted, so
+ * a saturated link loses packets, not the middle of one.
+ *
+ * Receive runs DMA into a circular buffer, with the idle-line event telling
+ * how far it got, and `receive` copies out what arrived. Reading must keep
+ * up within `RX_BUFFER_SIZE` bytes, or the bytes in between are dropped and
+ * counted.
+ *
+ * Needs the RX DMA stream in circular mode. The application forwards
+ * HAL_UART_TxCpltCallback, HAL_UARTEx_RxEventCallback and
+ * HAL_UART_ErrorCallback through `from_handle`.
+ */
+class uart {
+public:
+
+    enum class status {
+        OK,
+        FULL, /* dropped, no room in the transmit buffer */
+        ERROR, /* refused by the HAL, or an unregistered instance */
+    };
+
+    /** bytes per transmit buffer, so the longest single `send` */
+    static constexpr uint16_t TX_BUFFER_SIZE = 256;
+    static constexpr uint16_t RX_BUFFER_SIZE = 256;
+    static_assert((RX_BUFFER_SIZE & (RX_BUFFER_SIZE - 1)) == 0,
+        "byte counts wrap at 2^32, which must be a multiple of the buffer");
+
+    /** instances `from_handle` can find, one per USART */
+    static constexpr int MAX_INSTANCES = 3;
+
+    struct stats {
+        uint32_t tx_bytes; /* accepted by `send` */
+        uint32_t tx_dropped; /* `send` calls dropped */
+        uint32_t tx_dropped_bytes;
+        uint32_t rx_bytes; /* returned by `receive` */
+        uint32_t rx_dropped_bytes; /* overwritten before they were read */
+        uint32_t errors; /* line errors reported by the HAL */
+    };
+
+public:
+
+    /**
+     * Creates a `uart` on an initialized HAL handle. Only the first
+     * `MAX_INSTANCES` are registered for `from_handle`; the HAL callbacks
+     * cannot reach any later one, so its `start` and `send` fail.
+     */
+    explicit uart(UART_HandleTypeDef *handle);
+
+    uart(const uart &) = delete;
+    uart &operator=(const uart &) = delete;
+
+    /** The `uart` of a HAL handle, for the HAL callbacks */
+    static uart *from_handle(UART_HandleTypeDef *handle);
+
+    /** Starts receiving. Nothing is received before. */
+    status start();
+
+    /**
+     * Queues `size` bytes for transmission, all or nothing. Never blocks;
+     * callable from any task, not from ISRs.
+     */
+    status send(const uint8_t *data, uint16_t size);
+
+    /**
+     * Frames `payload` (see sdk/packet.h) and queues the frame, as `send`.
+     * `size` is at most `packet::MAX_PAYLOAD`.
+     */
+    status send_packet(const void *payload, uint16_t size);
+
+    /**
+     * Copies up to `size` received bytes into `data`. Never blocks; returns
+     * the number copied. One reader only.
+     */
+    uint16_t receive(uint8_t *data, uint16_t size);
+
+    /** Gets if a transmission is queued or in progress */
+    bool is_sending() const { return tx_busy; }
+
+    stats get_stats() const;
+
+    /** From HAL_UART_TxCpltCallback */
+    void tx_complete_from_isr();
+
+    /** From HAL_UARTEx_RxEventCallback, with its `Size` */
+    void rx_event_from_isr(uint16_t size);
+
+    /** From HAL_UART_ErrorCallback; restarts a reception the HAL stopped */
+    void error_from_isr();
+
+private:
+
+    /* hands the filled buffer to DMA, in a critical section */
+    void start_transmit();
+
+    UART_HandleTypeDef *handle;
+    bool registered; /* found by `from_handle` */
+
+    uint8_t tx_buffers[2][TX_BUFFER_SIZE];
+    uint8_t tx_fill; /* index of the buffer `send` appends to */
+    uint16_t tx_fill_size;
+    volatile bool tx_busy;
+
+    uint8_t rx_buffer[RX_BUFFER_SIZE];
+    uint16_t rx_position; /* of the DMA in rx_buffer, at the last event */
+    volatile uint32_t rx_head; /* bytes received, ever */
+    uint32_t rx_tail; /* bytes consumed, ever */
+    /* where `rx_head` skipped to when reception restarted, and by how much */
+    volatile uint32_t rx_resync;
+    volatile uint32_t rx_resync_gap;
+    volatile uint32_t rx_restarts;
+    uint32_t rx_restarts_seen;
+
+    stats counts;
+};
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_UART_H_
@@ -2,13 +2,442 @@
 #ifndef AIRBRAKES_SDK_VECMATH_H_
 #define AIRBRAKES_SDK_VECMATH_H_
 
+#include <cmath>
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * Small fixed-size vector, quaternion and matrix types shared by the drivers
+ * and estimators. Header-only. The types are plain aggregates templated on the
+ * scalar, so they brace-initialise like the structs they replace and keep the
+ * same layout; everything short of a square root is constexpr.
+ *
+ * Use the float aliases (`vec3`, `quat`, ...) unless there is a reason not
+ * to: the Cortex-M4 FPU is single precision only, doubles are emulated.
+ */
+
 namespace sdk {
 
-/** 4-element vector type */
-struct vec4 {
-    double x, y, z, w;
+template<typename T>
+struct basic_vec3 {
+    T x, y, z;
+};
+
+template<typename T>
+struct basic_vec4 {
+    T x, y, z, w;
+};
+
+/** w + xi + yj + zk. Rotations use unit quaternions, body to world. */
+template<typename T>
+struct basic_quat {
+    T w, x, y, z;
 };
 
+/** 3x3 matrix, row-major */
+template<typename T>
+struct basic_mat3 {
+    T m[3][3];
+
+    constexpr T operator()(int row, int col) const { return m[row][col]; }
+    constexpr T &operator()(int row, int col) { return m[row][col]; }
+};
+
+using vec3 = basic_vec3<float>;
+using vec4 = basic_vec4<float>;
+using quat = basic_quat<float>;
+using mat3 = basic_mat3<float>;
+
+static_assert(sizeof(vec3) == 3 * sizeof(float), "vec3 must be packed");
+
+/*
+ * vec3
+ */
+
+/** Converts the scalar type, e.g. raw int16_t samples to float */
+template<typename U, typename T>
+constexpr basic_vec3<U> vec_cast(const basic_vec3<T> &v)
+{
+    return { (U) v.x, (U) v.y, (U) v.z };
+}
+
+template<typename T>
+constexpr basic_vec3<T> operator+(const basic_vec3<T> &a,
+        const basic_vec3<T> &b)
+{
+    return { a.x + b.x, a.y + b.y, a.z + b.z };
+}
+
+template<typename T>
+constexpr basic_vec3<T> operator-(const basic_vec3<T> &a,
+        const basic_vec3<T> &b)
+{
+    return { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+template<typename T>
+constexpr basic_vec3<T> operator-(const basic_vec3<T> &v)
+{
+    return { -v.x, -v.y, -v.z };
+}
+
+template<typename T>
+constexpr basic_vec3<T> operator*(const basic_vec3<T> &v, T s)
+{
+    return { v.x * s, v.y * s, v.z * s };
+}
+
+template<typename T>
+constexpr basic_vec3<T> operator*(T s, const basic_vec3<T> &v)
+{
+    return v * s;
+}
+
+template<typename T>
+constexpr basic_vec3<T> operator/(const basic_vec3<T> &v, T s)
+{
+    return { v.x / s, v.y / s, v.z / s };
+}
+
+template<typename T>
+constexpr basic_vec3<T> &operator+=(basic_vec3<T> &a, const basic_vec3<T> &b)
+{
+    a.x += b.x;
+    a.y += b.y;
+    a.z += b.z;
+    return a;
+}
+
+template<typename T>
+constexpr basic_vec3<T> &operator-=(basic_vec3<T> &a, const basic_vec3<T> &b)
+{
+    a.x -= b.x;
+    a.y -= b.y;
+    a.z -= b.z;
+    return a;
+}
+
+template<typename T>
+constexpr basic_vec3<T> &operator*=(basic_vec3<T> &v, T s)
+{
+    v.x *= s;
+    v.y *= s;
+    v.z *= s;
+    return v;
+}
+
+template<typename T>
+constexpr bool operator==(const basic_vec3<T> &a, const basic_vec3<T> &b)
+{
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+template<typename T>
+constexpr bool operator!=(const basic_vec3<T> &a, const basic_vec3<T> &b)
+{
+    return !(a == b);
+}
+
+/** Component-wise product */
+template<typename T>
+constexpr basic_vec3<T> hadamard(const basic_vec3<T> &a,
+        const basic_vec3<T> &b)
+{
+    return { a.x * b.x, a.y * b.y, a.z * b.z };
+}
+
+template<typename T>
+constexpr T dot(const basic_vec3<T> &a, const basic_vec3<T> &b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+template<typename T>
+constexpr basic_vec3<T> cross(const basic_vec3<T> &a, const basic_vec3<T> &b)
+{
+    return {
+        a.y * b.z - a.z * b.y,
+        a.z * b.x - a.x * b.z,
+        a.x * b.y - a.y * b.x,
+    };
+}
+
+template<typename T>
+constexpr T norm2(const basic_vec3<T> &v)
+{
+    return dot(v, v);
+}
+
+template<typename T>
+T norm(const basic_vec3<T> &v)
+{
+    return std::sqrt(norm2(v));
+}
+
+/** `v` scaled to unit length, or `v` itself if it is zero */
+template<typename T>
+basic_vec3<T> normalized(const basic_vec3<T> &v)
+{
+    T n = norm(v);
+    return n > 0 ? v * ((T) 1 / n) : v;
+}
+
+/*
+ * vec4
+ */
+
+template<typename T>
+constexpr basic_vec4<T> operator+(const basic_vec4<T> &a,
+        const basic_vec4<T> &b)
+{
+    return { a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w };
+}
+
+template<typename T>
+constexpr basic_vec4<T> operator-(const basic_vec4<T> &a,
+        const basic_vec4<T> &b)
+{
+    return { a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w };
+}
+
+template<typename T>
+constexpr basic_vec4<T> operator*(const basic_vec4<T> &v, T s)
+{
+    return { v.x * s, v.y * s, v.z * s, v.w * s };
+}
+
+template<typename T>
+constexpr basic_vec4<T> operator*(T s, const basic_vec4<T> &v)
+{
+    return v * s;
+}
+
+template<typename T>
+constexpr T dot(const basic_vec4<T> &a, const basic_vec4<T> &b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+template<typename T>
+constexpr T norm2(const basic_vec4<T> &v)
+{
+    return dot(v, v);
+}
+
+template<typename T>
+T norm(const basic_vec4<T> &v)
+{
+    return std::sqrt(norm2(v));
+}
+
+/*
+ * quat
+ */
+
+template<typename T>
+constexpr basic_quat<T> identity_quat()
+{
+    return { 1, 0, 0, 0 };
+}
+
+/** Rotation of `angle` rad about the unit vector `axis` */
+template<typename T>
+basic_quat<T> axis_angle(const basic_vec3<T> &axis, T angle)
+{
+    T s = std::sin(angle / 2);
+    return { std::cos(angle / 2), axis.x * s, axis.y * s, axis.z * s };
+}
+
+/** Hamilton product, `a` applied after `b` */
+template<typename T>
+constexpr basic_quat<T> operator*(const basic_quat<T> &a,
+        const basic_quat<T> &b)
+{
+    return {
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+    };
+}
+
+template<typename T>
+constexpr basic_quat<T> operator*(const basic_quat<T> &q, T s)
+{
+    return { q.w * s, q.x * s, q.y * s, q.z * s };
+}
+
+template<typename T>
+constexpr basic_quat<T> operator+(const basic_quat<T> &a,
+        const basic_quat<T> &b)
+{
+    return { a.w + b.w, a.x + b.x, a.y + b.y, a.z + b.z };
+}
+
+/** Inverse rotation, for unit quaternions */
+template<typename T>
+constexpr basic_quat<T> conjugate(const basic_quat<T> &q)
+{
+    return { q.w, -q.x, -q.y, -q.z };
+}
+
+template<typename T>
+constexpr T dot(const basic_quat<T> &a, const basic_quat<T> &b)
+{
+    return a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+template<typename T>
+constexpr T norm2(const basic_quat<T> &q)
+{
+    return dot(q, q);
+}
+
+template<typename T>
+basic_quat<T> normalized(const basic_quat<T> &q)
+{
+    T n = std::sqrt(norm2(q));
+    return n > 0 ? q * ((T) 1 / n) : q;
+}
+
+/** Vector part */
+template<typename T>
+constexpr basic_vec3<T> vector_part(const basic_quat<T> &q)
+{
+    return { q.x, q.y, q.z };
+}
+
+/**
+ * Rotates `v` by the unit quaternion `q` (q v q*). 15 multiplies, cheaper
+ * than building the matrix for a single vector.
+ */
+template<typename T>
+constexpr basic_vec3<T> rotate(const basic_quat<T> &q, const basic_vec3<T> &v)
+{
+    basic_vec3<T> u = vector_part(q);
+    basic_vec3<T> t = cross(u, v) * (T) 2;
+    return v + t * q.w + cross(u, t);
+}
+
+/** Rotation matrix of the unit quaternion `q` */
+template<typename T>
+constexpr basic_mat3<T> to_mat3(const basic_quat<T> &q)
+{
+    T xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    T xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    T wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    return {{
+        { 1 - 2 * (yy + zz), 2 * (xy - wz), 2 * (xz + wy) },
+        { 2 * (xy + wz), 1 - 2 * (xx + zz), 2 * (yz - wx) },
+        { 2 * (xz - wy), 2 * (yz + wx), 1 - 2 * (xx + yy) },
+    }};
+}
+
+/*
+ * mat3
+ */
+
+template<typename T>
+constexpr basic_mat3<T> identity_mat3()
+{
+    return {{ { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } }};
+}
+
+template<typename T>
+constexpr basic_vec3<T> operator*(const basic_mat3<T> &a,
+        const basic_vec3<T> &v)
+{
+    return {
+        a.m[0][0] * v.x + a.m[0][1] * v.y + a.m[0][2] * v.z,
+        a.m[1][0] * v.x + a.m[1][1] * v.y + a.m[1][2] * v.z,
+        a.m[2][0] * v.x + a.m[2][1] * v.y + a.m[2][2] * v.z,
+    };
+}
+
+template<typename T>
+constexpr basic_mat3<T> operator*(const basic_mat3<T> &a,
+        const basic_mat3<T> &b)
+{
+    basic_mat3<T> out = {};
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            out.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] +
+                a.m[i][2] * b.m[2][j];
+    return out;
+}
+
+template<typename T>
+constexpr basic_mat3<T> transpose(const basic_mat3<T> &a)
+{
+    return {{
+        { a.m[0][0], a.m[1][0], a.m[2][0] },
+        { a.m[0][1], a.m[1][1], a.m[2][1] },
+        { a.m[0][2], a.m[1][2], a.m[2][2] },
+    }};
+}
+
+template<typename T>
+constexpr T determinant(const basic_mat3<T> &a)
+{
+    return a.m[0][0] * (a.m[1][1] * a.m[2][2] - a.m[1][2] * a.m[2][1]) -
+        a.m[0][1] * (a.m[1][0] * a.m[2][2] - a.m[1][2] * a.m[2][0]) +
+        a.m[0][2] * (a.m[1][0] * a.m[2][1] - a.m[1][1] * a.m[2][0]);
+}
+
+/*
+ * Batched kernels over sample arrays
+ */
+
+/**
+ * out[i] = raw[i] * scale - offset for `count` samples, the batched form of
+ * `bmi088::convert` for FIFO bursts and offline processing. `raw` and `out`
+ * must not overlap.
+ *
+ * Uses SSE2 on the host, four samples per iteration. The Cortex-M4 has no
+ * float SIMD (its DSP extension is integer only), so there the plain loop is
+ * as good as it gets; results are identical either way.
+ */
+inline void scale_offset(const basic_vec3<int16_t> *raw, uint32_t count,
+        float scale, const vec3 &offset, vec3 *out)
+{
+    uint32_t i = 0;
+#if defined(__SSE2__)
+    // four xyz samples are exactly three registers: xyzx yzxy zxyz
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 o0 = _mm_setr_ps(offset.x, offset.y, offset.z, offset.x);
+    const __m128 o1 = _mm_setr_ps(offset.y, offset.z, offset.x, offset.y);
+    const __m128 o2 = _mm_setr_ps(offset.z, offset.x, offset.y, offset.z);
+    for (; i + 4 <= count; i += 4) {
+        const int16_t *src = &raw[i].x;
+        float *dst = &out[i].x;
+        __m128i lo = _mm_loadu_si128((const __m128i *) src);
+        __m128i hi = _mm_loadl_epi64((const __m128i *) (src + 8));
+        // sign-extend to 32 bits
+        __m128i r0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16);
+        __m128i r1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16);
+        __m128i r2 = _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16);
+        _mm_storeu_ps(dst, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(r0), s), o0));
+        _mm_storeu_ps(dst + 4,
+            _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(r1), s), o1));
+        _mm_storeu_ps(dst + 8,
+            _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(r2), s), o2));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = vec_cast<float>(raw[i]) * scale - offset;
+}
+
+/** out[i] = r * in[i] for `count` vectors; `in` and `out` may be the same */
+template<typename T>
+void transform(const basic_mat3<T> &r, const basic_vec3<T> *in,
+        uint32_t count, basic_vec3<T> *out)
+{
+    for (uint32_t i = 0; i < count; i++)
+        out[i] = r * in[i];
+}
 
 } // namespace sdk
 
@@ -0,0 +1,103 @@
+
+#ifndef AIRBRAKES_SDK_VERTICAL_KALMAN_H_
+#define AIRBRAKES_SDK_VERTICAL_KALMAN_H_
+
+#include <sdk/drivers/bmi088.h>
+#include <sdk/drivers/bmp390.h>
+
+#include <stdint.h>
+
+namespace sdk {
+
+/**
+ * Three-state (altitude, vertical velocity, accelerometer bias) Kalman filter
+ * fusing IMU acceleration with barometric altitude. Acceleration drives the
+ * predict step at IMU rate; barometric altitude corrects it at baro rate.
+ *
+ * The covariance is kept as the six unique entries of a symmetric 3x3 matrix
+ * and every step is hand-unrolled, so nothing is allocated and a step is a
+ * fixed, small number of multiply-adds.
+ *
+ * Not thread-safe; meant to be owned by a single control task.
+ */
+class vertical_kalman {
+public:
+
+    using real = float;
+
+    static constexpr real GRAVITY_EARTH = bmi088::GRAVITY_EARTH;
+
+    /** IMU body axis that points up when the rocket sits on the rail */
+    enum class axis : uint8_t {
+        POS_X,
+        POS_Y,
+        POS_Z,
+        NEG_X,
+        NEG_Y,
+        NEG_Z,
+    };
+
+    struct config {
+        axis vertical_axis;
+        real accel_noise; /* accelerometer noise, in m/s^2 (1-sigma) */
+        real bias_drift; /* accel bias random walk, in m/s^2/sqrt(s) */
+        real baro_noise; /* barometric altitude noise, in m (1-sigma) */
+    };
+
+    struct state {
+        real altitude_m; /* above ground reference, in m */
+        real vertical_velocity_ms; /* in m/s, positive up */
+        real vertical_acceleration_ms2; /* in m/s^2, gravity removed */
+        real accel_bias_ms2; /* estimated accelerometer bias, in m/s^2 */
+
+        real altitude_variance; /* in m^2 */
+        real velocity_variance; /* in m^2/s^2 */
+    };
+
+public:
+
+    explicit vertical_kalman(const config &conf);
+
+    /** Resets the filter to rest at the ground reference. */
+    void reset();
+
+    /**
+     * Sets the ground reference altitude above sea level (in m), see
+     * `altitude_estimator::capture_ground`.
+     */
+    void set_ground_altitude(real altitude_m) { ground_altitude_m = altitude_m; }
+
+    /**
+     * Predict step from a specific force along the vertical axis (in m/s^2,
+     * reads +g at rest), `dt` seconds after the previous predict.
+     */
+    void predict(real specific_force_ms2, real dt);
+
+    /** Predict step from an IMU sample, using the configured vertical axis. */
+    void predict(const bmi088::state &imu, real dt);
+
+    /** Update step from an altitude above the ground reference (in m). */
+    void update(real altitude_m);
+
+    /** Update step from a barometer sample; skips locked-out ones. */
+    void update(const bmp390::state &baro);
+
+    state get_state() const;
+
+private:
+    config conf;
+    real ground_altitude_m;
+
+    /* state vector */
+    real h, v, b;
+    real last_accel;
+
+    /* symmetric covariance, upper triangle */
+    real p00, p01, p02;
+    real p11, p12;
+    real p22;
+};
+
+} // namespace sdk
+
+#endif // AIRBRAKES_SDK_VERTICAL_KALMAN_H_
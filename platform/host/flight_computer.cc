@@ -0,0 +1,371 @@
+
+#include "flight_computer.h"
+
+#include <sdk/clock.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <chrono>
+#include <stdio.h>
+
+using namespace sdk;
+
+/*
+ * baro samples on the pad, half a second at 50 Hz; locked-out samples do not
+ * count, so the capture has to finish before ignition
+ */
+static constexpr uint32_t GROUND_SAMPLES = 25;
+
+/*
+ * baro outliers past 3 sigma or 25 Pa (about 2 m), and a lockout over the
+ * boost (over 4 g of specific force) and 100 ms after it, while the IMU
+ * carries the estimate. This airframe stays under Mach 0.4, but the lockout
+ * is what keeps a transonic one's shock-corrupted pressure out.
+ */
+static constexpr baro_filter::config BARO_FILTER = {
+    3.0f, 25.0f, 40.0f, 100000
+};
+
+static flight_computer *instance;
+
+static const char *const STAGE_NAMES[flight_computer::STAGE_COUNT] = {
+    "sensors", "estimator", "controller", "motor", "end_to_end",
+};
+
+static uint32_t period_us(float hz)
+{
+    return (uint32_t) (1e6f / hz + 0.5f);
+}
+
+static uint64_t host_ns()
+{
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    i2c_master::from_handle(hi2c)->unblock_from_isr();
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    i2c_master::from_handle(hi2c)->unblock_from_isr();
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    i2c_master::from_handle(hi2c)->error_from_isr();
+}
+
+void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    i2c_master::from_handle(hi2c)->error_from_isr();
+}
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    if (instance != nullptr && (GPIO_Pin == flight_computer::ENCODER_A_PIN ||
+            GPIO_Pin == flight_computer::ENCODER_B_PIN))
+        instance->on_encoder_edge(GPIO_Pin);
+}
+
+flight_computer::flight_computer(const config &conf, I2C_HandleTypeDef *hi2c,
+        TIM_HandleTypeDef *htim) : conf(conf), i2c(hi2c), imu(i2c),
+        baro(i2c), baro_outliers(BARO_FILTER),
+        motors(0.004f, 0.0f, 0.00002f,
+            drv8701(
+                pwm(htim, pwm::tim_channel::CHANNEL_1),
+                pwm(htim, pwm::tim_channel::CHANNEL_2),
+                unique_pin(GPIOB, MOTOR_SH1_PIN),
+                unique_pin(GPIOB, MOTOR_SH2_PIN),
+                unique_pin(GPIOB, MOTOR_NSLEEP_PIN)),
+            quad_encoder(conf.counts_per_rev,
+                unique_pin(GPIOB, ENCODER_A_PIN),
+                unique_pin(GPIOB, ENCODER_B_PIN))),
+        kalman({ vertical_kalman::axis::POS_Z, 0.05f, 0.01f, 0.5f }),
+        ground(0.5f, 0.1f), predictor(conf.predictor)
+{
+    for (int i = 0; i < STAGE_COUNT; i++)
+        stats[i] = { STAGE_NAMES[i], 0, 0, 0, 0, 0 };
+    i2c.set_recovery_pins(GPIOB, I2C_SCL_PIN, GPIOB, I2C_SDA_PIN);
+    baro.set_filter(&baro_outliers);
+    instance = this;
+}
+
+apogee_predictor::config flight_computer::airframe(const sim::flight &model)
+{
+    const sim::flight::config &fc = model.get_config();
+    apogee_predictor::config out = {};
+    out.coast_mass_kg = (float) fc.dry_mass_kg;
+    out.ground_altitude_asl_m = (float) fc.ground_altitude_asl_m;
+    out.max_deployment_deg = (float) fc.max_deployment_deg;
+    for (int i = 0; i < apogee_predictor::DRAG_TABLE_SIZE; i++) {
+        out.drag_area_m2[i] = (float) model.drag_area(fc.max_deployment_deg *
+            i / (apogee_predictor::DRAG_TABLE_SIZE - 1));
+    }
+    return out;
+}
+
+void flight_computer::set_i2c_tap(i2c_master::tap_fn fn, void *ctx)
+{
+    i2c.set_tap(fn, ctx);
+}
+
+void flight_computer::start()
+{
+    xTaskCreate(motor_task, "motor", 512, this, 4, nullptr);
+    xTaskCreate(sensor_task, "sensors", 1024, this, 3, nullptr);
+    xTaskCreate(control_task, "control", 1024, this, 2, nullptr);
+}
+
+void flight_computer::record(stage s, uint64_t sim_us, uint64_t host)
+{
+    stage_stats &st = stats[s];
+    st.count++;
+    st.sim_total_us += sim_us;
+    st.host_total_ns += host;
+    if (sim_us > st.sim_max_us)
+        st.sim_max_us = sim_us;
+    if (host > st.host_max_ns)
+        st.host_max_ns = host;
+}
+
+uint32_t flight_computer::imu_period(void *ctx)
+{
+    return period_us(((flight_computer *) ctx)->imu.get_odr_hz());
+}
+
+uint32_t flight_computer::baro_period(void *ctx)
+{
+    return period_us(((flight_computer *) ctx)->baro.get_odr_hz());
+}
+
+bool flight_computer::read_imu(void *ctx)
+{
+    flight_computer *self = (flight_computer *) ctx;
+    uint64_t sim_start = clock::now_us();
+    uint64_t host_start = host_ns();
+    bool ok = self->imu.update();
+    self->record(SENSORS, clock::now_us() - sim_start, host_ns() - host_start);
+    return ok;
+}
+
+bool flight_computer::read_baro(void *ctx)
+{
+    flight_computer *self = (flight_computer *) ctx;
+    uint64_t sim_start = clock::now_us();
+    uint64_t host_start = host_ns();
+    bool ok = self->baro.update();
+    self->record(SENSORS, clock::now_us() - sim_start, host_ns() - host_start);
+    return ok;
+}
+
+void flight_computer::on_imu(void *ctx)
+{
+    flight_computer *self = (flight_computer *) ctx;
+    bmi088::state s = self->imu.copy_state();
+    self->baro_outliers.update_acceleration(s);
+    if (self->last_imu_us != 0 && self->ground_set) {
+        uint64_t host_start = host_ns();
+        self->kalman.predict(s, (float) (s.timestamp_us - self->last_imu_us) *
+            1e-6f);
+        vertical_kalman::state est = self->kalman.get_state();
+        self->record(ESTIMATOR, 0, host_ns() - host_start);
+
+        self->last_sample_us = s.timestamp_us;
+        self->estimates.publish(est);
+    }
+    self->last_imu_us = s.timestamp_us;
+}
+
+void flight_computer::on_baro(void *ctx)
+{
+    flight_computer *self = (flight_computer *) ctx;
+    bmp390::state s = self->baro.copy_state();
+    if (!self->ground_set) {
+        self->ground.capture_ground(s);
+        if (self->ground.get_state().ground_samples >= GROUND_SAMPLES) {
+            self->kalman.set_ground_altitude(
+                self->ground.get_state().ground_altitude_m);
+            self->ground_set = true;
+        }
+        return;
+    }
+
+    uint64_t host_start = host_ns();
+    self->kalman.update(s);
+    self->record(ESTIMATOR, 0, host_ns() - host_start);
+}
+
+bool flight_computer::probe_imu(void *ctx)
+{
+    return ((flight_computer *) ctx)->imu.is_connected();
+}
+
+bool flight_computer::start_imu(void *ctx)
+{
+    return ((flight_computer *) ctx)->imu.start();
+}
+
+bool flight_computer::configure_imu(void *ctx)
+{
+    flight_computer *self = (flight_computer *) ctx;
+    return self->imu.set_acc_config(bmi088::acc_range::RANGE_24G,
+            bmi088::acc_bwp::NORMAL, bmi088::acc_odr::ODR_400HZ) &&
+        self->imu.set_gyro_config(bmi088::gyro_range::RANGE_2000DPS,
+            bmi088::gyro_bw::BW_47HZ);
+}
+
+bool flight_computer::probe_baro(void *ctx)
+{
+    return ((flight_computer *) ctx)->baro.is_connected();
+}
+
+bool flight_computer::calibrate_baro(void *ctx)
+{
+    return ((flight_computer *) ctx)->baro.read_calibration_data();
+}
+
+bool flight_computer::configure_baro(void *ctx)
+{
+    flight_computer *self = (flight_computer *) ctx;
+    return self->baro.set_config(0) &&
+        self->baro.set_odr(bmp390::odr::ODR_50HZ);
+}
+
+void flight_computer::sensor_task(void *params)
+{
+    flight_computer *self = (flight_computer *) params;
+
+    // the baro calibration and config fit in the IMU start-up wait
+    boot_sequencer &boot = self->boot;
+    int imu_probe = boot.add("imu_probe", probe_imu, self);
+    int imu_start = boot.add("imu_start", start_imu, self,
+        boot_sequencer::after(imu_probe), bmi088::START_DELAY_US);
+    boot.add("imu_config", configure_imu, self,
+        boot_sequencer::after(imu_start));
+    int baro_power = boot.add("baro_power", nullptr, nullptr, 0,
+        bmp390::STARTUP_US);
+    int baro_probe = boot.add("baro_probe", probe_baro, self,
+        boot_sequencer::after(baro_power));
+    boot.add("baro_calib", calibrate_baro, self,
+        boot_sequencer::after(baro_probe));
+    boot.add("baro_config", configure_baro, self,
+        boot_sequencer::after(baro_probe));
+    if (!boot.run()) {
+        printf("sensors not found\n");
+        vTaskEndScheduler();
+    }
+
+    // the hub's own bmi088/bmp390 readers, wrapped to time them
+    sensor_hub &hub = self->hub;
+    int imu_id = hub.add("bmi088", imu_period, read_imu, self);
+    int baro_id = hub.add("bmp390", baro_period, read_baro, self);
+    hub.subscribe(imu_id, on_imu, self);
+    hub.subscribe(baro_id, on_baro, self);
+    hub.run();
+}
+
+void flight_computer::control_task(void *params)
+{
+    flight_computer *self = (flight_computer *) params;
+    auto sub = self->estimates.subscribe(true);
+
+    bool boosted = false;
+    for (;;) {
+        self->estimates.wait(100);
+        vertical_kalman::state est{};
+        bool fresh = false;
+        while (self->estimates.read(sub, est))
+            fresh = true;
+        if (!fresh)
+            continue;
+
+        if (est.vertical_acceleration_ms2 > 30.0f)
+            boosted = true;
+
+        // only brake while coasting up, retract otherwise
+        uint64_t host_start = host_ns();
+        float deployment = 0;
+        float predicted = 0;
+        if (boosted && est.vertical_acceleration_ms2 < 0 &&
+                est.vertical_velocity_ms > 0) {
+            deployment = self->predictor.solve_deployment(est.altitude_m,
+                est.vertical_velocity_ms, self->conf.target_apogee_m);
+            predicted = self->predictor.predict(est.altitude_m,
+                est.vertical_velocity_ms, deployment);
+        }
+        self->record(CONTROLLER, 0, host_ns() - host_start);
+
+        self->motors.set_target_degrees(deployment * self->conf.gear_ratio);
+        uint64_t now_us = clock::now_us();
+        self->record(END_TO_END, now_us - self->last_sample_us, 0);
+
+        if (deployment > self->peak_deployment_deg)
+            self->peak_deployment_deg = deployment;
+        self->last_output = {
+            now_us, est.altitude_m, est.vertical_velocity_ms,
+            est.vertical_acceleration_ms2, deployment,
+            predicted != 0 ? predicted : self->last_output.predicted_apogee_m,
+        };
+        if (self->on_output != nullptr)
+            self->on_output(self->last_output, self->output_ctx);
+    }
+}
+
+void flight_computer::motor_task(void *params)
+{
+    flight_computer *self = (flight_computer *) params;
+    self->motors.start();
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        uint64_t host_start = host_ns();
+        self->motors.update_motor();
+        self->record(MOTOR, 0, host_ns() - host_start);
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(1));
+    }
+}
+
+void flight_computer::print_stats() const
+{
+    uint64_t now = clock::now_us();
+    static const char *const STATUS_NAMES[] = {
+        "pending", "done", "failed", "skipped",
+    };
+    printf("boot: %llu us\n", (unsigned long long) boot.get_boot_us());
+    for (int id = 0; id < boot.get_count(); id++) {
+        const boot_sequencer::step_stats &st = boot.get_stats(id);
+        printf("  %-11s %-7s ready %6llu start %6llu end %6llu us\n",
+            st.name, STATUS_NAMES[(int) st.status],
+            (unsigned long long) st.ready_us,
+            (unsigned long long) st.start_us,
+            (unsigned long long) st.end_us);
+    }
+
+    printf("sensors:\n");
+    for (int id = 0; id < hub.get_count(); id++) {
+        const sensor_hub::sensor_stats &st = hub.get_stats(id);
+        printf("  %-8s %6u reads %4u failures %4u overruns, max %u us\n",
+            st.name, (unsigned) st.reads, (unsigned) st.failures,
+            (unsigned) st.overruns, (unsigned) st.max_read_us);
+    }
+    printf("  bus load %.1f%%\n", hub.get_bus_load(now) * 100.0f);
+    baro_filter::stats baro_stats = baro_outliers.get_stats();
+    printf("  baro filter: %u replaced, %u locked out in %u lockouts\n",
+        (unsigned) baro_stats.replaced, (unsigned) baro_stats.locked_out,
+        (unsigned) baro_stats.lockouts);
+
+    printf("stages:       count   sim mean/max us   host mean/max ns\n");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        const stage_stats &st = stats[i];
+        uint64_t n = st.count > 0 ? st.count : 1;
+        printf("  %-10s %8llu %8llu %8llu %9llu %8llu\n", st.name,
+            (unsigned long long) st.count,
+            (unsigned long long) (st.sim_total_us / n),
+            (unsigned long long) st.sim_max_us,
+            (unsigned long long) (st.host_total_ns / n),
+            (unsigned long long) st.host_max_ns);
+    }
+}
@@ -0,0 +1,171 @@
+
+#ifndef AIRBRAKES_SDK_HOST_FLIGHT_COMPUTER_H_
+#define AIRBRAKES_SDK_HOST_FLIGHT_COMPUTER_H_
+
+#include <sdk/altitude.h>
+#include <sdk/apogee.h>
+#include <sdk/baro_filter.h>
+#include <sdk/boot_sequencer.h>
+#include <sdk/i2c.h>
+#include <sdk/sensor_hub.h>
+#include <sdk/topic.h>
+#include <sdk/vertical_kalman.h>
+#include <sdk/drivers/bmi088.h>
+#include <sdk/drivers/bmp390.h>
+#include <sdk/drivers/motor_controller.h>
+#include <sdk/sim/flight.h>
+
+#include <stm32f4xx_hal.h>
+
+#include <stdint.h>
+
+/*
+ * The airbrakes flight software as the host harnesses run it: the sensor hub
+ * task feeding the vertical Kalman filter, the control task solving for a
+ * deployment, and the motor task closing the loop on the encoder. Each stage
+ * is timed twice: in simulated time (what the target would see, including
+ * bus waits) and in host time (CPU cost on this machine, which for the sensor
+ * stage also includes the sim kernel's task switches).
+ *
+ * Only one instance may exist; it owns the HAL I2C and EXTI callbacks.
+ */
+class flight_computer {
+public:
+
+    enum stage {
+        SENSORS, /* driver reads, parse and compensation */
+        ESTIMATOR, /* Kalman predict/update */
+        CONTROLLER, /* deployment solve */
+        MOTOR, /* PID update */
+        END_TO_END, /* IMU sample time to motor target set */
+        STAGE_COUNT,
+    };
+
+    struct stage_stats {
+        const char *name;
+        uint64_t count;
+        uint64_t sim_total_us;
+        uint64_t sim_max_us;
+        uint64_t host_total_ns;
+        uint64_t host_max_ns;
+    };
+
+    /** One control decision */
+    struct output {
+        uint64_t time_us; /* sdk::clock */
+        float altitude_m;
+        float velocity_ms;
+        float acceleration_ms2;
+        float deployment_deg;
+        float predicted_apogee_m;
+    };
+
+    using output_fn = void (*)(const output &out, void *ctx);
+
+    struct config {
+        float target_apogee_m;
+        sdk::apogee_predictor::config predictor;
+        float gear_ratio; /* motor revolutions per brake revolution */
+        float counts_per_rev; /* encoder counts per motor revolution */
+    };
+
+    /* board wiring */
+    static constexpr uint16_t MOTOR_NSLEEP_PIN = GPIO_PIN_0;
+    static constexpr uint16_t MOTOR_SH1_PIN = GPIO_PIN_1;
+    static constexpr uint16_t MOTOR_SH2_PIN = GPIO_PIN_2;
+    static constexpr uint16_t ENCODER_A_PIN = GPIO_PIN_6;
+    static constexpr uint16_t ENCODER_B_PIN = GPIO_PIN_7;
+    static constexpr uint16_t I2C_SCL_PIN = GPIO_PIN_8;
+    static constexpr uint16_t I2C_SDA_PIN = GPIO_PIN_9;
+
+public:
+
+    /**
+     * Motor, encoder and I2C pins are on GPIOB, PWM on channels 1/2 of
+     * `htim`.
+     */
+    flight_computer(const config &conf, I2C_HandleTypeDef *hi2c,
+            TIM_HandleTypeDef *htim);
+
+    /** The controller's model of a simulated airframe */
+    static sdk::apogee_predictor::config airframe(
+            const sdk::sim::flight &model);
+
+    /** Called on every control decision, from the control task */
+    void set_output(output_fn fn, void *ctx)
+    {
+        on_output = fn;
+        output_ctx = ctx;
+    }
+
+    /** Installs a tap on the sensor bus, see sdk::i2c_master::set_tap */
+    void set_i2c_tap(sdk::i2c_master::tap_fn fn, void *ctx);
+
+    /** Forwards an encoder pin interrupt */
+    void on_encoder_edge(uint16_t pin)
+    {
+        motors.get_encoder().read_and_update(pin);
+    }
+
+    /** Creates the tasks. Call before starting the scheduler. */
+    void start();
+
+    const stage_stats &get_stats(stage s) const { return stats[s]; }
+
+    /** Prints boot, sensor hub and stage stats */
+    void print_stats() const;
+
+    /** The last thing the controller decided */
+    const output &get_last_output() const { return last_output; }
+    float get_peak_deployment_deg() const { return peak_deployment_deg; }
+
+private:
+    static void sensor_task(void *params);
+    static void control_task(void *params);
+    static void motor_task(void *params);
+
+    /* boot steps, see sensor_task */
+    static bool probe_imu(void *ctx);
+    static bool start_imu(void *ctx);
+    static bool configure_imu(void *ctx);
+    static bool probe_baro(void *ctx);
+    static bool calibrate_baro(void *ctx);
+    static bool configure_baro(void *ctx);
+
+    static uint32_t imu_period(void *ctx);
+    static uint32_t baro_period(void *ctx);
+    static bool read_imu(void *ctx);
+    static bool read_baro(void *ctx);
+    static void on_imu(void *ctx);
+    static void on_baro(void *ctx);
+
+    void record(stage s, uint64_t sim_us, uint64_t host_ns);
+
+    config conf;
+
+    sdk::i2c_master i2c;
+    sdk::bmi088 imu;
+    sdk::bmp390 baro;
+    sdk::baro_filter baro_outliers;
+    sdk::motor_controller motors;
+    sdk::boot_sequencer boot;
+    sdk::sensor_hub hub;
+
+    sdk::vertical_kalman kalman;
+    sdk::altitude_estimator ground;
+    bool ground_set = false;
+    uint64_t last_imu_us = 0;
+    sdk::topic<sdk::vertical_kalman::state, 8> estimates;
+    uint64_t last_sample_us = 0; /* IMU time behind the newest estimate */
+
+    sdk::apogee_predictor predictor;
+
+    output_fn on_output = nullptr;
+    void *output_ctx = nullptr;
+
+    stage_stats stats[STAGE_COUNT];
+    output last_output = {};
+    float peak_deployment_deg = 0;
+};
+
+#endif // AIRBRAKES_SDK_HOST_FLIGHT_COMPUTER_H_
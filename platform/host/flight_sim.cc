@@ -0,0 +1,267 @@
+
+/*
+ * Runs a whole simulated flight on the host: the SDK drivers, estimator and
+ * controller (see flight_computer.h) against simulated sensors and actuator,
+ * with FreeRTOS tasks on the sim kernel. Prints what happened and how much
+ * faster than real time it ran, so it doubles as a performance regression
+ * check. Control decisions are downlinked as telemetry packets over a UART
+ * looped back to a simulated ground station. Optionally records the sensor
+ * bus to an I2C log for airbrakes_sdk_replay.
+ *
+ * usage: airbrakes_sdk_sim [target_apogee_m] [time_limit_s] [log.bin]
+ */
+
+#include "flight_computer.h"
+
+#include <sdk/clock.h>
+#include <sdk/i2c_log.h>
+#include <sdk/packet.h>
+#include <sdk/spi.h>
+#include <sdk/uart.h>
+#include <sdk/drivers/w25q16jv.h>
+
+#include <sdk/sim/actuator_sim.h>
+#include <sdk/sim/bmi088_sim.h>
+#include <sdk/sim/bmp390_sim.h>
+#include <sdk/sim/flight.h>
+#include <sdk/sim/kernel.h>
+#include <sdk/sim/w25q16jv_sim.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace sdk;
+
+static I2C_HandleTypeDef hi2c1;
+static SPI_HandleTypeDef hspi1;
+static TIM_HandleTypeDef htim2;
+static UART_HandleTypeDef huart1; /* radio */
+static UART_HandleTypeDef huart2; /* the ground station's end of the link */
+
+#define FLASH_CS_PORT GPIOA
+#define FLASH_CS_PIN GPIO_PIN_4
+
+/* the world */
+static sim::flight world(sim::flight::DEFAULT_CONFIG);
+static sim::bmi088_sim imu_sim(world, sim::bmi088_sim::DEFAULT_CONFIG);
+static sim::bmp390_sim baro_sim(world, sim::bmp390_sim::DEFAULT_CONFIG);
+static sim::w25q16jv_sim flash_sim;
+static sim::actuator_sim actuator(world, sim::actuator_sim::DEFAULT_CONFIG, {
+    &htim2, TIM_CHANNEL_1, &htim2, TIM_CHANNEL_2,
+    GPIOB, flight_computer::MOTOR_NSLEEP_PIN,
+    GPIOB, flight_computer::ENCODER_A_PIN,
+    GPIOB, flight_computer::ENCODER_B_PIN,
+});
+
+static w25q16jv *flash;
+static float time_limit_s = 200.0f;
+
+/* downlinked control decision */
+struct telemetry {
+    uint32_t time_ms;
+    float altitude_m;
+    float velocity_ms;
+    float deployment_deg;
+    float predicted_apogee_m;
+};
+
+static constexpr uint64_t TELEMETRY_PERIOD_US = 20000;
+
+static uart *radio;
+static uart *ground;
+
+struct ground_station {
+    uint32_t received;
+    telemetry last;
+};
+
+static ground_station station;
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    uart::from_handle(huart)->tx_complete_from_isr();
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    uart::from_handle(huart)->rx_event_from_isr(Size);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    uart::from_handle(huart)->error_from_isr();
+}
+
+static void send_telemetry(const flight_computer::output &out, void *ctx)
+{
+    uint64_t &next_us = *(uint64_t *) ctx;
+    if (out.time_us < next_us)
+        return;
+    next_us = out.time_us + TELEMETRY_PERIOD_US;
+
+    telemetry t = {
+        (uint32_t) (out.time_us / 1000), out.altitude_m, out.velocity_ms,
+        out.deployment_deg, out.predicted_apogee_m,
+    };
+    // never blocks the control task; a saturated link drops and counts
+    radio->send_packet(&t, sizeof(t));
+}
+
+static void on_telemetry(const uint8_t *payload, uint16_t size, void *ctx)
+{
+    ground_station &gs = *(ground_station *) ctx;
+    if (size != sizeof(telemetry))
+        return;
+    memcpy(&gs.last, payload, sizeof(telemetry));
+    gs.received++;
+}
+
+static packet::decoder downlink(on_telemetry, &station);
+
+static void ground_task(void *params)
+{
+    (void) params;
+    uint8_t buffer[64];
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        uint16_t size;
+        while ((size = ground->receive(buffer, sizeof(buffer))) > 0)
+            downlink.feed(buffer, size);
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(10));
+    }
+}
+
+static void write_log_record(void *ctx, uint64_t issued_us,
+        uint16_t device_address, uint16_t reg_address, const uint8_t *data,
+        uint16_t data_size, bool write)
+{
+    i2c_log::record r = i2c_log::make_record(issued_us, device_address,
+        reg_address, data, data_size, write);
+    fwrite(&r, sizeof(r), 1, (FILE *) ctx);
+}
+
+static void monitor_task(void *params)
+{
+    (void) params;
+    struct log_record {
+        uint32_t time_ms;
+        float altitude_m;
+        float deployment_deg;
+    };
+
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        const sim::flight::state &s = world.get_state();
+        if (s.phase == sim::flight::phase::LANDED || s.time_s > time_limit_s)
+            vTaskEndScheduler();
+
+        log_record record = {
+            (uint32_t) (clock::now_us() / 1000), (float) s.altitude_m,
+            (float) s.deployment_deg,
+        };
+        flash->queue_write(0, (const uint8_t *) &record, sizeof(record));
+        flash->update();
+
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(100));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    flight_computer::config conf = {
+        600.0f, flight_computer::airframe(world),
+        (float) sim::actuator_sim::DEFAULT_CONFIG.gear_ratio,
+        (float) sim::actuator_sim::DEFAULT_CONFIG.counts_per_rev,
+    };
+    if (argc > 1)
+        conf.target_apogee_m = (float) atof(argv[1]);
+    if (argc > 2)
+        time_limit_s = (float) atof(argv[2]);
+
+    FILE *log = nullptr;
+    if (argc > 3) {
+        log = fopen(argv[3], "wb");
+        if (log == nullptr) {
+            perror(argv[3]);
+            return 1;
+        }
+        i2c_log::header h = i2c_log::make_header();
+        fwrite(&h, sizeof(h), 1, log);
+    }
+
+    HAL_Init();
+    clock::start();
+
+    hi2c1.Instance = I2C1;
+    hi2c1.Init.ClockSpeed = 400000;
+    HAL_I2C_Init(&hi2c1);
+    hspi1.Instance = SPI1;
+    htim2.Instance = TIM2;
+    htim2.Init.Period = 999;
+    huart1.Instance = USART1;
+    huart1.Init.BaudRate = 57600;
+    HAL_UART_Init(&huart1);
+    huart2.Instance = USART2;
+    huart2.Init.BaudRate = 57600;
+    HAL_UART_Init(&huart2);
+    HAL_GPIO_WritePin(FLASH_CS_PORT, FLASH_CS_PIN, GPIO_PIN_SET);
+
+    imu_sim.attach(&hi2c1);
+    baro_sim.attach(&hi2c1);
+    sim::hal::attach_i2c_pins(&hi2c1, GPIOB, flight_computer::I2C_SCL_PIN,
+        GPIOB, flight_computer::I2C_SDA_PIN);
+    flash_sim.attach(&hspi1, FLASH_CS_PORT, FLASH_CS_PIN);
+    sim::hal::connect(&huart1, &huart2);
+
+    static flight_computer computer(conf, &hi2c1, &htim2);
+    static spi spi1(&hspi1);
+    static w25q16jv flash1(spi1, unique_pin(FLASH_CS_PORT, FLASH_CS_PIN));
+    flash = &flash1;
+    static uart radio1(&huart1);
+    static uart ground1(&huart2);
+    radio = &radio1;
+    ground = &ground1;
+    ground->start();
+    static uint64_t next_telemetry_us = 0;
+    computer.set_output(send_telemetry, &next_telemetry_us);
+    if (log != nullptr)
+        computer.set_i2c_tap(write_log_record, log);
+
+    world.start();
+    actuator.start();
+    computer.start();
+    xTaskCreate(monitor_task, "monitor", 512, nullptr, 1, nullptr);
+    xTaskCreate(ground_task, "ground", 512, nullptr, 1, nullptr);
+
+    auto wall_start = std::chrono::steady_clock::now();
+    vTaskStartScheduler();
+    double wall_s = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - wall_start).count();
+
+    if (log != nullptr)
+        fclose(log);
+
+    const sim::flight::state &s = world.get_state();
+    double sim_s = (double) sim::kernel::now_ns() * 1e-9;
+    printf("flight: apogee %.1f m (target %.1f m, last prediction %.1f m), "
+        "peak deployment %.1f deg\n", s.apogee_m, conf.target_apogee_m,
+        computer.get_last_output().predicted_apogee_m,
+        computer.get_peak_deployment_deg());
+    printf("time: %.2f s simulated in %.3f s wall, %.1fx real time, "
+        "%llu task switches\n", sim_s, wall_s, sim_s / wall_s,
+        (unsigned long long) sim::kernel::get_switch_count());
+    uart::stats link = radio->get_stats();
+    const packet::decoder::stats &rx = downlink.get_stats();
+    printf("telemetry: %lu bytes sent, %lu packets dropped, %lu received "
+        "(%lu bad), last at %.1f s %.1f m\n", (unsigned long) link.tx_bytes,
+        (unsigned long) link.tx_dropped, (unsigned long) station.received,
+        (unsigned long) (rx.crc_errors + rx.framing_errors),
+        station.last.time_ms / 1000.0, station.last.altitude_m);
+    computer.print_stats();
+    return 0;
+}
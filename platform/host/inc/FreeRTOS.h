@@ -0,0 +1,73 @@
+
+#ifndef AIRBRAKES_SDK_HOST_FREERTOS_H_
+#define AIRBRAKES_SDK_HOST_FREERTOS_H_
+
+/*
+ * Host stand-in for the FreeRTOS kernel headers. Only the API the SDK uses is
+ * provided; it is implemented on std::thread in src/sim/kernel.cc with a
+ * simulated clock, see sdk::sim::kernel.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FreeRTOSConfig.h"
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE ((BaseType_t) 0)
+#define pdTRUE ((BaseType_t) 1)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define errQUEUE_EMPTY ((BaseType_t) 0)
+#define errQUEUE_FULL ((BaseType_t) 0)
+
+#define portMAX_DELAY ((TickType_t) 0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t) 1000 / configTICK_RATE_HZ)
+
+#define pdMS_TO_TICKS(ms) ((TickType_t) (((uint64_t) (ms) * \
+    (uint64_t) configTICK_RATE_HZ) / (uint64_t) 1000U))
+
+/*
+ * Only one simulated context (a task or an ISR) ever runs at a time, so
+ * critical sections have nothing to exclude.
+ */
+#define taskENTER_CRITICAL() do { } while (0)
+#define taskEXIT_CRITICAL() do { } while (0)
+#define taskENTER_CRITICAL_FROM_ISR() ((UBaseType_t) 0)
+#define taskEXIT_CRITICAL_FROM_ISR(saved) ((void) (saved))
+#define taskDISABLE_INTERRUPTS() do { } while (0)
+#define taskENABLE_INTERRUPTS() do { } while (0)
+
+/* ISRs run between tasks, the scheduler picks the woken task afterwards */
+#define portYIELD_FROM_ISR(woken) ((void) (woken))
+#define portEND_SWITCHING_ISR(woken) ((void) (woken))
+
+/* opaque storage for statically allocated kernel objects */
+typedef struct {
+    union {
+        void *p;
+        uint64_t u;
+        long double d;
+    } storage[24];
+} StaticQueue_t;
+typedef StaticQueue_t StaticSemaphore_t;
+typedef struct {
+    void *p[4];
+} StaticTask_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void *pvPortMalloc(size_t size);
+void vPortFree(void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AIRBRAKES_SDK_HOST_FREERTOS_H_
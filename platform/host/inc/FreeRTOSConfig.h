@@ -0,0 +1,23 @@
+
+#ifndef AIRBRAKES_SDK_HOST_FREERTOS_CONFIG_H_
+#define AIRBRAKES_SDK_HOST_FREERTOS_CONFIG_H_
+
+/* Kernel configuration of the host simulation, mirrors the firmware's */
+
+#ifndef configTICK_RATE_HZ
+#define configTICK_RATE_HZ 1000
+#endif
+
+#ifndef configMAX_PRIORITIES
+#define configMAX_PRIORITIES 8
+#endif
+
+#ifndef configTASK_NOTIFICATION_ARRAY_ENTRIES
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 3
+#endif
+
+#define configMINIMAL_STACK_SIZE 128
+#define configSUPPORT_STATIC_ALLOCATION 1
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+
+#endif // AIRBRAKES_SDK_HOST_FREERTOS_CONFIG_H_
@@ -0,0 +1,52 @@
+
+#ifndef AIRBRAKES_SDK_HOST_QUEUE_H_
+#define AIRBRAKES_SDK_HOST_QUEUE_H_
+
+#include "FreeRTOS.h"
+
+typedef struct QueueDefinition *QueueHandle_t;
+
+#define queueSEND_TO_BACK ((BaseType_t) 0)
+#define queueSEND_TO_FRONT ((BaseType_t) 1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size,
+    uint8_t *storage, StaticQueue_t *queue);
+void vQueueDelete(QueueHandle_t queue);
+
+BaseType_t xQueueGenericSend(QueueHandle_t queue, const void *item,
+    TickType_t ticks, BaseType_t position);
+BaseType_t xQueueGenericSendFromISR(QueueHandle_t queue, const void *item,
+    BaseType_t *woken, BaseType_t position);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void *item,
+    BaseType_t *woken);
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks);
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+UBaseType_t uxQueueMessagesWaitingFromISR(QueueHandle_t queue);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue);
+BaseType_t xQueueReset(QueueHandle_t queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define xQueueSend(q, item, ticks) \
+    xQueueGenericSend((q), (item), (ticks), queueSEND_TO_BACK)
+#define xQueueSendToBack(q, item, ticks) \
+    xQueueGenericSend((q), (item), (ticks), queueSEND_TO_BACK)
+#define xQueueSendToFront(q, item, ticks) \
+    xQueueGenericSend((q), (item), (ticks), queueSEND_TO_FRONT)
+#define xQueueSendFromISR(q, item, woken) \
+    xQueueGenericSendFromISR((q), (item), (woken), queueSEND_TO_BACK)
+#define xQueueSendToBackFromISR(q, item, woken) \
+    xQueueGenericSendFromISR((q), (item), (woken), queueSEND_TO_BACK)
+#define xQueueSendToFrontFromISR(q, item, woken) \
+    xQueueGenericSendFromISR((q), (item), (woken), queueSEND_TO_FRONT)
+
+#endif // AIRBRAKES_SDK_HOST_QUEUE_H_
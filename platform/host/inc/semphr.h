@@ -0,0 +1,36 @@
+
+#ifndef AIRBRAKES_SDK_HOST_SEMPHR_H_
+#define AIRBRAKES_SDK_HOST_SEMPHR_H_
+
+#include "queue.h"
+#include "task.h"
+
+/* as in FreeRTOS, semaphores are queues of zero-sized items */
+typedef QueueHandle_t SemaphoreHandle_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buffer);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max,
+    UBaseType_t initial);
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t semaphore);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define xSemaphoreTake(s, ticks) xQueueReceive((s), NULL, (ticks))
+#define xSemaphoreTakeFromISR(s, woken) xQueueReceiveFromISR((s), NULL, \
+    (woken))
+#define xSemaphoreGive(s) xQueueGenericSend((s), NULL, 0, queueSEND_TO_BACK)
+#define xSemaphoreGiveFromISR(s, woken) xQueueGenericSendFromISR((s), NULL, \
+    (woken), queueSEND_TO_BACK)
+#define uxSemaphoreGetCount(s) uxQueueMessagesWaiting((s))
+#define vSemaphoreDelete(s) vQueueDelete((s))
+
+#endif // AIRBRAKES_SDK_HOST_SEMPHR_H_
@@ -0,0 +1,128 @@
+
+#ifndef AIRBRAKES_SDK_HOST_STM32F401XC_H_
+#define AIRBRAKES_SDK_HOST_STM32F401XC_H_
+
+/*
+ * Host stand-in for the STM32F401xC device header: the peripheral register
+ * blocks the SDK touches, backed by plain memory in src/sim/hal.cc.
+ */
+
+#include <stdint.h>
+
+#define __IO volatile
+
+typedef struct {
+    __IO uint32_t MODER;
+    __IO uint32_t OTYPER;
+    __IO uint32_t OSPEEDR;
+    __IO uint32_t PUPDR;
+    __IO uint32_t IDR;
+    __IO uint32_t ODR;
+    __IO uint32_t BSRR;
+    __IO uint32_t LCKR;
+    __IO uint32_t AFR[2];
+} GPIO_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t SMCR;
+    __IO uint32_t DIER;
+    __IO uint32_t SR;
+    __IO uint32_t EGR;
+    __IO uint32_t CCMR1;
+    __IO uint32_t CCMR2;
+    __IO uint32_t CCER;
+    __IO uint32_t CNT;
+    __IO uint32_t PSC;
+    __IO uint32_t ARR;
+    __IO uint32_t RCR;
+    __IO uint32_t CCR1;
+    __IO uint32_t CCR2;
+    __IO uint32_t CCR3;
+    __IO uint32_t CCR4;
+    __IO uint32_t BDTR;
+    __IO uint32_t DCR;
+    __IO uint32_t DMAR;
+    __IO uint32_t OR;
+} TIM_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t SR;
+    __IO uint32_t DR;
+    __IO uint32_t CRCPR;
+    __IO uint32_t RXCRCR;
+    __IO uint32_t TXCRCR;
+    __IO uint32_t I2SCFGR;
+    __IO uint32_t I2SPR;
+} SPI_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t OAR1;
+    __IO uint32_t OAR2;
+    __IO uint32_t DR;
+    __IO uint32_t SR1;
+    __IO uint32_t SR2;
+    __IO uint32_t CCR;
+    __IO uint32_t TRISE;
+    __IO uint32_t FLTR;
+} I2C_TypeDef;
+
+typedef struct {
+    __IO uint32_t SR;
+    __IO uint32_t DR;
+    __IO uint32_t BRR;
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t CR3;
+    __IO uint32_t GTPR;
+} USART_TypeDef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern GPIO_TypeDef host_gpio[8];
+extern TIM_TypeDef host_tim[5];
+extern SPI_TypeDef host_spi[3];
+extern I2C_TypeDef host_i2c[3];
+extern USART_TypeDef host_usart[3];
+
+extern uint32_t SystemCoreClock;
+
+#ifdef __cplusplus
+}
+#endif
+
+#define GPIOA (&host_gpio[0])
+#define GPIOB (&host_gpio[1])
+#define GPIOC (&host_gpio[2])
+#define GPIOD (&host_gpio[3])
+#define GPIOE (&host_gpio[4])
+#define GPIOH (&host_gpio[7])
+
+#define TIM1 (&host_tim[0])
+#define TIM2 (&host_tim[1])
+#define TIM3 (&host_tim[2])
+#define TIM4 (&host_tim[3])
+#define TIM5 (&host_tim[4])
+
+#define SPI1 (&host_spi[0])
+#define SPI2 (&host_spi[1])
+#define SPI3 (&host_spi[2])
+
+#define I2C1 (&host_i2c[0])
+#define I2C2 (&host_i2c[1])
+#define I2C3 (&host_i2c[2])
+
+#define I2C_CR1_SWRST (1u << 15)
+
+#define USART1 (&host_usart[0])
+#define USART2 (&host_usart[1])
+#define USART6 (&host_usart[2])
+
+#endif // AIRBRAKES_SDK_HOST_STM32F401XC_H_
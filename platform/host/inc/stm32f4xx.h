@@ -0,0 +1,10 @@
+
+#ifndef AIRBRAKES_SDK_HOST_STM32F4XX_H_
+#define AIRBRAKES_SDK_HOST_STM32F4XX_H_
+
+#include "stm32f401xc.h"
+
+/* as with USE_HAL_DRIVER on the target */
+#include "stm32f4xx_hal.h"
+
+#endif // AIRBRAKES_SDK_HOST_STM32F4XX_H_
@@ -0,0 +1,32 @@
+
+#ifndef AIRBRAKES_SDK_HOST_STM32F4XX_HAL_DEF_H_
+#define AIRBRAKES_SDK_HOST_STM32F4XX_HAL_DEF_H_
+
+#include "stm32f4xx.h"
+
+#include <stddef.h>
+
+typedef enum {
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U,
+} HAL_StatusTypeDef;
+
+typedef enum {
+    HAL_UNLOCKED = 0x00U,
+    HAL_LOCKED = 0x01U,
+} HAL_LockTypeDef;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+#ifndef __weak
+#define __weak __attribute__((weak))
+#endif
+
+typedef struct {
+    void *Instance;
+    void *Parent;
+} DMA_HandleTypeDef;
+
+#endif // AIRBRAKES_SDK_HOST_STM32F4XX_HAL_DEF_H_
@@ -0,0 +1,79 @@
+
+#ifndef AIRBRAKES_SDK_HOST_STM32F4XX_HAL_UART_H_
+#define AIRBRAKES_SDK_HOST_STM32F4XX_HAL_UART_H_
+
+#include "stm32f4xx_hal_def.h"
+
+typedef struct {
+    uint32_t BaudRate; /* used for transfer timing */
+    uint32_t WordLength;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t Mode;
+    uint32_t HwFlowCtl;
+    uint32_t OverSampling;
+} UART_InitTypeDef;
+
+typedef enum {
+    HAL_UART_STATE_RESET = 0x00U,
+    HAL_UART_STATE_READY = 0x20U,
+    HAL_UART_STATE_BUSY = 0x24U,
+    HAL_UART_STATE_BUSY_TX = 0x21U,
+    HAL_UART_STATE_BUSY_RX = 0x22U,
+    HAL_UART_STATE_ERROR = 0xE0U,
+} HAL_UART_StateTypeDef;
+
+#define HAL_UART_ERROR_NONE 0x00000000U
+#define HAL_UART_ERROR_PE 0x00000001U /* parity */
+#define HAL_UART_ERROR_NE 0x00000002U /* noise */
+#define HAL_UART_ERROR_FE 0x00000004U /* frame */
+#define HAL_UART_ERROR_ORE 0x00000008U /* overrun */
+#define HAL_UART_ERROR_DMA 0x00000010U
+
+typedef struct __UART_HandleTypeDef {
+    USART_TypeDef *Instance;
+    UART_InitTypeDef Init;
+
+    uint8_t *pTxBuffPtr;
+    uint16_t TxXferSize;
+    __IO uint16_t TxXferCount;
+
+    uint8_t *pRxBuffPtr;
+    uint16_t RxXferSize;
+    __IO uint16_t RxXferCount;
+
+    DMA_HandleTypeDef *hdmatx;
+    DMA_HandleTypeDef *hdmarx;
+
+    HAL_LockTypeDef Lock;
+    __IO HAL_UART_StateTypeDef gState; /* transmit, and global */
+    __IO HAL_UART_StateTypeDef RxState;
+    __IO uint32_t ErrorCode;
+} UART_HandleTypeDef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart,
+    const uint8_t *pData, uint16_t Size);
+/* the DMA stream is circular, as configured in CubeMX */
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart,
+    uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart);
+
+HAL_UART_StateTypeDef HAL_UART_GetState(UART_HandleTypeDef *huart);
+uint32_t HAL_UART_GetError(UART_HandleTypeDef *huart);
+
+/* weak, defined by the application as on the target */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AIRBRAKES_SDK_HOST_STM32F4XX_HAL_UART_H_
@@ -0,0 +1,61 @@
+
+#ifndef AIRBRAKES_SDK_HOST_TASK_H_
+#define AIRBRAKES_SDK_HOST_TASK_H_
+
+#include "FreeRTOS.h"
+
+typedef struct tskTaskControlBlock *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define tskIDLE_PRIORITY ((UBaseType_t) 0)
+
+#define taskYIELD() vTaskYield()
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name,
+    uint32_t stack_depth, void *arg, UBaseType_t priority,
+    TaskHandle_t *created);
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name,
+    uint32_t stack_depth, void *arg, UBaseType_t priority,
+    StackType_t *stack, StaticTask_t *tcb);
+void vTaskDelete(TaskHandle_t task);
+
+/*
+ * Runs the simulation until vTaskEndScheduler, sdk::sim::kernel::stop or a
+ * deadlock. Unlike the target port, it returns.
+ */
+void vTaskStartScheduler(void);
+void vTaskEndScheduler(void);
+
+void vTaskDelay(TickType_t ticks);
+BaseType_t xTaskDelayUntil(TickType_t *previous_wake, TickType_t increment);
+#define vTaskDelayUntil(previous_wake, increment) \
+    ((void) xTaskDelayUntil((previous_wake), (increment)))
+void vTaskYield(void);
+
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task);
+const char *pcTaskGetName(TaskHandle_t task);
+
+BaseType_t xTaskNotifyGiveIndexed(TaskHandle_t task, UBaseType_t index);
+void vTaskNotifyGiveIndexedFromISR(TaskHandle_t task, UBaseType_t index,
+    BaseType_t *woken);
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear,
+    TickType_t ticks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define xTaskNotifyGive(task) xTaskNotifyGiveIndexed((task), 0)
+#define vTaskNotifyGiveFromISR(task, woken) \
+    vTaskNotifyGiveIndexedFromISR((task), 0, (woken))
+#define ulTaskNotifyTake(clear, ticks) ulTaskNotifyTakeIndexed(0, (clear), \
+    (ticks))
+
+#endif // AIRBRAKES_SDK_HOST_TASK_H_
@@ -0,0 +1,133 @@
+
+/*
+ * Replays a recorded I2C log (see sdk/i2c_log.h) through the unchanged
+ * drivers, estimator and controller (see flight_computer.h), as fast as the
+ * host allows. Reports per-stage latency and throughput and writes every
+ * control decision to a CSV, so estimator or controller changes can be
+ * compared on identical input. The brakes are the simulated actuator, moving
+ * a model of the default simulated airframe.
+ *
+ * usage: airbrakes_sdk_replay log.bin [target_apogee_m] [out.csv]
+ */
+
+#include "flight_computer.h"
+
+#include <sdk/sim/actuator_sim.h>
+#include <sdk/sim/flight.h>
+#include <sdk/sim/i2c_replay.h>
+#include <sdk/sim/kernel.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace sdk;
+
+static I2C_HandleTypeDef hi2c1;
+static TIM_HandleTypeDef htim2;
+
+static sim::i2c_replay replay;
+
+/* never started, only carries the brake deployment */
+static sim::flight brakes(sim::flight::DEFAULT_CONFIG);
+static sim::actuator_sim actuator(brakes, sim::actuator_sim::DEFAULT_CONFIG, {
+    &htim2, TIM_CHANNEL_1, &htim2, TIM_CHANNEL_2,
+    GPIOB, flight_computer::MOTOR_NSLEEP_PIN,
+    GPIOB, flight_computer::ENCODER_A_PIN,
+    GPIOB, flight_computer::ENCODER_B_PIN,
+});
+
+static void write_csv(const flight_computer::output &out, void *ctx)
+{
+    fprintf((FILE *) ctx, "%llu,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+        (unsigned long long) out.time_us, out.altitude_m, out.velocity_ms,
+        out.acceleration_ms2, out.deployment_deg, out.predicted_apogee_m);
+}
+
+static void monitor_task(void *params)
+{
+    (void) params;
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        if (replay.is_finished())
+            vTaskEndScheduler();
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(100));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s log.bin [target_apogee_m] [out.csv]\n",
+            argv[0]);
+        return 2;
+    }
+    if (!replay.load(argv[1])) {
+        fprintf(stderr, "%s: not a readable I2C log\n", argv[1]);
+        return 1;
+    }
+
+    flight_computer::config conf = {
+        600.0f, flight_computer::airframe(brakes),
+        (float) sim::actuator_sim::DEFAULT_CONFIG.gear_ratio,
+        (float) sim::actuator_sim::DEFAULT_CONFIG.counts_per_rev,
+    };
+    if (argc > 2)
+        conf.target_apogee_m = (float) atof(argv[2]);
+
+    FILE *csv = nullptr;
+    if (argc > 3) {
+        csv = fopen(argv[3], "w");
+        if (csv == nullptr) {
+            perror(argv[3]);
+            return 1;
+        }
+        fprintf(csv, "time_us,altitude_m,velocity_ms,acceleration_ms2,"
+            "deployment_deg,predicted_apogee_m\n");
+    }
+
+    HAL_Init();
+    clock::start();
+
+    hi2c1.Instance = I2C1;
+    hi2c1.Init.ClockSpeed = 400000;
+    HAL_I2C_Init(&hi2c1);
+    htim2.Instance = TIM2;
+    htim2.Init.Period = 999;
+
+    replay.attach(&hi2c1);
+
+    static flight_computer computer(conf, &hi2c1, &htim2);
+    if (csv != nullptr)
+        computer.set_output(write_csv, csv);
+
+    actuator.start();
+    computer.start();
+    xTaskCreate(monitor_task, "monitor", 512, nullptr, 1, nullptr);
+
+    auto wall_start = std::chrono::steady_clock::now();
+    vTaskStartScheduler();
+    double wall_s = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - wall_start).count();
+
+    if (csv != nullptr)
+        fclose(csv);
+
+    double sim_s = (double) sim::kernel::now_ns() * 1e-9;
+    const flight_computer::stage_stats &est =
+        computer.get_stats(flight_computer::ESTIMATOR);
+    printf("replay: %u records, %.2f s of log\n",
+        (unsigned) replay.get_record_count(),
+        (double) replay.get_duration_us() * 1e-6);
+    printf("time: %.2f s replayed in %.3f s wall, %.1fx real time, "
+        "%.0f estimator updates/s\n", sim_s, wall_s, sim_s / wall_s,
+        (double) est.count / wall_s);
+    printf("controller: peak deployment %.1f deg, last prediction %.1f m "
+        "(target %.1f m)\n", computer.get_peak_deployment_deg(),
+        computer.get_last_output().predicted_apogee_m, conf.target_apogee_m);
+    computer.print_stats();
+    return 0;
+}
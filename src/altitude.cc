@@ -0,0 +1,115 @@
+
+#include <sdk/altitude.h>
+#include <sdk/constexpr_math.h>
+
+#include <math.h>
+
+namespace sdk {
+
+/* ISA barometric formula constants, h = SCALE * (1 - (p/p0)^EXPONENT) */
+static constexpr double BARO_SCALE = 44330.77;
+static constexpr double BARO_EXPONENT = 0.190263;
+
+struct altitude_table {
+    float altitude_m[altitude_estimator::TABLE_SIZE];
+};
+
+static constexpr double TABLE_STEP =
+    ((double) altitude_estimator::TABLE_MAX_PRESSURE -
+     (double) altitude_estimator::TABLE_MIN_PRESSURE) /
+    (altitude_estimator::TABLE_SIZE - 1);
+
+static constexpr altitude_table make_altitude_table()
+{
+    altitude_table table{};
+    for (int i = 0; i < altitude_estimator::TABLE_SIZE; i++) {
+        double p = altitude_estimator::TABLE_MIN_PRESSURE + i * TABLE_STEP;
+        double ratio = p / altitude_estimator::SEA_LEVEL_PRESSURE;
+        table.altitude_m[i] = (float) (BARO_SCALE *
+            (1.0 - constexpr_math::pow(ratio, BARO_EXPONENT)));
+    }
+    return table;
+}
+
+/* generated at compile time, lives in flash (1 KiB) */
+static constexpr altitude_table ALTITUDE_TABLE = make_altitude_table();
+
+altitude_estimator::altitude_estimator(real alpha, real beta) : alpha(alpha),
+        beta(beta), initialized(false), current_state{}
+{
+}
+
+altitude_estimator::real altitude_estimator::pressure_to_altitude(
+        real pressure_pascals)
+{
+    constexpr real inv_step = (real) (1.0 / TABLE_STEP);
+    real pos = (pressure_pascals - TABLE_MIN_PRESSURE) * inv_step;
+
+    // also catches NaN
+    if (!(pos >= 0.0f && pos < (real) (TABLE_SIZE - 1)))
+        return pressure_to_altitude_exact(pressure_pascals);
+
+    int idx = (int) pos;
+    real frac = pos - (real) idx;
+    real lo = ALTITUDE_TABLE.altitude_m[idx];
+    real hi = ALTITUDE_TABLE.altitude_m[idx + 1];
+    return lo + frac * (hi - lo);
+}
+
+altitude_estimator::real altitude_estimator::pressure_to_altitude_exact(
+        real pressure_pascals)
+{
+    return (real) BARO_SCALE * (1.0f - powf(pressure_pascals /
+        SEA_LEVEL_PRESSURE, (real) BARO_EXPONENT));
+}
+
+void altitude_estimator::capture_ground(const bmp390::state &baro)
+{
+    if (baro.sample_quality == bmp390::quality::LOCKED_OUT)
+        return;
+    real altitude = pressure_to_altitude(baro.pressure_pascals);
+
+    // running mean, numerically fine for the few thousand samples on the pad
+    current_state.ground_samples++;
+    current_state.ground_altitude_m += (altitude -
+        current_state.ground_altitude_m) / (real) current_state.ground_samples;
+    initialized = false;
+}
+
+void altitude_estimator::reset_ground()
+{
+    current_state = state{};
+    initialized = false;
+}
+
+void altitude_estimator::update(const bmp390::state &baro, real dt)
+{
+    if (baro.sample_quality == bmp390::quality::LOCKED_OUT) {
+        // nothing was measured, so coast
+        if (initialized)
+            current_state.altitude_m += current_state.vertical_velocity_ms * dt;
+        return;
+    }
+
+    real measured = pressure_to_altitude(baro.pressure_pascals) -
+        current_state.ground_altitude_m;
+
+    if (!initialized) {
+        current_state.altitude_m = measured;
+        current_state.vertical_velocity_ms = 0;
+        initialized = true;
+        return;
+    }
+
+    // predict
+    real predicted = current_state.altitude_m +
+        current_state.vertical_velocity_ms * dt;
+    real residual = measured - predicted;
+
+    // correct
+    current_state.altitude_m = predicted + alpha * residual;
+    if (dt > 0)
+        current_state.vertical_velocity_ms += beta * residual / dt;
+}
+
+} // namespace sdk
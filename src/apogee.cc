@@ -0,0 +1,209 @@
+
+#include <sdk/apogee.h>
+#include <sdk/constexpr_math.h>
+#include <sdk/fast_math.h>
+
+namespace sdk {
+
+/* ISA troposphere density, rho = RHO0 * (1 - LAPSE * h)^EXPONENT */
+static constexpr double ISA_RHO0 = 1.225;
+static constexpr double ISA_LAPSE = 2.25577e-5;
+static constexpr double ISA_DENSITY_EXPONENT = 4.25588;
+
+static constexpr int DENSITY_TABLE_SIZE = 129;
+static constexpr double DENSITY_TABLE_STEP = 80.0; /* m, covers 0-10240 m ASL */
+
+/* fraction of the remaining climb at which density is sampled, see predict */
+static constexpr apogee_predictor::real CLIMB_DENSITY_POINT = 0.38f;
+
+/* bisection iterations, resolves max_deployment_deg / 2^12 */
+static constexpr int SOLVE_ITERATIONS = 12;
+
+/*
+ * layers the long-climb fallback splits the estimated climb into; 8 keeps it
+ * within 0.03% of RK4 at 3-6 km climbs
+ */
+static constexpr int FALLBACK_LAYERS = 8;
+
+struct density_table {
+    float density[DENSITY_TABLE_SIZE];
+};
+
+static constexpr density_table make_density_table()
+{
+    density_table table{};
+    for (int i = 0; i < DENSITY_TABLE_SIZE; i++) {
+        double h = i * DENSITY_TABLE_STEP;
+        table.density[i] = (float) (ISA_RHO0 *
+            constexpr_math::pow(1.0 - ISA_LAPSE * h, ISA_DENSITY_EXPONENT));
+    }
+    return table;
+}
+
+/* generated at compile time, lives in flash */
+static constexpr density_table DENSITY_TABLE = make_density_table();
+
+/*
+ * closed-form climb (in m) until v = 0 for dv/dt = -g - k v^2 with constant k,
+ * where v2 is the initial speed squared
+ */
+static apogee_predictor::real ballistic_climb(apogee_predictor::real k,
+        apogee_predictor::real v2)
+{
+    constexpr apogee_predictor::real g = apogee_predictor::GRAVITY_EARTH;
+    apogee_predictor::real u = k * v2 / g;
+
+    // ln(1 + u) / 2k loses precision as k -> 0, use the series instead
+    if (u < 1e-4f)
+        return v2 / (2.0f * g) * (1.0f - 0.5f * u);
+    return fast_math::log(1.0f + u) / (2.0f * k);
+}
+
+apogee_predictor::real apogee_predictor::air_density(real altitude_m)
+{
+    constexpr real inv_step = (real) (1.0 / DENSITY_TABLE_STEP);
+    real pos = (altitude_m + conf.ground_altitude_asl_m) * inv_step;
+
+    // clamp to the table, also catches NaN
+    if (!(pos > 0.0f))
+        return DENSITY_TABLE.density[0];
+    if (pos >= (real) (DENSITY_TABLE_SIZE - 1))
+        return DENSITY_TABLE.density[DENSITY_TABLE_SIZE - 1];
+
+    int idx = (int) pos;
+    real frac = pos - (real) idx;
+    real lo = DENSITY_TABLE.density[idx];
+    real hi = DENSITY_TABLE.density[idx + 1];
+    return lo + frac * (hi - lo);
+}
+
+apogee_predictor::real apogee_predictor::drag_area(real deployment_deg)
+{
+    real pos = deployment_deg / conf.max_deployment_deg *
+        (real) (DRAG_TABLE_SIZE - 1);
+
+    if (!(pos > 0.0f))
+        return conf.drag_area_m2[0];
+    if (pos >= (real) (DRAG_TABLE_SIZE - 1))
+        return conf.drag_area_m2[DRAG_TABLE_SIZE - 1];
+
+    int idx = (int) pos;
+    real frac = pos - (real) idx;
+    real lo = conf.drag_area_m2[idx];
+    real hi = conf.drag_area_m2[idx + 1];
+    return lo + frac * (hi - lo);
+}
+
+apogee_predictor::real apogee_predictor::predict(real altitude_m,
+        real velocity_ms, real deployment_deg)
+{
+    if (velocity_ms <= 0)
+        return altitude_m;
+
+    real c = drag_area(deployment_deg) / (2.0f * conf.coast_mass_kg);
+    real v2 = velocity_ms * velocity_ms;
+
+    // first guess with density at the current altitude, then refine with the
+    // effective density of the climb. most of the drag loss happens early
+    // while the rocket is still fast, so the effective point sits below the
+    // midpoint; 38% keeps the error within 0.15% of RK4 up to a 3 km climb
+    real climb = ballistic_climb(air_density(altitude_m) * c, v2);
+    climb = ballistic_climb(air_density(altitude_m + CLIMB_DENSITY_POINT *
+        climb) * c, v2);
+
+    if (climb > FAST_PATH_MAX_CLIMB)
+        return predict_layered(altitude_m, v2, c, climb);
+    return altitude_m + climb;
+}
+
+apogee_predictor::real apogee_predictor::predict_layered(real altitude_m,
+        real v2, real c, real climb_estimate)
+{
+    constexpr real g = GRAVITY_EARTH;
+    real layer = climb_estimate / (real) FALLBACK_LAYERS;
+    real h = altitude_m;
+    real w = v2;
+
+    // with density constant over a layer, v^2 obeys dw/dh = -2g - 2k w
+    // exactly: w' = w e^-x - 2g dh (1 - e^-x) / x, x = 2k dh. taking
+    // density at each layer's midpoint leaves no step-size limit on drag
+    for (int i = 0; i < FALLBACK_LAYERS; i++) {
+        real k = air_density(h + 0.5f * layer) * c;
+        real rest = ballistic_climb(k, w);
+        if (rest <= layer)
+            return h + ballistic_climb(air_density(h + 0.5f * rest) * c, w);
+
+        real x = 2.0f * k * layer;
+        real decay = fast_math::exp(-x);
+        // (1 - e^-x) / x, by its series where the difference cancels
+        real lost = x < 1e-3f ? 1.0f - 0.5f * x : (1.0f - decay) / x;
+        w = w * decay - 2.0f * g * layer * lost;
+        h += layer;
+    }
+    // the estimate fell short, finish as the fast path does
+    real k = air_density(h) * c;
+    real rest = ballistic_climb(k, w);
+    return h + ballistic_climb(air_density(h + CLIMB_DENSITY_POINT * rest) *
+        c, w);
+}
+
+apogee_predictor::real apogee_predictor::predict_integrated(real altitude_m,
+        real velocity_ms, real deployment_deg, real step_s, int max_steps)
+{
+    real c = drag_area(deployment_deg) / (2.0f * conf.coast_mass_kg);
+    real h = altitude_m;
+    real v = velocity_ms;
+
+    // vertical coast only, so v > 0 until apogee and v|v| = v^2
+    auto accel = [this, c](real h, real v) {
+        return -GRAVITY_EARTH - air_density(h) * c * v * v;
+    };
+
+    for (int i = 0; i < max_steps && v > 0; i++) {
+        real k1h = v;
+        real k1v = accel(h, v);
+        real k2h = v + 0.5f * step_s * k1v;
+        real k2v = accel(h + 0.5f * step_s * k1h, k2h);
+        real k3h = v + 0.5f * step_s * k2v;
+        real k3v = accel(h + 0.5f * step_s * k2h, k3h);
+        real k4h = v + step_s * k3v;
+        real k4v = accel(h + step_s * k3h, k4h);
+
+        real next_h = h + step_s / 6.0f * (k1h + 2.0f * k2h + 2.0f * k3h + k4h);
+        real next_v = v + step_s / 6.0f * (k1v + 2.0f * k2v + 2.0f * k3v + k4v);
+
+        if (next_v <= 0) {
+            // apogee is inside this step, assume constant deceleration
+            real t = step_s * v / (v - next_v);
+            return h + 0.5f * v * t;
+        }
+        h = next_h;
+        v = next_v;
+    }
+    return h;
+}
+
+apogee_predictor::real apogee_predictor::solve_deployment(real altitude_m,
+        real velocity_ms, real target_apogee_m)
+{
+    real lo = 0;
+    real hi = conf.max_deployment_deg;
+
+    // target is out of reach, saturate
+    if (predict(altitude_m, velocity_ms, lo) <= target_apogee_m)
+        return lo;
+    if (predict(altitude_m, velocity_ms, hi) >= target_apogee_m)
+        return hi;
+
+    // apogee is non-increasing in deployment
+    for (int i = 0; i < SOLVE_ITERATIONS; i++) {
+        real mid = 0.5f * (lo + hi);
+        if (predict(altitude_m, velocity_ms, mid) > target_apogee_m)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return 0.5f * (lo + hi);
+}
+
+} // namespace sdk
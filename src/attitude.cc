@@ -0,0 +1,88 @@
+
+#include <sdk/attitude.h>
+#include <sdk/fast_math.h>
+
+namespace sdk {
+
+static constexpr attitude_estimator::real RAD_TO_DEG = 57.2957795f;
+
+/* world up expressed in the body frame, third row of R(q) */
+static constexpr vec3 world_up(const quat &q)
+{
+    return {
+        2.0f * (q.x * q.z - q.w * q.y),
+        2.0f * (q.w * q.x + q.y * q.z),
+        q.w * q.w - q.x * q.x - q.y * q.y + q.z * q.z,
+    };
+}
+
+void attitude_estimator::reset()
+{
+    aligned = false;
+    q = { 1, 0, 0, 0 };
+    bias = { 0, 0, 0 };
+}
+
+void attitude_estimator::align(const vec3 &accel_ms2)
+{
+    real n = norm(accel_ms2);
+    if (!(n > 0))
+        return;
+    vec3 a = accel_ms2 * (1.0f / n);
+
+    // shortest rotation taking a onto +z: q = [1 + a.z, a x z], normalised
+    real w = 1.0f + a.z;
+    if (w < 1e-6f) {
+        // upside down, any half turn about a horizontal axis works
+        q = { 0, 1, 0, 0 };
+    } else {
+        q = normalized(quat { w, a.y, -a.x, 0 });
+    }
+    aligned = true;
+}
+
+void attitude_estimator::update(const vec3 &gyro_rads, const vec3 &accel_ms2,
+        real dt)
+{
+    if (!aligned) {
+        align(accel_ms2);
+        return;
+    }
+
+    vec3 g = gyro_rads;
+
+    real a2 = norm2(accel_ms2);
+    real lo = (1.0f - conf.accel_gate) * GRAVITY_EARTH;
+    real hi = (1.0f + conf.accel_gate) * GRAVITY_EARTH;
+
+    // only trust the accelerometer as a gravity reference near 1 g
+    if (a2 > lo * lo && a2 < hi * hi) {
+        vec3 a = accel_ms2 * (fast_math::inv_sqrt(a2));
+
+        // error is the rotation between measured and estimated up
+        vec3 e = cross(a, world_up(q));
+
+        bias += e * (conf.ki * dt);
+        g += e * conf.kp;
+    }
+
+    g += bias;
+
+    // q' = q + 0.5 * q (x) (0, g) * dt
+    q = normalized(q + q * quat { 0, g.x, g.y, g.z } * (0.5f * dt));
+}
+
+attitude_estimator::real attitude_estimator::tilt_cos(const quat &q,
+        const vec3 &body_up)
+{
+    // world z component of R(q) * body_up
+    return dot(world_up(q), body_up);
+}
+
+attitude_estimator::real attitude_estimator::tilt_deg(const quat &q,
+        const vec3 &body_up)
+{
+    return fast_math::acos(tilt_cos(q, body_up)) * RAD_TO_DEG;
+}
+
+} // namespace sdk
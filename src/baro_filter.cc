@@ -0,0 +1,144 @@
+
+#include <sdk/baro_filter.h>
+
+#include <string.h>
+
+namespace sdk {
+
+/* median absolute deviation to standard deviation, for gaussian noise */
+static constexpr baro_filter::real MAD_TO_SIGMA = 1.4826f;
+
+baro_filter::baro_filter(const config &conf) : conf(conf), counts{}
+{
+    reset();
+}
+
+void baro_filter::reset()
+{
+    head = 0;
+    count = 0;
+    last_good_pa = 0;
+    lockout_until_us = 0;
+    manual_lockout = false;
+    was_locked_out = false;
+}
+
+void baro_filter::process(bmp390::state &sample)
+{
+    counts.samples++;
+
+    if (is_locked_out(sample.timestamp_us)) {
+        if (!was_locked_out)
+            counts.lockouts++;
+        was_locked_out = true;
+        counts.locked_out++;
+        sample.pressure_pascals = last_good_pa;
+        sample.sample_quality = bmp390::quality::LOCKED_OUT;
+        return;
+    }
+    if (was_locked_out) {
+        // the window is from before, at another altitude
+        was_locked_out = false;
+        head = 0;
+        count = 0;
+    }
+
+    insert(sample.pressure_pascals);
+    if (count < WINDOW) {
+        // too few to tell an outlier yet
+        last_good_pa = sample.pressure_pascals;
+        sample.sample_quality = bmp390::quality::MEASURED;
+        return;
+    }
+
+    real median = sorted[WINDOW / 2];
+    real limit = conf.threshold * MAD_TO_SIGMA * median_deviation(median);
+    if (limit < conf.min_deviation_pa)
+        limit = conf.min_deviation_pa;
+
+    real deviation = sample.pressure_pascals - median;
+    if (deviation > limit || deviation < -limit) {
+        counts.replaced++;
+        sample.pressure_pascals = median;
+        sample.sample_quality = bmp390::quality::REPLACED;
+    } else {
+        sample.sample_quality = bmp390::quality::MEASURED;
+    }
+    last_good_pa = sample.pressure_pascals;
+}
+
+void baro_filter::update_acceleration(const bmi088::state &imu)
+{
+    if (conf.lockout_accel_ms2 <= 0)
+        return;
+    // compared squared, no need for the root
+    if (norm2(imu.acceleration_ms2) >=
+            conf.lockout_accel_ms2 * conf.lockout_accel_ms2)
+        lockout_until_us = imu.timestamp_us + conf.lockout_hold_us;
+}
+
+void baro_filter::update_acceleration(real specific_force_ms2,
+        uint64_t timestamp_us)
+{
+    if (conf.lockout_accel_ms2 <= 0)
+        return;
+    if (specific_force_ms2 >= conf.lockout_accel_ms2 ||
+            specific_force_ms2 <= -conf.lockout_accel_ms2)
+        lockout_until_us = timestamp_us + conf.lockout_hold_us;
+}
+
+baro_filter::real baro_filter::get_median() const
+{
+    if (count == 0)
+        return 0;
+    return sorted[count / 2];
+}
+
+void baro_filter::insert(real pressure)
+{
+    int size = count;
+    if (count == WINDOW) {
+        // take the oldest out of the sorted copy
+        real oldest = window[head];
+        int at = 0;
+        while (at < WINDOW - 1 && sorted[at] != oldest)
+            at++;
+        memmove(sorted + at, sorted + at + 1,
+            (WINDOW - 1 - at) * sizeof(real));
+        size--;
+    } else {
+        count++;
+    }
+    window[head] = pressure;
+    head = (head + 1) % WINDOW;
+
+    int at = size;
+    while (at > 0 && sorted[at - 1] > pressure) {
+        sorted[at] = sorted[at - 1];
+        at--;
+    }
+    sorted[at] = pressure;
+}
+
+baro_filter::real baro_filter::median_deviation(real median) const
+{
+    // the deviations grow outward from the median on both sides, so the
+    // median of them is found merging the two sides, halfway
+    int below = WINDOW / 2 - 1;
+    int above = WINDOW / 2 + 1;
+    real deviation = 0;
+    for (int i = 0; i < WINDOW / 2; i++) {
+        real down = below >= 0 ? median - sorted[below] : -1;
+        real up = above < WINDOW ? sorted[above] - median : -1;
+        if (up < 0 || (down >= 0 && down <= up)) {
+            deviation = down;
+            below--;
+        } else {
+            deviation = up;
+            above++;
+        }
+    }
+    return deviation;
+}
+
+} // namespace sdk
@@ -0,0 +1,136 @@
+
+#include <sdk/boot_sequencer.h>
+
+namespace sdk {
+
+int boot_sequencer::add(const char *name, step_fn fn, void *ctx,
+        uint32_t depends, uint32_t settle_us)
+{
+    // dependencies come first, so the graph has no cycles
+    if (count >= MAX_STEPS || started || (depends >> count) != 0)
+        return -1;
+
+    int id = count++;
+    entry &e = steps[id];
+    e.fn = fn;
+    e.ctx = ctx;
+    e.depends = depends;
+    e.chain_us = 0;
+    e.stats = step_stats{};
+    e.stats.name = name;
+    e.stats.status = step_status::PENDING;
+    e.stats.settle_us = settle_us;
+    return id;
+}
+
+uint64_t boot_sequencer::ready_at(entry &e)
+{
+    uint64_t ready = start_us;
+    for (int i = 0; i < count; i++) {
+        if (!(e.depends & after(i)))
+            continue;
+        const step_stats &dep = steps[i].stats;
+        if (dep.status == step_status::FAILED ||
+                dep.status == step_status::SKIPPED) {
+            e.stats.status = step_status::SKIPPED;
+            return UINT64_MAX;
+        }
+        if (dep.status == step_status::PENDING)
+            return UINT64_MAX;
+        if (dep.end_us + dep.settle_us > ready)
+            ready = dep.end_us + dep.settle_us;
+    }
+    return ready;
+}
+
+uint64_t boot_sequencer::step(uint64_t now_us)
+{
+    if (!started) {
+        started = true;
+        start_us = now_us;
+
+        // dependents have higher ids, so one backwards pass finds the chains
+        for (int i = count - 1; i >= 0; i--) {
+            entry &e = steps[i];
+            uint64_t longest = 0;
+            for (int j = i + 1; j < count; j++) {
+                if ((steps[j].depends & after(i)) &&
+                        steps[j].chain_us > longest)
+                    longest = steps[j].chain_us;
+            }
+            e.chain_us = e.stats.settle_us + longest;
+        }
+    }
+
+    for (;;) {
+        // pick the runnable step heading the longest chain of delays
+        entry *next = nullptr;
+        uint64_t next_ready = UINT64_MAX;
+        uint64_t earliest = UINT64_MAX;
+        for (int i = 0; i < count; i++) {
+            entry &e = steps[i];
+            if (e.stats.status != step_status::PENDING)
+                continue;
+            uint64_t ready = ready_at(e);
+            if (ready < earliest)
+                earliest = ready;
+            if (ready > now_us)
+                continue;
+            if (next == nullptr || e.chain_us > next->chain_us) {
+                next = &e;
+                next_ready = ready;
+            }
+        }
+        if (next == nullptr)
+            return earliest;
+
+        // a pure delay takes no bus time, so it counts from when it was ready
+        next->stats.ready_us = next_ready;
+        bool ok = true;
+        if (next->fn == nullptr) {
+            next->stats.start_us = next_ready;
+            next->stats.end_us = next_ready;
+        } else {
+            next->stats.start_us = now();
+            ok = next->fn(next->ctx);
+            next->stats.end_us = now();
+            now_us = next->stats.end_us;
+        }
+        next->stats.status = ok ? step_status::DONE : step_status::FAILED;
+    }
+}
+
+bool boot_sequencer::run()
+{
+    for (;;) {
+        uint64_t next = step(now());
+        if (next == UINT64_MAX)
+            return succeeded();
+        uint64_t current = now();
+        // `now` may not be the clock's, so only the wait carries over
+        if (next > current)
+            clock::sleep_until_us(clock::now_us() + (next - current));
+    }
+}
+
+bool boot_sequencer::succeeded() const
+{
+    for (int i = 0; i < count; i++) {
+        if (steps[i].stats.status != step_status::DONE)
+            return false;
+    }
+    return true;
+}
+
+uint64_t boot_sequencer::get_boot_us() const
+{
+    uint64_t end = start_us;
+    for (int i = 0; i < count; i++) {
+        if (steps[i].stats.status != step_status::PENDING &&
+                steps[i].stats.end_us > end)
+            end = steps[i].stats.end_us;
+    }
+    return end - start_us;
+}
+
+} // namespace sdk
@@ -0,0 +1,66 @@
+
+#include <sdk/clock.h>
+
+namespace sdk {
+
+void timebase_sync::reset()
+{
+    initialized = false;
+    anchor_sensor = 0;
+    anchor_local_ns = 0;
+    rate = 0;
+}
+
+int64_t timebase_sync::ticks_since_anchor(uint32_t sensor_ticks) const
+{
+    uint64_t diff = ((uint64_t) sensor_ticks + conf.modulus - anchor_sensor) %
+        conf.modulus;
+    // anything more than half a wrap away is in the past
+    if (diff >= conf.modulus / 2)
+        return (int64_t) diff - (int64_t) conf.modulus;
+    return (int64_t) diff;
+}
+
+void timebase_sync::observe(uint32_t sensor_ticks, uint64_t local_us)
+{
+    uint64_t local_ns = local_us * 1000;
+    if (!initialized) {
+        anchor_sensor = sensor_ticks;
+        anchor_local_ns = local_ns;
+        initialized = true;
+        return;
+    }
+
+    // ignore repeated or out-of-order readings
+    int64_t ticks = ticks_since_anchor(sensor_ticks);
+    if (ticks <= 0)
+        return;
+
+    real elapsed_ns = (real) ticks * conf.tick_us * 1000.0f * (1.0f + rate);
+    uint64_t predicted_ns = anchor_local_ns + (int64_t) elapsed_ns;
+    real error_ns = (real) (int64_t) (local_ns - predicted_ns);
+
+    // second-order loop: nudge the rate, then move the anchor partway
+    rate += conf.rate_gain * error_ns / elapsed_ns;
+    anchor_local_ns = predicted_ns + (int64_t) (conf.phase_gain * error_ns);
+    anchor_sensor = sensor_ticks;
+}
+
+uint64_t timebase_sync::to_local_us(uint32_t sensor_ticks) const
+{
+    real offset_ns = (real) ticks_since_anchor(sensor_ticks) * conf.tick_us *
+        1000.0f * (1.0f + rate);
+    return (anchor_local_ns + (int64_t) offset_ns) / 1000;
+}
+
+uint32_t timebase_sync::to_sensor_ticks(uint64_t local_us) const
+{
+    real offset_ns = (real) (int64_t) (local_us * 1000 - anchor_local_ns);
+    int64_t ticks = (int64_t) (offset_ns /
+        (conf.tick_us * 1000.0f * (1.0f + rate)));
+    int64_t modulus = (int64_t) conf.modulus;
+    return (uint32_t) ((((int64_t) anchor_sensor + ticks) % modulus +
+        modulus) % modulus);
+}
+
+} // namespace sdk
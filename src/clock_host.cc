@@ -0,0 +1,52 @@
+
+#include <sdk/clock.h>
+#include <sdk/sim/kernel.h>
+
+#include <stm32f4xx.h>
+
+namespace sdk {
+
+/*
+ * Host clock: simulated kernel time, scaled to a core clock of
+ * SystemCoreClock so cycle counts read like the target's.
+ */
+
+static void wake_event(void *)
+{
+    clock::wake_from_isr();
+}
+
+static void arm_wake_timer(uint32_t delay_us, void *)
+{
+    sim::kernel::schedule(sim::kernel::now_ns() + (uint64_t) delay_us * 1000,
+        wake_event, nullptr);
+}
+
+void clock::start()
+{
+    // a wake timer as precise as simulated time; a stale one only wakes
+    // the sleeper early, which it checks for
+    set_wake_timer(arm_wake_timer, nullptr);
+}
+
+uint64_t clock::now_cycles()
+{
+    return sim::kernel::now_ns() * cycles_per_us() / 1000;
+}
+
+uint32_t clock::now_cycles32()
+{
+    return (uint32_t) now_cycles();
+}
+
+uint64_t clock::now_us()
+{
+    return sim::kernel::now_ns() / 1000;
+}
+
+uint32_t clock::cycles_per_us()
+{
+    return SystemCoreClock / 1000000;
+}
+
+} // namespace sdk
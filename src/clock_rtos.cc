@@ -0,0 +1,93 @@
+
+#include <sdk/clock.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <atomic>
+
+/*
+ * Task notification index the wake timer signals. i2c_master blocks on index
+ * 0 and topics on index 1, so sleeps take index 2 when the kernel has that
+ * many; with fewer, `sleep_until_us` never uses the wake timer.
+ */
+#ifndef SDK_CLOCK_NOTIFY_INDEX
+#if defined(configTASK_NOTIFICATION_ARRAY_ENTRIES) && \
+        configTASK_NOTIFICATION_ARRAY_ENTRIES >= 3
+#define SDK_CLOCK_NOTIFY_INDEX 2
+#endif
+#endif
+
+namespace sdk {
+
+static constexpr uint64_t US_PER_TICK = 1000000 / configTICK_RATE_HZ;
+
+static clock::wake_timer_fn wake_timer;
+static void *wake_timer_ctx;
+
+/* the task waiting on the wake timer, if any */
+static std::atomic<TaskHandle_t> sleeper{nullptr};
+
+void clock::set_wake_timer(wake_timer_fn arm, void *ctx)
+{
+    wake_timer = arm;
+    wake_timer_ctx = ctx;
+}
+
+void clock::wake_from_isr()
+{
+#ifdef SDK_CLOCK_NOTIFY_INDEX
+    TaskHandle_t task = sleeper.load(std::memory_order_acquire);
+    if (task == nullptr)
+        return;
+    BaseType_t task_woken = pdFALSE;
+    vTaskNotifyGiveIndexedFromISR(task, SDK_CLOCK_NOTIFY_INDEX, &task_woken);
+    portYIELD_FROM_ISR(task_woken);
+#endif
+}
+
+/* sleeps the last stretch on the wake timer, false if it is not available */
+static bool sleep_on_timer(uint64_t left_us)
+{
+#ifdef SDK_CLOCK_NOTIFY_INDEX
+    if (wake_timer == nullptr)
+        return false;
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    TaskHandle_t none = nullptr;
+    if (!sleeper.compare_exchange_strong(none, self))
+        return false;
+
+    // a late wake from an earlier sleep only makes the caller check again
+    ulTaskNotifyTakeIndexed(SDK_CLOCK_NOTIFY_INDEX, pdTRUE, 0);
+    wake_timer((uint32_t) left_us, wake_timer_ctx);
+    // the tick timeout only guards against a timer that never fires
+    ulTaskNotifyTakeIndexed(SDK_CLOCK_NOTIFY_INDEX, pdTRUE,
+        (TickType_t) (left_us / US_PER_TICK + 2));
+    sleeper.store(nullptr, std::memory_order_release);
+    return true;
+#else
+    (void) left_us;
+    return false;
+#endif
+}
+
+void clock::sleep_until_us(uint64_t deadline_us)
+{
+    for (;;) {
+        uint64_t current = now_us();
+        if (current >= deadline_us)
+            return;
+        uint64_t left = deadline_us - current;
+
+        // vTaskDelay(n) wakes between n - 1 and n ticks later, so leave the
+        // last tick or two to the timer
+        if (left < 2 * US_PER_TICK && sleep_on_timer(left))
+            continue;
+        TickType_t ticks = (TickType_t) (left / US_PER_TICK);
+        if (wake_timer != nullptr && ticks >= 2)
+            ticks--;
+        vTaskDelay(ticks > 0 ? ticks : 1);
+    }
+}
+
+} // namespace sdk
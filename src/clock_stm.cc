@@ -0,0 +1,43 @@
+
+#include <sdk/clock.h>
+
+#include <stm32f4xx.h>
+#include <FreeRTOS.h>
+#include <task.h>
+
+namespace sdk {
+
+static counter_extender cycle_counter;
+
+void clock::start()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint64_t clock::now_cycles()
+{
+    // the extender state is shared between tasks and ISRs
+    UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+    uint64_t out = cycle_counter.extend(DWT->CYCCNT);
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+    return out;
+}
+
+uint32_t clock::now_cycles32()
+{
+    return DWT->CYCCNT;
+}
+
+uint64_t clock::now_us()
+{
+    return now_cycles() / cycles_per_us();
+}
+
+uint32_t clock::cycles_per_us()
+{
+    return SystemCoreClock / 1000000;
+}
+
+} // namespace sdk
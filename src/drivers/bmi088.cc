@@ -5,100 +5,86 @@
 
 namespace sdk {
 
-void bmi088::set_acc_config(acc_range range, acc_bwp bwp, acc_odr odr)
+bool bmi088::set_acc_config(acc_range range, acc_bwp bwp, acc_odr odr)
 {
-    acc_range curr_range;
-    acc_bwp curr_bwp;
-    acc_odr curr_odr;
+    scoped_lock lock(config_mutex);
+    stage_acc_config(range, bwp, odr);
+    return flush_config();
+}
 
-    // scoped read from internal state
-    {
-        scoped_lock lock(state_mutex);
-        curr_range = internal_state.acc_range;
-        curr_bwp = internal_state.acc_bwp;
-        curr_odr = internal_state.acc_odr;
-    }
+bool bmi088::set_gyro_config(gyro_range range, gyro_bw bw)
+{
+    scoped_lock lock(config_mutex);
+    stage_gyro_config(range, bw);
+    return flush_config();
+}
 
-    if (range != curr_range) { 
-        auto status = i2c.write(
-            SLAVE_ADDRESS_ACC << 1,
-            ACC_RANGE_ADDR,
-            (uint8_t *) &range,
-            1,
-            false
-        );
-        if (status != i2c_master::status::OK) {
-            /* TODO: error condition */
-            return;
-        }
-        scoped_lock lock(state_mutex);
-        internal_state.acc_range = range;
-    }
+void bmi088::stage_acc_config(acc_range range, acc_bwp bwp, acc_odr odr)
+{
+    uint8_t acc_conf = 0;
+    acc_conf |= (uint8_t)odr;
+    acc_conf |= ((uint8_t)bwp) << 4;
+    acc_conf |= 1 << 7; /* last bit must always be 1 (see 5.3.8) */
 
-    if (bwp != curr_bwp || odr != curr_odr) {
-        uint8_t acc_conf = 0;
-        acc_conf |= (uint8_t)odr;
-        acc_conf |= ((uint8_t)bwp) << 4;
-        acc_conf |= 1 << 7; /* last bit must always be 1 (see 5.3.8) */
-        auto status = i2c.write(
-            SLAVE_ADDRESS_ACC << 1,
-            ACC_CONF_ADDR,
-            &acc_conf,
-            1,
-            false
-        );
-        if (status != i2c_master::status::OK) {
-            /* TODO: error condition */
-            return;
-        }
-        scoped_lock lock(state_mutex);
-        internal_state.acc_bwp = bwp;
-        internal_state.acc_odr = odr;
-    }
+    // ACC_CONF and ACC_RANGE are adjacent, one burst if both changed
+    acc_regs.set(ACC_CONF_ADDR, acc_conf);
+    acc_regs.set(ACC_RANGE_ADDR, (uint8_t) range);
 }
 
-void bmi088::set_gyro_config(gyro_range range, gyro_bw bw)
+void bmi088::stage_gyro_config(gyro_range range, gyro_bw bw)
 {
-    gyro_range curr_range;
-    gyro_bw curr_bw;
+    gyro_regs.set(GYRO_RANGE_ADDR, (uint8_t) range);
+    gyro_regs.set(GYRO_BANDWIDTH_ADDR, (uint8_t) bw);
+}
 
-    {
-        scoped_lock lock(state_mutex);
-        curr_range = internal_state.gyro_range;
-        curr_bw = internal_state.gyro_bw;
+bool bmi088::flush_config()
+{
+    if (gyro_regs.flush() != i2c_master::status::OK ||
+            acc_regs.flush() != i2c_master::status::OK)
+        return false;
+
+    uint8_t acc_conf = acc_regs.get(ACC_CONF_ADDR);
+    acc_range range = (acc_range) acc_regs.get(ACC_RANGE_ADDR);
+    gyro_range g_range = (gyro_range) gyro_regs.get(GYRO_RANGE_ADDR);
+
+    // only what has been written, the rest keeps the reset values
+    scoped_lock lock(state_mutex);
+    if (acc_regs.is_known(ACC_CONF_ADDR)) {
+        internal_state.acc_odr = (acc_odr) (acc_conf & 0x0f);
+        internal_state.acc_bwp = (acc_bwp) ((acc_conf >> 4) & 0x07);
     }
-    
-    if (range != curr_range) {
-        auto status = i2c.write(
-            SLAVE_ADDRESS_GYRO << 1,
-            GYRO_RANGE_ADDR,
-            (uint8_t *) &range,
-            1,
-            false
-        );
-        if (status != i2c_master::status::OK) {
-            /* TODO: error condition */
-            return;
-        }
-        scoped_lock lock(state_mutex);
-        internal_state.gyro_range = range;
+    if (acc_regs.is_known(ACC_RANGE_ADDR)) {
+        internal_state.acc_range = range;
+        internal_state.acc_scale = get_acc_scale(range);
     }
-
-    if (bw != curr_bw) {
-        auto status = i2c.write(
-            SLAVE_ADDRESS_GYRO << 1,
-            GYRO_BANDWIDTH_ADDR,
-            (uint8_t *) &bw,
-            1,
-            false
-        );
-        if (status != i2c_master::status::OK) {
-            /* TODO: error condition */
-            return;
-        }
-        scoped_lock lock(state_mutex);
-        internal_state.gyro_bw = bw;
+    if (gyro_regs.is_known(GYRO_BANDWIDTH_ADDR))
+        internal_state.gyro_bw = (gyro_bw) gyro_regs.get(GYRO_BANDWIDTH_ADDR);
+    if (gyro_regs.is_known(GYRO_RANGE_ADDR)) {
+        internal_state.gyro_range = g_range;
+        internal_state.gyro_scale = get_gyro_scale(g_range);
     }
+    return true;
+}
+
+bool bmi088::start()
+{
+    // accel to active mode and enabled (see 4.1.1), gyro to normal mode
+    return write_reg(SLAVE_ADDRESS_ACC, ACC_PWR_CONF_ADDR, 0x00) ==
+            i2c_master::status::OK &&
+        write_reg(SLAVE_ADDRESS_ACC, ACC_PWR_CTRL_ADDR, 0x04) ==
+            i2c_master::status::OK &&
+        write_reg(SLAVE_ADDRESS_GYRO, GYRO_LPM1_ADDR, 0x00) ==
+            i2c_master::status::OK;
+}
+
+bool bmi088::stop()
+{
+    return write_reg(SLAVE_ADDRESS_ACC, ACC_PWR_CTRL_ADDR, 0x00) ==
+            i2c_master::status::OK &&
+        write_reg(SLAVE_ADDRESS_ACC, ACC_PWR_CONF_ADDR, 0x03) ==
+            i2c_master::status::OK &&
+        write_reg(SLAVE_ADDRESS_GYRO, GYRO_LPM1_ADDR, 0x80) ==
+            i2c_master::status::OK;
 }
 
 bool bmi088::is_connected()
@@ -107,7 +93,7 @@ bool bmi088::is_connected()
     uint8_t acc_chip_id = 0;
     auto status = i2c.read(
         SLAVE_ADDRESS_ACC << 1,
-        ACC_CHIP_ID,
+        ACC_CHIP_ID_ADDR,
         &acc_chip_id,
         1,
         false
@@ -118,7 +104,19 @@ bool bmi088::is_connected()
     return acc_chip_id == ACC_CHIP_ID;
 }
 
-void bmi088::update()
+void bmi088::set_offsets(const offsets &new_offsets)
+{
+    scoped_lock lock(state_mutex);
+    internal_state.offsets = new_offsets;
+}
+
+void bmi088::set_attitude_config(const attitude_estimator::config &conf)
+{
+    scoped_lock lock(state_mutex);
+    internal_state.attitude_config = conf;
+}
+
+bool bmi088::update()
 {
     state out;
 
@@ -131,12 +129,23 @@ void bmi088::update()
     // fetch relevant data
     if (!fetch_data(out)) {
         /* TODO: error condition */
-        return;
+        return false;
     }
     
     // then copy it back
     scoped_lock lock(state_mutex);
     internal_state = out;
+    return true;
+}
+
+bmi088::real bmi088::get_odr_hz()
+{
+    scoped_lock lock(state_mutex);
+    real gyro_hz = get_gyro_odr_hz(internal_state.gyro_bw);
+    if (internal_state.sync_mode != sync_mode::OFF)
+        return gyro_hz;
+    real acc_hz = get_acc_odr_hz(internal_state.acc_odr);
+    return acc_hz > gyro_hz ? acc_hz : gyro_hz;
 }
 
 bmi088::state bmi088::copy_state()
@@ -153,116 +162,185 @@ bmi088::real bmi088::sensortime_to_s(uint32_t sensortime)
 
 bmi088::real bmi088::get_delta_t(uint32_t last_sensortime, uint32_t sensortime)
 {
-    // overflow has occurred
-    if (sensortime < last_sensortime)
-        sensortime += 0x00ffffff;
-    real out = sensortime_to_s(sensortime) - sensortime_to_s(last_sensortime);
-
-    // really make sure that there is no negative times
-    if (out < 0)
-        return 0;
-    return out;
+    // modular difference handles the 24-bit counter wrapping around
+    uint32_t ticks = (sensortime - last_sensortime) & (SENSORTIME_MODULUS - 1);
+    return sensortime_to_s(ticks);
 }
 
-static bmi088::real get_acc_range_multiplier(bmi088::acc_range range)
+void bmi088::parse_frames(const uint8_t *acc_frame, const uint8_t *gyro_frame,
+        state &out)
 {
-    switch (range) {
-    case bmi088::acc_range::RANGE_3G:
-        return 3.0f;
-    case bmi088::acc_range::RANGE_6G:
-        return 6.0f;
-    case bmi088::acc_range::RANGE_12G:
-        return 12.0f;
-    case bmi088::acc_range::RANGE_24G:
-        return 24.0f;
-    }
-}
-
+    out.acc_raw.x = (int16_t) ((acc_frame[1] << 8) | acc_frame[0]);
+    out.acc_raw.y = (int16_t) ((acc_frame[3] << 8) | acc_frame[2]);
+    out.acc_raw.z = (int16_t) ((acc_frame[5] << 8) | acc_frame[4]);
+    uint32_t sensortime = (acc_frame[8] << 16) | (acc_frame[7] << 8) |
+        acc_frame[6];
 
-bool bmi088::fetch_acc_data(state &out)
-{
-    uint8_t data_frame[9];
-    auto status = i2c.read(
-        SLAVE_ADDRESS_ACC << 1,
-        ACC_X_LSB_ADDR,
-        data_frame,
-        sizeof(data_frame),
-        false
-    );
-    if (status != i2c_master::status::OK) {
-        /* TODO: error condition */
-        return false;
-    }
-    int16_t accel_x = (data_frame[1] << 8) | data_frame[0];
-    int16_t accel_y = (data_frame[3] << 8) | data_frame[2];
-    int16_t accel_z = (data_frame[5] << 8) | data_frame[4];
-    uint32_t sensortime = (data_frame[8] << 16) | (data_frame[7] << 8) |
-        data_frame[6];
+    out.gyro_raw.x = (int16_t) ((gyro_frame[1] << 8) | gyro_frame[0]);
+    out.gyro_raw.y = (int16_t) ((gyro_frame[3] << 8) | gyro_frame[2]);
+    out.gyro_raw.z = (int16_t) ((gyro_frame[5] << 8) | gyro_frame[4]);
 
-    real mult = get_acc_range_multiplier(out.acc_range);
-    
-    /* see 5.3.4 */
-    out.acceleration_ms2.x = (GRAVITY_EARTH * (real)accel_x * mult) / 32768.0f;
-    out.acceleration_ms2.y = (GRAVITY_EARTH * (real)accel_y * mult) / 32768.0f;
-    out.acceleration_ms2.z = (GRAVITY_EARTH * (real)accel_z * mult) / 32768.0f;
+    /* see 5.3.4 and 5.5.4, scales are kept up to date by set_*_config */
+    out.acceleration_ms2 = convert(out.acc_raw, out.acc_scale,
+        out.offsets.acc_ms2);
+    out.angular_velocity_ds = convert(out.gyro_raw, out.gyro_scale,
+        out.offsets.gyro_ds);
 
     // its better to have a delta-T of 0 rather than a large amount
     out.last_sensortime = out.uninitialized_sensortime ? sensortime :
         out.sensortime;
     out.uninitialized_sensortime = false;
     out.sensortime = sensortime;
-    return true;
 }
 
-static bmi088::real get_gyro_range_multiplier(bmi088::gyro_range range)
+void bmi088::update_attitude(state &out)
 {
-    switch (range) {
-    case bmi088::gyro_range::RANGE_2000DPS:
-        return 2000.0f;
-    case bmi088::gyro_range::RANGE_1000DPS:
-        return 1000.0f;
-    case bmi088::gyro_range::RANGE_500DPS:
-        return 500.0f;
-    case bmi088::gyro_range::RANGE_250DPS:
-        return 250.0f;
-    case bmi088::gyro_range::RANGE_125DPS:
-        return 125.0f;
-    }
+    real delta_t = get_delta_t(out.last_sensortime, out.sensortime);
+    attitude.set_config(out.attitude_config);
+    attitude.update(out.angular_velocity_ds * DEG_TO_RAD, out.acceleration_ms2,
+        delta_t);
+    out.orientation = attitude.get_orientation();
+    out.gyro_bias_rads = attitude.get_gyro_bias();
 }
 
-bool bmi088::fetch_gyro_data(state &out)
+bool bmi088::fetch_data(state &out)
 {
-    uint8_t data_frame[6];
+    uint8_t acc_frame[ACC_FRAME_SIZE];
+    uint8_t gyro_frame[GYRO_FRAME_SIZE];
+
+    // read back to back so the pair is as close in time as possible; in sync
+    // mode both belong to the same gyro-triggered sample
     auto status = i2c.read(
+        SLAVE_ADDRESS_ACC << 1,
+        ACC_X_LSB_ADDR,
+        acc_frame,
+        sizeof(acc_frame),
+        false
+    );
+    if (status != i2c_master::status::OK) {
+        /* TODO: error condition */
+        return false;
+    }
+    // sensortime latches on the accel read
+    uint64_t read_us = clock::now_us();
+    status = i2c.read(
         SLAVE_ADDRESS_GYRO << 1,
         RATE_X_LSB_ADDR,
-        data_frame,
-        sizeof(data_frame),
+        gyro_frame,
+        sizeof(gyro_frame),
         false
     );
     if (status != i2c_master::status::OK) {
         /* TODO: error condition */
         return false;
     }
-    int16_t rate_x = (data_frame[1] << 8) | data_frame[0];
-    int16_t rate_y = (data_frame[3] << 8) | data_frame[2];
-    int16_t rate_z = (data_frame[5] << 8) | data_frame[4];
-
-    real mult = get_gyro_range_multiplier(out.gyro_range);
-    out.angular_velocity_ds.x = (rate_x * mult) / 32768.0f;
-    out.angular_velocity_ds.y = (rate_y * mult) / 32768.0f;
-    out.angular_velocity_ds.z = (rate_z * mult) / 32768.0f;
 
-    real delta_t = get_delta_t(out.last_sensortime, out.sensortime);
-    out.orientation_deg.x += out.angular_velocity_ds.x * delta_t;
-    out.orientation_deg.y += out.angular_velocity_ds.y * delta_t;
-    out.orientation_deg.z += out.angular_velocity_ds.z * delta_t;
+    parse_frames(acc_frame, gyro_frame, out);
+    sensortime_sync.observe(out.sensortime, read_us);
+    out.timestamp_us = sensortime_sync.to_local_us(out.sensortime);
+    update_attitude(out);
     return true;
 }
 
-bool bmi088::fetch_data(state &out)
+i2c_master::status bmi088::write_reg(int slave_address, uint8_t reg,
+        uint8_t value)
+{
+    return i2c.write(slave_address << 1, reg, &value, 1, false);
+}
+
+bool bmi088::load_feature_config(const uint8_t *config, uint16_t size)
 {
-    return fetch_acc_data(out) && fetch_gyro_data(out);
+    // disable advanced power save while loading, see the BMI08x SensorAPI
+    if (write_reg(SLAVE_ADDRESS_ACC, ACC_PWR_CONF_ADDR, 0x00) !=
+            i2c_master::status::OK)
+        return false;
+    vTaskDelay(pdMS_TO_TICKS(1));
+    if (write_reg(SLAVE_ADDRESS_ACC, ACC_INIT_CTRL_ADDR, 0x00) !=
+            i2c_master::status::OK)
+        return false;
+
+    for (uint16_t index = 0; index < size; index += FEATURE_CONFIG_CHUNK) {
+        // the feature address is in 16-bit words, split 4/8 bits
+        uint16_t word = index / 2;
+        uint8_t addr[2] = {
+            (uint8_t) (word & 0x0f),
+            (uint8_t) (word >> 4),
+        };
+        uint16_t chunk = size - index;
+        if (chunk > FEATURE_CONFIG_CHUNK)
+            chunk = FEATURE_CONFIG_CHUNK;
+
+        if (i2c.write(SLAVE_ADDRESS_ACC << 1, ACC_FEATURE_ADDR_LSB_ADDR, addr,
+                sizeof(addr), false) != i2c_master::status::OK)
+            return false;
+        if (i2c.write(SLAVE_ADDRESS_ACC << 1, ACC_FEATURE_CFG_ADDR,
+                (uint8_t *) config + index, chunk, false) !=
+                i2c_master::status::OK)
+            return false;
+    }
+
+    if (write_reg(SLAVE_ADDRESS_ACC, ACC_INIT_CTRL_ADDR, 0x01) !=
+            i2c_master::status::OK)
+        return false;
+    vTaskDelay(pdMS_TO_TICKS(150));
+
+    uint8_t internal_stat = 0;
+    if (i2c.read(SLAVE_ADDRESS_ACC << 1, ACC_INTERNAL_STAT_ADDR,
+            &internal_stat, 1, false) != i2c_master::status::OK)
+        return false;
+    return (internal_stat & 0x0f) == 0x01; /* init_ok */
+}
+
+bool bmi088::set_sync_mode(sync_mode mode)
+{
+    scoped_lock config_lock(config_mutex);
+    state curr;
+    {
+        scoped_lock lock(state_mutex);
+        curr = internal_state;
+    }
+
+    bool enable = mode != sync_mode::OFF;
+    if (enable) {
+        gyro_bw bw = gyro_bw::BW_230HZ;
+        if (mode == sync_mode::SYNC_1000HZ)
+            bw = gyro_bw::BW_116HZ;
+        else if (mode == sync_mode::SYNC_400HZ)
+            bw = gyro_bw::BW_47HZ;
+
+        // accel runs at its highest rate, the gyro paces the samples
+        stage_gyro_config(curr.gyro_range, bw);
+        stage_acc_config(curr.acc_range, acc_bwp::NORMAL,
+            acc_odr::ODR_1600HZ);
+    }
+
+    // gyro data-ready on INT3, push-pull active high
+    gyro_regs.set(GYRO_INT_CTRL_ADDR, enable ? 0x80 : 0x00);
+    gyro_regs.set(GYRO_INT3_INT4_IO_CONF_ADDR, 0x01);
+    gyro_regs.set(GYRO_INT3_INT4_IO_MAP_ADDR, enable ? 0x01 : 0x00);
+    // accel INT1 is the sync input, INT2 the synchronized data-ready output
+    acc_regs.set(ACC_INT1_IO_CONF_ADDR, enable ? 0x10 : 0x00);
+    acc_regs.set(ACC_INT2_IO_CONF_ADDR, enable ? 0x0a : 0x00);
+    acc_regs.set(ACC_INT2_MAP_ADDR, enable ? 0x01 : 0x00);
+
+    // rates and interrupts together, one burst per run of changed registers
+    if (!flush_config())
+        return false;
+
+    // read-modify-write the data sync word of the feature config
+    uint8_t feature[FEATURE_DATA_SYNC_OFFSET + 2];
+    if (i2c.read(SLAVE_ADDRESS_ACC << 1, ACC_FEATURE_CFG_ADDR, feature,
+            sizeof(feature), false) != i2c_master::status::OK)
+        return false;
+    feature[FEATURE_DATA_SYNC_OFFSET] = (uint8_t) mode;
+    feature[FEATURE_DATA_SYNC_OFFSET + 1] = 0;
+    if (i2c.write(SLAVE_ADDRESS_ACC << 1, ACC_FEATURE_CFG_ADDR, feature,
+            sizeof(feature), false) != i2c_master::status::OK)
+        return false;
+
+    scoped_lock lock(state_mutex);
+    internal_state.sync_mode = mode;
+    return true;
 }
 
 } // namespace sdk
@@ -1,6 +1,8 @@
 
 #include <sdk/drivers/bmp390.h>
 
+#include <sdk/baro_filter.h>
+#include <sdk/clock.h>
 #include <sdk/scoped_lock.h>
 
 namespace sdk {
@@ -15,7 +17,7 @@ bool bmp390::is_connected()
     return (chip_id & 0xf0) == CHIP_ID_FIXED; /* chip_id_fixed <4:7> */
 }
 
-void bmp390::read_calibration_data()
+bool bmp390::read_calibration_data()
 {
     uint8_t reg_data[21];
     i2c_master::status status = i2c.read(
@@ -26,61 +28,93 @@ void bmp390::read_calibration_data()
         false
     );
 
-    if (status != i2c_master::status::OK) {
-        /* TODO: error condition */
-        return;
-    }
+    if (status != i2c_master::status::OK)
+        return false;
 
-    /* this is derived from boschsensortec/BMP3_SensorAPI */
+    set_calibration_data(reg_data);
+    return true;
+}
+
+void bmp390::set_calibration_data(const uint8_t *reg_data)
+{
+    /*
+     * this is derived from boschsensortec/BMP3_SensorAPI; T3, P1-P4 and
+     * P7-P11 are signed
+     */
     uint16_t p = (reg_data[1] << 8) | reg_data[0];
     calib_data.par_t1 = ((real)p * (real)(1 << 8));
     p = (reg_data[3] << 8) | reg_data[2];
     calib_data.par_t2 = ((real)p / (real)(1 << 30));
-    p = reg_data[4];
-    calib_data.par_t3 = ((real)p / (real)((uint64_t) 1 << 48));
-    p = (reg_data[6] << 8) | reg_data[5];
-    calib_data.par_p1 = ((real)(p - 16384) / (real)(1 << 20));
-    p = (reg_data[8] << 8) | reg_data[7];
-    calib_data.par_p2 = ((real)(p - 16384) / (real)(1 << 29)); 
-    p = reg_data[9];
-    calib_data.par_p3 = ((real)p / (real)((uint64_t) 1 << 32));
-    p = reg_data[10];
-    calib_data.par_p4 = ((real)p / (real)((uint64_t) 1 << 37));
+    calib_data.par_t3 = ((real)(int8_t) reg_data[4] /
+        (real)((uint64_t) 1 << 48));
+    int16_t s = (int16_t) ((reg_data[6] << 8) | reg_data[5]);
+    calib_data.par_p1 = ((real)(s - 16384) / (real)(1 << 20));
+    s = (int16_t) ((reg_data[8] << 8) | reg_data[7]);
+    calib_data.par_p2 = ((real)(s - 16384) / (real)(1 << 29)); 
+    calib_data.par_p3 = ((real)(int8_t) reg_data[9] /
+        (real)((uint64_t) 1 << 32));
+    calib_data.par_p4 = ((real)(int8_t) reg_data[10] /
+        (real)((uint64_t) 1 << 37));
     p = (reg_data[12] << 8) | reg_data[11];
     calib_data.par_p5 = ((real)p * (real)(1 << 3));
     p = (reg_data[14] << 8) | reg_data[13];
     calib_data.par_p6 = ((real)p / (real)(1 << 6));
-    p = reg_data[15];
-    calib_data.par_p7 = ((real)p / (real)(1 << 8));
-    p = reg_data[16];
-    calib_data.par_p8 = ((real)p / (real)(1 << 15));
-    p = (reg_data[18] << 8) | reg_data[17];
-    calib_data.par_p9 = ((real)p / (real)((uint64_t) 1 << 48));
-    p = reg_data[19];
-    calib_data.par_p10 = ((real)p / (real)((uint64_t) 1 << 48));
-    p = reg_data[20];
+    calib_data.par_p7 = ((real)(int8_t) reg_data[15] / (real)(1 << 8));
+    calib_data.par_p8 = ((real)(int8_t) reg_data[16] / (real)(1 << 15));
+    s = (int16_t) ((reg_data[18] << 8) | reg_data[17]);
+    calib_data.par_p9 = ((real)s / (real)((uint64_t) 1 << 48));
+    calib_data.par_p10 = ((real)(int8_t) reg_data[19] /
+        (real)((uint64_t) 1 << 48));
     /* 2^65 */
-    calib_data.par_p11 = ((real)p / 36893488147419103232.0f);
+    calib_data.par_p11 = ((real)(int8_t) reg_data[20] /
+        36893488147419103232.0f);
 }
 
-void bmp390::update()
+bool bmp390::update()
 {
     state out;
     bool success = fetch_data(out);
     if (!success) {
         /* TODO: error condition */
-        return;
+        return false;
     }
+    if (filter != nullptr)
+        filter->process(out);
 
     scoped_lock lock(state_mutex);
     current_state = out;
+    return true;
+}
+
+bool bmp390::set_config(uint8_t filter_coefficient)
+{
+    scoped_lock lock(config_mutex);
+    regs.set(CONFIG_ADDR, (filter_coefficient & 0x07) << 1);
+    return regs.flush() == i2c_master::status::OK;
+}
+
+bool bmp390::set_odr(odr rate)
+{
+    scoped_lock config_lock(config_mutex);
+    // the rate first, then the mode, so that it starts at the new rate
+    regs.set(ODR_ADDR, (uint8_t) rate);
+    if (regs.flush() != i2c_master::status::OK)
+        return false;
+
+    regs.set(PWR_CTRL_ADDR, 0x33); /* press_en, temp_en, normal mode */
+    if (regs.flush() != i2c_master::status::OK)
+        return false;
+
+    scoped_lock lock(state_mutex);
+    current_odr = rate;
+    return true;
 }
 
-void bmp390::set_config(uint8_t filter_coefficient)
+bmp390::real bmp390::get_odr_hz()
 {
-    uint8_t config = (filter_coefficient & 0x07) << 1;
-    i2c.write(SLAVE_ADDRESS << 1, CONFIG_ADDR, &config, sizeof(config), false);
-    /* TODO: error handling */
+    scoped_lock lock(state_mutex);
+    // 200 Hz / 2^odr_sel
+    return 200.0f / (real) (1 << (uint8_t) current_odr);
 }
 
 bmp390::state bmp390::copy_state()
@@ -93,9 +127,9 @@ bmp390::state bmp390::copy_state()
 bmp390::real bmp390::compensate_temperature(data_frame frame)
 {
     uint32_t uncomp = 0;
-    uncomp |= frame[0];
-    uncomp |= frame[1] << 8;
-    uncomp |= frame[2] << 16;
+    uncomp |= frame[3];
+    uncomp |= frame[4] << 8;
+    uncomp |= frame[5] << 16;
     real partial0 = (real)uncomp - calib_data.par_t1;
     real partial1 = partial0 * calib_data.par_t2;
 
@@ -105,10 +139,12 @@ bmp390::real bmp390::compensate_temperature(data_frame frame)
 
 bmp390::real bmp390::compensate_pressure(real temp_c, data_frame frame)
 {
-    uint32_t uncomp = 0;
-    uncomp |= frame[3];
-    uncomp |= frame[4] << 8;
-    uncomp |= frame[5] << 16;
+    uint32_t raw = 0;
+    raw |= frame[0];
+    raw |= frame[1] << 8;
+    raw |= frame[2] << 16;
+    // squared and cubed below, which overflows in 32-bit integer math
+    real uncomp = (real) raw;
 
     real partial0 = calib_data.par_p6 * temp_c;
     real partial1 = calib_data.par_p7 * temp_c * temp_c;
@@ -134,7 +170,7 @@ bmp390::real bmp390::compensate_pressure(real temp_c, data_frame frame)
 
 bool bmp390::fetch_data(state &out)
 {
-    // also reads reversed bytes
+    // pressure in bytes 0-2, temperature in 3-5, both little-endian
     data_frame frame;
     if (i2c.read(
         SLAVE_ADDRESS << 1,
@@ -146,6 +182,7 @@ bool bmp390::fetch_data(state &out)
         /* TODO: error condition */
         return false;
     };
+    out.timestamp_us = clock::now_us();
     out.temperature_celsius = compensate_temperature(frame);
     out.pressure_pascals = compensate_pressure(out.temperature_celsius, frame);
     return true;
@@ -1,5 +1,7 @@
 
 #include <sdk/drivers/motor_controller.h>
+#include <sdk/clock.h>
+#include <sdk/trace.h>
 
 namespace sdk {
 
@@ -20,6 +22,7 @@ void motor_controller::set_target_degrees(float new_target)
 
 void motor_controller::update_motor(float dt)
 {
+    SDK_TRACE_BEGIN(MOTOR_UPDATE, 0);
     float curr_degrees = encoder.get_degrees();
     float error = curr_degrees - target_degrees;
 
@@ -42,6 +45,17 @@ void motor_controller::update_motor(float dt)
     else if (output < -1) output = -1;
 
     target_motor.set_power(output);
+    SDK_TRACE_END(MOTOR_UPDATE, (int32_t) (output * 1000));
+}
+
+void motor_controller::update_motor()
+{
+    uint64_t now_us = clock::now_us();
+    uint64_t last_us = last_update_us;
+    last_update_us = now_us;
+    if (last_us == 0 || now_us <= last_us)
+        return;
+    update_motor((float) (now_us - last_us) * 1e-6f);
 }
 
 } // namespace sdk
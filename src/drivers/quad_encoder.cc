@@ -1,5 +1,7 @@
 
 #include <sdk/drivers/quad_encoder.h>
+#include <sdk/clock.h>
+#include <sdk/trace.h>
 
 namespace sdk {
 
@@ -24,9 +26,24 @@ void quad_encoder::read_and_update(uint16_t updated_pin)
     } else {
         /* TODO: imprecision from the rounding */
         count += inc_dec;
+        // the 64-bit clock divides, which waits for task context
+        last_edge_cycles = clock::now_cycles32();
+        edge_seen = true;
+        SDK_TRACE_INSTANT(ENCODER_EDGE, count);
     }
 }
 
+uint64_t quad_encoder::get_last_edge_us()
+{
+    if (!edge_seen)
+        return 0;
+    // read the stamp first, so a newer edge cannot land after `now`
+    uint32_t edge = last_edge_cycles;
+    uint64_t now = clock::now_cycles();
+    uint32_t age = (uint32_t) now - edge;
+    return (now - age) / clock::cycles_per_us();
+}
+
 float quad_encoder::get_revolutions()
 {
     return (float) count / counts_per_rev;
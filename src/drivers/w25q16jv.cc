@@ -7,10 +7,11 @@ namespace sdk {
 
 void w25q16jv::update()
 {
-    while (!write_queue.is_empty()) {
-        write_command command = write_queue.pop();
-
-        vPortFree(command.data);
+    write_command commands[8];
+    uint32_t count;
+    while ((count = write_queue.drain(commands, 8)) > 0) {
+        for (uint32_t i = 0; i < count; i++)
+            vPortFree(commands[i].data);
     }
 }
 
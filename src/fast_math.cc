@@ -0,0 +1,164 @@
+
+#include <sdk/fast_math.h>
+#include <sdk/constexpr_math.h>
+
+namespace sdk {
+
+namespace fast_math {
+
+/* all tables have 2^TABLE_BITS intervals, plus the end point */
+static constexpr int TABLE_BITS = 8;
+static constexpr int TABLE_SIZE = (1 << TABLE_BITS) + 1;
+
+struct table {
+    float value[TABLE_SIZE];
+};
+
+/* sin over one turn */
+static constexpr table make_sin_table()
+{
+    table t{};
+    for (int i = 0; i < TABLE_SIZE; i++)
+        t.value[i] = (float) constexpr_math::sin(
+            2.0 * constexpr_math::PI * i / (TABLE_SIZE - 1));
+    return t;
+}
+
+/* atan over [0, 1] */
+static constexpr table make_atan_table()
+{
+    table t{};
+    for (int i = 0; i < TABLE_SIZE; i++)
+        t.value[i] = (float) constexpr_math::atan((double) i /
+            (TABLE_SIZE - 1));
+    return t;
+}
+
+/* 2^f over f in [0, 1] */
+static constexpr table make_exp2_table()
+{
+    table t{};
+    for (int i = 0; i < TABLE_SIZE; i++)
+        t.value[i] = (float) constexpr_math::exp(constexpr_math::LN_2 * i /
+            (TABLE_SIZE - 1));
+    return t;
+}
+
+/* ln(m) over m in [1, 2] */
+static constexpr table make_log_table()
+{
+    table t{};
+    for (int i = 0; i < TABLE_SIZE; i++)
+        t.value[i] = (float) constexpr_math::log(1.0 + (double) i /
+            (TABLE_SIZE - 1));
+    return t;
+}
+
+/* generated at compile time, live in flash (1 KiB each) */
+static constexpr table SIN_TABLE = make_sin_table();
+static constexpr table ATAN_TABLE = make_atan_table();
+static constexpr table EXP2_TABLE = make_exp2_table();
+static constexpr table LOG_TABLE = make_log_table();
+
+/* linear interpolation at `pos` in [0, TABLE_SIZE - 1] */
+static inline float lookup(const table &t, float pos)
+{
+    int idx = (int) pos;
+    // the last entry is interpolated to from the one before it
+    if (idx > TABLE_SIZE - 2)
+        idx = TABLE_SIZE - 2;
+    float frac = pos - (float) idx;
+    float lo = t.value[idx];
+    return lo + frac * (t.value[idx + 1] - lo);
+}
+
+/* sin of x, offset by `quarter` quarter turns */
+static inline float sin_turns(float x, int quarter)
+{
+    constexpr float scale = (float) ((TABLE_SIZE - 1) /
+        (2.0 * constexpr_math::PI));
+    constexpr int mask = TABLE_SIZE - 2; /* intervals - 1 */
+
+    // split into a whole index (wrapped to one turn) and a fraction
+    float pos = x * scale;
+    int whole = detail::round_to_int(pos - 0.5f);
+    float frac = pos - (float) whole;
+    int idx = (whole + quarter * ((TABLE_SIZE - 1) / 4)) & mask;
+    float lo = SIN_TABLE.value[idx];
+    return lo + frac * (SIN_TABLE.value[idx + 1] - lo);
+}
+
+float sin_lut(float x)
+{
+    return sin_turns(x, 0);
+}
+
+float cos_lut(float x)
+{
+    return sin_turns(x, 1);
+}
+
+float atan2_lut(float y, float x)
+{
+    float ax = x < 0 ? -x : x;
+    float ay = y < 0 ? -y : y;
+    float hi = ax > ay ? ax : ay;
+    if (hi == 0)
+        return 0;
+    float lo = ax > ay ? ay : ax;
+
+    // first octant from the table, then unfolded as in atan2
+    float r = lookup(ATAN_TABLE, lo / hi * (float) (TABLE_SIZE - 1));
+    if (ay > ax)
+        r = HALF_PI - r;
+    if (x < 0)
+        r = PI - r;
+    return y < 0 ? -r : r;
+}
+
+float exp_lut(float x)
+{
+    if (x > 88.7f)
+        return detail::from_bits(0x7f800000);
+    if (x < -87.3f)
+        return 0;
+
+    // e^x = 2^n 2^f, f in [0, 1), reduced with the same split ln(2) as exp
+    int32_t n = detail::round_to_int(x * 1.44269504f - 0.5f);
+    float r = x - (float) n * 0.693359375f + (float) n * 2.12194440e-4f;
+    float f = r * 1.44269504f;
+    if (f < 0) { // rounding at the ends of the interval
+        f += 1.0f;
+        n--;
+    } else if (f >= 1.0f) {
+        f -= 1.0f;
+        n++;
+    }
+    float p = lookup(EXP2_TABLE, f * (float) (TABLE_SIZE - 1));
+    if (n > 127)
+        return p * 2.0f * detail::exp2_int(n - 1);
+    return p * detail::exp2_int(n);
+}
+
+float log_lut(float x)
+{
+    uint32_t bits = detail::to_bits(x);
+    if ((bits & 0x7fffffff) < 0x00800000) // zero or denormal
+        return detail::from_bits(0xff800000);
+    if (bits >= 0x7f800000) // negative, infinity or NaN
+        return (int32_t) bits < 0 ? detail::from_bits(0x7fc00000) : x;
+
+    // x = m 2^e with m in [1, 2); the top mantissa bits index the table
+    int32_t e = (int32_t) (bits >> 23) - 127;
+    uint32_t mantissa = bits & 0x007fffff;
+    int idx = (int) (mantissa >> (23 - TABLE_BITS));
+    float frac = (float) (mantissa & ((1 << (23 - TABLE_BITS)) - 1)) *
+        (1.0f / (float) (1 << (23 - TABLE_BITS)));
+    float lo = LOG_TABLE.value[idx];
+    return lo + frac * (LOG_TABLE.value[idx + 1] - lo) +
+        (float) e * 0.693147181f;
+}
+
+} // namespace fast_math
+
+} // namespace sdk
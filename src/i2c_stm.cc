@@ -1,75 +1,217 @@
 
 #include <sdk/i2c.h>
+#include <sdk/clock.h>
 #include <sdk/scoped_lock.h>
+#include <sdk/trace.h>
 
 #include "stm32f4xx_hal.h"
 #include "stm32f4xx_hal_i2c.h"
 
 namespace sdk {
 
+/* clocks for a device holding SDA to finish its byte and release it */
+static constexpr int RECOVERY_CLOCKS = 9;
+
+/* transfer_error of an abort, which carries no HAL error of its own */
+static constexpr uint32_t ERROR_ABORTED = 0x80000000;
+
 i2c_master *i2c_master::from_handle(I2C_HandleTypeDef *handle)
 {
     return (i2c_master *) handle->hdmatx;
 }
 
+static i2c_master::status from_hal_error(uint32_t error)
+{
+    if (error == HAL_I2C_ERROR_NONE)
+        return i2c_master::status::OK;
+    if (error & HAL_I2C_ERROR_ARLO)
+        return i2c_master::status::ARBITRATION_LOST;
+    if (error & HAL_I2C_ERROR_BERR)
+        return i2c_master::status::BUS_ERROR;
+    if (error & HAL_I2C_ERROR_TIMEOUT)
+        return i2c_master::status::TIMEOUT;
+    if (error & HAL_I2C_ERROR_AF)
+        return i2c_master::status::NACK;
+    return i2c_master::status::ERROR;
+}
+
+/* half an SCL period at 100 kHz, the slowest a device may ask for */
+static void half_bit_delay()
+{
+    // about 4 cycles per iteration
+    for (volatile uint32_t i = 0; i < SystemCoreClock / 800000; i++) {
+    }
+}
+
 i2c_master::status i2c_master::read(uint16_t device_address, uint16_t
-        reg_address, uint8_t *data, uint16_t data_size, bool mem_16bit) 
-{ 
+        reg_address, uint8_t *data, uint16_t data_size, bool mem_16bit,
+        uint32_t timeout_ms)
+{
     // make sure the address can fit
     if (!mem_16bit)
         reg_address &= 0xff;
-    
-    // lock the interface mutex before read
-    scoped_lock lock(interface_mutex);
 
-    HAL_StatusTypeDef status = HAL_I2C_Mem_Read_IT(
-        handle,
-        device_address,
-        reg_address,
-        mem_16bit ? I2C_MEMADD_SIZE_16BIT : I2C_MEMADD_SIZE_8BIT,
-        data,
-        data_size
-    );
-
-    blocked_task = xTaskGetCurrentTaskHandle();
-    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-    return status == HAL_OK ? status::OK : status::ERROR;
+    SDK_TRACE_BEGIN(I2C_READ, (uint32_t) device_address << 16 | reg_address);
+    status result = transfer(device_address, reg_address, data, data_size,
+        mem_16bit, timeout_ms, true);
+    SDK_TRACE_END(I2C_READ, (uint32_t) result);
+    return result;
 }
 
 i2c_master::status i2c_master::write(uint16_t device_address, uint16_t
-        reg_address, uint8_t *data, uint16_t data_size, bool mem_16bit)
+        reg_address, uint8_t *data, uint16_t data_size, bool mem_16bit,
+        uint32_t timeout_ms)
 {
     // make sure the address can fit
     if (!mem_16bit)
         reg_address &= 0xff;
 
-    // lock the interface mutex before write
+    SDK_TRACE_BEGIN(I2C_WRITE, (uint32_t) device_address << 16 | reg_address);
+    status result = transfer(device_address, reg_address, data, data_size,
+        mem_16bit, timeout_ms, false);
+    SDK_TRACE_END(I2C_WRITE, (uint32_t) result);
+    return result;
+}
+
+i2c_master::status i2c_master::transfer(uint16_t device_address,
+        uint16_t reg_address, uint8_t *data, uint16_t data_size,
+        bool mem_16bit, uint32_t timeout_ms, bool read)
+{
+    // lock the interface mutex before the transfer
     scoped_lock lock(interface_mutex);
 
-    HAL_StatusTypeDef status = HAL_I2C_Mem_Write_IT(
-        handle,
-        device_address,
-        reg_address,
-        mem_16bit ? I2C_MEMADD_SIZE_16BIT : I2C_MEMADD_SIZE_8BIT,
-        data,
-        data_size
-    );
-
-    blocked_task = xTaskGetCurrentTaskHandle();
-    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-    return status == HAL_OK ? status::OK : status::ERROR;
+    uint64_t issued_us = tap != nullptr ? clock::now_us() : 0;
+
+    HAL_StatusTypeDef started = start(device_address, reg_address, data,
+        data_size, mem_16bit, read);
+    if (started != HAL_OK)
+        return status::ERROR;
+
+    SDK_TRACE_BEGIN(I2C_WAIT, 0);
+    // at least one full tick, a partial one may be nearly over
+    uint32_t completed = ulTaskNotifyTake(pdTRUE,
+        pdMS_TO_TICKS(timeout_ms) + 1);
+    SDK_TRACE_END(I2C_WAIT, 0);
+
+    if (completed == 0) {
+        // from here on a late callback finds nobody to wake
+        taskENTER_CRITICAL();
+        bool raced = blocked_task == nullptr;
+        blocked_task = nullptr;
+        taskEXIT_CRITICAL();
+        if (raced) {
+            // it completed between the timeout and now; consume the notify
+            ulTaskNotifyTake(pdTRUE, 0);
+        } else {
+            // the statuses below promise a recovered bus
+            return recover(status::TIMEOUT) == status::OK ? status::TIMEOUT :
+                status::ERROR;
+        }
+    }
+
+    status result = from_hal_error(transfer_error);
+    if ((result == status::ARBITRATION_LOST || result == status::BUS_ERROR ||
+            result == status::TIMEOUT) && recover(result) != status::OK)
+        result = status::ERROR;
+
+    if (tap != nullptr && result == status::OK)
+        tap(tap_ctx, issued_us, device_address, reg_address, data, data_size,
+            !read);
+    return result;
+}
+
+HAL_StatusTypeDef i2c_master::start(uint16_t device_address,
+        uint16_t reg_address, uint8_t *data, uint16_t data_size,
+        bool mem_16bit, bool read)
+{
+    uint16_t mem_size = mem_16bit ? I2C_MEMADD_SIZE_16BIT :
+        I2C_MEMADD_SIZE_8BIT;
+    HAL_StatusTypeDef status = HAL_ERROR;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        // the completion interrupt can fire before the HAL call returns
+        transfer_error = HAL_I2C_ERROR_NONE;
+        blocked_task = xTaskGetCurrentTaskHandle();
+        status = read ?
+            HAL_I2C_Mem_Read_IT(handle, device_address, reg_address,
+                mem_size, data, data_size) :
+            HAL_I2C_Mem_Write_IT(handle, device_address, reg_address,
+                mem_size, data, data_size);
+        if (status == HAL_OK)
+            return HAL_OK;
+
+        // nothing was started, so no callback will unblock us
+        blocked_task = nullptr;
+        // busy is a bus held low or a peripheral stuck from an earlier fault
+        if (status != HAL_BUSY ||
+                recover(status::ERROR) != status::OK)
+            break;
+    }
+    return status;
+}
+
+i2c_master::status i2c_master::recover(status cause)
+{
+    (void) cause;
+    SDK_TRACE_BEGIN(I2C_RECOVER, (uint32_t) cause);
+    recovery_count++;
+
+    // takes the pins off the peripheral, a transfer in flight ends here
+    HAL_I2C_DeInit(handle);
+
+    if (scl_port != nullptr && sda_port != nullptr) {
+        GPIO_InitTypeDef pin_init = {};
+        pin_init.Mode = GPIO_MODE_OUTPUT_OD;
+        pin_init.Pull = GPIO_NOPULL;
+        pin_init.Speed = GPIO_SPEED_FREQ_HIGH;
+        HAL_GPIO_WritePin(scl_port, scl_pin, GPIO_PIN_SET);
+        HAL_GPIO_WritePin(sda_port, sda_pin, GPIO_PIN_SET);
+        pin_init.Pin = scl_pin;
+        HAL_GPIO_Init(scl_port, &pin_init);
+        pin_init.Pin = sda_pin;
+        HAL_GPIO_Init(sda_port, &pin_init);
+
+        // clock out whatever byte a device is still sending (see UM10204
+        // 3.1.16), then a STOP: SDA rising while SCL is high
+        for (int i = 0; i < RECOVERY_CLOCKS &&
+                HAL_GPIO_ReadPin(sda_port, sda_pin) == GPIO_PIN_RESET; i++) {
+            HAL_GPIO_WritePin(scl_port, scl_pin, GPIO_PIN_RESET);
+            half_bit_delay();
+            HAL_GPIO_WritePin(scl_port, scl_pin, GPIO_PIN_SET);
+            half_bit_delay();
+        }
+        HAL_GPIO_WritePin(sda_port, sda_pin, GPIO_PIN_RESET);
+        half_bit_delay();
+        HAL_GPIO_WritePin(sda_port, sda_pin, GPIO_PIN_SET);
+        half_bit_delay();
+    }
+
+    // a software reset clears a BUSY flag the peripheral latched from the
+    // glitches (see the STM32F4 errata sheet); init gives it the pins back
+    handle->Instance->CR1 |= I2C_CR1_SWRST;
+    handle->Instance->CR1 &= ~I2C_CR1_SWRST;
+    status result = HAL_I2C_Init(handle) == HAL_OK ? status::OK :
+        status::ERROR;
+    SDK_TRACE_END(I2C_RECOVER, recovery_count);
+    return result;
 }
 
 void i2c_master::unblock_from_isr()
 {
     if (blocked_task == nullptr) {
-        /* TODO: this is an error condition! */
+        // a transfer that already timed out
         return;
     }
-    BaseType_t task_woken;
+    BaseType_t task_woken = pdFALSE;
     vTaskNotifyGiveFromISR(blocked_task, &task_woken);
     blocked_task = nullptr;
     portYIELD_FROM_ISR(task_woken);
 }
 
+void i2c_master::error_from_isr()
+{
+    uint32_t error = HAL_I2C_GetError(handle);
+    transfer_error = error != HAL_I2C_ERROR_NONE ? error : ERROR_ABORTED;
+    unblock_from_isr();
+}
+
 } // namespace sdk
@@ -0,0 +1,127 @@
+
+#include <sdk/imu_calibration.h>
+
+#include <string.h>
+
+namespace sdk {
+
+void running_stats::reset()
+{
+    n = 0;
+    m = { 0, 0, 0 };
+    m2 = { 0, 0, 0 };
+}
+
+void running_stats::add(const vec3 &sample)
+{
+    n++;
+    real inv_n = 1.0f / (real) n;
+
+    vec3 d = sample - m;
+    m += d * inv_n;
+
+    // uses the deviation from both the old and the new mean
+    m2 += hadamard(d, sample - m);
+}
+
+running_stats::vec3 running_stats::variance() const
+{
+    if (n < 2)
+        return { 0, 0, 0 };
+    real inv = 1.0f / (real) (n - 1);
+    return m2 * inv;
+}
+
+void imu_calibration::reset()
+{
+    done = false;
+    acc_stats.reset();
+    gyro_stats.reset();
+}
+
+static bool exceeds(const bmi088::vec3 &variance, bmi088::real max_stddev)
+{
+    bmi088::real max_var = max_stddev * max_stddev;
+    return variance.x > max_var || variance.y > max_var ||
+        variance.z > max_var;
+}
+
+imu_calibration::status imu_calibration::add_sample(
+        const bmi088::state &sample)
+{
+    if (done)
+        return status::DONE;
+
+    // undo the offsets the driver already applied
+    vec3 acc = sample.acceleration_ms2 + sample.offsets.acc_ms2;
+    vec3 gyro = sample.angular_velocity_ds + sample.offsets.gyro_ds;
+
+    // cheap early out on an obvious bump
+    real rate2 = norm2(gyro);
+    if (rate2 > conf.max_gyro_rate_ds * conf.max_gyro_rate_ds) {
+        reset();
+        return status::MOTION_DETECTED;
+    }
+
+    acc_stats.add(acc);
+    gyro_stats.add(gyro);
+    if (acc_stats.count() < conf.window_samples)
+        return status::IN_PROGRESS;
+
+    if (exceeds(gyro_stats.variance(), conf.max_gyro_stddev_ds) ||
+            exceeds(acc_stats.variance(), conf.max_acc_stddev_ms2)) {
+        reset();
+        return status::MOTION_DETECTED;
+    }
+
+    // gyro should read zero at rest
+    result.gyro_ds = gyro_stats.mean();
+
+    // accel should read 1 g along the measured gravity direction; only the
+    // component along gravity is observable from a single orientation
+    vec3 mean = acc_stats.mean();
+    real g = norm(mean);
+    real excess = g > 0 ? (g - bmi088::GRAVITY_EARTH) / g : 0;
+    result.acc_ms2 = mean * excess;
+
+    done = true;
+    return status::DONE;
+}
+
+/* CRC-32 (IEEE 802.3), bitwise since this only runs at boot */
+static uint32_t crc32(const uint8_t *data, uint32_t size)
+{
+    uint32_t crc = 0xffffffff;
+    for (uint32_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+void imu_calibration::serialize(const bmi088::offsets &offsets, uint8_t *out)
+{
+    // little-endian layout: magic, 6 floats, crc of everything before it
+    uint32_t magic = BLOB_MAGIC;
+    memcpy(out, &magic, 4);
+    memcpy(out + 4, &offsets.acc_ms2, 12);
+    memcpy(out + 16, &offsets.gyro_ds, 12);
+    uint32_t crc = crc32(out, BLOB_SIZE - 4);
+    memcpy(out + BLOB_SIZE - 4, &crc, 4);
+}
+
+bool imu_calibration::deserialize(const uint8_t *in, bmi088::offsets &out)
+{
+    uint32_t magic, crc;
+    memcpy(&magic, in, 4);
+    memcpy(&crc, in + BLOB_SIZE - 4, 4);
+    if (magic != BLOB_MAGIC || crc != crc32(in, BLOB_SIZE - 4))
+        return false;
+
+    memcpy(&out.acc_ms2, in + 4, 12);
+    memcpy(&out.gyro_ds, in + 16, 12);
+    return true;
+}
+
+} // namespace sdk
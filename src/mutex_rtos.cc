@@ -1,14 +1,101 @@
 
 #include <sdk/mutex.h>
+#include <sdk/trace.h>
 
 #include <FreeRTOS.h>
 #include <semphr.h>
+#include <task.h>
+
+#ifdef SDK_MUTEX_STATS
+#include <sdk/clock.h>
+
+#include <stdio.h>
+#endif
+
+#if defined(SDK_STATIC_ALLOCATION) && !configSUPPORT_STATIC_ALLOCATION
+#error "SDK_STATIC_ALLOCATION needs configSUPPORT_STATIC_ALLOCATION"
+#endif
 
 namespace sdk {
 
-mutex::mutex()
+#ifdef SDK_MUTEX_STATS
+static mutex *registry_head = nullptr;
+#endif
+
+mutex::mutex(const char *name)
+{
+    create();
+#ifdef SDK_MUTEX_STATS
+    this->name = name;
+    reset_stats();
+    register_self();
+#else
+    (void) name;
+#endif
+}
+
+mutex::~mutex()
+{
+    destroy();
+#ifdef SDK_MUTEX_STATS
+    unregister_self();
+#endif
+}
+
+mutex::mutex(mutex &&other)
+{
+#ifdef SDK_STATIC_ALLOCATION
+    create();
+    other.destroy();
+#else
+    handle = other.handle;
+    other.handle = nullptr;
+#endif
+#ifdef SDK_MUTEX_STATS
+    name = other.name;
+    counters = other.counters;
+    locked_at = other.locked_at;
+    take_registry_entry(other);
+#endif
+}
+
+mutex &mutex::operator=(mutex &&other)
+{
+    if (this == &other)
+        return *this;
+
+    destroy();
+#ifdef SDK_STATIC_ALLOCATION
+    create();
+    other.destroy();
+#else
+    handle = other.handle;
+    other.handle = nullptr;
+#endif
+#ifdef SDK_MUTEX_STATS
+    name = other.name;
+    counters = other.counters;
+    locked_at = other.locked_at;
+    other.unregister_self();
+#endif
+    return *this;
+}
+
+void mutex::create()
 {
+#ifdef SDK_STATIC_ALLOCATION
+    handle = xSemaphoreCreateMutexStatic(&storage);
+#else
+    // null when the heap is exhausted; lock and unlock then report ERROR
     handle = xSemaphoreCreateMutex();
+#endif
+}
+
+void mutex::destroy()
+{
+    if (handle != nullptr)
+        vSemaphoreDelete((SemaphoreHandle_t) handle);
+    handle = nullptr;
 }
 
 void mutex::lock()
@@ -16,18 +103,172 @@ void mutex::lock()
     try_lock(portMAX_DELAY);
 }
 
+#ifndef SDK_MUTEX_STATS
+
 mutex::status mutex::try_lock(uint32_t timeout_ms)
 {
-    return xSemaphoreTake((SemaphoreHandle_t) handle, pdMS_TO_TICKS(timeout_ms))
-        == pdTRUE ? status::OK : status::IN_USE;
+    if (handle == nullptr)
+        return status::ERROR;
+
+    SDK_TRACE_BEGIN(MUTEX_LOCK, (uintptr_t) handle);
+    BaseType_t taken = xSemaphoreTake((SemaphoreHandle_t) handle,
+        pdMS_TO_TICKS(timeout_ms));
+    SDK_TRACE_END(MUTEX_LOCK, taken);
+    return taken == pdTRUE ? status::OK : status::IN_USE;
 }
 
 mutex::status mutex::unlock()
 {
+    if (handle == nullptr)
+        return status::ERROR;
     return xSemaphoreGive((SemaphoreHandle_t) handle) == pdTRUE ? status::OK :
         status::ERROR;
 }
 
+#else // SDK_MUTEX_STATS
+
+mutex::status mutex::try_lock(uint32_t timeout_ms)
+{
+    if (handle == nullptr)
+        return status::ERROR;
+
+    SDK_TRACE_BEGIN(MUTEX_LOCK, (uintptr_t) handle);
+    uint32_t start = clock::now_cycles32();
+
+    // an uncontended take never blocks, so a failed poll means contention
+    bool contended = false;
+    BaseType_t taken = xSemaphoreTake((SemaphoreHandle_t) handle, 0);
+    if (taken != pdTRUE && timeout_ms != 0) {
+        contended = true;
+        taken = xSemaphoreTake((SemaphoreHandle_t) handle,
+            pdMS_TO_TICKS(timeout_ms));
+    }
+    SDK_TRACE_END(MUTEX_LOCK, taken);
+
+    if (taken != pdTRUE) {
+        // not holding the mutex, so the counter needs its own protection
+        taskENTER_CRITICAL();
+        counters.timeouts++;
+        taskEXIT_CRITICAL();
+        return status::IN_USE;
+    }
+
+    record_lock(clock::now_cycles32() - start, contended);
+    return status::OK;
+}
+
+mutex::status mutex::unlock()
+{
+    if (handle == nullptr)
+        return status::ERROR;
+
+    uint32_t held = clock::now_cycles32() - locked_at;
+    if (held > counters.max_hold_cycles)
+        counters.max_hold_cycles = held;
+
+    return xSemaphoreGive((SemaphoreHandle_t) handle) == pdTRUE ? status::OK :
+        status::ERROR;
+}
+
+void mutex::record_lock(uint32_t wait_cycles, bool contended)
+{
+    locked_at = clock::now_cycles32();
+    counters.acquisitions++;
+    if (contended) {
+        counters.contended++;
+        counters.total_wait_cycles += wait_cycles;
+        if (wait_cycles > counters.max_wait_cycles)
+            counters.max_wait_cycles = wait_cycles;
+    }
+}
+
+void mutex::reset_stats()
+{
+    counters = {};
+    locked_at = 0;
+}
+
+void mutex::register_self()
+{
+    // appended, so the registry stays in creation order
+    taskENTER_CRITICAL();
+    mutex **it = &registry_head;
+    while (*it != nullptr)
+        it = &(*it)->next;
+    *it = this;
+    next = nullptr;
+    taskEXIT_CRITICAL();
+}
+
+void mutex::take_registry_entry(mutex &other)
+{
+    taskENTER_CRITICAL();
+    next = nullptr;
+    for (mutex **it = &registry_head; *it != nullptr; it = &(*it)->next) {
+        if (*it == &other) {
+            *it = this;
+            next = other.next;
+            other.next = nullptr;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+void mutex::unregister_self()
+{
+    taskENTER_CRITICAL();
+    for (mutex **it = &registry_head; *it != nullptr; it = &(*it)->next) {
+        if (*it == this) {
+            *it = next;
+            break;
+        }
+    }
+    next = nullptr;
+    taskEXIT_CRITICAL();
+}
+
+void mutex::for_each(void (*fn)(mutex &m, void *ctx), void *ctx)
+{
+    // mutexes are created at boot, so the list is not locked while walking
+    for (mutex *m = registry_head; m != nullptr; m = m->next)
+        fn(*m, ctx);
+}
+
+uint32_t mutex::format_stats(char *out, uint32_t size)
+{
+    if (size == 0)
+        return 0;
+
+    uint32_t cpu = clock::cycles_per_us();
+    uint32_t len = 0;
+    int n = snprintf(out, size, "%-16s %10s %10s %8s %12s %10s %10s\n",
+        "name", "acquired", "contended", "timeouts", "wait_us", "max_wait",
+        "max_hold");
+    if (n > 0)
+        len = (uint32_t) n < size ? n : size - 1;
+
+    for (mutex *m = registry_head; m != nullptr && len + 1 < size;
+            m = m->next) {
+        stats s = m->counters;
+        n = snprintf(out + len, size - len,
+            "%-16s %10lu %10lu %8lu %12llu %10lu %10lu\n",
+            m->name != nullptr ? m->name : "?",
+            (unsigned long) s.acquisitions,
+            (unsigned long) s.contended,
+            (unsigned long) s.timeouts,
+            (unsigned long long) (s.total_wait_cycles / cpu),
+            (unsigned long) (s.max_wait_cycles / cpu),
+            (unsigned long) (s.max_hold_cycles / cpu));
+        if (n < 0)
+            break;
+        len += (uint32_t) n < size - len ? n : size - len - 1;
+    }
+    return len;
+}
+
+#endif // SDK_MUTEX_STATS
+
 void *mutex::unwrap()
 {
     return handle;
@@ -0,0 +1,171 @@
+
+#include <sdk/packet.h>
+
+namespace sdk {
+
+namespace packet {
+
+struct crc_table {
+    uint16_t value[256];
+};
+
+static constexpr crc_table make_crc_table()
+{
+    crc_table t{};
+    for (int i = 0; i < 256; i++) {
+        uint16_t crc = (uint16_t) (i << 8);
+        for (int bit = 0; bit < 8; bit++)
+            crc = (uint16_t) ((crc << 1) ^ ((crc & 0x8000) ? 0x1021 : 0));
+        t.value[i] = crc;
+    }
+    return t;
+}
+
+/* const, so it stays in flash */
+static constexpr crc_table CRC_TABLE = make_crc_table();
+
+uint16_t crc16(const uint8_t *data, uint32_t size, uint16_t crc)
+{
+    for (uint32_t i = 0; i < size; i++)
+        crc = (uint16_t) ((crc << 8) ^ CRC_TABLE.value[(crc >> 8) ^ data[i]]);
+    return crc;
+}
+
+/* COBS encoding a byte at a time, so the CRC needs no copy of the payload */
+class cobs_writer {
+public:
+
+    explicit cobs_writer(uint8_t *out) : out(out), code_at(0), pos(1),
+            code(1)
+    {
+    }
+
+    void put(uint8_t byte)
+    {
+        if (byte != 0) {
+            out[pos++] = byte;
+            code++;
+        }
+        // a zero ends the block, as does the longest block a code allows
+        if (byte == 0 || code == 0xff) {
+            out[code_at] = code;
+            code_at = pos++;
+            code = 1;
+        }
+    }
+
+    uint16_t finish()
+    {
+        out[code_at] = code;
+        return pos;
+    }
+
+private:
+    uint8_t *out;
+    uint16_t code_at; /* where the open block's code byte goes */
+    uint16_t pos;
+    uint8_t code;
+};
+
+uint16_t cobs_encode(const uint8_t *data, uint16_t size, uint8_t *out)
+{
+    cobs_writer writer(out);
+    for (uint16_t i = 0; i < size; i++)
+        writer.put(data[i]);
+    return writer.finish();
+}
+
+int32_t cobs_decode(const uint8_t *data, uint16_t size, uint8_t *out)
+{
+    uint16_t in = 0;
+    uint16_t written = 0;
+    while (in < size) {
+        uint8_t code = data[in++];
+        if (code == 0 || in + code - 1 > size)
+            return -1;
+        for (uint8_t i = 1; i < code; i++) {
+            if (data[in] == 0)
+                return -1;
+            out[written++] = data[in++];
+        }
+        // every block but the last and the longest ones ends in a zero
+        if (code != 0xff && in < size)
+            out[written++] = 0;
+    }
+    return written;
+}
+
+uint16_t encode(const void *payload, uint16_t size, uint8_t *out)
+{
+    const uint8_t *bytes = (const uint8_t *) payload;
+    uint16_t crc = crc16(bytes, size);
+
+    cobs_writer writer(out);
+    for (uint16_t i = 0; i < size; i++)
+        writer.put(bytes[i]);
+    writer.put((uint8_t) (crc >> 8));
+    writer.put((uint8_t) crc);
+    uint16_t length = writer.finish();
+    out[length++] = 0;
+    return length;
+}
+
+void decoder::feed(const uint8_t *data, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++) {
+        uint8_t byte = data[i];
+        if (byte == 0) {
+            end_frame();
+            continue;
+        }
+        in_frame = true;
+        if (overflow)
+            continue;
+
+        uint8_t value = byte;
+        if (block_left == 0) {
+            // a code byte: the zero ending the previous block, if any, and
+            // the length of the next one
+            block_left = (uint8_t) (byte - 1);
+            bool had_zero = zero_pending;
+            zero_pending = byte != 0xff;
+            if (!had_zero)
+                continue;
+            value = 0;
+        } else {
+            block_left--;
+        }
+
+        if (length == sizeof(buffer)) {
+            overflow = true;
+            continue;
+        }
+        buffer[length++] = value;
+    }
+}
+
+void decoder::end_frame()
+{
+    // delimiters back to back are just idle line
+    if (!in_frame)
+        return;
+
+    if (overflow || block_left != 0 || length < CRC_SIZE) {
+        counts.framing_errors++;
+    } else if (crc16(buffer, length) != 0) {
+        counts.crc_errors++;
+    } else {
+        counts.packets++;
+        fn(buffer, (uint16_t) (length - CRC_SIZE), ctx);
+    }
+
+    length = 0;
+    block_left = 0;
+    zero_pending = false;
+    in_frame = false;
+    overflow = false;
+}
+
+} // namespace packet
+
+} // namespace sdk
@@ -20,7 +20,7 @@ void pwm::set(real value)
     if (value < 0) value = 0;
     else if (value > 1) value = 1;
 
-    uint32_t ccr = (uint32_t)(value / (real) htim->Instance->ARR);
+    uint32_t ccr = (uint32_t)(value * (real) htim->Instance->ARR);
     switch (channel) {
     case tim_channel::CHANNEL_1:
         htim->Instance->CCR1 = ccr;
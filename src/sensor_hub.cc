@@ -0,0 +1,207 @@
+
+#include <sdk/sensor_hub.h>
+
+namespace sdk {
+
+static bool read_bmi088(void *ctx)
+{
+    return ((bmi088 *) ctx)->update();
+}
+
+static bool read_bmp390(void *ctx)
+{
+    return ((bmp390 *) ctx)->update();
+}
+
+static uint32_t hz_to_period_us(float hz)
+{
+    return hz > 0 ? (uint32_t) (1e6f / hz + 0.5f) : 0;
+}
+
+static uint32_t bmi088_period(void *ctx)
+{
+    return hz_to_period_us(((bmi088 *) ctx)->get_odr_hz());
+}
+
+static uint32_t bmp390_period(void *ctx)
+{
+    return hz_to_period_us(((bmp390 *) ctx)->get_odr_hz());
+}
+
+int sensor_hub::add(const char *name, uint32_t period_us, read_fn read,
+        void *ctx)
+{
+    if (count >= MAX_SENSORS || period_us == 0)
+        return -1;
+
+    int id = count++;
+    entry &e = entries[id];
+    e.read = read;
+    e.period = nullptr;
+    e.ctx = ctx;
+    e.next_release_us = 0;
+    e.subscriber_count = 0;
+    e.stats = sensor_stats{};
+    e.stats.name = name;
+    e.stats.period_us = period_us;
+
+    order[id] = id;
+    sort_order();
+    return id;
+}
+
+int sensor_hub::add(const char *name, period_fn period, read_fn read,
+        void *ctx)
+{
+    int id = add(name, period(ctx), read, ctx);
+    if (id >= 0)
+        entries[id].period = period;
+    return id;
+}
+
+int sensor_hub::add(bmi088 &imu)
+{
+    return add("bmi088", bmi088_period, read_bmi088, &imu);
+}
+
+int sensor_hub::add(bmp390 &baro)
+{
+    return add("bmp390", bmp390_period, read_bmp390, &baro);
+}
+
+void sensor_hub::set_period(int sensor_id, uint32_t period_us)
+{
+    if (sensor_id < 0 || sensor_id >= count || period_us == 0)
+        return;
+    entries[sensor_id].stats.period_us = period_us;
+    sort_order();
+}
+
+void sensor_hub::sort_order()
+{
+    // rate-monotonic, ties keep registration order
+    for (int id = 0; id < count; id++) {
+        int i = id;
+        while (i > 0 && entries[order[i - 1]].stats.period_us >
+                entries[id].stats.period_us) {
+            order[i] = order[i - 1];
+            i--;
+        }
+        order[i] = id;
+    }
+}
+
+bool sensor_hub::subscribe(int sensor_id, notify_fn notify, void *ctx)
+{
+    if (sensor_id < 0 || sensor_id >= count)
+        return false;
+    entry &e = entries[sensor_id];
+    if (e.subscriber_count >= MAX_SUBSCRIBERS)
+        return false;
+    e.subscribers[e.subscriber_count++] = { notify, ctx };
+    return true;
+}
+
+uint64_t sensor_hub::step(uint64_t now_us)
+{
+    if (!started) {
+        started = true;
+        start_us = now_us;
+        busy_us = 0;
+        for (int i = 0; i < count; i++)
+            entries[i].next_release_us = now_us;
+    }
+
+    // batch every due read onto the bus first, highest rate first
+    bool fresh[MAX_SENSORS] = {};
+    bool resort = false;
+    for (int i = 0; i < count; i++) {
+        entry &e = entries[order[i]];
+        if (now_us < e.next_release_us)
+            continue;
+
+        uint64_t begin = now();
+        bool ok = e.read(e.ctx);
+        uint64_t end = now();
+        uint32_t took = (uint32_t) (end - begin);
+
+        e.stats.busy_us += took;
+        busy_us += took;
+        if (took > e.stats.max_read_us)
+            e.stats.max_read_us = took;
+
+        if (ok) {
+            e.stats.reads++;
+            e.stats.last_read_us = end;
+            fresh[order[i]] = true;
+        } else {
+            e.stats.failures++;
+        }
+
+        // a rate change starts from this release
+        if (e.period != nullptr) {
+            uint32_t period_us = e.period(e.ctx);
+            if (period_us != 0 && period_us != e.stats.period_us) {
+                e.stats.period_us = period_us;
+                resort = true;
+            }
+        }
+
+        // keep the grid, but never try to catch up on missed releases
+        e.next_release_us += e.stats.period_us;
+        if (e.next_release_us <= now_us) {
+            uint64_t behind = now_us - e.next_release_us;
+            uint32_t missed = (uint32_t) (behind / e.stats.period_us) + 1;
+            e.stats.overruns += missed;
+            e.next_release_us += (uint64_t) missed * e.stats.period_us;
+        }
+    }
+
+    if (resort)
+        sort_order();
+
+    // then fan out
+    for (int i = 0; i < count; i++) {
+        entry &e = entries[order[i]];
+        if (!fresh[order[i]])
+            continue;
+        for (int j = 0; j < e.subscriber_count; j++)
+            e.subscribers[j].notify(e.subscribers[j].ctx);
+    }
+
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < count; i++) {
+        if (entries[i].next_release_us < next)
+            next = entries[i].next_release_us;
+    }
+    return next;
+}
+
+void sensor_hub::run()
+{
+    for (;;) {
+        uint64_t next = step(now());
+        uint64_t current = now();
+        // `now` may not be the clock's, so only the wait carries over
+        if (next > current)
+            clock::sleep_until_us(clock::now_us() + (next - current));
+    }
+}
+
+uint64_t sensor_hub::get_age_us(int sensor_id, uint64_t now_us) const
+{
+    const sensor_stats &stats = entries[sensor_id].stats;
+    uint64_t last = stats.last_read_us;
+    if (stats.reads == 0 || now_us < last)
+        return UINT64_MAX;
+    return now_us - last;
+}
+
+float sensor_hub::get_bus_load(uint64_t now_us) const
+{
+    if (!started || now_us <= start_us)
+        return 0;
+    return (float) busy_us / (float) (now_us - start_us);
+}
+
+} // namespace sdk
@@ -0,0 +1,84 @@
+
+#include <sdk/sim/actuator_sim.h>
+#include <sdk/sim/kernel.h>
+
+#include <math.h>
+
+namespace sdk {
+
+namespace sim {
+
+/* quadrature states (a << 1 | b) in the positive direction */
+static constexpr uint8_t QUADRATURE[4] = { 0b00, 0b10, 0b11, 0b01 };
+
+actuator_sim::actuator_sim(flight &target, const config &conf,
+        const wiring &pins) : target(target), conf(conf), pins(pins),
+        shaft_deg(0), speed_rps(0), count(0)
+{
+    max_shaft_deg = target.get_config().max_deployment_deg * conf.gear_ratio;
+}
+
+void actuator_sim::start()
+{
+    kernel::schedule(kernel::now_ns(), on_step, this);
+}
+
+void actuator_sim::on_step(void *ctx)
+{
+    actuator_sim *self = (actuator_sim *) ctx;
+    self->step(self->conf.step_s);
+    if (self->target.get_state().phase != flight::phase::LANDED)
+        kernel::schedule(kernel::now_ns() + (uint64_t) (self->conf.step_s *
+            1e9), on_step, self);
+}
+
+actuator_sim::real actuator_sim::bridge_power() const
+{
+    // outputs are Hi-Z while asleep, the motor coasts
+    if (!hal::read_pin(pins.nsleep_port, pins.nsleep_pin))
+        return 0;
+    return (real) hal::get_pwm_duty(pins.in1_tim, pins.in1_channel) -
+        (real) hal::get_pwm_duty(pins.in2_tim, pins.in2_channel);
+}
+
+void actuator_sim::step(real dt)
+{
+    real target_speed = bridge_power() * conf.max_speed_rps;
+    speed_rps += (target_speed - speed_rps) * (dt / (conf.time_constant_s +
+        dt));
+
+    shaft_deg += speed_rps * 360.0 * dt;
+    if (shaft_deg <= 0) {
+        shaft_deg = 0;
+        speed_rps = speed_rps < 0 ? 0 : speed_rps;
+    } else if (shaft_deg >= max_shaft_deg) {
+        shaft_deg = max_shaft_deg;
+        speed_rps = speed_rps > 0 ? 0 : speed_rps;
+    }
+
+    int32_t want = (int32_t) floor(shaft_deg / 360.0 * conf.counts_per_rev +
+        0.5);
+    while (count < want)
+        emit_edge(1);
+    while (count > want)
+        emit_edge(-1);
+
+    target.set_deployment_deg(shaft_deg / conf.gear_ratio);
+}
+
+void actuator_sim::emit_edge(int direction)
+{
+    uint8_t before = QUADRATURE[count & 3];
+    count += direction;
+    uint8_t after = QUADRATURE[count & 3];
+
+    // exactly one of the two lines changes per count
+    if ((before ^ after) & 0b10)
+        hal::drive_pin(pins.enc_a_port, pins.enc_a_pin, (after & 0b10) != 0);
+    else
+        hal::drive_pin(pins.enc_b_port, pins.enc_b_pin, (after & 0b01) != 0);
+}
+
+} // namespace sim
+
+} // namespace sdk
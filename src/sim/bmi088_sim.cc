@@ -0,0 +1,264 @@
+
+#include <sdk/sim/bmi088_sim.h>
+#include <sdk/sim/kernel.h>
+
+#include <math.h>
+#include <string.h>
+
+namespace sdk {
+
+namespace sim {
+
+/* register map, see the BMI088 datasheet sections 5.3 and 5.5 */
+static constexpr uint8_t ACC_ADDRESS = 0x18;
+static constexpr uint8_t GYRO_ADDRESS = 0x68;
+
+static constexpr uint8_t ACC_CHIP_ID = 0x00;
+static constexpr uint8_t ACC_STATUS = 0x03;
+static constexpr uint8_t ACC_DATA = 0x12;
+static constexpr uint8_t ACC_SENSORTIME = 0x18;
+static constexpr uint8_t ACC_INTERNAL_STAT = 0x2a;
+static constexpr uint8_t ACC_CONF = 0x40;
+static constexpr uint8_t ACC_RANGE = 0x41;
+static constexpr uint8_t ACC_INIT_CTRL = 0x59;
+static constexpr uint8_t ACC_FEATURE_ADDR_LSB = 0x5b;
+static constexpr uint8_t ACC_FEATURE_ADDR_MSB = 0x5c;
+static constexpr uint8_t ACC_FEATURE_CFG = 0x5e;
+static constexpr uint8_t ACC_PWR_CONF = 0x7c;
+static constexpr uint8_t ACC_PWR_CTRL = 0x7d;
+
+static constexpr uint8_t GYRO_CHIP_ID = 0x00;
+static constexpr uint8_t GYRO_DATA = 0x02;
+static constexpr uint8_t GYRO_RANGE = 0x0f;
+static constexpr uint8_t GYRO_BANDWIDTH = 0x10;
+static constexpr uint8_t GYRO_LPM1 = 0x11;
+
+/* byte offset of the data sync word in the feature registers */
+static constexpr int DATA_SYNC = 4;
+
+static constexpr double SENSORTIME_NS = 39062.5;
+/* start-up times, t_su in the datasheet */
+static constexpr uint64_t ACC_START_NS = 1000000;
+static constexpr uint64_t GYRO_START_NS = 30000000;
+
+bmi088_sim::bmi088_sim(const flight &source, const config &conf) :
+        source(source), conf(conf), noise(conf.seed), acc(*this),
+        gyro(*this), acc_ready_ns(UINT64_MAX), gyro_ready_ns(GYRO_START_NS),
+        sync_period_index(UINT64_MAX), feature_address(0), feature_size(0)
+{
+    // reset values
+    memset(acc_regs, 0, sizeof(acc_regs));
+    memset(gyro_regs, 0, sizeof(gyro_regs));
+    memset(feature_config, 0, sizeof(feature_config));
+    memset(features, 0, sizeof(features));
+    acc_regs[ACC_CHIP_ID] = 0x1e;
+    acc_regs[ACC_CONF] = 0xa8;
+    acc_regs[ACC_RANGE] = 0x01;
+    acc_regs[ACC_PWR_CONF] = 0x03; /* suspended, the gyro is on at power-up */
+    gyro_regs[GYRO_CHIP_ID] = 0x0f;
+    gyro_regs[GYRO_BANDWIDTH] = 0x80;
+}
+
+void bmi088_sim::attach(I2C_HandleTypeDef *bus)
+{
+    hal::attach(bus, ACC_ADDRESS, acc);
+    hal::attach(bus, GYRO_ADDRESS, gyro);
+}
+
+static void put_axis(uint8_t *regs, int axis, double value, double lsb)
+{
+    double raw = round(value / lsb);
+    if (raw > 32767)
+        raw = 32767;
+    else if (raw < -32768)
+        raw = -32768;
+    uint16_t bits = (uint16_t) (int16_t) raw;
+    regs[axis * 2] = bits & 0xff;
+    regs[axis * 2 + 1] = bits >> 8;
+}
+
+void bmi088_sim::sample_acc()
+{
+    if (kernel::now_ns() < acc_ready_ns)
+        return;
+
+    // LSB per 5.3.4: range 3g << acc_range over 16 bits
+    double lsb = flight::GRAVITY_EARTH * 3.0 *
+        (1 << (acc_regs[ACC_RANGE] & 0x03)) / 32768.0;
+    for (int axis = 0; axis < 3; axis++) {
+        double value = axis == conf.vertical_axis ?
+            source.get_state().specific_force_ms2 : 0;
+        put_axis(acc_regs + ACC_DATA, axis,
+            value + noise.gaussian(conf.acc_noise_ms2), lsb);
+    }
+    acc_regs[ACC_STATUS] = 0x80; /* drdy */
+}
+
+void bmi088_sim::latch_sensortime()
+{
+    if (kernel::now_ns() < acc_ready_ns)
+        return;
+
+    uint32_t sensortime = (uint32_t) (kernel::now_ns() / SENSORTIME_NS) &
+        0xffffff;
+    acc_regs[ACC_SENSORTIME] = sensortime & 0xff;
+    acc_regs[ACC_SENSORTIME + 1] = (sensortime >> 8) & 0xff;
+    acc_regs[ACC_SENSORTIME + 2] = sensortime >> 16;
+}
+
+void bmi088_sim::sample_gyro()
+{
+    if (kernel::now_ns() < gyro_ready_ns)
+        return;
+
+    // LSB per 5.5.4: 2000 deg/s >> gyro_range over 16 bits
+    double lsb = 2000.0 / (1 << (gyro_regs[GYRO_RANGE] & 0x07)) / 32768.0;
+    for (int axis = 0; axis < 3; axis++)
+        put_axis(gyro_regs + GYRO_DATA, axis, conf.gyro_bias_ds +
+            noise.gaussian(conf.gyro_noise_ds), lsb);
+}
+
+/* gyro ODR period for a GYRO_BANDWIDTH value, see 5.5.5 */
+static uint64_t gyro_period_ns(uint8_t bandwidth)
+{
+    switch (bandwidth & 0x07) {
+    case 0x00:
+    case 0x01:
+        return 500000;
+    case 0x02:
+        return 1000000;
+    case 0x03:
+        return 2500000;
+    case 0x04:
+    case 0x06:
+        return 5000000;
+    default:
+        return 10000000;
+    }
+}
+
+bool bmi088_sim::sample_synced()
+{
+    if (acc_regs[ACC_INTERNAL_STAT] != 0x01 ||
+            (features[DATA_SYNC] == 0 && features[DATA_SYNC + 1] == 0))
+        return false;
+
+    // the gyro's data-ready triggers the accel, so both change together
+    uint64_t index = kernel::now_ns() /
+        gyro_period_ns(gyro_regs[GYRO_BANDWIDTH]);
+    if (index != sync_period_index) {
+        sync_period_index = index;
+        sample_acc();
+        sample_gyro();
+    }
+    return true;
+}
+
+bool bmi088_sim::acc_port::read(uint16_t reg, uint8_t *data, uint16_t size)
+{
+    bmi088_sim &s = owner;
+    // reading the data LSB latches the whole frame, sensortime included
+    if (reg <= ACC_DATA && reg + size > ACC_DATA) {
+        if (!s.sample_synced())
+            s.sample_acc();
+        s.latch_sensortime();
+    }
+
+    if (reg == ACC_FEATURE_CFG && s.acc_regs[ACC_INTERNAL_STAT] == 0x01) {
+        // once initialized, the window shows the feature registers
+        for (uint16_t i = 0; i < size; i++)
+            data[i] = i < sizeof(s.features) ? s.features[i] : 0;
+        return true;
+    }
+    if (reg == ACC_FEATURE_CFG) {
+        // the feature window does not auto-increment past itself
+        for (uint16_t i = 0; i < size; i++) {
+            uint32_t at = s.feature_address + i;
+            data[i] = at < sizeof(s.feature_config) ? s.feature_config[at] : 0;
+        }
+        return true;
+    }
+
+    for (uint16_t i = 0; i < size; i++)
+        data[i] = reg + i < sizeof(s.acc_regs) ? s.acc_regs[reg + i] : 0;
+    return true;
+}
+
+bool bmi088_sim::acc_port::write(uint16_t reg, const uint8_t *data,
+        uint16_t size)
+{
+    bmi088_sim &s = owner;
+    if (reg == ACC_FEATURE_CFG && s.acc_regs[ACC_INTERNAL_STAT] == 0x01) {
+        for (uint16_t i = 0; i < size && i < sizeof(s.features); i++)
+            s.features[i] = data[i];
+        return true;
+    }
+    if (reg == ACC_FEATURE_CFG) {
+        for (uint16_t i = 0; i < size; i++) {
+            uint32_t at = s.feature_address + i;
+            if (at < sizeof(s.feature_config))
+                s.feature_config[at] = data[i];
+        }
+        if (s.feature_address + size > s.feature_size)
+            s.feature_size = s.feature_address + size;
+        return true;
+    }
+
+    for (uint16_t i = 0; i < size && reg + i < sizeof(s.acc_regs); i++) {
+        uint8_t r = reg + i;
+        s.acc_regs[r] = data[i];
+        if (r == ACC_FEATURE_ADDR_LSB || r == ACC_FEATURE_ADDR_MSB) {
+            // address in 16-bit words, split 4/8 bits
+            uint16_t word = (s.acc_regs[ACC_FEATURE_ADDR_LSB] & 0x0f) |
+                (s.acc_regs[ACC_FEATURE_ADDR_MSB] << 4);
+            s.feature_address = word * 2;
+        } else if (r == ACC_INIT_CTRL && data[i] == 0x01) {
+            s.acc_regs[ACC_INTERNAL_STAT] = s.feature_size > 0 ? 0x01 : 0x02;
+            memset(s.features, 0, sizeof(s.features));
+        } else if (r == ACC_INIT_CTRL) {
+            s.acc_regs[ACC_INTERNAL_STAT] = 0x00;
+        } else if (r == ACC_PWR_CTRL) {
+            bool on = data[i] == 0x04;
+            if (!on)
+                s.acc_ready_ns = UINT64_MAX;
+            else if (s.acc_ready_ns == UINT64_MAX)
+                s.acc_ready_ns = kernel::now_ns() + ACC_START_NS;
+        }
+    }
+    return true;
+}
+
+bool bmi088_sim::gyro_port::read(uint16_t reg, uint8_t *data, uint16_t size)
+{
+    bmi088_sim &s = owner;
+    if (reg <= GYRO_DATA && reg + size > GYRO_DATA && !s.sample_synced())
+        s.sample_gyro();
+
+    for (uint16_t i = 0; i < size; i++)
+        data[i] = reg + i < sizeof(s.gyro_regs) ? s.gyro_regs[reg + i] : 0;
+    return true;
+}
+
+bool bmi088_sim::gyro_port::write(uint16_t reg, const uint8_t *data,
+        uint16_t size)
+{
+    bmi088_sim &s = owner;
+    for (uint16_t i = 0; i < size && reg + i < sizeof(s.gyro_regs); i++) {
+        uint8_t r = reg + i;
+        s.gyro_regs[r] = data[i];
+        if (r == GYRO_BANDWIDTH) {
+            s.gyro_regs[r] |= 0x80; /* bit 7 always reads 1 */
+        } else if (r == GYRO_LPM1) {
+            bool on = data[i] == 0x00;
+            if (!on)
+                s.gyro_ready_ns = UINT64_MAX;
+            else if (s.gyro_ready_ns == UINT64_MAX)
+                s.gyro_ready_ns = kernel::now_ns() + GYRO_START_NS;
+        }
+    }
+    return true;
+}
+
+} // namespace sim
+
+} // namespace sdk
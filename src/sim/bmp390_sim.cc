@@ -0,0 +1,191 @@
+
+#include <sdk/sim/bmp390_sim.h>
+#include <sdk/sim/kernel.h>
+
+#include <math.h>
+#include <string.h>
+
+namespace sdk {
+
+namespace sim {
+
+static constexpr uint8_t ADDRESS = 0x76;
+
+static constexpr uint8_t CHIP_ID = 0x00;
+static constexpr uint8_t STATUS = 0x03;
+static constexpr uint8_t DATA_0 = 0x04;
+static constexpr uint8_t PWR_CTRL = 0x1b;
+static constexpr uint8_t NVM_PAR_T1 = 0x31;
+
+/*
+ * NVM calibration image (0x31..0x45), little-endian: T1 T2 T3 P1 P2 P3 P4 P5
+ * P6 P7 P8 P9 P10 P11. Values in the range real parts report, with signed
+ * coefficients negative where the datasheet allows it.
+ */
+static constexpr uint16_t NVM_T1 = 27000;
+static constexpr uint16_t NVM_T2 = 19000;
+static constexpr int8_t NVM_T3 = -7;
+static constexpr int16_t NVM_P1 = 6000;
+static constexpr int16_t NVM_P2 = 16000;
+static constexpr int8_t NVM_P3 = 5;
+static constexpr int8_t NVM_P4 = 0;
+static constexpr uint16_t NVM_P5 = 20000;
+static constexpr uint16_t NVM_P6 = 24000;
+static constexpr int8_t NVM_P7 = 3;
+static constexpr int8_t NVM_P8 = -4;
+static constexpr int16_t NVM_P9 = 1000;
+static constexpr int8_t NVM_P10 = 2;
+static constexpr int8_t NVM_P11 = 10;
+
+static constexpr uint32_t RAW_MAX = (1u << 24) - 1;
+/* power-on to the first bus access, t_startup in the datasheet */
+static constexpr uint64_t STARTUP_NS = 2000000;
+
+static void put16(uint8_t *at, uint16_t value)
+{
+    at[0] = value & 0xff;
+    at[1] = value >> 8;
+}
+
+static void put24(uint8_t *at, uint32_t value)
+{
+    at[0] = value & 0xff;
+    at[1] = (value >> 8) & 0xff;
+    at[2] = (value >> 16) & 0xff;
+}
+
+bmp390_sim::bmp390_sim(const flight &source, const config &conf) :
+        source(source), conf(conf), noise(conf.seed)
+{
+    memset(regs, 0, sizeof(regs));
+    regs[CHIP_ID] = 0x60;
+    regs[0x01] = 0x01; /* rev id */
+    put24(regs + DATA_0, 0x800000);
+    put24(regs + DATA_0 + 3, 0x800000);
+
+    uint8_t *nvm = regs + NVM_PAR_T1;
+    put16(nvm + 0, NVM_T1);
+    put16(nvm + 2, NVM_T2);
+    nvm[4] = (uint8_t) NVM_T3;
+    put16(nvm + 5, (uint16_t) NVM_P1);
+    put16(nvm + 7, (uint16_t) NVM_P2);
+    nvm[9] = (uint8_t) NVM_P3;
+    nvm[10] = (uint8_t) NVM_P4;
+    put16(nvm + 11, NVM_P5);
+    put16(nvm + 13, NVM_P6);
+    nvm[15] = (uint8_t) NVM_P7;
+    nvm[16] = (uint8_t) NVM_P8;
+    put16(nvm + 17, (uint16_t) NVM_P9);
+    nvm[19] = (uint8_t) NVM_P10;
+    nvm[20] = (uint8_t) NVM_P11;
+
+    // floating point coefficients, see datasheet 9.1 / BMP3_SensorAPI
+    calib.t1 = NVM_T1 * 256.0;
+    calib.t2 = NVM_T2 / 1073741824.0;
+    calib.t3 = NVM_T3 / 281474976710656.0;
+    calib.p1 = (NVM_P1 - 16384) / 1048576.0;
+    calib.p2 = (NVM_P2 - 16384) / 536870912.0;
+    calib.p3 = NVM_P3 / 4294967296.0;
+    calib.p4 = NVM_P4 / 137438953472.0;
+    calib.p5 = NVM_P5 * 8.0;
+    calib.p6 = NVM_P6 / 64.0;
+    calib.p7 = NVM_P7 / 256.0;
+    calib.p8 = NVM_P8 / 32768.0;
+    calib.p9 = NVM_P9 / 281474976710656.0;
+    calib.p10 = NVM_P10 / 281474976710656.0;
+    calib.p11 = NVM_P11 / 36893488147419103232.0;
+}
+
+void bmp390_sim::attach(I2C_HandleTypeDef *bus)
+{
+    hal::attach(bus, ADDRESS, *this);
+}
+
+double bmp390_sim::compensate_temperature(uint32_t raw) const
+{
+    double d = (double) raw - calib.t1;
+    return d * calib.t2 + d * d * calib.t3;
+}
+
+double bmp390_sim::compensate_pressure(double t, uint32_t raw) const
+{
+    double u = raw;
+    double out0 = calib.p5 + calib.p6 * t + calib.p7 * t * t +
+        calib.p8 * t * t * t;
+    double out1 = u * (calib.p1 + calib.p2 * t + calib.p3 * t * t +
+        calib.p4 * t * t * t);
+    double out2 = u * u * (calib.p9 + calib.p10 * t) + u * u * u * calib.p11;
+    return out0 + out1 + out2;
+}
+
+/* raw value whose compensated reading is closest to `target` */
+template<typename F>
+static uint32_t invert(F compensate, double target, bool increasing)
+{
+    uint32_t lo = 0;
+    uint32_t hi = RAW_MAX;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if ((compensate(mid) < target) == increasing)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return fabs(compensate(lo) - target) < fabs(compensate(hi) - target) ?
+        lo : hi;
+}
+
+void bmp390_sim::sample()
+{
+    // nothing converts unless both channels run in normal mode
+    if ((regs[PWR_CTRL] & 0x33) != 0x33)
+        return;
+
+    double altitude = source.get_state().altitude_m;
+    double temperature = source.air_temperature(altitude) +
+        conf.temperature_offset_c;
+    double pressure = source.air_pressure(altitude) +
+        noise.gaussian(conf.pressure_noise_pa);
+
+    uint32_t raw_t = invert([&](uint32_t raw) {
+        return compensate_temperature(raw);
+    }, temperature, true);
+    double t = compensate_temperature(raw_t);
+    uint32_t raw_p = invert([&](uint32_t raw) {
+        return compensate_pressure(t, raw);
+    }, pressure, false);
+
+    put24(regs + DATA_0, raw_p);
+    put24(regs + DATA_0 + 3, raw_t);
+    regs[STATUS] = 0x70; /* cmd_rdy, drdy_press, drdy_temp */
+}
+
+bool bmp390_sim::read(uint16_t reg, uint8_t *data, uint16_t size)
+{
+    if (kernel::now_ns() < STARTUP_NS)
+        return false;
+
+    // a burst starting in the data registers reads one consistent conversion
+    if (reg <= DATA_0 && reg + size > DATA_0)
+        sample();
+    for (uint16_t i = 0; i < size; i++)
+        data[i] = reg + i < sizeof(regs) ? regs[reg + i] : 0;
+    return true;
+}
+
+bool bmp390_sim::write(uint16_t reg, const uint8_t *data, uint16_t size)
+{
+    if (kernel::now_ns() < STARTUP_NS)
+        return false;
+
+    for (uint16_t i = 0; i < size && reg + i < sizeof(regs); i++) {
+        // the calibration NVM and ids are read-only
+        if (reg + i < NVM_PAR_T1 || reg + i > NVM_PAR_T1 + 20)
+            regs[reg + i] = data[i];
+    }
+    return true;
+}
+
+} // namespace sim
+
+} // namespace sdk
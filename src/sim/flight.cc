@@ -0,0 +1,147 @@
+
+#include <sdk/sim/flight.h>
+#include <sdk/sim/kernel.h>
+
+#include <math.h>
+
+namespace sdk {
+
+namespace sim {
+
+/* ISA troposphere */
+static constexpr double SEA_LEVEL_PRESSURE = 101325.0; /* Pa */
+static constexpr double SEA_LEVEL_TEMPERATURE = 288.15; /* K */
+static constexpr double LAPSE_RATE = 0.0065; /* K/m */
+static constexpr double GAS_CONSTANT = 287.05287; /* J/(kg K), dry air */
+static constexpr double KELVIN = 273.15;
+
+void flight::reset()
+{
+    current = {};
+    current.phase = phase::PAD;
+    current.specific_force_ms2 = GRAVITY_EARTH;
+}
+
+void flight::start()
+{
+    kernel::schedule(kernel::now_ns(), on_step, this);
+}
+
+void flight::on_step(void *ctx)
+{
+    flight *self = (flight *) ctx;
+    self->step(self->conf.step_s);
+    if (self->current.phase != phase::LANDED)
+        kernel::schedule(kernel::now_ns() + (uint64_t) (self->conf.step_s *
+            1e9), on_step, self);
+}
+
+flight::real flight::drag_area(real deployment_deg) const
+{
+    return conf.body_drag_area_m2 + conf.brake_drag_area_m2 *
+        deployment_deg / conf.max_deployment_deg;
+}
+
+flight::real flight::air_temperature(real altitude_m) const
+{
+    real asl = conf.ground_altitude_asl_m + altitude_m;
+    return SEA_LEVEL_TEMPERATURE - LAPSE_RATE * asl - KELVIN;
+}
+
+flight::real flight::air_pressure(real altitude_m) const
+{
+    real asl = conf.ground_altitude_asl_m + altitude_m;
+    return SEA_LEVEL_PRESSURE * pow(1.0 - LAPSE_RATE * asl /
+        SEA_LEVEL_TEMPERATURE, GRAVITY_EARTH / (GAS_CONSTANT * LAPSE_RATE));
+}
+
+flight::real flight::air_density(real altitude_m) const
+{
+    return air_pressure(altitude_m) / (GAS_CONSTANT *
+        (air_temperature(altitude_m) + KELVIN));
+}
+
+void flight::set_deployment_deg(real deployment_deg)
+{
+    if (deployment_deg < 0)
+        deployment_deg = 0;
+    else if (deployment_deg > conf.max_deployment_deg)
+        deployment_deg = conf.max_deployment_deg;
+    current.deployment_deg = deployment_deg;
+}
+
+flight::real flight::acceleration(real altitude_m, real velocity_ms,
+        real mass_kg, real thrust_n) const
+{
+    real drag = 0.5 * air_density(altitude_m) * velocity_ms *
+        fabs(velocity_ms) * drag_area(current.deployment_deg);
+    return (thrust_n - drag) / mass_kg - GRAVITY_EARTH;
+}
+
+void flight::step(real dt)
+{
+    state &s = current;
+    s.time_s += dt;
+
+    switch (s.phase) {
+    case phase::PAD:
+        if (s.time_s >= conf.launch_time_s)
+            s.phase = phase::BOOST;
+        s.specific_force_ms2 = GRAVITY_EARTH;
+        return;
+
+    case phase::DESCENT:
+        s.velocity_ms = -conf.descent_rate_ms;
+        s.acceleration_ms2 = 0;
+        s.specific_force_ms2 = GRAVITY_EARTH;
+        s.altitude_m += s.velocity_ms * dt;
+        if (s.altitude_m <= 0) {
+            s.altitude_m = 0;
+            s.velocity_ms = 0;
+            s.phase = phase::LANDED;
+        }
+        return;
+
+    case phase::LANDED:
+        return;
+
+    default:
+        break;
+    }
+
+    real burn_t = s.time_s - conf.launch_time_s;
+    bool burning = burn_t < conf.burn_time_s;
+    real thrust = burning ? conf.thrust_n : 0;
+    real burnt = burning ? burn_t / conf.burn_time_s : 1;
+    real mass = conf.dry_mass_kg + conf.propellant_mass_kg * (1 - burnt);
+    if (!burning)
+        s.phase = phase::COAST;
+
+    // RK2 (midpoint) is plenty at a millisecond step
+    real a0 = acceleration(s.altitude_m, s.velocity_ms, mass, thrust);
+    real v_mid = s.velocity_ms + 0.5 * dt * a0;
+    real h_mid = s.altitude_m + 0.5 * dt * s.velocity_ms;
+    real a_mid = acceleration(h_mid, v_mid, mass, thrust);
+
+    s.altitude_m += dt * v_mid;
+    s.velocity_ms += dt * a_mid;
+    s.acceleration_ms2 = a_mid;
+    s.specific_force_ms2 = a_mid + GRAVITY_EARTH;
+
+    // the rail holds it down until thrust beats gravity
+    if (s.altitude_m < 0) {
+        s.altitude_m = 0;
+        s.velocity_ms = 0;
+        s.acceleration_ms2 = 0;
+        s.specific_force_ms2 = GRAVITY_EARTH;
+    }
+
+    if (s.altitude_m > s.apogee_m)
+        s.apogee_m = s.altitude_m;
+    if (s.phase == phase::COAST && s.velocity_ms <= 0)
+        s.phase = phase::DESCENT;
+}
+
+} // namespace sim
+
+} // namespace sdk
@@ -0,0 +1,654 @@
+
+#include <sdk/sim/hal.h>
+#include <sdk/sim/kernel.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <string.h>
+#include <vector>
+
+GPIO_TypeDef host_gpio[8];
+TIM_TypeDef host_tim[5];
+SPI_TypeDef host_spi[3];
+I2C_TypeDef host_i2c[3];
+USART_TypeDef host_usart[3];
+
+uint32_t SystemCoreClock = 84000000;
+
+namespace sdk {
+
+namespace sim {
+
+struct i2c_target {
+    I2C_HandleTypeDef *bus;
+    uint16_t address; /* 7-bit */
+    i2c_device *device;
+};
+
+/* per-bus state beyond the handle */
+struct i2c_bus {
+    I2C_HandleTypeDef *handle;
+    uint64_t complete_at_ns; /* of the transfer in flight, 0 if none */
+
+    i2c_fault fault;
+    int fault_count; /* transfers left to fail with `fault` */
+    int stuck_clocks; /* SCL edges until SDA is released, 0 if it is */
+    int init_failures; /* HAL_I2C_Init calls left to fail */
+
+    GPIO_TypeDef *scl_port;
+    uint16_t scl_pin;
+    GPIO_TypeDef *sda_port;
+    uint16_t sda_pin;
+};
+
+struct uart_port {
+    UART_HandleTypeDef *handle;
+    UART_HandleTypeDef *peer; /* whose RX our TX drives, if any */
+    uint16_t rx_position; /* of the DMA in the receive buffer */
+};
+
+struct spi_target {
+    SPI_HandleTypeDef *bus;
+    GPIO_TypeDef *cs_port;
+    uint16_t cs_pin;
+    spi_device *device;
+};
+
+static std::vector<i2c_target> i2c_targets;
+static std::vector<spi_target> spi_targets;
+static std::vector<i2c_bus> i2c_buses;
+static std::vector<uart_port> uart_ports;
+
+static constexpr uint32_t DEFAULT_I2C_CLOCK_HZ = 400000;
+/* a byte of a stuck read left to shift out, minus the clock it stopped on */
+static constexpr int STUCK_SDA_CLOCKS = 7;
+
+static i2c_bus &find_bus(I2C_HandleTypeDef *handle)
+{
+    for (i2c_bus &b : i2c_buses)
+        if (b.handle == handle)
+            return b;
+    i2c_bus b = {};
+    b.handle = handle;
+    i2c_buses.push_back(b);
+    return i2c_buses.back();
+}
+
+void hal::attach(I2C_HandleTypeDef *bus, uint16_t address, i2c_device &device)
+{
+    i2c_targets.push_back({ bus, address, &device });
+}
+
+void hal::attach_i2c_pins(I2C_HandleTypeDef *bus, GPIO_TypeDef *scl_port,
+        uint16_t scl_pin, GPIO_TypeDef *sda_port, uint16_t sda_pin)
+{
+    i2c_bus &b = find_bus(bus);
+    b.scl_port = scl_port;
+    b.scl_pin = scl_pin;
+    b.sda_port = sda_port;
+    b.sda_pin = sda_pin;
+    scl_port->ODR |= scl_pin;
+    scl_port->IDR |= scl_pin;
+    sda_port->ODR |= sda_pin;
+    if (b.stuck_clocks == 0)
+        sda_port->IDR |= sda_pin;
+    else
+        sda_port->IDR &= ~(uint32_t) sda_pin;
+}
+
+void hal::inject_i2c_fault(I2C_HandleTypeDef *bus, i2c_fault fault, int count)
+{
+    i2c_bus &b = find_bus(bus);
+    if (fault == i2c_fault::SDA_STUCK) {
+        b.stuck_clocks = STUCK_SDA_CLOCKS;
+        if (b.sda_port != nullptr)
+            b.sda_port->IDR &= ~(uint32_t) b.sda_pin;
+        return;
+    }
+    if (fault == i2c_fault::INIT_FAILS) {
+        b.init_failures = count;
+        return;
+    }
+    b.fault = fault;
+    b.fault_count = count;
+}
+
+static uart_port &find_port(UART_HandleTypeDef *handle)
+{
+    for (uart_port &p : uart_ports)
+        if (p.handle == handle)
+            return p;
+    uart_port p = {};
+    p.handle = handle;
+    uart_ports.push_back(p);
+    return uart_ports.back();
+}
+
+void hal::connect(UART_HandleTypeDef *from, UART_HandleTypeDef *to)
+{
+    find_port(from).peer = to;
+}
+
+void hal::inject_uart_error(UART_HandleTypeDef *uart, uint32_t error)
+{
+    uart->ErrorCode |= error;
+    uart->RxState = HAL_UART_STATE_READY;
+    HAL_UART_ErrorCallback(uart);
+}
+
+void hal::attach(SPI_HandleTypeDef *bus, GPIO_TypeDef *cs_port,
+        uint16_t cs_pin, spi_device &device)
+{
+    spi_targets.push_back({ bus, cs_port, cs_pin, &device });
+}
+
+void hal::drive_pin(GPIO_TypeDef *port, uint16_t pin, bool value)
+{
+    uint32_t before = port->IDR;
+    if (value)
+        port->IDR = before | pin;
+    else
+        port->IDR = before & ~(uint32_t) pin;
+    if (port->IDR != before)
+        HAL_GPIO_EXTI_Callback(pin);
+}
+
+bool hal::read_pin(GPIO_TypeDef *port, uint16_t pin)
+{
+    return (port->IDR & pin) != 0;
+}
+
+static volatile uint32_t *ccr(TIM_TypeDef *tim, uint32_t channel)
+{
+    switch (channel) {
+    case TIM_CHANNEL_1:
+        return &tim->CCR1;
+    case TIM_CHANNEL_2:
+        return &tim->CCR2;
+    case TIM_CHANNEL_3:
+        return &tim->CCR3;
+    default:
+        return &tim->CCR4;
+    }
+}
+
+float hal::get_pwm_duty(TIM_HandleTypeDef *htim, uint32_t channel)
+{
+    TIM_TypeDef *tim = htim->Instance;
+    if ((tim->CCER & (1u << channel)) == 0 || tim->ARR == 0)
+        return 0;
+    float duty = (float) *ccr(tim, channel) / (float) tim->ARR;
+    return duty > 1 ? 1 : duty;
+}
+
+void hal::reset()
+{
+    i2c_targets.clear();
+    spi_targets.clear();
+    i2c_buses.clear();
+    uart_ports.clear();
+    memset(host_gpio, 0, sizeof(host_gpio));
+    memset(host_tim, 0, sizeof(host_tim));
+    memset(host_spi, 0, sizeof(host_spi));
+    memset(host_i2c, 0, sizeof(host_i2c));
+    memset(host_usart, 0, sizeof(host_usart));
+}
+
+static i2c_device *find_i2c(I2C_HandleTypeDef *bus, uint16_t dev_address)
+{
+    for (const i2c_target &t : i2c_targets)
+        if (t.bus == bus && t.address == (dev_address >> 1))
+            return t.device;
+    return nullptr;
+}
+
+static spi_device *find_selected(SPI_HandleTypeDef *bus)
+{
+    for (const spi_target &t : spi_targets)
+        if (t.bus == bus && (t.cs_port->IDR & t.cs_pin) == 0)
+            return t.device;
+    return nullptr;
+}
+
+/* wire time of a register transfer, 9 clocks per byte plus start/stop */
+static uint64_t i2c_transfer_ns(I2C_HandleTypeDef *hi2c, uint16_t mem_size,
+        uint16_t size, bool read)
+{
+    uint32_t clock_hz = hi2c->Init.ClockSpeed != 0 ? hi2c->Init.ClockSpeed :
+        DEFAULT_I2C_CLOCK_HZ;
+    uint32_t bytes = 1 + (mem_size == I2C_MEMADD_SIZE_16BIT ? 2 : 1) + size +
+        (read ? 1 : 0);
+    uint32_t bits = bytes * 9 + (read ? 4 : 2);
+    return (uint64_t) bits * 1000000000ull / clock_hz;
+}
+
+/* performs the register access, returns false on a NACK */
+static bool i2c_access(I2C_HandleTypeDef *hi2c, uint16_t dev_address,
+        uint16_t mem_address, uint8_t *data, uint16_t size, bool read)
+{
+    i2c_device *device = find_i2c(hi2c, dev_address);
+    if (device == nullptr)
+        return false;
+    return read ? device->read(mem_address, data, size) :
+        device->write(mem_address, data, size);
+}
+
+static void i2c_complete(void *ctx)
+{
+    I2C_HandleTypeDef *hi2c = (I2C_HandleTypeDef *) ctx;
+    i2c_bus &b = find_bus(hi2c);
+    // the transfer was torn down by HAL_I2C_DeInit since
+    if (b.complete_at_ns != kernel::now_ns())
+        return;
+    b.complete_at_ns = 0;
+
+    HAL_I2C_StateTypeDef was = hi2c->State;
+    hi2c->State = HAL_I2C_STATE_READY;
+    if (hi2c->ErrorCode != HAL_I2C_ERROR_NONE)
+        HAL_I2C_ErrorCallback(hi2c);
+    else if (was == HAL_I2C_STATE_BUSY_RX)
+        HAL_I2C_MemRxCpltCallback(hi2c);
+    else
+        HAL_I2C_MemTxCpltCallback(hi2c);
+}
+
+static HAL_StatusTypeDef i2c_start_it(I2C_HandleTypeDef *hi2c,
+        uint16_t dev_address, uint16_t mem_address, uint16_t mem_size,
+        uint8_t *data, uint16_t size, bool read)
+{
+    i2c_bus &b = find_bus(hi2c);
+    // with SDA held low the peripheral never gets to send a START
+    if (b.stuck_clocks > 0)
+        return HAL_BUSY;
+    if (hi2c->State != HAL_I2C_STATE_READY &&
+            hi2c->State != HAL_I2C_STATE_RESET)
+        return HAL_BUSY;
+
+    hi2c->State = read ? HAL_I2C_STATE_BUSY_RX : HAL_I2C_STATE_BUSY_TX;
+    hi2c->Devaddress = dev_address;
+    hi2c->Memaddress = mem_address;
+    hi2c->pBuffPtr = data;
+    hi2c->XferSize = size;
+    hi2c->XferCount = 0;
+
+    uint32_t error = HAL_I2C_ERROR_NONE;
+    if (b.fault_count > 0) {
+        b.fault_count--;
+        switch (b.fault) {
+        case i2c_fault::NACK:
+            error = HAL_I2C_ERROR_AF;
+            break;
+        case i2c_fault::ARBITRATION_LOST:
+            error = HAL_I2C_ERROR_ARLO;
+            break;
+        case i2c_fault::BUS_ERROR:
+            error = HAL_I2C_ERROR_BERR;
+            break;
+        default:
+            // no interrupt ever comes, the state stays busy
+            hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+            b.complete_at_ns = 0;
+            return HAL_OK;
+        }
+    }
+
+    // the device sees the access now, the CPU hears about it when the last
+    // byte is on the wire; a fault ends the transfer after the address byte
+    if (error == HAL_I2C_ERROR_NONE &&
+            !i2c_access(hi2c, dev_address, mem_address, data, size, read))
+        error = HAL_I2C_ERROR_AF;
+    hi2c->ErrorCode = error;
+    uint64_t duration = error == HAL_I2C_ERROR_NONE ?
+        i2c_transfer_ns(hi2c, mem_size, size, read) :
+        i2c_transfer_ns(hi2c, mem_size, 0, false) / 3;
+    b.complete_at_ns = kernel::now_ns() + duration;
+    kernel::schedule(b.complete_at_ns, i2c_complete, hi2c);
+    return HAL_OK;
+}
+
+/* receives `size` bytes into a circular DMA reception, if one is running */
+static void uart_deliver(UART_HandleTypeDef *huart, const uint8_t *data,
+        uint16_t size)
+{
+    uart_port &p = find_port(huart);
+    uint16_t reported = p.rx_position;
+    for (uint16_t i = 0; i < size; i++) {
+        if (huart->RxState != HAL_UART_STATE_BUSY_RX)
+            return;
+        huart->pRxBuffPtr[p.rx_position++] = data[i];
+        // transfer complete, and the circular DMA starts over
+        if (p.rx_position == huart->RxXferSize) {
+            p.rx_position = 0;
+            reported = 0;
+            HAL_UARTEx_RxEventCallback(huart, huart->RxXferSize);
+        }
+    }
+    if (p.rx_position != reported &&
+            huart->RxState == HAL_UART_STATE_BUSY_RX)
+        HAL_UARTEx_RxEventCallback(huart, p.rx_position);
+}
+
+static void uart_tx_complete(void *ctx)
+{
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *) ctx;
+    UART_HandleTypeDef *peer = find_port(huart).peer;
+    if (peer != nullptr)
+        uart_deliver(peer, huart->pTxBuffPtr, huart->TxXferSize);
+    huart->TxXferCount = 0;
+    huart->gState = HAL_UART_STATE_READY;
+    HAL_UART_TxCpltCallback(huart);
+}
+
+} // namespace sim
+
+} // namespace sdk
+
+using sdk::sim::kernel;
+
+/* weak callbacks, overridden by the application */
+
+__weak void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    (void) hi2c;
+}
+
+__weak void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    (void) hi2c;
+}
+
+__weak void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    (void) hi2c;
+}
+
+__weak void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    (void) hi2c;
+}
+
+__weak void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    (void) huart;
+}
+
+__weak void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart,
+        uint16_t Size)
+{
+    (void) huart;
+    (void) Size;
+}
+
+__weak void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    (void) huart;
+}
+
+__weak void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    (void) GPIO_Pin;
+}
+
+/* core */
+
+HAL_StatusTypeDef HAL_Init(void)
+{
+    return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t) (kernel::now_ns() / 1000000);
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+    // busy waits take no simulated time, so only a task can actually wait
+    if (xTaskGetCurrentTaskHandle() != nullptr)
+        vTaskDelay(pdMS_TO_TICKS(Delay) + 1);
+}
+
+/* gpio */
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+    // pin modes are not simulated, every pin reads back what drives it
+    (void) GPIOx;
+    (void) GPIO_Init;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return (GPIOx->IDR & GPIO_Pin) != 0 ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin,
+        GPIO_PinState PinState)
+{
+    uint32_t before = GPIOx->ODR;
+    if (PinState == GPIO_PIN_SET)
+        GPIOx->ODR = before | GPIO_Pin;
+    else
+        GPIOx->ODR = before & ~(uint32_t) GPIO_Pin;
+    // outputs read back through IDR
+    GPIOx->IDR = (GPIOx->IDR & ~(uint32_t) GPIO_Pin) | (GPIOx->ODR & GPIO_Pin);
+
+    uint32_t changed = before ^ GPIOx->ODR;
+    for (sdk::sim::i2c_bus &b : sdk::sim::i2c_buses) {
+        if (b.stuck_clocks == 0 || b.sda_port == nullptr)
+            continue;
+        // open drain: the device holding SDA wins, each SCL rise shifts a bit
+        if (GPIOx == b.scl_port && (changed & GPIOx->ODR & b.scl_pin) != 0 &&
+                --b.stuck_clocks == 0) {
+            b.sda_port->IDR = (b.sda_port->IDR & ~(uint32_t) b.sda_pin) |
+                (b.sda_port->ODR & b.sda_pin);
+        } else if (b.stuck_clocks > 0) {
+            b.sda_port->IDR &= ~(uint32_t) b.sda_pin;
+        }
+    }
+    for (const sdk::sim::spi_target &t : sdk::sim::spi_targets) {
+        if (t.cs_port != GPIOx || (changed & t.cs_pin) == 0)
+            continue;
+        if (GPIOx->ODR & t.cs_pin)
+            t.device->deselect();
+        else
+            t.device->select();
+    }
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    HAL_GPIO_WritePin(GPIOx, GPIO_Pin, (GPIOx->ODR & GPIO_Pin) != 0 ?
+        GPIO_PIN_RESET : GPIO_PIN_SET);
+}
+
+/* timers */
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    htim->Instance->CCER |= 1u << Channel; /* CCxE */
+    if (htim->Instance->ARR == 0)
+        htim->Instance->ARR = htim->Init.Period;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    htim->Instance->CCER &= ~(1u << Channel);
+    return HAL_OK;
+}
+
+/* spi, blocking transfers take no simulated time */
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef *hspi,
+        uint8_t *pTxData, uint8_t *pRxData, uint16_t Size, uint32_t Timeout)
+{
+    (void) Timeout;
+    sdk::sim::spi_device *device = sdk::sim::find_selected(hspi);
+    if (device != nullptr) {
+        device->transfer(pTxData, pRxData, Size);
+    } else if (pRxData != nullptr) {
+        memset(pRxData, 0xff, Size); /* nobody drives MISO */
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData,
+        uint16_t Size, uint32_t Timeout)
+{
+    return HAL_SPI_TransmitReceive(hspi, pData, nullptr, Size, Timeout);
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData,
+        uint16_t Size, uint32_t Timeout)
+{
+    return HAL_SPI_TransmitReceive(hspi, nullptr, pData, Size, Timeout);
+}
+
+/* i2c */
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c)
+{
+    sdk::sim::i2c_bus &b = sdk::sim::find_bus(hi2c);
+    if (b.init_failures > 0) {
+        // as the HAL's own early return, after it has marked the handle busy
+        b.init_failures--;
+        hi2c->State = HAL_I2C_STATE_BUSY;
+        return HAL_ERROR;
+    }
+    hi2c->State = HAL_I2C_STATE_READY;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c)
+{
+    // a transfer in flight (or hung) is dropped without a callback
+    sdk::sim::find_bus(hi2c).complete_at_ns = 0;
+    hi2c->State = HAL_I2C_STATE_RESET;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c,
+        uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize,
+        uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void) MemAddSize;
+    (void) Timeout;
+    bool acked = sdk::sim::i2c_access(hi2c, DevAddress, MemAddress, pData,
+        Size, false);
+    hi2c->ErrorCode = acked ? HAL_I2C_ERROR_NONE : HAL_I2C_ERROR_AF;
+    return acked ? HAL_OK : HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c,
+        uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize,
+        uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void) MemAddSize;
+    (void) Timeout;
+    bool acked = sdk::sim::i2c_access(hi2c, DevAddress, MemAddress, pData,
+        Size, true);
+    hi2c->ErrorCode = acked ? HAL_I2C_ERROR_NONE : HAL_I2C_ERROR_AF;
+    return acked ? HAL_OK : HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef *hi2c,
+        uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize,
+        uint8_t *pData, uint16_t Size)
+{
+    return sdk::sim::i2c_start_it(hi2c, DevAddress, MemAddress, MemAddSize,
+        pData, Size, false);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef *hi2c,
+        uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize,
+        uint8_t *pData, uint16_t Size)
+{
+    return sdk::sim::i2c_start_it(hi2c, DevAddress, MemAddress, MemAddSize,
+        pData, Size, true);
+}
+
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c,
+        uint16_t DevAddress, uint32_t Trials, uint32_t Timeout)
+{
+    (void) Trials;
+    (void) Timeout;
+    return sdk::sim::find_i2c(hi2c, DevAddress) != nullptr ? HAL_OK :
+        HAL_ERROR;
+}
+
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c)
+{
+    return hi2c->State;
+}
+
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef *hi2c)
+{
+    return hi2c->ErrorCode;
+}
+
+/* uart */
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart,
+        const uint8_t *pData, uint16_t Size)
+{
+    if (huart->gState != HAL_UART_STATE_READY)
+        return HAL_BUSY;
+    if (pData == nullptr || Size == 0)
+        return HAL_ERROR;
+
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    huart->pTxBuffPtr = (uint8_t *) pData;
+    huart->TxXferSize = Size;
+    huart->TxXferCount = Size;
+
+    // start, 8 data and stop bits per byte
+    uint32_t baud = huart->Init.BaudRate != 0 ? huart->Init.BaudRate : 115200;
+    uint64_t duration = (uint64_t) Size * 10 * 1000000000ull / baud;
+    kernel::schedule(kernel::now_ns() + duration, sdk::sim::uart_tx_complete,
+        huart);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart,
+        uint8_t *pData, uint16_t Size)
+{
+    if (huart->RxState != HAL_UART_STATE_READY)
+        return HAL_BUSY;
+    if (pData == nullptr || Size == 0)
+        return HAL_ERROR;
+
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    sdk::sim::find_port(huart).rx_position = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart)
+{
+    huart->RxState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_UART_StateTypeDef HAL_UART_GetState(UART_HandleTypeDef *huart)
+{
+    return (HAL_UART_StateTypeDef) (huart->gState | huart->RxState);
+}
+
+uint32_t HAL_UART_GetError(UART_HandleTypeDef *huart)
+{
+    return huart->ErrorCode;
+}
@@ -0,0 +1,121 @@
+
+#include <sdk/sim/i2c_replay.h>
+#include <sdk/sim/kernel.h>
+
+#include <stdio.h>
+#include <string.h>
+
+namespace sdk {
+
+namespace sim {
+
+bool i2c_replay::load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == nullptr)
+        return false;
+
+    i2c_log::header h;
+    if (fread(&h, sizeof(h), 1, f) != 1 || h.magic != i2c_log::MAGIC ||
+            h.version != i2c_log::VERSION ||
+            h.record_size != sizeof(i2c_log::record)) {
+        fclose(f);
+        return false;
+    }
+
+    records.clear();
+    devices.clear();
+    i2c_log::record r;
+    while (fread(&r, sizeof(r), 1, f) == 1) {
+        records.push_back(r);
+        if (find(r.address) == nullptr)
+            devices.emplace_back(new device(*this, r.address));
+    }
+    fclose(f);
+
+    cursor = 0;
+    aligned = false;
+    return !records.empty();
+}
+
+void i2c_replay::attach(I2C_HandleTypeDef *bus)
+{
+    for (std::unique_ptr<device> &d : devices)
+        hal::attach(bus, d->get_address(), *d);
+}
+
+bool i2c_replay::is_finished() const
+{
+    if (records.empty())
+        return true;
+    if (!aligned)
+        return false;
+    int64_t now_us = (int64_t) (kernel::now_ns() / 1000);
+    return now_us + offset_us > (int64_t) records.back().timestamp_us;
+}
+
+uint64_t i2c_replay::get_duration_us() const
+{
+    if (records.empty())
+        return 0;
+    return records.back().timestamp_us - records.front().timestamp_us;
+}
+
+i2c_replay::device *i2c_replay::find(uint8_t address)
+{
+    for (std::unique_ptr<device> &d : devices)
+        if (d->get_address() == address)
+            return d.get();
+    return nullptr;
+}
+
+void i2c_replay::advance()
+{
+    int64_t now_us = (int64_t) (kernel::now_ns() / 1000);
+    if (!aligned) {
+        offset_us = (int64_t) records.front().timestamp_us - now_us;
+        aligned = true;
+    }
+
+    int64_t log_now = now_us + offset_us;
+    while (cursor < records.size() &&
+            (int64_t) records[cursor].timestamp_us <= log_now) {
+        const i2c_log::record &r = records[cursor++];
+        if ((r.flags & i2c_log::FLAG_WRITE) == 0)
+            find(r.address)->apply(r);
+    }
+}
+
+i2c_replay::device::device(i2c_replay &owner, uint8_t address) :
+        owner(owner), address(address)
+{
+    memset(regs, 0, sizeof(regs));
+}
+
+void i2c_replay::device::apply(const i2c_log::record &r)
+{
+    for (uint16_t i = 0; i < r.size && r.reg + i < sizeof(regs); i++)
+        regs[r.reg + i] = r.data[i];
+}
+
+bool i2c_replay::device::read(uint16_t reg, uint8_t *data, uint16_t size)
+{
+    owner.advance();
+    for (uint16_t i = 0; i < size; i++)
+        data[i] = reg + i < sizeof(regs) ? regs[reg + i] : 0;
+    return true;
+}
+
+bool i2c_replay::device::write(uint16_t reg, const uint8_t *data,
+        uint16_t size)
+{
+    (void) reg;
+    (void) data;
+    (void) size;
+    owner.advance();
+    return true;
+}
+
+} // namespace sim
+
+} // namespace sdk
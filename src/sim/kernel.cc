@@ -0,0 +1,839 @@
+
+#include <sdk/sim/kernel.h>
+
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <semphr.h>
+#include <task.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * FreeRTOS on the host, in simulated time. Every task is a std::thread, but
+ * the threads hand a single baton around: the scheduler (the thread that
+ * called vTaskStartScheduler) picks one ready task, lets it run until it
+ * blocks, and only then picks again. When nothing is ready it runs due events
+ * (simulated interrupts) or jumps the clock to the next timeout.
+ *
+ * Not modelled: time slicing, priority inheritance, stack sizes.
+ */
+
+using sdk::sim::kernel;
+
+static constexpr uint64_t NS_PER_TICK = 1000000000ull / configTICK_RATE_HZ;
+static constexpr uint64_t FOREVER = UINT64_MAX;
+
+/* thrown into a task to unwind it when it is deleted or the scheduler ends */
+struct task_exit {
+};
+
+struct tskTaskControlBlock {
+    enum class state {
+        READY,
+        RUNNING,
+        BLOCKED,
+        DELETED,
+    };
+
+    TaskFunction_t fn;
+    void *arg;
+    const char *name;
+    UBaseType_t priority;
+
+    std::thread thread;
+    std::condition_variable wake;
+
+    state st;
+    uint64_t deadline_ns; /* FOREVER if blocked without a timeout */
+    bool timed_out;
+    bool killed;
+    std::vector<TaskHandle_t> *wait_list; /* the list it is queued on */
+
+    uint32_t notify_value[configTASK_NOTIFICATION_ARRAY_ENTRIES];
+    int notify_waiting; /* notification index blocked on, or -1 */
+};
+
+struct QueueDefinition {
+    uint8_t *storage;
+    bool owns_storage;
+    bool is_static;
+
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head; /* index of the front item */
+    UBaseType_t count;
+
+    bool is_mutex;
+    TaskHandle_t holder;
+
+    std::vector<TaskHandle_t> waiting_to_receive;
+    std::vector<TaskHandle_t> waiting_to_send;
+};
+
+static_assert(sizeof(QueueDefinition) <= sizeof(StaticQueue_t),
+        "StaticQueue_t too small for the host queue");
+
+namespace {
+
+struct event {
+    uint64_t at_ns;
+    uint64_t seq; /* keeps events at the same instant in FIFO order */
+    kernel::event_fn fn;
+    void *ctx;
+
+    bool operator>(const event &other) const
+    {
+        return at_ns != other.at_ns ? at_ns > other.at_ns : seq > other.seq;
+    }
+};
+
+struct kernel_state {
+    std::mutex lock;
+    std::condition_variable scheduler_wake;
+
+    uint64_t now_ns = 0;
+    uint64_t event_seq = 0;
+    uint64_t switches = 0;
+    std::priority_queue<event, std::vector<event>, std::greater<event>>
+        events;
+
+    std::vector<TaskHandle_t> tasks; /* in creation order */
+    std::deque<TaskHandle_t> ready[configMAX_PRIORITIES];
+    TaskHandle_t current = nullptr;
+
+    bool running = false;
+    bool stop_requested = false;
+    bool ending = false; /* unwinding the tasks after a stop */
+};
+
+} // namespace
+
+/* see kernel::get_heap_allocations; kernel objects outlive scheduler runs */
+static std::atomic<uint64_t> heap_allocations{0};
+
+static kernel_state &state()
+{
+    // constructed on first use, kernel objects may be created by static
+    // constructors
+    static kernel_state s;
+    return s;
+}
+
+/* the task running on this thread, null for the scheduler and main */
+static thread_local TaskHandle_t this_task = nullptr;
+
+using guard = std::unique_lock<std::mutex>;
+
+static uint64_t deadline_after(const kernel_state &s, TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY)
+        return FOREVER;
+    return (s.now_ns / NS_PER_TICK + ticks) * NS_PER_TICK;
+}
+
+static void make_ready(kernel_state &s, TaskHandle_t task)
+{
+    if (task->st != tskTaskControlBlock::state::BLOCKED)
+        return;
+    if (task->wait_list != nullptr) {
+        auto &list = *task->wait_list;
+        list.erase(std::find(list.begin(), list.end(), task));
+        task->wait_list = nullptr;
+    }
+    task->notify_waiting = -1;
+    task->st = tskTaskControlBlock::state::READY;
+    s.ready[task->priority].push_back(task);
+}
+
+/* wakes the highest priority waiter, first come first served within one */
+static TaskHandle_t wake_one(kernel_state &s, std::vector<TaskHandle_t> &list)
+{
+    if (list.empty())
+        return nullptr;
+    TaskHandle_t best = list.front();
+    for (TaskHandle_t task : list)
+        if (task->priority > best->priority)
+            best = task;
+    make_ready(s, best);
+    return best;
+}
+
+static int highest_ready(const kernel_state &s)
+{
+    for (int p = configMAX_PRIORITIES - 1; p >= 0; p--)
+        if (!s.ready[p].empty())
+            return p;
+    return -1;
+}
+
+/* hands the baton back to the scheduler and waits to be picked again */
+static void switch_out(kernel_state &s, guard &lk, TaskHandle_t self)
+{
+    s.current = nullptr;
+    s.scheduler_wake.notify_one();
+    self->wake.wait(lk, [&] { return s.current == self; });
+    self->st = tskTaskControlBlock::state::RUNNING;
+    if (self->killed && std::uncaught_exceptions() == 0)
+        throw task_exit();
+}
+
+/*
+ * Blocks the calling task until it is made ready or `deadline_ns` passes,
+ * queued on `list` if given. Returns false on timeout.
+ */
+static bool block(kernel_state &s, guard &lk, uint64_t deadline_ns,
+        std::vector<TaskHandle_t> *list)
+{
+    TaskHandle_t self = this_task;
+    if (self == nullptr || s.ending || deadline_ns <= s.now_ns)
+        return false;
+
+    self->st = tskTaskControlBlock::state::BLOCKED;
+    self->deadline_ns = deadline_ns;
+    self->timed_out = false;
+    self->wait_list = list;
+    if (list != nullptr)
+        list->push_back(self);
+    switch_out(s, lk, self);
+    return !self->timed_out;
+}
+
+/* lets a higher priority task that was just made ready run first */
+static void preempt_check(kernel_state &s, guard &lk)
+{
+    TaskHandle_t self = this_task;
+    if (self == nullptr || s.ending || s.current != self)
+        return;
+    if (highest_ready(s) <= (int) self->priority)
+        return;
+    self->st = tskTaskControlBlock::state::READY;
+    s.ready[self->priority].push_front(self);
+    switch_out(s, lk, self);
+}
+
+static void task_entry(TaskHandle_t self)
+{
+    kernel_state &s = state();
+    this_task = self;
+    {
+        guard lk(s.lock);
+        self->wake.wait(lk, [&] { return s.current == self; });
+        self->st = tskTaskControlBlock::state::RUNNING;
+    }
+
+    if (!self->killed) {
+        try {
+            self->fn(self->arg);
+        } catch (const task_exit &) {
+        }
+    }
+
+    // returning from a task function counts as deleting it
+    guard lk(s.lock);
+    self->st = tskTaskControlBlock::state::DELETED;
+    s.current = nullptr;
+    s.scheduler_wake.notify_one();
+}
+
+/* joins and frees deleted tasks, called by the scheduler */
+static void reap(kernel_state &s, guard &lk)
+{
+    for (size_t i = 0; i < s.tasks.size();) {
+        TaskHandle_t task = s.tasks[i];
+        if (task->st != tskTaskControlBlock::state::DELETED) {
+            i++;
+            continue;
+        }
+        s.tasks.erase(s.tasks.begin() + i);
+        lk.unlock();
+        task->thread.join();
+        delete task;
+        lk.lock();
+    }
+}
+
+static void run_task(kernel_state &s, guard &lk, TaskHandle_t task)
+{
+    s.current = task;
+    s.switches++;
+    task->wake.notify_one();
+    s.scheduler_wake.wait(lk, [&] { return s.current == nullptr; });
+}
+
+/* runs every event due now; returns true if any ran */
+static bool run_due_events(kernel_state &s, guard &lk)
+{
+    bool ran = false;
+    while (!s.events.empty() && s.events.top().at_ns <= s.now_ns) {
+        event e = s.events.top();
+        s.events.pop();
+        lk.unlock();
+        e.fn(e.ctx);
+        lk.lock();
+        ran = true;
+    }
+    return ran;
+}
+
+static void wake_timeouts(kernel_state &s)
+{
+    for (TaskHandle_t task : s.tasks) {
+        if (task->st == tskTaskControlBlock::state::BLOCKED &&
+                task->deadline_ns <= s.now_ns) {
+            task->timed_out = true;
+            make_ready(s, task);
+        }
+    }
+}
+
+static uint64_t next_wakeup(const kernel_state &s)
+{
+    uint64_t next = s.events.empty() ? FOREVER : s.events.top().at_ns;
+    for (TaskHandle_t task : s.tasks)
+        if (task->st == tskTaskControlBlock::state::BLOCKED &&
+                task->deadline_ns < next)
+            next = task->deadline_ns;
+    return next;
+}
+
+/* unwinds every remaining task, one at a time */
+static void end_tasks(kernel_state &s, guard &lk)
+{
+    s.ending = true;
+    for (TaskHandle_t task : s.tasks) {
+        if (task->st == tskTaskControlBlock::state::DELETED)
+            continue;
+        task->killed = true;
+        make_ready(s, task); // off any wait list
+        run_task(s, lk, task);
+    }
+    reap(s, lk);
+    for (auto &list : s.ready)
+        list.clear();
+    s.ending = false;
+}
+
+namespace sdk {
+
+namespace sim {
+
+uint64_t kernel::now_ns()
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    return s.now_ns;
+}
+
+void kernel::schedule(uint64_t at_ns, event_fn fn, void *ctx)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    if (at_ns < s.now_ns)
+        at_ns = s.now_ns;
+    s.events.push({ at_ns, s.event_seq++, fn, ctx });
+}
+
+void kernel::stop()
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    s.stop_requested = true;
+}
+
+void kernel::reset()
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    if (s.running) {
+        fprintf(stderr, "sim: kernel::reset while the scheduler runs\n");
+        abort();
+    }
+    s.now_ns = 0;
+    s.event_seq = 0;
+    s.switches = 0;
+    s.events = {};
+}
+
+uint64_t kernel::get_switch_count()
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    return s.switches;
+}
+
+uint64_t kernel::get_heap_allocations()
+{
+    return heap_allocations.load();
+}
+
+} // namespace sim
+
+} // namespace sdk
+
+/* memory */
+
+void *pvPortMalloc(size_t size)
+{
+    heap_allocations++;
+    return malloc(size);
+}
+
+void vPortFree(void *ptr)
+{
+    free(ptr);
+}
+
+/* tasks */
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name,
+        uint32_t stack_depth, void *arg, UBaseType_t priority,
+        TaskHandle_t *created)
+{
+    (void) stack_depth;
+    kernel_state &s = state();
+
+    TaskHandle_t task = new tskTaskControlBlock();
+    task->fn = fn;
+    task->arg = arg;
+    task->name = name;
+    task->priority = priority < configMAX_PRIORITIES ? priority :
+        configMAX_PRIORITIES - 1;
+    task->st = tskTaskControlBlock::state::READY;
+    task->deadline_ns = FOREVER;
+    task->timed_out = false;
+    task->killed = false;
+    task->wait_list = nullptr;
+    task->notify_waiting = -1;
+
+    guard lk(s.lock);
+    task->thread = std::thread(task_entry, task);
+    s.tasks.push_back(task);
+    s.ready[task->priority].push_back(task);
+    if (created != nullptr)
+        *created = task;
+    preempt_check(s, lk);
+    return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name,
+        uint32_t stack_depth, void *arg, UBaseType_t priority,
+        StackType_t *stack, StaticTask_t *tcb)
+{
+    // threads bring their own stacks on the host
+    (void) stack;
+    (void) tcb;
+    TaskHandle_t task = nullptr;
+    xTaskCreate(fn, name, stack_depth, arg, priority, &task);
+    return task;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    kernel_state &s = state();
+    if (task == nullptr || task == this_task)
+        throw task_exit();
+
+    guard lk(s.lock);
+    task->killed = true;
+    make_ready(s, task);
+}
+
+void vTaskStartScheduler(void)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    s.running = true;
+    s.stop_requested = false;
+
+    while (!s.stop_requested) {
+        run_due_events(s, lk);
+        wake_timeouts(s);
+
+        int p = highest_ready(s);
+        if (p >= 0) {
+            TaskHandle_t task = s.ready[p].front();
+            s.ready[p].pop_front();
+            run_task(s, lk, task);
+            reap(s, lk);
+            continue;
+        }
+
+        uint64_t next = next_wakeup(s);
+        if (next == FOREVER) {
+            if (!s.tasks.empty())
+                fprintf(stderr, "sim: every task is blocked forever at "
+                    "%llu ns\n", (unsigned long long) s.now_ns);
+            break;
+        }
+        s.now_ns = next;
+    }
+
+    end_tasks(s, lk);
+    s.running = false;
+}
+
+void vTaskEndScheduler(void)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    s.stop_requested = true;
+    TaskHandle_t self = this_task;
+    if (self != nullptr && !s.ending) {
+        // parked until the scheduler unwinds it
+        self->st = tskTaskControlBlock::state::READY;
+        switch_out(s, lk, self);
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    if (ticks == 0) {
+        lk.unlock();
+        vTaskYield();
+        return;
+    }
+    block(s, lk, deadline_after(s, ticks), nullptr);
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *previous_wake, TickType_t increment)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    TickType_t wake = *previous_wake + increment;
+    *previous_wake = wake;
+    uint64_t deadline = (uint64_t) wake * NS_PER_TICK;
+    if (deadline <= s.now_ns)
+        return pdFALSE;
+    block(s, lk, deadline, nullptr);
+    return pdTRUE;
+}
+
+void vTaskYield(void)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    TaskHandle_t self = this_task;
+    if (self == nullptr || s.ending)
+        return;
+    self->st = tskTaskControlBlock::state::READY;
+    s.ready[self->priority].push_back(self);
+    switch_out(s, lk, self);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    return (TickType_t) (s.now_ns / NS_PER_TICK);
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return this_task;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+    task = task != nullptr ? task : this_task;
+    return task != nullptr ? task->priority : 0;
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+    task = task != nullptr ? task : this_task;
+    return task != nullptr ? task->name : nullptr;
+}
+
+/* notifications */
+
+static bool notify_give(kernel_state &s, TaskHandle_t task, UBaseType_t index)
+{
+    task->notify_value[index]++;
+    if (task->st == tskTaskControlBlock::state::BLOCKED &&
+            task->notify_waiting == (int) index) {
+        make_ready(s, task);
+        return true;
+    }
+    return false;
+}
+
+BaseType_t xTaskNotifyGiveIndexed(TaskHandle_t task, UBaseType_t index)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    notify_give(s, task, index);
+    preempt_check(s, lk);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveIndexedFromISR(TaskHandle_t task, UBaseType_t index,
+        BaseType_t *woken)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    if (notify_give(s, task, index) && woken != nullptr)
+        *woken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear,
+        TickType_t ticks)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    TaskHandle_t self = this_task;
+    if (self == nullptr)
+        return 0;
+
+    uint64_t deadline = deadline_after(s, ticks);
+    for (;;) {
+        uint32_t value = self->notify_value[index];
+        if (value != 0) {
+            self->notify_value[index] = clear ? 0 : value - 1;
+            return value;
+        }
+        self->notify_waiting = (int) index;
+        if (!block(s, lk, deadline, nullptr)) {
+            self->notify_waiting = -1;
+            return 0;
+        }
+    }
+}
+
+/* queues and semaphores */
+
+static QueueHandle_t queue_init(QueueDefinition *q, UBaseType_t length,
+        UBaseType_t item_size, uint8_t *storage, bool is_static)
+{
+    q->owns_storage = storage == nullptr && item_size > 0;
+    q->storage = q->owns_storage ? (uint8_t *) malloc(length * item_size) :
+        storage;
+    q->is_static = is_static;
+    q->length = length;
+    q->item_size = item_size;
+    q->head = 0;
+    q->count = 0;
+    q->is_mutex = false;
+    q->holder = nullptr;
+    return q;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    heap_allocations++;
+    return queue_init(new QueueDefinition(), length, item_size, nullptr,
+        false);
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size,
+        uint8_t *storage, StaticQueue_t *queue)
+{
+    return queue_init(new (queue) QueueDefinition(), length, item_size,
+        storage, true);
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (queue->owns_storage)
+        free(queue->storage);
+    if (queue->is_static)
+        queue->~QueueDefinition();
+    else
+        delete queue;
+}
+
+static void copy_in(QueueHandle_t q, const void *item, BaseType_t position)
+{
+    if (position == queueSEND_TO_FRONT) {
+        q->head = (q->head + q->length - 1) % q->length;
+        if (q->item_size > 0)
+            memcpy(q->storage + q->head * q->item_size, item, q->item_size);
+    } else if (q->item_size > 0) {
+        UBaseType_t tail = (q->head + q->count) % q->length;
+        memcpy(q->storage + tail * q->item_size, item, q->item_size);
+    }
+    q->count++;
+}
+
+static BaseType_t queue_send(QueueHandle_t q, const void *item,
+        TickType_t ticks, BaseType_t position, BaseType_t *woken)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    uint64_t deadline = woken != nullptr ? 0 : deadline_after(s, ticks);
+    for (;;) {
+        if (q->count < q->length) {
+            if (q->is_mutex) {
+                // only the holder may give a mutex back
+                if (q->holder != this_task)
+                    return pdFAIL;
+                q->holder = nullptr;
+            }
+            copy_in(q, item, position);
+            if (wake_one(s, q->waiting_to_receive) != nullptr &&
+                    woken != nullptr)
+                *woken = pdTRUE;
+            if (woken == nullptr)
+                preempt_check(s, lk);
+            return pdPASS;
+        }
+        if (!block(s, lk, deadline, &q->waiting_to_send))
+            return errQUEUE_FULL;
+    }
+}
+
+static BaseType_t queue_receive(QueueHandle_t q, void *item, TickType_t ticks,
+        bool peek, BaseType_t *woken)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    uint64_t deadline = woken != nullptr ? 0 : deadline_after(s, ticks);
+    for (;;) {
+        if (q->count > 0) {
+            if (item != nullptr && q->item_size > 0)
+                memcpy(item, q->storage + q->head * q->item_size,
+                    q->item_size);
+            if (!peek) {
+                q->head = (q->head + 1) % q->length;
+                q->count--;
+                if (q->is_mutex)
+                    q->holder = this_task;
+                if (wake_one(s, q->waiting_to_send) != nullptr &&
+                        woken != nullptr)
+                    *woken = pdTRUE;
+            }
+            if (woken == nullptr)
+                preempt_check(s, lk);
+            return pdPASS;
+        }
+        if (!block(s, lk, deadline, &q->waiting_to_receive))
+            return errQUEUE_EMPTY;
+    }
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t queue, const void *item,
+        TickType_t ticks, BaseType_t position)
+{
+    return queue_send(queue, item, ticks, position, nullptr);
+}
+
+BaseType_t xQueueGenericSendFromISR(QueueHandle_t queue, const void *item,
+        BaseType_t *woken, BaseType_t position)
+{
+    BaseType_t unused = pdFALSE;
+    return queue_send(queue, item, 0, position,
+        woken != nullptr ? woken : &unused);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    return queue_receive(queue, item, ticks, false, nullptr);
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void *item,
+        BaseType_t *woken)
+{
+    BaseType_t unused = pdFALSE;
+    return queue_receive(queue, item, 0, false,
+        woken != nullptr ? woken : &unused);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    return queue_receive(queue, item, ticks, true, nullptr);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    return queue->count;
+}
+
+UBaseType_t uxQueueMessagesWaitingFromISR(QueueHandle_t queue)
+{
+    return uxQueueMessagesWaiting(queue);
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    return queue->length - queue->count;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    queue->head = 0;
+    queue->count = 0;
+    while (wake_one(s, queue->waiting_to_send) != nullptr) {
+    }
+    return pdPASS;
+}
+
+static SemaphoreHandle_t semaphore_init(QueueDefinition *q,
+        UBaseType_t max, UBaseType_t initial, bool is_mutex, bool is_static)
+{
+    queue_init(q, max, 0, nullptr, is_static);
+    q->count = initial;
+    q->is_mutex = is_mutex;
+    return q;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    heap_allocations++;
+    return semaphore_init(new QueueDefinition(), 1, 1, true, false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer)
+{
+    return semaphore_init(new (buffer) QueueDefinition(), 1, 1, true, true);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    heap_allocations++;
+    return semaphore_init(new QueueDefinition(), 1, 0, false, false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buffer)
+{
+    return semaphore_init(new (buffer) QueueDefinition(), 1, 0, false, true);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max,
+        UBaseType_t initial)
+{
+    heap_allocations++;
+    return semaphore_init(new QueueDefinition(), max, initial, false, false);
+}
+
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t semaphore)
+{
+    kernel_state &s = state();
+    guard lk(s.lock);
+    return semaphore->holder;
+}
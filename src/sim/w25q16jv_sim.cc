@@ -0,0 +1,165 @@
+
+#include <sdk/sim/w25q16jv_sim.h>
+#include <sdk/sim/kernel.h>
+
+#include <string.h>
+
+namespace sdk {
+
+namespace sim {
+
+static constexpr uint8_t WRITE_ENABLE = 0x06;
+static constexpr uint8_t WRITE_DISABLE = 0x04;
+static constexpr uint8_t READ_STATUS_1 = 0x05;
+static constexpr uint8_t PAGE_PROGRAM = 0x02;
+static constexpr uint8_t READ_DATA = 0x03;
+static constexpr uint8_t SECTOR_ERASE = 0x20;
+static constexpr uint8_t BLOCK_ERASE_64K = 0xd8;
+static constexpr uint8_t CHIP_ERASE = 0xc7;
+static constexpr uint8_t CHIP_ERASE_ALT = 0x60;
+static constexpr uint8_t JEDEC_ID = 0x9f;
+
+static constexpr uint8_t STATUS_BUSY = 0x01;
+static constexpr uint8_t STATUS_WEL = 0x02;
+
+/* typical times, datasheet 9.6 */
+static constexpr uint64_t PAGE_PROGRAM_NS = 400000;
+static constexpr uint64_t SECTOR_ERASE_NS = 45000000;
+static constexpr uint64_t BLOCK_ERASE_NS = 150000000;
+static constexpr uint64_t CHIP_ERASE_NS = 5000000000ull;
+
+static constexpr uint8_t JEDEC[3] = { 0xef, 0x40, 0x15 };
+
+w25q16jv_sim::w25q16jv_sim() : memory(SIZE, 0xff), selected(false),
+        position(0), command(0), address(0), write_enabled(false),
+        busy_until_ns(0), program_count(0), erase_count(0)
+{
+}
+
+void w25q16jv_sim::attach(SPI_HandleTypeDef *bus, GPIO_TypeDef *cs_port,
+        uint16_t cs_pin)
+{
+    hal::attach(bus, cs_port, cs_pin, *this);
+}
+
+bool w25q16jv_sim::is_busy() const
+{
+    return kernel::now_ns() < busy_until_ns;
+}
+
+void w25q16jv_sim::select()
+{
+    selected = true;
+    position = 0;
+    command = 0;
+    address = 0;
+}
+
+void w25q16jv_sim::deselect()
+{
+    if (selected && position > 0)
+        finish_command();
+    selected = false;
+}
+
+void w25q16jv_sim::transfer(const uint8_t *tx, uint8_t *rx, uint16_t size)
+{
+    for (uint16_t i = 0; i < size; i++) {
+        uint8_t out = exchange(tx != nullptr ? tx[i] : 0xff);
+        if (rx != nullptr)
+            rx[i] = out;
+    }
+}
+
+uint8_t w25q16jv_sim::exchange(uint8_t in)
+{
+    uint32_t at = position++;
+    if (at == 0) {
+        command = in;
+        return 0xff;
+    }
+
+    switch (command) {
+    case READ_STATUS_1:
+        return (is_busy() ? STATUS_BUSY : 0) | (write_enabled ? STATUS_WEL : 0);
+    case JEDEC_ID:
+        return at <= 3 ? JEDEC[at - 1] : 0xff;
+    default:
+        break;
+    }
+
+    // everything else is ignored while an operation is in progress
+    if (is_busy())
+        return 0xff;
+
+    if (at <= 3) {
+        address = (address << 8) | in;
+        return 0xff;
+    }
+
+    uint32_t offset = at - 4;
+    switch (command) {
+    case READ_DATA:
+        return memory[(address + offset) % SIZE];
+    case PAGE_PROGRAM:
+        if (write_enabled) {
+            // wraps within the page, and can only clear bits
+            uint32_t page = address & ~(PAGE_SIZE - 1);
+            uint32_t target = page + ((address + offset) & (PAGE_SIZE - 1));
+            memory[target % SIZE] &= in;
+        }
+        return 0xff;
+    default:
+        return 0xff;
+    }
+}
+
+void w25q16jv_sim::finish_command()
+{
+    if (is_busy() && command != READ_STATUS_1 && command != JEDEC_ID)
+        return;
+
+    uint64_t now = kernel::now_ns();
+    switch (command) {
+    case WRITE_ENABLE:
+        write_enabled = true;
+        break;
+    case WRITE_DISABLE:
+        write_enabled = false;
+        break;
+    case PAGE_PROGRAM:
+        if (write_enabled && position > 4) {
+            write_enabled = false;
+            busy_until_ns = now + PAGE_PROGRAM_NS;
+            program_count++;
+        }
+        break;
+    case SECTOR_ERASE:
+    case BLOCK_ERASE_64K:
+        if (write_enabled && position >= 4) {
+            uint32_t length = command == SECTOR_ERASE ? 4096 : 65536;
+            uint32_t start = (address % SIZE) & ~(length - 1);
+            memset(memory.data() + start, 0xff, length);
+            write_enabled = false;
+            busy_until_ns = now + (command == SECTOR_ERASE ? SECTOR_ERASE_NS :
+                BLOCK_ERASE_NS);
+            erase_count++;
+        }
+        break;
+    case CHIP_ERASE:
+    case CHIP_ERASE_ALT:
+        if (write_enabled) {
+            memset(memory.data(), 0xff, SIZE);
+            write_enabled = false;
+            busy_until_ns = now + CHIP_ERASE_NS;
+            erase_count++;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+} // namespace sim
+
+} // namespace sdk
@@ -0,0 +1,90 @@
+
+#include <sdk/trace.h>
+
+#ifdef SDK_TRACE
+
+#include <sdk/clock.h>
+
+#include <atomic>
+#include <string.h>
+
+namespace sdk {
+
+namespace trace {
+
+static_assert((SDK_TRACE_BUFFER_SIZE & (SDK_TRACE_BUFFER_SIZE - 1)) == 0,
+        "trace buffer size must be a power of two");
+static_assert(sizeof(record) == 12, "trace record layout changed");
+
+/* a record, and which event it holds once it is completely written */
+struct slot {
+    record r;
+    std::atomic<uint32_t> sequence; /* claimed index + 1, 0 while written */
+};
+
+static slot ring[SDK_TRACE_BUFFER_SIZE];
+static std::atomic<uint32_t> write_index(0);
+
+void emit(event id, phase ph, uint32_t arg)
+{
+    // claiming the slot is the only synchronization; an ISR preempting this
+    // simply takes the next one, and may stamp an earlier time than this
+    uint32_t idx = write_index.fetch_add(1, std::memory_order_relaxed);
+    slot &s = ring[idx & (SDK_TRACE_BUFFER_SIZE - 1)];
+    s.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.r.cycles = clock::now_cycles32();
+    s.r.id = (uint16_t) id;
+    s.r.phase = (uint16_t) ph;
+    s.r.arg = arg;
+    s.sequence.store(idx + 1, std::memory_order_release);
+}
+
+uint32_t dump(uint8_t *out, uint32_t size)
+{
+    if (size < sizeof(dump_header))
+        return 0;
+
+    uint32_t end = write_index.load(std::memory_order_acquire);
+    uint32_t count = end < SDK_TRACE_BUFFER_SIZE ? end : SDK_TRACE_BUFFER_SIZE;
+    uint32_t room = (size - sizeof(dump_header)) / sizeof(record);
+    if (count > room)
+        count = room; // keep the newest
+
+    uint8_t *dst = out + sizeof(dump_header);
+    uint32_t written = 0;
+    for (uint32_t i = end - count; i != end; i++) {
+        // skipped unless the same event was complete before and after the
+        // copy: still being written, or overwritten meanwhile
+        const slot &s = ring[i & (SDK_TRACE_BUFFER_SIZE - 1)];
+        if (s.sequence.load(std::memory_order_acquire) != i + 1)
+            continue;
+        memcpy(dst, &s.r, sizeof(record));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.sequence.load(std::memory_order_relaxed) != i + 1)
+            continue;
+        dst += sizeof(record);
+        written++;
+    }
+
+    dump_header header = {
+        DUMP_MAGIC,
+        DUMP_VERSION,
+        (uint16_t) sizeof(record),
+        clock::cycles_per_us(),
+        written,
+    };
+    memcpy(out, &header, sizeof(header));
+    return dst - out;
+}
+
+void clear()
+{
+    write_index.store(0, std::memory_order_release);
+}
+
+} // namespace trace
+
+} // namespace sdk
+
+#endif // SDK_TRACE
@@ -0,0 +1,175 @@
+
+#include <sdk/uart.h>
+#include <sdk/packet.h>
+#include <sdk/trace.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <string.h>
+
+namespace sdk {
+
+static uart *instances[uart::MAX_INSTANCES];
+static UART_HandleTypeDef *instance_handles[uart::MAX_INSTANCES];
+
+uart::uart(UART_HandleTypeDef *handle) : handle(handle), registered(false),
+        tx_fill(0), tx_fill_size(0), tx_busy(false), rx_position(0),
+        rx_head(0), rx_tail(0), rx_resync(0), rx_resync_gap(0),
+        rx_restarts(0), rx_restarts_seen(0), counts{}
+{
+    for (int i = 0; i < MAX_INSTANCES; i++) {
+        if (instances[i] == nullptr) {
+            instances[i] = this;
+            instance_handles[i] = handle;
+            registered = true;
+            return;
+        }
+    }
+}
+
+uart *uart::from_handle(UART_HandleTypeDef *handle)
+{
+    for (int i = 0; i < MAX_INSTANCES; i++) {
+        if (instance_handles[i] == handle)
+            return instances[i];
+    }
+    return nullptr;
+}
+
+uart::status uart::start()
+{
+    // no completion or receive event would ever reach it
+    if (!registered)
+        return status::ERROR;
+
+    rx_position = 0;
+    HAL_StatusTypeDef result = HAL_UARTEx_ReceiveToIdle_DMA(handle, rx_buffer,
+        RX_BUFFER_SIZE);
+    return result == HAL_OK ? status::OK : status::ERROR;
+}
+
+uart::status uart::send(const uint8_t *data, uint16_t size)
+{
+    // the first transmission would never complete, blocking all later ones
+    if (!registered)
+        return status::ERROR;
+
+    taskENTER_CRITICAL();
+    if (size > TX_BUFFER_SIZE - tx_fill_size) {
+        counts.tx_dropped++;
+        counts.tx_dropped_bytes += size;
+        taskEXIT_CRITICAL();
+        SDK_TRACE_INSTANT(UART_DROP, size);
+        return status::FULL;
+    }
+    memcpy(tx_buffers[tx_fill] + tx_fill_size, data, size);
+    tx_fill_size += size;
+    counts.tx_bytes += size;
+    if (!tx_busy)
+        start_transmit();
+    taskEXIT_CRITICAL();
+    return status::OK;
+}
+
+uart::status uart::send_packet(const void *payload, uint16_t size)
+{
+    if (size > packet::MAX_PAYLOAD)
+        return status::ERROR;
+    uint8_t frame[packet::frame_size(packet::MAX_PAYLOAD)];
+    uint16_t frame_size = packet::encode(payload, size, frame);
+    return send(frame, frame_size);
+}
+
+void uart::start_transmit()
+{
+    uint8_t *data = tx_buffers[tx_fill];
+    uint16_t size = tx_fill_size;
+    tx_fill ^= 1;
+    tx_fill_size = 0;
+    tx_busy = true;
+
+    SDK_TRACE_INSTANT(UART_TX_DMA, size);
+    if (HAL_UART_Transmit_DMA(handle, data, size) != HAL_OK) {
+        // nothing will complete, so nothing would ever send again
+        tx_busy = false;
+        counts.tx_dropped++;
+        counts.tx_dropped_bytes += size;
+    }
+}
+
+uint16_t uart::receive(uint8_t *data, uint16_t size)
+{
+    uint32_t restarts = rx_restarts;
+    if (restarts != rx_restarts_seen) {
+        // what was unread when reception restarted is gone
+        rx_restarts_seen = restarts;
+        counts.rx_dropped_bytes += rx_resync - rx_resync_gap - rx_tail;
+        rx_tail = rx_resync;
+    }
+
+    uint32_t available = rx_head - rx_tail;
+    if (available > RX_BUFFER_SIZE) {
+        // the DMA lapped the reader, and is now writing over the oldest
+        counts.rx_dropped_bytes += available;
+        rx_tail += available;
+        return 0;
+    }
+
+    uint16_t count = available < size ? (uint16_t) available : size;
+    uint16_t start = (uint16_t) (rx_tail % RX_BUFFER_SIZE);
+    uint16_t first = count < RX_BUFFER_SIZE - start ? count :
+        (uint16_t) (RX_BUFFER_SIZE - start);
+    memcpy(data, rx_buffer + start, first);
+    memcpy(data + first, rx_buffer, count - first);
+    rx_tail += count;
+    counts.rx_bytes += count;
+    return count;
+}
+
+uart::stats uart::get_stats() const
+{
+    taskENTER_CRITICAL();
+    stats out = counts;
+    taskEXIT_CRITICAL();
+    return out;
+}
+
+void uart::tx_complete_from_isr()
+{
+    UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+    if (tx_fill_size > 0)
+        start_transmit();
+    else
+        tx_busy = false;
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+void uart::rx_event_from_isr(uint16_t size)
+{
+    // `size` is where the DMA is in the buffer, RX_BUFFER_SIZE at the wrap
+    uint16_t received = size >= rx_position ? size - rx_position :
+        (uint16_t) (size + RX_BUFFER_SIZE - rx_position);
+    rx_position = size == RX_BUFFER_SIZE ? 0 : size;
+    rx_head += received;
+}
+
+void uart::error_from_isr()
+{
+    counts.errors++;
+    // the HAL ends a DMA reception on any line error
+    if (handle->RxState != HAL_UART_STATE_READY)
+        return;
+
+    // the DMA starts over at the top of the buffer, so skip ahead to where
+    // that is in the byte count
+    uint32_t next = (rx_head + RX_BUFFER_SIZE - 1) / RX_BUFFER_SIZE *
+        RX_BUFFER_SIZE;
+    rx_resync_gap = next - rx_head;
+    rx_head = next;
+    rx_resync = next;
+    rx_restarts++;
+    start();
+}
+
+} // namespace sdk
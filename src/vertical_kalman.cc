@@ -0,0 +1,132 @@
+
+#include <sdk/vertical_kalman.h>
+#include <sdk/altitude.h>
+
+namespace sdk {
+
+/* initial uncertainty of the accelerometer bias, in (m/s^2)^2 */
+static constexpr vertical_kalman::real INITIAL_BIAS_VARIANCE = 0.25f;
+
+vertical_kalman::vertical_kalman(const config &conf) : conf(conf),
+        ground_altitude_m(0)
+{
+    reset();
+}
+
+void vertical_kalman::reset()
+{
+    h = 0;
+    v = 0;
+    b = 0;
+    last_accel = 0;
+
+    real r = conf.baro_noise * conf.baro_noise;
+    p00 = r;
+    p01 = 0;
+    p02 = 0;
+    p11 = r;
+    p12 = 0;
+    p22 = INITIAL_BIAS_VARIANCE;
+}
+
+void vertical_kalman::predict(real specific_force_ms2, real dt)
+{
+    real a = specific_force_ms2 - GRAVITY_EARTH - b;
+    real half_dt2 = 0.5f * dt * dt;
+
+    // x = F x + G a
+    h += v * dt + a * half_dt2;
+    v += a * dt;
+    last_accel = a;
+
+    // F = [1 dt -dt^2/2; 0 1 -dt; 0 0 1], first F * P
+    real fp00 = p00 + dt * p01 - half_dt2 * p02;
+    real fp01 = p01 + dt * p11 - half_dt2 * p12;
+    real fp02 = p02 + dt * p12 - half_dt2 * p22;
+    real fp11 = p11 - dt * p12;
+    real fp12 = p12 - dt * p22;
+
+    // then (F * P) * F^T + Q, with Q = G G^T accel_noise^2 + bias walk
+    real qa = conf.accel_noise * conf.accel_noise;
+    real qa_dt = qa * dt;
+    p00 = fp00 + dt * fp01 - half_dt2 * fp02 + qa * half_dt2 * half_dt2;
+    p01 = fp01 - dt * fp02 + qa_dt * half_dt2;
+    p02 = fp02;
+    p11 = fp11 - dt * fp12 + qa_dt * dt;
+    p12 = fp12;
+    p22 += conf.bias_drift * conf.bias_drift * dt;
+}
+
+void vertical_kalman::predict(const bmi088::state &imu, real dt)
+{
+    real f;
+    switch (conf.vertical_axis) {
+    case axis::POS_X:
+        f = imu.acceleration_ms2.x;
+        break;
+    case axis::POS_Y:
+        f = imu.acceleration_ms2.y;
+        break;
+    case axis::POS_Z:
+        f = imu.acceleration_ms2.z;
+        break;
+    case axis::NEG_X:
+        f = -imu.acceleration_ms2.x;
+        break;
+    case axis::NEG_Y:
+        f = -imu.acceleration_ms2.y;
+        break;
+    case axis::NEG_Z:
+    default:
+        f = -imu.acceleration_ms2.z;
+        break;
+    }
+    predict(f, dt);
+}
+
+void vertical_kalman::update(real altitude_m)
+{
+    // H = [1 0 0], so S and K fall out of the first row of P
+    real s = p00 + conf.baro_noise * conf.baro_noise;
+    real inv_s = 1.0f / s;
+    real k0 = p00 * inv_s;
+    real k1 = p01 * inv_s;
+    real k2 = p02 * inv_s;
+
+    real residual = altitude_m - h;
+    h += k0 * residual;
+    v += k1 * residual;
+    b += k2 * residual;
+
+    // P = (I - K H) P, using the old first row
+    real r0 = p00, r1 = p01, r2 = p02;
+    p00 -= k0 * r0;
+    p01 -= k0 * r1;
+    p02 -= k0 * r2;
+    p11 -= k1 * r1;
+    p12 -= k1 * r2;
+    p22 -= k2 * r2;
+}
+
+void vertical_kalman::update(const bmp390::state &baro)
+{
+    // no measurement, the IMU carries the estimate alone
+    if (baro.sample_quality == bmp390::quality::LOCKED_OUT)
+        return;
+    update(altitude_estimator::pressure_to_altitude(baro.pressure_pascals) -
+        ground_altitude_m);
+}
+
+vertical_kalman::state vertical_kalman::get_state() const
+{
+    state out;
+    out.altitude_m = h;
+    out.vertical_velocity_ms = v;
+    out.vertical_acceleration_ms2 = last_accel;
+    out.accel_bias_ms2 = b;
+    out.altitude_variance = p00;
+    out.velocity_variance = p11;
+    return out;
+}
+
+} // namespace sdk
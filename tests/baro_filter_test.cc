@@ -0,0 +1,170 @@
+/*
+ * sdk::baro_filter against a plain Hampel filter that copies and sorts its
+ * window for every sample, on a noisy climb with injected spikes: the same
+ * samples are replaced, with the same medians. Then the acceleration and
+ * manual lockouts, and the window restarting after them.
+ */
+
+#include "check.h"
+
+#include <sdk/baro_filter.h>
+
+#include <sdk/sim/rng.h>
+
+#include <algorithm>
+
+using namespace sdk;
+
+using real = baro_filter::real;
+
+static constexpr int WINDOW = baro_filter::WINDOW;
+static constexpr baro_filter::config CONFIG = { 3.0f, 25.0f, 40.0f, 100000 };
+static constexpr uint64_t PERIOD_US = 20000; /* 50 Hz */
+
+/*
+ * The textbook filter over the last WINDOW raw samples: median by sorting a
+ * copy, MAD as the median of the sorted absolute deviations.
+ */
+class reference_hampel {
+public:
+
+    /* returns the filtered pressure, and if it was replaced */
+    real process(real pressure, bool &replaced)
+    {
+        history[count++ % WINDOW] = pressure;
+        replaced = false;
+        if (count < WINDOW)
+            return pressure;
+
+        real sorted[WINDOW];
+        std::copy(history, history + WINDOW, sorted);
+        std::sort(sorted, sorted + WINDOW);
+        real median = sorted[WINDOW / 2];
+
+        real deviations[WINDOW];
+        for (int i = 0; i < WINDOW; i++) {
+            deviations[i] = sorted[i] > median ? sorted[i] - median :
+                median - sorted[i];
+        }
+        std::sort(deviations, deviations + WINDOW);
+        real limit = CONFIG.threshold * 1.4826f * deviations[WINDOW / 2];
+        if (limit < CONFIG.min_deviation_pa)
+            limit = CONFIG.min_deviation_pa;
+
+        real deviation = pressure - median;
+        if (deviation > limit || deviation < -limit) {
+            replaced = true;
+            return median;
+        }
+        return pressure;
+    }
+
+private:
+    real history[WINDOW];
+    int count = 0;
+};
+
+static bmp390::state sample(real pressure, uint64_t timestamp_us)
+{
+    bmp390::state s = {};
+    s.pressure_pascals = pressure;
+    s.timestamp_us = timestamp_us;
+    return s;
+}
+
+static void check_against_reference()
+{
+    static constexpr int SAMPLES = 3000;
+    baro_filter filter(CONFIG);
+    reference_hampel reference;
+    sim::rng noise(11);
+
+    int injected = 0;
+    int caught = 0;
+    int mismatches = 0;
+    for (int i = 0; i < SAMPLES; i++) {
+        // a 60 m/s climb from the ground, about 14 Pa a sample, with enough
+        // noise that the window's deviations are all different
+        real pressure = 101325.0f - 14.0f * i +
+            (real) noise.gaussian(10.0);
+
+        // a spike every so often, either sign, clear of the climb's own
+        // spread (3 sigma of it is 100-200 Pa)
+        bool spike = i > WINDOW && noise.uniform() < 0.03;
+        if (spike) {
+            injected++;
+            pressure += (real) ((noise.uniform() < 0.5 ? -1 : 1) *
+                (300.0 + 2000.0 * noise.uniform()));
+        }
+
+        bool replaced = false;
+        real expected = reference.process(pressure, replaced);
+        bmp390::state s = sample(pressure, i * PERIOD_US);
+        filter.process(s);
+
+        bool filter_replaced = s.sample_quality == bmp390::quality::REPLACED;
+        if (filter_replaced != replaced || s.pressure_pascals != expected)
+            mismatches++;
+        if (spike && filter_replaced)
+            caught++;
+        CHECK(s.sample_quality != bmp390::quality::LOCKED_OUT);
+    }
+
+    CHECK(mismatches == 0);
+    CHECK(injected > 50);
+    // spikes stay a minority of any window, so all are caught
+    CHECK(caught == injected);
+    CHECK(filter.get_stats().samples == SAMPLES);
+    CHECK(filter.get_stats().replaced >= (uint32_t) injected);
+}
+
+static void check_lockouts()
+{
+    baro_filter filter(CONFIG);
+    uint64_t t = 0;
+    for (int i = 0; i < WINDOW; i++, t += PERIOD_US) {
+        bmp390::state s = sample(100000.0f, t);
+        filter.process(s);
+    }
+
+    // over the limit: the last good pressure, until the hold has passed
+    filter.update_acceleration(CONFIG.lockout_accel_ms2 + 1.0f, t);
+    uint64_t until = t + CONFIG.lockout_hold_us;
+    for (; t < until; t += PERIOD_US) {
+        bmp390::state s = sample(95000.0f, t);
+        filter.process(s);
+        CHECK(s.sample_quality == bmp390::quality::LOCKED_OUT);
+        CHECK(s.pressure_pascals == 100000.0f);
+    }
+    CHECK(filter.get_stats().lockouts == 1);
+    CHECK(filter.get_stats().locked_out == CONFIG.lockout_hold_us / PERIOD_US);
+
+    // just under the limit does not lock out, in either direction
+    filter.update_acceleration(CONFIG.lockout_accel_ms2 - 1.0f, t);
+    filter.update_acceleration(-CONFIG.lockout_accel_ms2 + 1.0f, t);
+    CHECK(!filter.is_locked_out(t));
+
+    // the window restarts: a new level is taken without rejection
+    for (int i = 0; i < 2 * WINDOW; i++, t += PERIOD_US) {
+        bmp390::state s = sample(95000.0f + (i % 3), t);
+        filter.process(s);
+        CHECK(s.sample_quality == bmp390::quality::MEASURED);
+    }
+    CHECK(filter.get_median() > 94999.0f && filter.get_median() < 95003.0f);
+
+    // a manual lockout holds until cleared
+    filter.set_lockout(true);
+    bmp390::state s = sample(80000.0f, t + 10 * CONFIG.lockout_hold_us);
+    filter.process(s);
+    CHECK(s.sample_quality == bmp390::quality::LOCKED_OUT);
+    filter.set_lockout(false);
+    CHECK(!filter.is_locked_out(s.timestamp_us));
+    CHECK(filter.get_stats().lockouts == 2);
+}
+
+int main()
+{
+    check_against_reference();
+    check_lockouts();
+    return check_failures();
+}
@@ -0,0 +1,193 @@
+/*
+ * sdk::bmi088 frame pairing against sim::bmi088_sim on the host I2C bus: the
+ * byte layout `parse_frames` decodes, conversions that follow a range change
+ * mid-stream, timestamps and sensortime deltas across missed samples, and in
+ * data sync mode, accel and gyro halves that belong to the same sample.
+ */
+
+#include "check.h"
+
+#include <sdk/clock.h>
+#include <sdk/drivers/bmi088.h>
+#include <sdk/i2c.h>
+
+#include <sdk/sim/bmi088_sim.h>
+#include <sdk/sim/flight.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <math.h>
+
+using namespace sdk;
+
+using real = bmi088::real;
+
+/* a few sigma of the simulated noise */
+static constexpr real ACC_TOLERANCE_MS2 = 0.3f;
+static constexpr real GYRO_TOLERANCE_DS = 0.6f;
+static constexpr real SENSORTIME_US = bmi088::SENSORTIME_RESOLUTION * 1e6f;
+
+static I2C_HandleTypeDef hi2c1;
+/* never started, so it sits on the pad reading 1 g up */
+static sim::flight world(sim::flight::DEFAULT_CONFIG);
+static sim::bmi088_sim imu_sim(world, sim::bmi088_sim::DEFAULT_CONFIG);
+
+/* stands in for Bosch's feature config, which the sim does not interpret */
+static const uint8_t FEATURE_CONFIG[64] = {};
+
+static bool near(real value, real expected, real tolerance)
+{
+    return fabsf(value - expected) < tolerance;
+}
+
+static bmi088::state read_sample(bmi088 &imu)
+{
+    CHECK(imu.update());
+    return imu.copy_state();
+}
+
+/* at rest on the pad: 1 g on z, the configured gyro bias on every axis */
+static void check_at_rest(const bmi088::state &s)
+{
+    real bias = (real) sim::bmi088_sim::DEFAULT_CONFIG.gyro_bias_ds;
+    CHECK(near(s.acceleration_ms2.x, 0, ACC_TOLERANCE_MS2));
+    CHECK(near(s.acceleration_ms2.y, 0, ACC_TOLERANCE_MS2));
+    CHECK(near(s.acceleration_ms2.z, bmi088::GRAVITY_EARTH,
+        ACC_TOLERANCE_MS2));
+    CHECK(near(s.angular_velocity_ds.x, bias, GYRO_TOLERANCE_DS));
+    CHECK(near(s.angular_velocity_ds.y, bias, GYRO_TOLERANCE_DS));
+    CHECK(near(s.angular_velocity_ds.z, bias, GYRO_TOLERANCE_DS));
+}
+
+static void check_parse_frames()
+{
+    // little endian axes, then the 24-bit sensortime on the accel
+    const uint8_t acc_frame[bmi088::ACC_FRAME_SIZE] = {
+        0xfe, 0xff, 0x34, 0x12, 0x00, 0x80, 0x56, 0x34, 0x12,
+    };
+    const uint8_t gyro_frame[bmi088::GYRO_FRAME_SIZE] = {
+        0x01, 0x00, 0xff, 0xff, 0xff, 0x7f,
+    };
+
+    bmi088::state s;
+    s.offsets = { { 0, 0, 1.0f }, { 0.5f, 0, 0 } };
+    bmi088::parse_frames(acc_frame, gyro_frame, s);
+    bmi088::raw_vec3 acc_raw = { -2, 0x1234, INT16_MIN };
+    bmi088::raw_vec3 gyro_raw = { 1, -1, INT16_MAX };
+    CHECK(s.acc_raw == acc_raw && s.gyro_raw == gyro_raw);
+    CHECK(s.acceleration_ms2 == bmi088::convert(s.acc_raw, s.acc_scale,
+        s.offsets.acc_ms2));
+    CHECK(s.angular_velocity_ds == bmi088::convert(s.gyro_raw, s.gyro_scale,
+        s.offsets.gyro_ds));
+
+    // the first sample has no predecessor, so a zero delta
+    CHECK(s.sensortime == 0x123456);
+    CHECK(s.last_sensortime == 0x123456);
+    CHECK(!s.uninitialized_sensortime);
+
+    // the next keeps the previous sensortime, across the 24-bit wrap too
+    const uint8_t wrapped[bmi088::ACC_FRAME_SIZE] = {
+        0, 0, 0, 0, 0, 0, 0x10, 0x00, 0x00,
+    };
+    s.sensortime = 0xfffff0;
+    bmi088::parse_frames(wrapped, gyro_frame, s);
+    CHECK(s.sensortime == 0x10);
+    CHECK(s.last_sensortime == 0xfffff0);
+}
+
+static void check_register_reads(bmi088 &imu)
+{
+    CHECK(imu.set_acc_config(bmi088::acc_range::RANGE_3G,
+        bmi088::acc_bwp::NORMAL, bmi088::acc_odr::ODR_1600HZ));
+    CHECK(imu.set_gyro_config(bmi088::gyro_range::RANGE_125DPS,
+        bmi088::gyro_bw::BW_116HZ));
+
+    // stamped with the accel read, just before the gyro read
+    bmi088::state a = read_sample(imu);
+    check_at_rest(a);
+    CHECK(a.timestamp_us <= clock::now_us());
+    CHECK(clock::now_us() - a.timestamp_us < 1000);
+
+    // without sync each half samples on its own read
+    bmi088::state b = read_sample(imu);
+    CHECK(b.acc_raw != a.acc_raw && b.gyro_raw != a.gyro_raw);
+
+    // a range change mid-stream: the raw values scale, the result does not
+    CHECK(imu.set_acc_config(bmi088::acc_range::RANGE_24G,
+        bmi088::acc_bwp::NORMAL, bmi088::acc_odr::ODR_1600HZ));
+    CHECK(imu.set_gyro_config(bmi088::gyro_range::RANGE_2000DPS,
+        bmi088::gyro_bw::BW_116HZ));
+    bmi088::state c = read_sample(imu);
+    check_at_rest(c);
+    CHECK(abs(a.acc_raw.z - 8 * c.acc_raw.z) < 80);
+    CHECK(abs(c.gyro_raw.x) < abs(a.gyro_raw.x));
+
+    // samples missed between reads show in the sensortime delta
+    vTaskDelay(pdMS_TO_TICKS(20));
+    bmi088::state d = read_sample(imu);
+    CHECK(d.last_sensortime == c.sensortime);
+    uint32_t ticks = (d.sensortime - d.last_sensortime) &
+        (bmi088::SENSORTIME_MODULUS - 1);
+    real elapsed_us = (real) (d.timestamp_us - c.timestamp_us);
+    CHECK(elapsed_us > 19000.0f);
+    CHECK(near(ticks * SENSORTIME_US, elapsed_us, 2 * SENSORTIME_US));
+}
+
+static void check_sync(bmi088 &imu)
+{
+    CHECK(imu.load_feature_config(FEATURE_CONFIG, sizeof(FEATURE_CONFIG)));
+    CHECK(imu.set_sync_mode(bmi088::sync_mode::SYNC_400HZ));
+    CHECK(imu.get_odr_hz() == 400.0f);
+
+    // just after a 2.5 ms sample, two reads fit before the next one
+    vTaskDelay(pdMS_TO_TICKS(5 - (clock::now_us() / 1000) % 5));
+    bmi088::state a = read_sample(imu);
+    bmi088::state b = read_sample(imu);
+    CHECK(clock::now_us() % 2500 < 2000);
+    check_at_rest(a);
+    CHECK(b.acc_raw == a.acc_raw && b.gyro_raw == a.gyro_raw);
+    // sensortime is the counter at the read, so it still moves
+    CHECK(b.sensortime != a.sensortime);
+
+    // and both halves change together on the next one
+    vTaskDelay(pdMS_TO_TICKS(3));
+    bmi088::state c = read_sample(imu);
+    CHECK(c.acc_raw != b.acc_raw && c.gyro_raw != b.gyro_raw);
+
+    // off again, the halves sample on their own
+    CHECK(imu.set_sync_mode(bmi088::sync_mode::OFF));
+    vTaskDelay(pdMS_TO_TICKS(5 - (clock::now_us() / 1000) % 5));
+    a = read_sample(imu);
+    b = read_sample(imu);
+    CHECK(b.acc_raw != a.acc_raw && b.gyro_raw != a.gyro_raw);
+}
+
+static void test_task(void *params)
+{
+    (void) params;
+    static i2c_master i2c(&hi2c1);
+    static bmi088 imu(i2c);
+
+    check_parse_frames();
+
+    CHECK(imu.is_connected());
+    CHECK(imu.start());
+    vTaskDelay(pdMS_TO_TICKS(bmi088::START_DELAY_US / 1000 + 1));
+    check_register_reads(imu);
+    check_sync(imu);
+
+    vTaskEndScheduler();
+}
+
+int main()
+{
+    hi2c1.Instance = I2C1;
+    hi2c1.Init.ClockSpeed = 400000;
+    HAL_I2C_Init(&hi2c1);
+    imu_sim.attach(&hi2c1);
+
+    xTaskCreate(test_task, "test", 1024, nullptr, 1, nullptr);
+    vTaskStartScheduler();
+    return check_failures();
+}
@@ -0,0 +1,110 @@
+/*
+ * sdk::bmp390's compensation against the double-precision datasheet formula
+ * in sim::bmp390_sim, with the calibration read from the simulated part over
+ * the host I2C bus. Covers the sensor's whole 300-1250 hPa range at the ends
+ * and the middle of its temperature range.
+ */
+
+#include "check.h"
+
+#include <sdk/drivers/bmp390.h>
+#include <sdk/i2c.h>
+
+#include <sdk/sim/bmp390_sim.h>
+#include <sdk/sim/flight.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <initializer_list>
+
+#include <math.h>
+
+using namespace sdk;
+
+static constexpr double MIN_PRESSURE_PA = 30000.0;
+static constexpr double MAX_PRESSURE_PA = 125000.0;
+/* float rounding only; ~0.1 m of altitude at sea level */
+static constexpr double MAX_ERROR_PA = 1.0;
+
+static I2C_HandleTypeDef hi2c1;
+static sim::flight world(sim::flight::DEFAULT_CONFIG);
+static sim::bmp390_sim baro_sim(world, sim::bmp390_sim::DEFAULT_CONFIG);
+
+static void put24(uint8_t *at, uint32_t value)
+{
+    at[0] = value & 0xff;
+    at[1] = (value >> 8) & 0xff;
+    at[2] = (value >> 16) & 0xff;
+}
+
+/* raw temperature closest to `celsius`, the compensation is increasing */
+static uint32_t raw_temperature(double celsius)
+{
+    uint32_t lo = 0;
+    uint32_t hi = (1u << 24) - 1;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (baro_sim.compensate_temperature(mid) < celsius)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* sweeps raw pressures at one temperature, returns the readings checked */
+static int check_temperature(bmp390 &baro, double celsius)
+{
+    bmp390::data_frame frame = {};
+    uint32_t raw_t = raw_temperature(celsius);
+    put24(frame + 3, raw_t);
+    double t = baro_sim.compensate_temperature(raw_t);
+    bmp390::real temp_c = baro.compensate_temperature(frame);
+    CHECK(fabs(temp_c - t) < 0.01);
+
+    int checked = 0;
+    double worst = 0;
+    for (uint32_t raw_p = 0; raw_p < (1u << 24); raw_p += 1u << 10) {
+        double expected = baro_sim.compensate_pressure(t, raw_p);
+        if (expected < MIN_PRESSURE_PA || expected > MAX_PRESSURE_PA)
+            continue;
+
+        put24(frame, raw_p);
+        double error = fabs(baro.compensate_pressure(temp_c, frame) -
+            expected);
+        if (error > worst)
+            worst = error;
+        checked++;
+    }
+    CHECK(worst < MAX_ERROR_PA);
+    return checked;
+}
+
+static void test_task(void *params)
+{
+    (void) params;
+    static i2c_master i2c(&hi2c1);
+    static bmp390 baro(i2c);
+
+    vTaskDelay(pdMS_TO_TICKS(bmp390::STARTUP_US / 1000 + 1));
+    CHECK(baro.is_connected());
+    CHECK(baro.read_calibration_data());
+
+    for (double celsius : { -40.0, 25.0, 85.0 })
+        CHECK(check_temperature(baro, celsius) > 100);
+
+    vTaskEndScheduler();
+}
+
+int main()
+{
+    hi2c1.Instance = I2C1;
+    hi2c1.Init.ClockSpeed = 400000;
+    HAL_I2C_Init(&hi2c1);
+    baro_sim.attach(&hi2c1);
+
+    xTaskCreate(test_task, "test", 1024, nullptr, 1, nullptr);
+    vTaskStartScheduler();
+    return check_failures();
+}
@@ -0,0 +1,28 @@
+
+#ifndef AIRBRAKES_SDK_TESTS_CHECK_H_
+#define AIRBRAKES_SDK_TESTS_CHECK_H_
+
+#include <stdio.h>
+
+/*
+ * Minimal assertions for the host tests: a failed check prints where it was
+ * and counts, and the test's main returns `check_failures()` so ctest sees
+ * a nonzero exit. Checks keep going after a failure to report them all.
+ */
+
+inline int &check_failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+                #cond); \
+            check_failures()++; \
+        } \
+    } while (0)
+
+#endif // AIRBRAKES_SDK_TESTS_CHECK_H_
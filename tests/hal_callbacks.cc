@@ -0,0 +1,28 @@
+/*
+ * Forwards the host HAL's I2C completion callbacks to sdk::i2c_master, as
+ * the firmware does on the target, for the tests that use the bus.
+ */
+
+#include <sdk/i2c.h>
+
+using sdk::i2c_master;
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    i2c_master::from_handle(hi2c)->unblock_from_isr();
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    i2c_master::from_handle(hi2c)->unblock_from_isr();
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    i2c_master::from_handle(hi2c)->error_from_isr();
+}
+
+void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    i2c_master::from_handle(hi2c)->error_from_isr();
+}
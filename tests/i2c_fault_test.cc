@@ -0,0 +1,118 @@
+/*
+ * sdk::i2c_master against every fault sim::hal::inject_i2c_fault can put on
+ * the host I2C bus: each transfer fails with the matching status (or, for a
+ * stuck SDA, succeeds after a recovery), the bus is recovered where the
+ * driver promises it, and the next transfer goes through. A peripheral that
+ * fails to initialize after a recovery turns any of these into ERROR.
+ */
+
+#include "check.h"
+#include "register_file.h"
+
+#include <sdk/clock.h>
+#include <sdk/i2c.h>
+
+#include <sdk/sim/hal.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+using namespace sdk;
+
+static constexpr uint16_t ADDRESS = 0x42;
+static constexpr uint8_t REG = 0x20;
+static constexpr uint32_t TIMEOUT_MS = 5;
+
+static constexpr uint16_t SCL_PIN = GPIO_PIN_8;
+static constexpr uint16_t SDA_PIN = GPIO_PIN_9;
+
+static I2C_HandleTypeDef hi2c1;
+static register_file device;
+
+/* reads REG and checks it got the device's value */
+static void check_read_ok(i2c_master &i2c)
+{
+    uint8_t value = 0;
+    CHECK(i2c.read(ADDRESS << 1, REG, &value, 1, false, TIMEOUT_MS) ==
+        i2c_master::status::OK);
+    CHECK(value == device.regs[REG]);
+}
+
+/*
+ * Injects `fault` into the next transfer and checks it returns `expected`,
+ * with `recoveries` bus recoveries and no access reaching the device.
+ */
+static void check_fault(i2c_master &i2c, sim::i2c_fault fault,
+        i2c_master::status expected, uint32_t recoveries)
+{
+    uint32_t recovered = i2c.get_recovery_count();
+    device.clear_log();
+    uint8_t value = 0x5a;
+
+    sim::hal::inject_i2c_fault(&hi2c1, fault);
+    CHECK(i2c.write(ADDRESS << 1, REG + 1, &value, 1, false, TIMEOUT_MS) ==
+        expected);
+    CHECK(i2c.get_recovery_count() - recovered == recoveries);
+    if (expected != i2c_master::status::OK) {
+        CHECK(device.count == 0);
+        CHECK(device.regs[REG + 1] != value);
+    }
+
+    check_read_ok(i2c);
+    CHECK(sim::hal::read_pin(GPIOB, SDA_PIN));
+}
+
+static void test_task(void *params)
+{
+    (void) params;
+    static i2c_master i2c(&hi2c1);
+    i2c.set_recovery_pins(GPIOB, SCL_PIN, GPIOB, SDA_PIN);
+    device.regs[REG] = 0xa5;
+
+    check_read_ok(i2c);
+
+    // a NACK is the device's answer, the bus itself is fine
+    check_fault(i2c, sim::i2c_fault::NACK, i2c_master::status::NACK, 0);
+    check_fault(i2c, sim::i2c_fault::ARBITRATION_LOST,
+        i2c_master::status::ARBITRATION_LOST, 1);
+    check_fault(i2c, sim::i2c_fault::BUS_ERROR, i2c_master::status::BUS_ERROR,
+        1);
+
+    // a hung transfer gives up after the timeout, not before
+    uint64_t start_us = clock::now_us();
+    check_fault(i2c, sim::i2c_fault::HANG, i2c_master::status::TIMEOUT, 1);
+    CHECK(clock::now_us() - start_us >= TIMEOUT_MS * 1000);
+
+    // the peripheral cannot start, so the driver recovers and retries
+    sim::hal::inject_i2c_fault(&hi2c1, sim::i2c_fault::SDA_STUCK);
+    CHECK(!sim::hal::read_pin(GPIOB, SDA_PIN));
+    check_fault(i2c, sim::i2c_fault::SDA_STUCK, i2c_master::status::OK, 1);
+    CHECK(device.regs[REG + 1] == 0x5a);
+    device.regs[REG + 1] = 0;
+
+    // the peripheral does not come back from the reset, so nothing claims a
+    // recovered bus; the next transfer finds it busy and resets it again
+    sim::hal::inject_i2c_fault(&hi2c1, sim::i2c_fault::INIT_FAILS);
+    check_fault(i2c, sim::i2c_fault::BUS_ERROR, i2c_master::status::ERROR, 1);
+    sim::hal::inject_i2c_fault(&hi2c1, sim::i2c_fault::INIT_FAILS);
+    check_fault(i2c, sim::i2c_fault::HANG, i2c_master::status::ERROR, 1);
+    // nor is a start retried on it
+    sim::hal::inject_i2c_fault(&hi2c1, sim::i2c_fault::INIT_FAILS);
+    sim::hal::inject_i2c_fault(&hi2c1, sim::i2c_fault::SDA_STUCK);
+    check_fault(i2c, sim::i2c_fault::SDA_STUCK, i2c_master::status::ERROR, 1);
+
+    vTaskEndScheduler();
+}
+
+int main()
+{
+    hi2c1.Instance = I2C1;
+    hi2c1.Init.ClockSpeed = 400000;
+    HAL_I2C_Init(&hi2c1);
+    sim::hal::attach(&hi2c1, ADDRESS, device);
+    sim::hal::attach_i2c_pins(&hi2c1, GPIOB, SCL_PIN, GPIOB, SDA_PIN);
+
+    xTaskCreate(test_task, "test", 1024, nullptr, 1, nullptr);
+    vTaskStartScheduler();
+    return check_failures();
+}
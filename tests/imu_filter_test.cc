@@ -0,0 +1,280 @@
+/*
+ * sdk::imu_filter outputs against direct, one-multiply-at-a-time references:
+ * the Q15 dot product and FIR decimator on both the SIMD (SMLAD / SSE2) and
+ * the portable path bit for bit, the CIC decimator's DC gain and decimation
+ * phase, and the biquads' DC gain and notch depth.
+ */
+
+#include "check.h"
+
+#include <sdk/imu_filter.h>
+
+#include <sdk/sim/rng.h>
+
+#include <math.h>
+#include <stdint.h>
+
+using namespace sdk;
+
+static constexpr int SAMPLES = 512;
+
+static sim::rng noise(7);
+
+/* full-scale noise, with the extremes thrown in */
+static int16_t random_sample()
+{
+    uint64_t r = noise.next();
+    if ((r & 0x3f) == 0)
+        return (r & 0x40) ? INT16_MAX : INT16_MIN;
+    return (int16_t) (r >> 48);
+}
+
+static void fill_random(raw_vec3 *out, int count)
+{
+    for (int i = 0; i < count; i++)
+        out[i] = { random_sample(), random_sample(), random_sample() };
+}
+
+static int16_t axis(const raw_vec3 &v, int a)
+{
+    return a == 0 ? v.x : a == 1 ? v.y : v.z;
+}
+
+/* the rounding and saturation the filters promise, on a wide accumulator */
+static int16_t round_q15(int64_t acc)
+{
+    int64_t y = (acc + (1 << 14)) >> 15;
+    if (y > INT16_MAX)
+        return INT16_MAX;
+    if (y < INT16_MIN)
+        return INT16_MIN;
+    return (int16_t) y;
+}
+
+/*
+ * Every length up to 40, so each one ends partway through a SIMD block;
+ * below the block size (8 on SSE2, 2 with SMLAD) only the portable loop runs.
+ */
+static void check_dot_q15()
+{
+    int16_t x[40];
+    int16_t h[40];
+    for (int i = 0; i < 40; i++) {
+        x[i] = random_sample();
+        // a lowpass's taps: their absolute sum stays under 2.0
+        h[i] = (int16_t) ((int64_t) random_sample() / 32);
+    }
+
+    for (int n = 0; n <= 40; n++) {
+        int32_t expected = 0;
+        for (int i = 0; i < n; i++)
+            expected += (int32_t) x[i] * h[i];
+        CHECK(detail::dot_q15(x, h, n) == expected);
+        // unaligned starts too
+        if (n < 40) {
+            int32_t shifted = 0;
+            for (int i = 0; i < n; i++)
+                shifted += (int32_t) x[i + 1] * h[i];
+            CHECK(detail::dot_q15(x + 1, h, n) == shifted);
+        }
+    }
+}
+
+/*
+ * Runs `in` through a fresh decimator in uneven bursts and checks every
+ * output against the convolution at the sample it was kept on, with the
+ * history before the first sample at zero.
+ */
+template<int TAPS, int FACTOR>
+static void check_fir(const raw_vec3 *in)
+{
+    static constexpr fir_coefficients<TAPS> taps =
+        fir_lowpass<TAPS>(0.4 / FACTOR);
+    fir_decimator<TAPS, FACTOR> fir(taps);
+
+    raw_vec3 out[SAMPLES / FACTOR + 1];
+    uint32_t written = 0;
+    for (int i = 0; i < SAMPLES; ) {
+        int burst = 1 + i % 7;
+        if (burst > SAMPLES - i)
+            burst = SAMPLES - i;
+        written += fir.process(in + i, burst, out + written);
+        i += burst;
+    }
+    CHECK(written == SAMPLES / FACTOR);
+
+    int mismatches = 0;
+    for (uint32_t k = 0; k < written; k++) {
+        // the first output is on the FACTORth sample
+        int n = (k + 1) * FACTOR - 1;
+        for (int a = 0; a < 3; a++) {
+            int64_t acc = 0;
+            for (int j = 0; j < TAPS && j <= n; j++)
+                acc += (int64_t) taps.h[j] * axis(in[n - j], a);
+            if (axis(out[k], a) != round_q15(acc))
+                mismatches++;
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+/* a constant passes through unchanged, the taps sum to exactly 1.0 */
+static void check_fir_dc()
+{
+    static constexpr fir_coefficients<32> taps = fir_lowpass<32>(0.1);
+    fir_decimator<32, 4> fir(taps);
+    raw_vec3 steady = { 1000, -2000, INT16_MAX };
+    fir.reset(steady);
+
+    raw_vec3 in[64];
+    raw_vec3 out[17];
+    for (int i = 0; i < 64; i++)
+        in[i] = steady;
+    CHECK(fir.process(in, 64, out) == 16);
+    for (int k = 0; k < 16; k++)
+        CHECK(out[k] == steady);
+}
+
+/*
+ * Checks a CIC decimator against its definition: ORDER boxcars of FACTOR
+ * samples convolved, kept on every FACTORth sample and divided by the gain,
+ * truncating.
+ */
+template<int ORDER, int FACTOR>
+static void check_cic(const raw_vec3 *in)
+{
+    using cic = cic_decimator<ORDER, FACTOR>;
+    static constexpr int LENGTH = ORDER * (FACTOR - 1) + 1;
+
+    int64_t h[LENGTH] = { 1 };
+    for (int s = 0; s < ORDER; s++) {
+        // convolve with a FACTOR-sample boxcar, in place from the end
+        for (int i = LENGTH - 1; i >= 0; i--) {
+            int64_t sum = 0;
+            for (int j = 0; j < FACTOR && j <= i; j++)
+                sum += h[i - j];
+            h[i] = sum;
+        }
+    }
+
+    cic filter;
+    raw_vec3 out[SAMPLES / FACTOR + 1];
+    CHECK(filter.process(in, SAMPLES, out) == SAMPLES / FACTOR);
+
+    int mismatches = 0;
+    for (int k = 0; k < SAMPLES / FACTOR; k++) {
+        int n = (k + 1) * FACTOR - 1;
+        for (int a = 0; a < 3; a++) {
+            int64_t acc = 0;
+            for (int j = 0; j < LENGTH && j <= n; j++)
+                acc += h[j] * axis(in[n - j], a);
+            if (axis(out[k], a) != (int16_t) (acc / cic::gain()))
+                mismatches++;
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+static void check_cic_dc_and_phase()
+{
+    using cic = cic_decimator<3, 4>;
+
+    // a constant comes out unchanged once the filter has filled
+    cic filter;
+    raw_vec3 steady = { 1234, -4321, INT16_MIN };
+    raw_vec3 in[64];
+    raw_vec3 out[17];
+    for (int i = 0; i < 64; i++)
+        in[i] = steady;
+    CHECK(filter.process(in, 64, out) == 16);
+    for (int k = 3; k < 16; k++)
+        CHECK(out[k] == steady);
+
+    // and at once after settling on it
+    filter.reset(steady);
+    CHECK(filter.process(in, 8, out) == 2);
+    CHECK(out[0] == steady && out[1] == steady);
+
+    // an impulse on the last sample of a block shows in that block's output
+    filter.reset();
+    raw_vec3 impulse[8] = {};
+    impulse[3] = { cic::gain(), 0, 0 };
+    CHECK(filter.process(impulse, 8, out) == 2);
+    CHECK(out[0].x == 1 && out[1].x == 12);
+    // one sample later, it is first seen a block later
+    filter.reset();
+    impulse[3] = {};
+    impulse[4] = { cic::gain(), 0, 0 };
+    CHECK(filter.process(impulse, 8, out) == 2);
+    CHECK(out[0].x == 0 && out[1].x == 10);
+}
+
+/*
+ * Gain at `hz` for a filter at 1600 Hz: after a second to settle, the
+ * amplitude of the response over the next second, by correlation.
+ */
+template<int SECTIONS>
+static double sine_gain(biquad_cascade<SECTIONS> &filter, double hz)
+{
+    filter.reset();
+    double in_phase = 0;
+    double quadrature = 0;
+    for (int i = 0; i < 3200; i++) {
+        double w = 2.0 * M_PI * hz * i / 1600.0;
+        float s = (float) sin(w);
+        vec3 y = filter.update({ s, s, s });
+        if (i >= 1600) {
+            in_phase += y.x * sin(w);
+            quadrature += y.x * cos(w);
+        }
+    }
+    return 2.0 / 1600.0 * sqrt(in_phase * in_phase + quadrature * quadrature);
+}
+
+static void check_biquads()
+{
+    biquad_coefficients sections[2] = {
+        biquad_lowpass(1600.0f, 100.0f),
+        biquad_notch(1600.0f, 250.0f, 5.0f),
+    };
+    biquad_cascade<2> filter(sections);
+
+    // settled on a constant, it stays there
+    vec3 steady = { 9.81f, -1.0f, 0.5f };
+    filter.reset(steady);
+    for (int i = 0; i < 100; i++) {
+        vec3 y = filter.update(steady);
+        CHECK(fabsf(y.x - steady.x) < 1e-4f && fabsf(y.y - steady.y) < 1e-4f);
+    }
+
+    biquad_coefficients notch[1] = { biquad_notch(1600.0f, 250.0f, 5.0f) };
+    biquad_cascade<1> only_notch(notch);
+    CHECK(sine_gain(only_notch, 250.0) < 0.01);
+    CHECK(sine_gain(only_notch, 50.0) > 0.98);
+
+    // Butterworth: -3 dB at the cutoff, flat well below it
+    biquad_coefficients lowpass[1] = { biquad_lowpass(1600.0f, 100.0f) };
+    biquad_cascade<1> only_lowpass(lowpass);
+    CHECK(fabs(sine_gain(only_lowpass, 100.0) - M_SQRT1_2) < 0.01);
+    CHECK(fabs(sine_gain(only_lowpass, 10.0) - 1.0) < 0.01);
+}
+
+int main()
+{
+    static raw_vec3 in[SAMPLES];
+    fill_random(in, SAMPLES);
+
+    check_dot_q15();
+    // SIMD blocks only, SIMD blocks and a portable tail, portable only
+    check_fir<32, 4>(in);
+    check_fir<13, 3>(in);
+    check_fir<5, 2>(in);
+    check_fir_dc();
+
+    check_cic<3, 4>(in);
+    check_cic<2, 8>(in);
+    check_cic_dc_and_phase();
+
+    check_biquads();
+    return check_failures();
+}
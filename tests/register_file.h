@@ -0,0 +1,63 @@
+
+#ifndef AIRBRAKES_SDK_TESTS_REGISTER_FILE_H_
+#define AIRBRAKES_SDK_TESTS_REGISTER_FILE_H_
+
+#include <sdk/sim/hal.h>
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * A simulated I2C device with 256 plain registers that records every
+ * transaction it acknowledges, so tests can count bus traffic. Accesses past
+ * the last register are NACKed.
+ */
+class register_file : public sdk::sim::i2c_device {
+public:
+
+    struct transaction {
+        bool write;
+        uint16_t reg;
+        uint16_t size;
+    };
+
+    static constexpr int MAX_LOG = 32;
+
+public:
+
+    bool read(uint16_t reg, uint8_t *data, uint16_t size) override
+    {
+        if (reg + size > 0x100)
+            return false;
+        record(false, reg, size);
+        memcpy(data, regs + reg, size);
+        return true;
+    }
+
+    bool write(uint16_t reg, const uint8_t *data, uint16_t size) override
+    {
+        if (reg + size > 0x100)
+            return false;
+        record(true, reg, size);
+        memcpy(regs + reg, data, size);
+        return true;
+    }
+
+    /** Forgets the transactions so far. */
+    void clear_log() { count = 0; }
+
+    int count = 0; /* transactions since `clear_log`, may exceed MAX_LOG */
+    transaction log[MAX_LOG];
+    uint8_t regs[0x100] = {};
+
+private:
+
+    void record(bool write, uint16_t reg, uint16_t size)
+    {
+        if (count < MAX_LOG)
+            log[count] = { write, reg, size };
+        count++;
+    }
+};
+
+#endif // AIRBRAKES_SDK_TESTS_REGISTER_FILE_H_
@@ -0,0 +1,180 @@
+/*
+ * sdk::register_map against a simulated device on the host I2C bus, counting
+ * the transactions each operation costs: redundant writes and
+ * read-modify-writes take none, dirty runs go out as one burst each, a failed
+ * flush leaves its registers staged and unknown, and `invalidate` makes the
+ * next write of a known value go out again.
+ */
+
+#include "check.h"
+#include "register_file.h"
+
+#include <sdk/i2c.h>
+#include <sdk/register_map.h>
+
+#include <sdk/sim/hal.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+using namespace sdk;
+
+static constexpr uint16_t ADDRESS = 0x42;
+static constexpr uint8_t FIRST = 0x10;
+
+using map = register_map<FIRST, 8>;
+
+static I2C_HandleTypeDef hi2c1;
+static register_file device;
+
+static bool is_burst(int i, uint16_t reg, uint16_t size)
+{
+    const register_file::transaction &t = device.log[i];
+    return t.write && t.reg == reg && t.size == size;
+}
+
+static void test_staging(i2c_master &i2c)
+{
+    map regs(i2c, ADDRESS << 1);
+
+    // unknown registers always write, known ones only when they change
+    regs.set(FIRST, 0x01);
+    CHECK(regs.is_dirty());
+    CHECK(!regs.is_known(FIRST));
+    device.clear_log();
+    CHECK(regs.flush() == i2c_master::status::OK);
+    CHECK(device.count == 1 && is_burst(0, FIRST, 1));
+    CHECK(device.regs[FIRST] == 0x01);
+    CHECK(regs.is_known(FIRST));
+
+    device.clear_log();
+    regs.set(FIRST, 0x01);
+    CHECK(!regs.is_dirty());
+    CHECK(regs.flush() == i2c_master::status::OK);
+    CHECK(device.count == 0);
+
+    // a read-modify-write reads the shadow, not the bus
+    regs.update_bits(FIRST, 0xf0, 0x30);
+    CHECK(regs.get(FIRST) == 0x31);
+    CHECK(device.count == 0);
+    CHECK(regs.flush() == i2c_master::status::OK);
+    CHECK(device.count == 1 && device.regs[FIRST] == 0x31);
+
+    // staging a change and then the old value again cancels it
+    device.clear_log();
+    regs.set(FIRST, 0x55);
+    regs.set(FIRST, 0x31);
+    CHECK(!regs.is_dirty());
+
+    // contiguous dirty registers share a burst, a gap splits them
+    regs.set(FIRST + 2, 0x02);
+    regs.set(FIRST + 3, 0x03);
+    regs.set(FIRST + 4, 0x04);
+    regs.set(FIRST + 6, 0x06);
+    CHECK(regs.flush() == i2c_master::status::OK);
+    CHECK(device.count == 2);
+    CHECK(is_burst(0, FIRST + 2, 3));
+    CHECK(is_burst(1, FIRST + 6, 1));
+    CHECK(device.regs[FIRST + 3] == 0x03 && device.regs[FIRST + 6] == 0x06);
+
+    // assumed and loaded values are known without writing them
+    device.clear_log();
+    regs.assume(FIRST + 7, 0x80);
+    regs.set(FIRST + 7, 0x80);
+    CHECK(!regs.is_dirty());
+
+    device.regs[FIRST + 5] = 0x5a;
+    CHECK(regs.load(FIRST + 5, 1) == i2c_master::status::OK);
+    CHECK(device.count == 1 && !device.log[0].write);
+    CHECK(regs.get(FIRST + 5) == 0x5a && regs.is_known(FIRST + 5));
+    regs.set(FIRST + 5, 0x5a);
+    CHECK(!regs.is_dirty());
+    CHECK(device.count == 1);
+}
+
+static void test_failed_flush(i2c_master &i2c)
+{
+    map regs(i2c, ADDRESS << 1);
+    regs.set(FIRST, 0x11);
+    regs.set(FIRST + 1, 0x12);
+    regs.set(FIRST + 4, 0x14);
+    CHECK(regs.flush() == i2c_master::status::OK);
+
+    regs.set(FIRST, 0x21);
+    regs.set(FIRST + 1, 0x22);
+    regs.set(FIRST + 4, 0x24);
+    device.clear_log();
+    sim::hal::inject_i2c_fault(&hi2c1, sim::i2c_fault::NACK);
+    CHECK(regs.flush() == i2c_master::status::NACK);
+
+    // the first burst failed, so the second was never tried
+    CHECK(device.count == 0);
+    CHECK(device.regs[FIRST] == 0x11 && device.regs[FIRST + 4] == 0x14);
+    CHECK(regs.is_dirty());
+    CHECK(!regs.is_known(FIRST) && !regs.is_known(FIRST + 1));
+    CHECK(!regs.is_known(FIRST + 4));
+    CHECK(regs.get(FIRST) == 0x21);
+
+    // the failed registers went unknown, so setting them back writes too
+    regs.set(FIRST, 0x11);
+    CHECK(regs.flush() == i2c_master::status::OK);
+    CHECK(device.count == 2);
+    CHECK(is_burst(0, FIRST, 2));
+    CHECK(is_burst(1, FIRST + 4, 1));
+    CHECK(device.regs[FIRST] == 0x11 && device.regs[FIRST + 1] == 0x22);
+    CHECK(device.regs[FIRST + 4] == 0x24);
+    CHECK(!regs.is_dirty() && regs.is_known(FIRST));
+}
+
+static void test_invalidate(i2c_master &i2c)
+{
+    map regs(i2c, ADDRESS << 1);
+    regs.set(FIRST, 0x01);
+    regs.set(FIRST + 1, 0x02);
+    CHECK(regs.flush() == i2c_master::status::OK);
+
+    // a device reset: the same values have to go out again
+    device.regs[FIRST] = 0;
+    device.regs[FIRST + 1] = 0;
+    regs.invalidate();
+    CHECK(!regs.is_known(FIRST));
+    device.clear_log();
+    regs.set(FIRST, 0x01);
+    regs.set(FIRST + 1, 0x02);
+    CHECK(regs.is_dirty());
+    CHECK(regs.flush() == i2c_master::status::OK);
+    CHECK(device.count == 1 && is_burst(0, FIRST, 2));
+    CHECK(device.regs[FIRST] == 0x01 && device.regs[FIRST + 1] == 0x02);
+
+    // staged writes survive an invalidate
+    device.clear_log();
+    regs.set(FIRST + 3, 0x33);
+    regs.invalidate();
+    CHECK(regs.is_dirty());
+    CHECK(regs.flush() == i2c_master::status::OK);
+    CHECK(device.count == 1 && is_burst(0, FIRST + 3, 1));
+}
+
+static void test_task(void *params)
+{
+    (void) params;
+    static i2c_master i2c(&hi2c1);
+
+    test_staging(i2c);
+    test_failed_flush(i2c);
+    test_invalidate(i2c);
+
+    vTaskEndScheduler();
+}
+
+int main()
+{
+    hi2c1.Instance = I2C1;
+    hi2c1.Init.ClockSpeed = 400000;
+    HAL_I2C_Init(&hi2c1);
+    sim::hal::attach(&hi2c1, ADDRESS, device);
+
+    xTaskCreate(test_task, "test", 1024, nullptr, 1, nullptr);
+    vTaskStartScheduler();
+    return check_failures();
+}
@@ -0,0 +1,215 @@
+/*
+ * sdk::sensor_hub driven through `step` with simulated time: reads are
+ * released on each sensor's grid in rate-monotonic order, all of a step's
+ * reads go out before any subscriber hears of them, missed releases count
+ * as overruns instead of being caught up, and a sensor's period can change
+ * under it.
+ */
+
+#include "check.h"
+
+#include <sdk/sensor_hub.h>
+
+#include <initializer_list>
+
+using namespace sdk;
+
+/* simulated time, in us; reads advance it by their sensor's `read_us` */
+static uint64_t sim_us;
+
+static uint64_t sim_now()
+{
+    return sim_us;
+}
+
+/* what happened, in order: reads and notifications, tagged by sensor */
+struct event {
+    bool read;
+    int sensor;
+    uint64_t at_us;
+};
+
+static event events[256];
+static int event_count;
+
+struct fake_sensor {
+    int tag;
+    uint32_t read_us;
+    bool fail;
+    uint32_t period_us; /* for the period_fn form */
+};
+
+static void log_event(bool read, int sensor)
+{
+    if (event_count < 256)
+        events[event_count] = { read, sensor, sim_us };
+    event_count++;
+}
+
+static bool read_fake(void *ctx)
+{
+    fake_sensor *s = (fake_sensor *) ctx;
+    log_event(true, s->tag);
+    sim_us += s->read_us;
+    return !s->fail;
+}
+
+static void notify_fake(void *ctx)
+{
+    log_event(false, ((fake_sensor *) ctx)->tag);
+}
+
+/* a second subscriber, to check subscription order */
+static void notify_fake_again(void *ctx)
+{
+    log_event(false, ((fake_sensor *) ctx)->tag + 100);
+}
+
+static uint32_t fake_period(void *ctx)
+{
+    return ((fake_sensor *) ctx)->period_us;
+}
+
+/* steps at `now_us` and checks the events it produced */
+static uint64_t check_step(sensor_hub &hub, uint64_t now_us,
+        std::initializer_list<event> expected)
+{
+    sim_us = now_us;
+    event_count = 0;
+    uint64_t next = hub.step(now_us);
+    CHECK(event_count == (int) expected.size());
+    int i = 0;
+    for (const event &e : expected) {
+        CHECK(i < event_count && events[i].read == e.read &&
+            events[i].sensor == e.sensor && events[i].at_us == e.at_us);
+        i++;
+    }
+    return next;
+}
+
+static void check_schedule()
+{
+    sensor_hub hub(sim_now);
+    // registered slowest first; the hub orders by period, ties by id
+    fake_sensor slow = { 3, 0, false, 0 };
+    fake_sensor fast = { 1, 0, false, 0 };
+    fake_sensor also_fast = { 2, 0, false, 0 };
+    int slow_id = hub.add("slow", 2500, read_fake, &slow);
+    int fast_id = hub.add("fast", 1000, read_fake, &fast);
+    int also_fast_id = hub.add("also_fast", 1000, read_fake, &also_fast);
+    CHECK(slow_id == 0 && fast_id == 1 && also_fast_id == 2);
+    CHECK(hub.subscribe(fast_id, notify_fake, &fast));
+    CHECK(hub.subscribe(fast_id, notify_fake_again, &fast));
+    CHECK(hub.subscribe(slow_id, notify_fake, &slow));
+
+    // everything is released at the first step; reads, then fan-out
+    uint64_t next = check_step(hub, 0, {
+        { true, 1, 0 }, { true, 2, 0 }, { true, 3, 0 },
+        { false, 1, 0 }, { false, 101, 0 }, { false, 3, 0 },
+    });
+    CHECK(next == 1000);
+
+    next = check_step(hub, next, {
+        { true, 1, 1000 }, { true, 2, 1000 },
+        { false, 1, 1000 }, { false, 101, 1000 },
+    });
+    CHECK(next == 2000);
+    next = check_step(hub, next, {
+        { true, 1, 2000 }, { true, 2, 2000 },
+        { false, 1, 2000 }, { false, 101, 2000 },
+    });
+    CHECK(next == 2500);
+    next = check_step(hub, next, { { true, 3, 2500 }, { false, 3, 2500 } });
+    CHECK(next == 3000);
+
+    // early steps release nothing
+    CHECK(check_step(hub, 2999, {}) == 3000);
+
+    // a failed read is counted and not fanned out
+    fast.fail = true;
+    next = check_step(hub, 3000, {
+        { true, 1, 3000 }, { true, 2, 3000 },
+    });
+    fast.fail = false;
+    CHECK(hub.get_stats(fast_id).failures == 1);
+    CHECK(hub.get_stats(fast_id).reads == 3);
+    CHECK(hub.get_stats(also_fast_id).reads == 4);
+
+    // a step 3.5 periods late runs each sensor once, on the old grid
+    next = check_step(hub, 7500, {
+        { true, 1, 7500 }, { true, 2, 7500 }, { true, 3, 7500 },
+        { false, 1, 7500 }, { false, 101, 7500 }, { false, 3, 7500 },
+    });
+    // fast: due at 4000, 5000-7000 missed; slow: due at 5000, 7500 missed
+    CHECK(hub.get_stats(fast_id).overruns == 3);
+    CHECK(hub.get_stats(also_fast_id).overruns == 3);
+    CHECK(hub.get_stats(slow_id).overruns == 1);
+    CHECK(next == 8000);
+    next = check_step(hub, next, {
+        { true, 1, 8000 }, { true, 2, 8000 },
+        { false, 1, 8000 }, { false, 101, 8000 },
+    });
+    CHECK(next == 9000);
+    CHECK(hub.get_stats(fast_id).last_read_us == 8000);
+    CHECK(hub.get_age_us(fast_id, 8600) == 600);
+}
+
+static void check_read_time()
+{
+    sensor_hub hub(sim_now);
+    fake_sensor a = { 1, 300, false, 0 };
+    fake_sensor b = { 2, 200, false, 0 };
+    int a_id = hub.add("a", 1000, read_fake, &a);
+    int b_id = hub.add("b", 2000, read_fake, &b);
+    CHECK(hub.subscribe(a_id, notify_fake, &a));
+
+    // reads run back to back; releases stay on the grid regardless
+    uint64_t next = check_step(hub, 0, {
+        { true, 1, 0 }, { true, 2, 300 }, { false, 1, 500 },
+    });
+    CHECK(next == 1000);
+    CHECK(hub.get_stats(a_id).max_read_us == 300);
+    CHECK(hub.get_stats(b_id).busy_us == 200);
+    CHECK(hub.get_stats(a_id).last_read_us == 300);
+    // 500 us busy out of 1000
+    CHECK(hub.get_bus_load(1000) == 0.5f);
+}
+
+static void check_period_change()
+{
+    sensor_hub hub(sim_now);
+    fake_sensor a = { 1, 0, false, 0 };
+    fake_sensor b = { 2, 0, false, 2000 };
+    int a_id = hub.add("a", 1000, read_fake, &a);
+    int b_id = hub.add("b", fake_period, read_fake, &b);
+    CHECK(hub.get_stats(b_id).period_us == 2000);
+
+    uint64_t next = check_step(hub, 0, { { true, 1, 0 }, { true, 2, 0 } });
+    CHECK(next == 1000);
+
+    // b's rate goes up: its release already due stands, then the new grid,
+    // and it now runs first
+    b.period_us = 500;
+    next = check_step(hub, 1000, { { true, 1, 1000 } });
+    next = check_step(hub, 2000, { { true, 1, 2000 }, { true, 2, 2000 } });
+    CHECK(hub.get_stats(b_id).period_us == 500);
+    CHECK(next == 2500);
+    next = check_step(hub, next, { { true, 2, 2500 } });
+    next = check_step(hub, next, { { true, 2, 3000 }, { true, 1, 3000 } });
+    CHECK(next == 3500);
+
+    // a fixed-period sensor changes with set_period
+    hub.set_period(a_id, 250);
+    next = check_step(hub, next, { { true, 2, 3500 } });
+    CHECK(next == 4000);
+    next = check_step(hub, next, { { true, 1, 4000 }, { true, 2, 4000 } });
+    CHECK(next == 4250);
+}
+
+int main()
+{
+    check_schedule();
+    check_read_time();
+    check_period_change();
+    return check_failures();
+}
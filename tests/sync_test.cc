@@ -0,0 +1,332 @@
+/*
+ * sdk::queue's operations on the sim kernel, with sim events standing in for
+ * ISRs, and moves of sdk::queue and sdk::mutex: items and locking carry over
+ * to the new object, the moved-from one reports ERROR or does nothing, and
+ * the statically allocated forms never touch the FreeRTOS heap. Built once per
+ * AIRBRAKES_SDK_STATIC_ALLOCATION setting, since that switches the mutex,
+ * and once with SDK_MUTEX_STATS for the contention counters and registry.
+ */
+
+#include "check.h"
+
+#include <sdk/mutex.h>
+#include <sdk/queue.h>
+
+#include <sdk/sim/kernel.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <initializer_list>
+#include <utility>
+
+#ifdef SDK_MUTEX_STATS
+#include <sdk/clock.h>
+
+#include <string.h>
+#endif
+
+using namespace sdk;
+
+#ifdef SDK_MUTEX_STATS
+/* the core clock sdk::clock scales by, normally defined by sim::hal */
+uint32_t SystemCoreClock = 84000000;
+#endif
+
+template<typename Q>
+static void check_moved_from(Q &q)
+{
+    int item = 0;
+    BaseType_t woken = pdFALSE;
+    CHECK(!q.is_valid());
+    CHECK(q.try_push_back(1, 0) == Q::status::ERROR);
+    CHECK(q.try_push_front(1, 0) == Q::status::ERROR);
+    CHECK(q.try_pop(&item, 0) == Q::status::ERROR);
+    CHECK(q.try_peek(&item, 0) == Q::status::ERROR);
+    CHECK(q.push_back_from_isr(1, &woken) == Q::status::ERROR);
+    CHECK(woken == pdFALSE);
+    CHECK(q.pop_n(&item, 1, 0) == 0);
+    CHECK(q.drain(&item, 1) == 0);
+    CHECK(q.size() == 0);
+
+    // the blocking forms return at once instead of waiting forever
+    q.push_back(1);
+    q.push_front(1);
+    CHECK(q.pop() == 0);
+}
+
+/* pops `expected` in order and checks nothing else is queued */
+template<typename Q>
+static void check_items(Q &q, std::initializer_list<int> expected)
+{
+    CHECK(q.is_valid());
+    CHECK(q.size() == expected.size());
+    for (int want : expected) {
+        int item = -1;
+        CHECK(q.try_pop(&item, 0) == Q::status::OK);
+        CHECK(item == want);
+    }
+    CHECK(q.is_empty());
+}
+
+/* fills a queue, then moves it by construction and by assignment */
+template<typename Q, typename... Args>
+static void check_queue_moves(Args... args)
+{
+    Q a(args...);
+    CHECK(a.try_push_back(1, 0) == Q::status::OK);
+    CHECK(a.try_push_back(2, 0) == Q::status::OK);
+
+    Q b(std::move(a));
+    check_moved_from(a);
+    CHECK(b.try_push_back(3, 0) == Q::status::OK);
+
+    Q c(args...);
+    CHECK(c.try_push_back(9, 0) == Q::status::OK);
+    c = std::move(b);
+    check_moved_from(b);
+    check_items(c, { 1, 2, 3 });
+
+    // the moved-to queue keeps working
+    CHECK(c.try_push_front(5, 0) == Q::status::OK);
+    check_items(c, { 5 });
+}
+
+using isr_queue = queue<int, 4>;
+
+/* what a push from a simulated ISR saw */
+struct isr_push {
+    isr_queue *q;
+    int value;
+    BaseType_t woken;
+    isr_queue::status result;
+};
+
+static void push_from_isr(void *ctx)
+{
+    isr_push *push = (isr_push *) ctx;
+    push->result = push->q->push_back_from_isr(push->value, &push->woken);
+}
+
+/* runs a push from an ISR at the current instant, before this task */
+static void run_isr(isr_push &push)
+{
+    sim::kernel::schedule(sim::kernel::now_ns(), push_from_isr, &push);
+    vTaskDelay(1);
+}
+
+static void check_queue_ops()
+{
+    isr_queue q;
+    int item = -1;
+    int out[4] = {};
+
+    // empty and full are told apart
+    CHECK(q.size() == 0 && q.is_empty());
+    CHECK(q.try_pop(&item, 0) == isr_queue::status::EMPTY);
+    CHECK(q.try_peek(&item, 0) == isr_queue::status::EMPTY);
+    CHECK(q.pop_n(out, 4, 0) == 0);
+    CHECK(q.drain(out, 4) == 0);
+    for (int i = 1; i <= 4; i++)
+        CHECK(q.try_push_back(i, 0) == isr_queue::status::OK);
+    CHECK(q.size() == 4);
+    CHECK(q.try_push_back(5, 0) == isr_queue::status::FULL);
+    CHECK(q.try_push_front(5, 0) == isr_queue::status::FULL);
+
+    // peeking leaves the item queued
+    CHECK(q.try_peek(&item, 0) == isr_queue::status::OK && item == 1);
+    CHECK(q.size() == 4);
+
+    // pop_n stops at `max`, drain takes the rest
+    CHECK(q.pop_n(out, 0, 0) == 0);
+    CHECK(q.pop_n(out, 3, 0) == 3);
+    CHECK(out[0] == 1 && out[1] == 2 && out[2] == 3);
+    CHECK(q.size() == 1);
+    CHECK(q.drain(out, 4) == 1 && out[0] == 4);
+    CHECK(q.is_empty());
+
+    // with nobody waiting, an ISR push leaves the caller's flag alone
+    isr_push push = { &q, 7, pdFALSE, isr_queue::status::ERROR };
+    run_isr(push);
+    CHECK(push.result == isr_queue::status::OK && push.woken == pdFALSE);
+    push.woken = pdTRUE;
+    run_isr(push);
+    CHECK(push.result == isr_queue::status::OK && push.woken == pdTRUE);
+    CHECK(q.drain(out, 4) == 2 && out[0] == 7 && out[1] == 7);
+
+    // a push that wakes the blocked task sets it; pop_n waits for it
+    push = { &q, 8, pdFALSE, isr_queue::status::ERROR };
+    uint64_t at = sim::kernel::now_ns() + 1000000;
+    sim::kernel::schedule(at, push_from_isr, &push);
+    CHECK(q.pop_n(out, 4, 10) == 1 && out[0] == 8);
+    CHECK(sim::kernel::now_ns() == at);
+    CHECK(push.result == isr_queue::status::OK && push.woken == pdTRUE);
+
+    // and a full queue refuses it
+    for (int i = 0; i < 4; i++)
+        q.push_back(i);
+    push = { &q, 9, pdFALSE, isr_queue::status::OK };
+    run_isr(push);
+    CHECK(push.result == isr_queue::status::FULL && push.woken == pdFALSE);
+    CHECK(q.drain(out, 4) == 4 && out[3] == 3);
+}
+
+static void check_mutex_moves()
+{
+    mutex a("a");
+    CHECK(a.try_lock(0) == mutex::status::OK);
+    CHECK(a.unlock() == mutex::status::OK);
+
+    mutex b(std::move(a));
+    CHECK(a.try_lock(0) == mutex::status::ERROR);
+    CHECK(a.unlock() == mutex::status::ERROR);
+    CHECK(a.unwrap() == nullptr);
+    CHECK(b.try_lock(0) == mutex::status::OK);
+    CHECK(b.try_lock(0) == mutex::status::IN_USE);
+    CHECK(b.unlock() == mutex::status::OK);
+
+    mutex c("c");
+    c = std::move(b);
+    CHECK(b.try_lock(0) == mutex::status::ERROR);
+    CHECK(b.unlock() == mutex::status::ERROR);
+    CHECK(c.try_lock(0) == mutex::status::OK);
+    CHECK(c.unlock() == mutex::status::OK);
+}
+
+#ifdef SDK_MUTEX_STATS
+
+static constexpr uint32_t HOLD_MS = 2;
+
+struct names {
+    const char *seen[8];
+    int count;
+};
+
+static void collect_name(mutex &m, void *ctx)
+{
+    names *out = (names *) ctx;
+    if (out->count < 8)
+        out->seen[out->count] = m.get_name();
+    out->count++;
+}
+
+/* checks mutex::for_each walks exactly `expected`, in order */
+static void check_registry(std::initializer_list<const char *> expected)
+{
+    names out = {};
+    mutex::for_each(collect_name, &out);
+    CHECK(out.count == (int) expected.size());
+    int i = 0;
+    for (const char *want : expected) {
+        CHECK(i < out.count && strcmp(out.seen[i], want) == 0);
+        i++;
+    }
+}
+
+static void check_registry_order()
+{
+    check_registry({});
+    {
+        mutex a("a");
+        mutex b("b");
+        mutex c("c");
+        check_registry({ "a", "b", "c" });
+
+        // a moved-to mutex takes the place of its source
+        mutex moved(std::move(b));
+        check_registry({ "a", "b", "c" });
+
+        // assignment keeps the target's place and drops the source
+        a = std::move(c);
+        check_registry({ "c", "b" });
+    }
+    check_registry({});
+}
+
+/* holds the mutex in `params` for HOLD_MS, then exits */
+static void holder_task(void *params)
+{
+    mutex *m = (mutex *) params;
+    m->lock();
+    vTaskDelay(pdMS_TO_TICKS(HOLD_MS));
+    m->unlock();
+    vTaskDelete(nullptr);
+}
+
+static void check_stats()
+{
+    mutex m("stats");
+    uint32_t cpu = clock::cycles_per_us();
+
+    CHECK(m.try_lock(0) == mutex::status::OK);
+    CHECK(m.unlock() == mutex::status::OK);
+    mutex::stats s = m.get_stats();
+    CHECK(s.acquisitions == 1 && s.contended == 0 && s.timeouts == 0);
+
+    // a higher priority task takes it first, so the next lock waits
+    xTaskCreate(holder_task, "holder", 1024, &m, 2, nullptr);
+    CHECK(m.try_lock(0) == mutex::status::IN_USE);
+    CHECK(m.try_lock(HOLD_MS * 10) == mutex::status::OK);
+    CHECK(m.unlock() == mutex::status::OK);
+
+    s = m.get_stats();
+    CHECK(s.acquisitions == 3);
+    CHECK(s.contended == 1);
+    CHECK(s.timeouts == 1);
+    CHECK(s.max_wait_cycles >= HOLD_MS * 1000 * cpu);
+    CHECK(s.total_wait_cycles == s.max_wait_cycles);
+    CHECK(s.max_hold_cycles >= HOLD_MS * 1000 * cpu);
+
+    // one header line, then one line per mutex
+    char table[256];
+    uint32_t len = mutex::format_stats(table, sizeof(table));
+    CHECK(len == strlen(table));
+    CHECK(strstr(table, "name") == table);
+    CHECK(strstr(table, "\nstats ") != nullptr);
+
+    // a short buffer truncates, still terminated
+    char small[16];
+    CHECK(mutex::format_stats(small, sizeof(small)) == sizeof(small) - 1);
+    CHECK(strlen(small) == sizeof(small) - 1);
+    CHECK(mutex::format_stats(small, 0) == 0);
+
+    m.reset_stats();
+    s = m.get_stats();
+    CHECK(s.acquisitions == 0 && s.timeouts == 0 && s.max_wait_cycles == 0);
+}
+
+#endif // SDK_MUTEX_STATS
+
+static void test_task(void *params)
+{
+    (void) params;
+
+    check_queue_ops();
+    check_queue_moves<queue<int>>(4);
+
+    uint64_t before = sim::kernel::get_heap_allocations();
+    check_queue_moves<queue<int, 4>>();
+    CHECK(sim::kernel::get_heap_allocations() == before);
+
+    before = sim::kernel::get_heap_allocations();
+    check_mutex_moves();
+#ifdef SDK_STATIC_ALLOCATION
+    CHECK(sim::kernel::get_heap_allocations() == before);
+#else
+    CHECK(sim::kernel::get_heap_allocations() > before);
+#endif
+
+#ifdef SDK_MUTEX_STATS
+    check_registry_order();
+    check_stats();
+#endif
+
+    vTaskEndScheduler();
+}
+
+int main()
+{
+    xTaskCreate(test_task, "test", 1024, nullptr, 1, nullptr);
+    vTaskStartScheduler();
+    return check_failures();
+}
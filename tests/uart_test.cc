@@ -0,0 +1,330 @@
+/*
+ * sdk::uart and sdk::packet framing over the host HAL's UART loopback: COBS
+ * on both sides of its 254-byte block limit, packets round trip intact up to
+ * the longest frame, a damaged CRC is rejected with the stream resyncing on
+ * the next frame, a saturated link drops whole packets on the send side and
+ * a slow reader loses bytes on the receive side, both counted. And an
+ * instance past `MAX_INSTANCES` refuses to start.
+ */
+
+#include "check.h"
+
+#include <sdk/packet.h>
+#include <sdk/uart.h>
+
+#include <sdk/sim/hal.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <initializer_list>
+
+#include <string.h>
+
+using namespace sdk;
+
+static UART_HandleTypeDef huart1; /* looped back onto itself */
+static UART_HandleTypeDef huart2;
+static UART_HandleTypeDef huart6;
+/* a fourth, which the instance table has no room for */
+static UART_HandleTypeDef huart_extra;
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    uart::from_handle(huart)->tx_complete_from_isr();
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    uart::from_handle(huart)->rx_event_from_isr(Size);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    uart::from_handle(huart)->error_from_isr();
+}
+
+/* a payload that carries its sequence number, and zeros most of the time */
+static void make_payload(uint8_t *out, uint16_t size, uint16_t seq)
+{
+    for (uint16_t i = 0; i < size; i++)
+        out[i] = (uint8_t) (seq * 37 + i * 11);
+    if (size >= 2) {
+        out[0] = (uint8_t) seq;
+        out[1] = (uint8_t) (seq >> 8);
+    }
+}
+
+/* the last payload decoded, and the sequence numbers of all of them */
+struct receiver {
+    uint8_t last[packet::MAX_PAYLOAD];
+    uint16_t last_size;
+    uint32_t count;
+    uint16_t seqs[64];
+};
+
+static receiver rx;
+
+static void on_packet(const uint8_t *payload, uint16_t size, void *ctx)
+{
+    receiver &r = *(receiver *) ctx;
+    memcpy(r.last, payload, size);
+    r.last_size = size;
+    if (r.count < 64)
+        r.seqs[r.count] = size >= 2 ? (uint16_t) (payload[0] |
+            payload[1] << 8) : 0;
+    r.count++;
+}
+
+/* reads what arrives until the link has been idle for a frame's time */
+static void pump(uart &port, packet::decoder &decoder)
+{
+    for (int idle = 0; idle < 30; idle++) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+        uint8_t buffer[64];
+        uint16_t n;
+        while ((n = port.receive(buffer, sizeof(buffer))) > 0) {
+            decoder.feed(buffer, n);
+            idle = 0;
+        }
+        if (port.is_sending())
+            idle = 0;
+    }
+}
+
+static bool has_zero(const uint8_t *data, uint16_t size)
+{
+    return memchr(data, 0, size) != nullptr;
+}
+
+/*
+ * 254 non-zero bytes fill a block (code 0xff), which implies no zero after
+ * it; one more starts the next block. Beyond what a frame can hold, so
+ * straight through cobs_encode/cobs_decode.
+ */
+static void check_cobs_blocks()
+{
+    static uint8_t data[600];
+    static uint8_t encoded[packet::cobs_size(600)];
+    static uint8_t decoded[600];
+
+    for (uint16_t size : { 0, 1, 253, 254, 255, 508, 509, 600 }) {
+        // no zeros: every block as long as a code allows
+        for (uint16_t i = 0; i < size; i++)
+            data[i] = (uint8_t) (1 + i % 255);
+        uint16_t length = packet::cobs_encode(data, size, encoded);
+        CHECK(length == packet::cobs_size(size));
+        CHECK(!has_zero(encoded, length));
+        CHECK(packet::cobs_decode(encoded, length, decoded) == size);
+        CHECK(memcmp(decoded, data, size) == 0);
+
+        // a zero right at the block limit, and one at the very end
+        if (size > 254) {
+            data[254] = 0;
+            data[size - 1] = 0;
+            length = packet::cobs_encode(data, size, encoded);
+            CHECK(length <= packet::cobs_size(size));
+            CHECK(!has_zero(encoded, length));
+            CHECK(packet::cobs_decode(encoded, length, decoded) == size);
+            CHECK(memcmp(decoded, data, size) == 0);
+        }
+    }
+
+    // a code running past the end, and a zero inside a block
+    const uint8_t truncated[] = { 0x05, 0x01, 0x02 };
+    const uint8_t zero_inside[] = { 0x03, 0x01, 0x00 };
+    CHECK(packet::cobs_decode(truncated, sizeof(truncated), decoded) == -1);
+    CHECK(packet::cobs_decode(zero_inside, sizeof(zero_inside), decoded) ==
+        -1);
+}
+
+static void check_round_trip(uart &port, packet::decoder &decoder)
+{
+    static uint8_t payload[packet::MAX_PAYLOAD];
+    uint16_t seq = 0;
+
+    for (uint16_t size : { 0, 1, 2, 3, 100, 249, 250 }) {
+        make_payload(payload, size, seq++);
+        uint32_t before = rx.count;
+        CHECK(port.send_packet(payload, size) == uart::status::OK);
+        pump(port, decoder);
+        CHECK(rx.count == before + 1);
+        CHECK(rx.last_size == size && memcmp(rx.last, payload, size) == 0);
+    }
+
+    // the longest run without a zero a frame can have: payload and CRC, 252
+    // bytes under one code, unless the CRC itself holds a zero
+    for (uint16_t i = 0; i < packet::MAX_PAYLOAD; i++)
+        payload[i] = (uint8_t) (0x80 | i);
+    CHECK(port.send_packet(payload, packet::MAX_PAYLOAD) == uart::status::OK);
+    pump(port, decoder);
+    CHECK(rx.last_size == packet::MAX_PAYLOAD);
+    CHECK(memcmp(rx.last, payload, packet::MAX_PAYLOAD) == 0);
+
+    CHECK(port.send_packet(payload, packet::MAX_PAYLOAD + 1) ==
+        uart::status::ERROR);
+    CHECK(decoder.get_stats().crc_errors == 0);
+    CHECK(decoder.get_stats().framing_errors == 0);
+}
+
+static void check_corrupted_crc(uart &port, packet::decoder &decoder)
+{
+    uint8_t payload[20];
+    for (int i = 0; i < 20; i++)
+        payload[i] = (uint8_t) (0x10 + i);
+    uint8_t frame[packet::frame_size(20)];
+    uint16_t length = packet::encode(payload, 20, frame);
+
+    // one bit of the payload, still valid COBS (frame[0] is the code byte)
+    frame[5] ^= 0x01;
+    uint32_t before = rx.count;
+    CHECK(port.send(frame, length) == uart::status::OK);
+    pump(port, decoder);
+    CHECK(rx.count == before);
+    CHECK(decoder.get_stats().crc_errors == 1);
+
+    // the same, frame[5] restored: the next frame decodes
+    frame[5] ^= 0x01;
+    CHECK(port.send(frame, length) == uart::status::OK);
+    pump(port, decoder);
+    CHECK(rx.count == before + 1);
+    CHECK(rx.last_size == 20 && memcmp(rx.last, payload, 20) == 0);
+
+    // a frame longer than any payload is a framing error, not a packet
+    static uint8_t too_long[packet::MAX_PAYLOAD + 1];
+    static uint8_t long_frame[packet::frame_size(packet::MAX_PAYLOAD + 1)];
+    memset(too_long, 0x55, sizeof(too_long));
+    length = packet::encode(too_long, sizeof(too_long), long_frame);
+    CHECK(port.send(long_frame, length) == uart::status::OK);
+    pump(port, decoder);
+    CHECK(rx.count == before + 1);
+    CHECK(decoder.get_stats().framing_errors == 1);
+}
+
+/*
+ * Packets queued faster than the line drains: one buffer goes out while the
+ * other fills, and the rest are dropped whole. What was accepted arrives, in
+ * order and intact.
+ */
+static void check_saturation(uart &port, packet::decoder &decoder)
+{
+    static constexpr uint16_t SIZE = 100;
+    static constexpr uint16_t FRAME = packet::frame_size(SIZE);
+    uint8_t payload[SIZE];
+
+    uart::stats before = port.get_stats();
+    packet::decoder::stats decoded = decoder.get_stats();
+    uint32_t first = rx.count;
+
+    uint32_t accepted = 0;
+    uint32_t dropped = 0;
+    uint16_t accepted_seqs[10];
+    for (uint16_t seq = 100; seq < 110; seq++) {
+        make_payload(payload, SIZE, seq);
+        uart::status result = port.send_packet(payload, SIZE);
+        CHECK(result == uart::status::OK || result == uart::status::FULL);
+        if (result == uart::status::OK)
+            accepted_seqs[accepted++] = seq;
+        else
+            dropped++;
+    }
+    // one frame on the wire, two in the other buffer
+    CHECK(accepted == 1 + uart::TX_BUFFER_SIZE / FRAME);
+
+    uart::stats after = port.get_stats();
+    CHECK(after.tx_bytes - before.tx_bytes == accepted * FRAME);
+    CHECK(after.tx_dropped - before.tx_dropped == dropped);
+    CHECK(after.tx_dropped_bytes - before.tx_dropped_bytes == dropped * FRAME);
+
+    pump(port, decoder);
+    CHECK(rx.count - first == accepted);
+    for (uint32_t i = 0; i < accepted && first + i < 64; i++)
+        CHECK(rx.seqs[first + i] == accepted_seqs[i]);
+    CHECK(decoder.get_stats().crc_errors == decoded.crc_errors);
+    CHECK(decoder.get_stats().framing_errors == decoded.framing_errors);
+}
+
+/*
+ * A reader that falls more than a buffer behind: what the DMA went over is
+ * dropped and counted, then reception carries on.
+ */
+static void check_rx_overrun(uart &port, packet::decoder &decoder)
+{
+    static constexpr uint16_t SIZE = 100;
+    static constexpr uint16_t FRAME = packet::frame_size(SIZE);
+    uint8_t payload[SIZE];
+
+    uart::stats before = port.get_stats();
+    uint32_t first = rx.count;
+    for (uint16_t seq = 200; seq < 203; seq++) {
+        make_payload(payload, SIZE, seq);
+        CHECK(port.send_packet(payload, SIZE) == uart::status::OK);
+        while (port.is_sending())
+            vTaskDelay(pdMS_TO_TICKS(1));
+    }
+
+    uint8_t buffer[64];
+    CHECK(port.receive(buffer, sizeof(buffer)) == 0);
+    uart::stats after = port.get_stats();
+    CHECK(after.rx_dropped_bytes - before.rx_dropped_bytes == 3 * FRAME);
+    CHECK(after.rx_bytes == before.rx_bytes);
+
+    make_payload(payload, SIZE, 203);
+    CHECK(port.send_packet(payload, SIZE) == uart::status::OK);
+    pump(port, decoder);
+    CHECK(rx.count == first + 1);
+    CHECK(rx.last_size == SIZE && memcmp(rx.last, payload, SIZE) == 0);
+}
+
+static void check_registration()
+{
+    // the loopback port took the first slot
+    static uart second(&huart2);
+    static uart third(&huart6);
+    static uart extra(&huart_extra);
+    CHECK(uart::from_handle(&huart2) == &second);
+    CHECK(uart::from_handle(&huart6) == &third);
+    CHECK(uart::from_handle(&huart_extra) == nullptr);
+
+    CHECK(second.start() == uart::status::OK);
+    CHECK(extra.start() == uart::status::ERROR);
+    uint8_t byte = 1;
+    CHECK(extra.send(&byte, 1) == uart::status::ERROR);
+    CHECK(extra.send_packet(&byte, 1) == uart::status::ERROR);
+    CHECK(!extra.is_sending());
+}
+
+static void test_task(void *params)
+{
+    (void) params;
+    static uart port(&huart1);
+    static packet::decoder decoder(on_packet, &rx);
+    CHECK(port.start() == uart::status::OK);
+
+    check_cobs_blocks();
+    check_round_trip(port, decoder);
+    check_corrupted_crc(port, decoder);
+    check_saturation(port, decoder);
+    check_rx_overrun(port, decoder);
+    check_registration();
+
+    vTaskEndScheduler();
+}
+
+int main()
+{
+    for (UART_HandleTypeDef *huart : { &huart1, &huart2, &huart6,
+            &huart_extra }) {
+        huart->Init.BaudRate = 115200;
+        HAL_UART_Init(huart);
+    }
+    huart1.Instance = USART1;
+    huart2.Instance = USART2;
+    huart6.Instance = USART6;
+    huart_extra.Instance = USART1;
+    sim::hal::connect(&huart1, &huart1);
+
+    xTaskCreate(test_task, "test", 2048, nullptr, 1, nullptr);
+    vTaskStartScheduler();
+    return check_failures();
+}
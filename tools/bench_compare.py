@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""
+Compares an airbrakes_sdk_bench report (see bench/bench.h) against a stored
+baseline and fails if any benchmark's median got slower than the tolerance,
+or if any of the report's accuracy checks failed.
+
+usage: bench_compare.py report.json baseline.json [tolerance]
+
+The tolerance is a fraction (default 0.25, i.e. 25% slower). To accept new
+numbers, copy the report over the baseline. Baselines are only comparable on
+the same platform, build config and machine.
+"""
+
+import json
+import sys
+
+DEFAULT_TOLERANCE = 0.25
+
+
+def load(path):
+    with open(path) as f:
+        report = json.load(f)
+    return report, {r["name"]: r for r in report["results"]}
+
+
+def compare(report_path, baseline_path, tolerance):
+    report, current = load(report_path)
+    baseline, previous = load(baseline_path)
+
+    for key in ("platform", "config"):
+        if report.get(key) != baseline.get(key):
+            sys.stderr.write("warning: %s differs from the baseline (%s vs %s)\n"
+                             % (key, report.get(key), baseline.get(key)))
+
+    regressions = 0
+    print("%-32s %12s %12s %8s" % ("benchmark", "baseline ns", "median ns",
+                                    "change"))
+    for name, result in current.items():
+        if name not in previous:
+            print("%-32s %12s %12.3f %8s" % (name, "-", result["median_ns"],
+                                             "new"))
+            continue
+        before = previous[name]["median_ns"]
+        after = result["median_ns"]
+        change = (after - before) / before if before > 0 else 0.0
+        flag = ""
+        if change > tolerance:
+            flag = "  REGRESSION"
+            regressions += 1
+        print("%-32s %12.3f %12.3f %+7.1f%%%s" % (name, before, after,
+                                                  change * 100, flag))
+    for name in previous:
+        if name not in current:
+            print("%-32s %12.3f %12s %8s" % (name, previous[name]["median_ns"],
+                                             "-", "gone"))
+
+    # accuracy checks are absolute, they do not depend on the baseline
+    failures = [a for a in report.get("accuracy", []) if not a["ok"]]
+    for a in failures:
+        print("%-32s error %d ppb exceeds the bound of %d ppb"
+              % (a["name"], a["max_error_ppb"], a["bound_ppb"]))
+
+    if regressions:
+        print("%d benchmark(s) regressed more than %.0f%%"
+              % (regressions, tolerance * 100))
+    if failures:
+        print("%d accuracy check(s) failed" % len(failures))
+    return 1 if regressions or failures else 0
+
+
+def main(argv):
+    if len(argv) not in (3, 4):
+        sys.stderr.write(__doc__)
+        return 2
+    tolerance = float(argv[3]) if len(argv) == 4 else DEFAULT_TOLERANCE
+    return compare(argv[1], argv[2], tolerance)
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
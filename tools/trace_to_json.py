@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+Converts an sdk::trace dump (see inc/sdk/trace.h) into Chrome trace event JSON,
+viewable in chrome://tracing or https://ui.perfetto.dev.
+
+usage: trace_to_json.py dump.bin [out.json]
+
+Each event kind gets its own track, since records do not carry the task that
+emitted them.
+"""
+
+import json
+import struct
+import sys
+
+DUMP_MAGIC = 0x544B4453
+DUMP_VERSION = 1
+
+HEADER = struct.Struct("<IHHII")
+RECORD = struct.Struct("<IHHI")
+
+# must match sdk::trace::event
+EVENTS = {
+    0: "i2c_read",
+    1: "i2c_write",
+    2: "i2c_wait",
+    3: "spi_transmit",
+    4: "spi_receive",
+    5: "mutex_lock",
+    6: "queue_push",
+    7: "queue_pop",
+    8: "encoder_edge",
+    9: "motor_update",
+    10: "i2c_recover",
+    11: "uart_tx_dma",
+    12: "uart_drop",
+}
+USER_BASE = 0x100
+
+# sdk::trace::phase to Chrome trace phases
+PHASES = {0: "i", 1: "B", 2: "E"}
+
+
+def event_name(event_id):
+    if event_id in EVENTS:
+        return EVENTS[event_id]
+    if event_id >= USER_BASE:
+        return "user_%d" % (event_id - USER_BASE)
+    return "unknown_%d" % event_id
+
+
+def decode(data):
+    magic, version, record_size, cycles_per_us, count = \
+        HEADER.unpack_from(data, 0)
+    if magic != DUMP_MAGIC:
+        raise ValueError("not a trace dump (magic 0x%08x)" % magic)
+    if version != DUMP_VERSION or record_size != RECORD.size:
+        raise ValueError("unsupported dump version %d" % version)
+
+    events = []
+    tracks = set()
+    now = 0
+    last = None
+    offset = HEADER.size
+    for _ in range(count):
+        cycles, event_id, phase, arg = RECORD.unpack_from(data, offset)
+        offset += RECORD.size
+
+        # unwrap the 32-bit cycle counter. Records are in slot order, and an
+        # ISR can take a slot and stamp it before the event it preempted, so
+        # a step back is a small negative delta, not a wrap
+        if last is not None:
+            delta = (cycles - last) & 0xFFFFFFFF
+            if delta >= 1 << 31:
+                delta -= 1 << 32
+            now += delta
+        else:
+            now = cycles
+        last = cycles
+
+        tracks.add(event_id)
+        event = {
+            "name": event_name(event_id),
+            "ph": PHASES.get(phase, "i"),
+            "ts": now / cycles_per_us,
+            "pid": 0,
+            "tid": event_id,
+            "args": {"arg": arg},
+        }
+        if event["ph"] == "i":
+            event["s"] = "t"
+        events.append(event)
+
+    for event_id in sorted(tracks):
+        events.append({
+            "name": "thread_name",
+            "ph": "M",
+            "pid": 0,
+            "tid": event_id,
+            "args": {"name": event_name(event_id)},
+        })
+    return {"traceEvents": events, "displayTimeUnit": "ns"}
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.stderr.write(__doc__)
+        return 1
+    with open(argv[1], "rb") as f:
+        trace = decode(f.read())
+    if len(argv) == 3:
+        with open(argv[2], "w") as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))